@@ -564,6 +564,19 @@ textclient_getc (text_data *d)
 }
 
 
+int
+textclient_read (text_data *d, char *buf, int n)
+{
+  int got = 0;
+  while (got < n) {
+    int c = textclient_getc (d);
+    if (c <= 0) break;
+    buf[got++] = (char) c;
+  }
+  return got;
+}
+
+
 Bool
 textclient_putc (text_data *d, XKeyEvent *k)
 {
@@ -17,6 +17,8 @@
 "*imageDirectory:	/Library/Desktop Pictures/",
 "*nice:			10",
 "*memoryLimit:		0",
+"*loadBudget:		0",
+"*renderScale:		1.0",
 "*lock:			False",
 "*verbose:		False",
 "*timestamp:		True",
@@ -29,6 +31,7 @@
 "*visualID:		default",
 "*captureStderr: 	True",
 "*ignoreUninstalledPrograms: False",
+"*warmLaunch:		False",
 "*authWarningSlack:	20",
 "*textMode:		file",
 "*textLiteral:		XScreenSaver",
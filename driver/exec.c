@@ -86,8 +86,12 @@ static void nice_process (int nice_level);
 
 #ifndef VMS
 
+/* If `path' is non-null, it is the already-resolved location of the
+   program, so don't search $PATH for it again -- unless it isn't there
+   any more.
+ */
 static void
-exec_simple_command (const char *command)
+exec_simple_command (const char *command, const char *path)
 {
   char *av[1024];
   int ac = 0;
@@ -99,6 +103,8 @@ exec_simple_command (const char *command)
     }
   av[ac] = 0;
 
+  if (path)
+    execv (path, av);	/* shouldn't return. */
   execvp (av[0], av);	/* shouldn't return. */
 }
 
@@ -175,8 +181,9 @@ exec_vms_command (const char *command)
 #endif /* !VMS */
 
 
-void
-exec_command (const char *shell, const char *command, int nice_level)
+static void
+exec_command_1 (const char *shell, const char *command, const char *path,
+                int nice_level)
 {
   int hairy_p;
 
@@ -203,13 +210,31 @@ exec_command (const char *shell, const char *command, int nice_level)
     exec_complex_command (shell, command);
   else
     /* Otherwise, we can just exec the program directly. */
-    exec_simple_command (command);
+    exec_simple_command (command, path);
 
 #else  /* VMS */
   exec_vms_command (command);
 #endif /* VMS */
 }
 
+
+void
+exec_command (const char *shell, const char *command, int nice_level)
+{
+  exec_command_1 (shell, command, 0, nice_level);
+}
+
+
+/* Like exec_command, but `path' is where find_on_path() found the program
+   earlier.  It is only used if the command can be run without a shell.
+ */
+void
+exec_resolved_command (const char *shell, const char *command,
+                       const char *path, int nice_level)
+{
+  exec_command_1 (shell, command, path, nice_level);
+}
+
 
 /* Setting process priority
  */
@@ -249,13 +274,14 @@ nice_process (int nice_level)
 }
 
 
-/* Whether the given command exists on $PATH.
+/* Returns the file name at which the given command exists on $PATH, or 0.
    (Anything before the first space is considered to be the program name.)
+   The result should be freed.
  */
-int
-on_path_p (const char *program)
+char *
+find_on_path (const char *program)
 {
-  int result = 0;
+  char *result = 0;
   struct stat st;
   char *cmd = strdup (program);
   char *token = strchr (cmd, ' ');
@@ -267,7 +293,11 @@ on_path_p (const char *program)
 
   if (strchr (cmd, '/'))
     {
-      result = (0 == stat (cmd, &st));
+      if (0 == stat (cmd, &st))
+        {
+          result = cmd;
+          cmd = 0;
+        }
       goto DONE;
     }
 
@@ -285,16 +315,30 @@ on_path_p (const char *program)
       strcpy (p2, token);
       strcat (p2, "/");
       strcat (p2, cmd);
-      result = (0 == stat (p2, &st));
+      if (0 == stat (p2, &st))
+        {
+          result = p2;
+          goto DONE;
+        }
       free (p2);
-      if (result)
-        goto DONE;
       token = strtok (0, ":");
     }
 
  DONE:
-  free (cmd);
+  if (cmd) free (cmd);
   if (path) free (path);
   return result;
 }
 
+
+/* Whether the given command exists on $PATH.
+ */
+int
+on_path_p (const char *program)
+{
+  char *file = find_on_path (program);
+  if (!file) return 0;
+  free (file);
+  return 1;
+}
+
@@ -16,6 +16,10 @@
 extern void exec_command (const char *shell, const char *command,
                           int nice_level);
 
+extern void exec_resolved_command (const char *shell, const char *command,
+                                   const char *path, int nice_level);
+
 extern int on_path_p (const char *program);
+extern char *find_on_path (const char *program);
 
 #endif /* __XSCREENSAVER_EXEC_H__ */
@@ -267,6 +267,8 @@ static const char * const prefs[] = {
   "newLoginCommand",		/* not saved */
   "nice",
   "memoryLimit",
+  "loadBudget",
+  "renderScale",
   "fade",
   "unfade",
   "fadeSeconds",
@@ -275,6 +277,7 @@ static const char * const prefs[] = {
   "captureStdout",		/* not saved -- obsolete */
   "logFile",			/* not saved */
   "ignoreUninstalledPrograms",
+  "warmLaunch",
   "font",
   "dpmsEnabled",
   "dpmsQuickOff",
@@ -764,12 +767,14 @@ write_init_file (Display *dpy,
     {
       char buf[255];
       const char *pr = prefs[j];
-      enum pref_type { pref_str, pref_int, pref_bool, pref_byte, pref_time
+      enum pref_type { pref_str, pref_int, pref_bool, pref_byte, pref_time,
+                       pref_float
       } type = pref_str;
       const char *s = 0;
       int i = 0;
       Bool b = False;
       Time t = 0;
+      double f = 0;
 
       if (pr && !*pr)
 	{
@@ -807,6 +812,8 @@ write_init_file (Display *dpy,
       CHECK("newLoginCommand")	continue;  /* don't save */
       CHECK("nice")		type = pref_int,  i = p->nice_inferior;
       CHECK("memoryLimit")	type = pref_byte, i = p->inferior_memory_limit;
+      CHECK("loadBudget")	type = pref_int,  i = p->load_budget;
+      CHECK("renderScale")	type = pref_float, f = p->render_scale;
       CHECK("fade")		type = pref_bool, b = p->fade_p;
       CHECK("unfade")		type = pref_bool, b = p->unfade_p;
       CHECK("fadeSeconds")	type = pref_time, t = p->fade_seconds;
@@ -816,6 +823,7 @@ write_init_file (Display *dpy,
       CHECK("logFile")		continue;  /* don't save */
       CHECK("ignoreUninstalledPrograms")
                                 type = pref_bool, b = p->ignore_uninstalled_p;
+      CHECK("warmLaunch")	type = pref_bool, b = p->warm_launch_p;
 
       CHECK("font")		type = pref_str,  s =    stderr_font;
 
@@ -878,6 +886,10 @@ write_init_file (Display *dpy,
 	  sprintf(buf, "%d", i);
 	  s = buf;
 	  break;
+	case pref_float:
+	  sprintf(buf, "%g", f);
+	  s = buf;
+	  break;
 	case pref_bool:
 	  s = b ? "True" : "False";
 	  break;
@@ -1056,6 +1068,8 @@ load_init_file (Display *dpy, saver_preferences *p)
   p->nice_inferior  = get_integer_resource (dpy, "nice", "Nice");
   p->inferior_memory_limit = get_byte_resource (dpy, "memoryLimit",
                                                 "MemoryLimit");
+  p->load_budget    = get_integer_resource (dpy, "loadBudget", "Integer");
+  p->render_scale   = get_float_resource (dpy, "renderScale", "RenderScale");
   p->splash_p       = get_boolean_resource (dpy, "splash", "Boolean");
 # ifdef QUAD_MODE
   p->quad_p         = get_boolean_resource (dpy, "quad", "Boolean");
@@ -1064,6 +1078,7 @@ load_init_file (Display *dpy, saver_preferences *p)
   p->ignore_uninstalled_p = get_boolean_resource (dpy, 
                                                   "ignoreUninstalledPrograms",
                                                   "Boolean");
+  p->warm_launch_p  = get_boolean_resource (dpy, "warmLaunch", "Boolean");
 
   p->initial_delay   = 1000 * get_seconds_resource (dpy, "initialDelay", "Time");
   p->splash_duration = 1000 * get_seconds_resource (dpy, "splashDuration", "Time");
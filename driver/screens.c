@@ -965,10 +965,46 @@ describe_monitor_layout (saver_info *si)
 }
 
 
+/* The width that a saver window on this monitor should have.
+ */
+static int
+monitor_saver_width (saver_info *si, monitor *m)
+{
+# ifndef DEBUG_MULTISCREEN
+  saver_preferences *p = &si->prefs;
+  if (p->debug_p
+#  ifdef QUAD_MODE
+      && !p->quad_p
+#  endif
+      )
+    return m->width / 2;
+# endif
+  return m->width;
+}
+
+
+/* Whether this ssi is already showing exactly this monitor.
+ */
+static Bool
+monitor_matches_ssi_p (saver_info *si, monitor *m, saver_screen_info *ssi)
+{
+  return (ssi->screen == m->screen &&
+          ssi->x      == m->x      &&
+          ssi->y      == m->y      &&
+          ssi->width  == monitor_saver_width (si, m) &&
+          ssi->height == m->height);
+}
+
+
 /* Synchronize the contents of si->ssi to the current state of the monitors.
    Doesn't change anything if nothing has changed; otherwise, alters and
    reuses existing saver_screen_info structs as much as possible.
    Returns True if anything changed.
+
+   A monitor that is still where it was keeps its old ssi, even if other
+   monitors were added or removed around it, and that ssi is left alone:
+   only the ones with layout_changed_p set need their windows resized or
+   their hacks started by resize_screensaver_window().
  */
 Bool
 update_screen_layout (saver_info *si)
@@ -976,8 +1012,11 @@ update_screen_layout (saver_info *si)
   monitor **monitors = scan_monitors (si);
   int count = 0;
   int good_count = 0;
+  int old_count = si->nscreens;
   int i, j;
   int seen_screens[100] = { 0, };
+  int *slots;
+  Bool *taken;
 
   if (! layouts_differ_p (monitors, si->monitor_layout))
     {
@@ -1014,29 +1053,63 @@ update_screen_layout (saver_info *si)
 
   if (! si->screens) abort();
 
-  si->nscreens = good_count;
+  /* Decide which ssi each sane monitor goes in.  si->screens has to stay
+     dense, so there are only good_count of them now.  First, monitors that
+     haven't moved keep the ssi they had, if it is still one of those; then
+     the rest fill in the gaps, in order.  So when a monitor goes away, the
+     others keep their windows and hacks, except for those that were in the
+     last few ssis: they move into the gap, and start over.
+   */
+  slots = (int *) calloc (count + 1, sizeof(*slots));
+  taken = (Bool *) calloc (good_count + 1, sizeof(*taken));
+  if (!slots || !taken) abort();
 
-  /* Regenerate the list of GL visuals as needed. */
-  if (si->best_gl_visuals)
-    free (si->best_gl_visuals);
-  si->best_gl_visuals = 0;
+  if (old_count > good_count)
+    old_count = good_count;
+
+  for (i = 0; i < count; i++)
+    {
+      slots[i] = -1;
+      if (monitors[i]->sanity != S_SANE) continue;
+      for (j = 0; j < old_count; j++)
+        if (!taken[j] &&
+            monitor_matches_ssi_p (si, monitors[i], &si->screens[j]))
+          {
+            slots[i] = j;
+            taken[j] = True;
+            break;
+          }
+    }
 
   for (i = 0, j = 0; i < count; i++)
+    {
+      if (monitors[i]->sanity != S_SANE || slots[i] >= 0) continue;
+      while (taken[j]) j++;
+      slots[i] = j;
+      taken[j] = True;
+    }
+
+  si->nscreens = good_count;
+
+  for (i = 0; i < count; i++)
     {
       monitor *m = monitors[i];
-      saver_screen_info *ssi = &si->screens[j];
-      Screen *old_screen = ssi->screen;
-      int sn;
+      saver_screen_info *ssi;
+      Screen *old_screen;
       if (monitors[i]->sanity != S_SANE) continue;
 
+      ssi = &si->screens[slots[i]];
+      ssi->layout_changed_p = ! (slots[i] < old_count &&
+                                 monitor_matches_ssi_p (si, m, ssi));
+      if (! ssi->layout_changed_p)
+        continue;
+
+      old_screen = ssi->screen;
       ssi->global = si;
-      ssi->number = j;
+      ssi->number = slots[i];
 
-      sn = screen_number (m->screen);
       ssi->screen = m->screen;
-      ssi->real_screen_number = sn;
-      ssi->real_screen_p = (seen_screens[sn] == 0);
-      seen_screens[sn]++;
+      ssi->real_screen_number = screen_number (m->screen);
 
       ssi->default_visual =
 	get_visual_resource (ssi->screen, "visualID", "VisualID", False);
@@ -1054,22 +1127,19 @@ update_screen_layout (saver_info *si)
 
       ssi->x      = m->x;
       ssi->y      = m->y;
-      ssi->width  = m->width;
+      ssi->width  = monitor_saver_width (si, m);
       ssi->height = m->height;
+    }
 
-# ifndef DEBUG_MULTISCREEN
-      {
-        saver_preferences *p = &si->prefs;
-        if (p->debug_p
-#  ifdef QUAD_MODE
-            && !p->quad_p
-#  endif
-            )
-          ssi->width /= 2;
-      }
-# endif
+  free (slots);
+  free (taken);
 
-      j++;
+  for (j = 0; j < si->nscreens; j++)
+    {
+      saver_screen_info *ssi = &si->screens[j];
+      int sn = ssi->real_screen_number;
+      ssi->real_screen_p = (seen_screens[sn] == 0);
+      seen_screens[sn]++;
     }
 
   si->default_screen = &si->screens[0];
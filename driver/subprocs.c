@@ -19,20 +19,29 @@
 #include <string.h>
 
 #include <X11/Xlib.h>		/* not used for much... */
+#include <X11/Xutil.h>		/* for XVisualInfo */
+#include <X11/Xatom.h>		/* for XA_CARDINAL */
 
 #ifndef ESRCH
 # include <errno.h>
 #endif
 
+#include <fcntl.h>		/* for open() and FD_CLOEXEC */
 #include <sys/time.h>		/* sys/resource.h needs this for timeval */
+#include <time.h>
+#include <sys/stat.h>		/* for stat() */
 #include <sys/param.h>		/* for PATH_MAX */
 
 #ifdef HAVE_SYS_WAIT_H
 # include <sys/wait.h>		/* for waitpid() and associated macros */
 #endif
 
-#ifdef HAVE_SETRLIMIT
-# include <sys/resource.h>	/* for setrlimit() and RLIMIT_AS */
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>		/* for sysconf() */
+#endif
+
+#if defined(HAVE_SETRLIMIT) || defined(HAVE_SETPRIORITY)
+# include <sys/resource.h>	/* for setrlimit(), RLIMIT_AS, setpriority() */
 #endif
 
 #ifdef VMS
@@ -832,9 +841,12 @@ print_path_error (const char *program)
    If successful, the pid of the other process is returned.
    Otherwise, -1 is returned and an error may have been
    printed to stderr.
+   If `path' is non-null, it is where the program was found on $PATH.
+   The program is told to draw on `window'.
  */
-pid_t
-fork_and_exec (saver_screen_info *ssi, const char *command)
+static pid_t
+fork_and_exec_1 (saver_screen_info *ssi, const char *command,
+                 const char *path, Window window)
 {
   saver_info *si = ssi->global;
   saver_preferences *p = &si->prefs;
@@ -853,14 +865,14 @@ fork_and_exec (saver_screen_info *ssi, const char *command)
     case 0:
       close (ConnectionNumber (si->dpy));	/* close display fd */
       limit_subproc_memory (p->inferior_memory_limit, p->verbose_p);
-      hack_subproc_environment (ssi->screen, ssi->screensaver_window);
+      hack_subproc_environment (ssi->screen, window, p->render_scale);
 
       if (p->verbose_p)
         fprintf (stderr, "%s: %d: spawning \"%s\" in pid %lu.\n",
                  blurb(), ssi->number, command,
                  (unsigned long) getpid ());
 
-      exec_command (p->shell, command, p->nice_inferior);
+      exec_resolved_command (p->shell, command, path, p->nice_inferior);
 
       /* If that returned, we were unable to exec the subprocess.
          Print an error message, if desired.
@@ -880,6 +892,732 @@ fork_and_exec (saver_screen_info *ssi, const char *command)
 }
 
 
+pid_t
+fork_and_exec (saver_screen_info *ssi, const char *command)
+{
+  return fork_and_exec_1 (ssi, command, 0, ssi->screensaver_window);
+}
+
+
+
+/* The hack catalogue.
+
+   Which hacks can run on which screen: they must be enabled, their
+   program must be on $PATH, and the screen must have the visual they ask
+   for.  Finding that out means a stat() per $PATH directory and a visual
+   lookup per hack, so it is done once, the first time a hack is launched
+   after the init file is (re)loaded, $PATH changes, or the screens change,
+   instead of every time we pick a hack.  Then picking a random hack is
+   just picking a random element of the list of usable ones.
+
+   Programs can also be installed or removed while we run, so the list is
+   redone every CATALOGUE_LIFETIME seconds, and whenever a hack that we
+   thought was there turns out not to be.
+ */
+
+#define CATALOGUE_LIFETIME (60 * 10)
+
+struct hack_catalogue {
+  screenhack **hacks;	/* p->screenhacks when this was built */
+  int nhacks;
+  char **paths;		/* where each program is, or 0 if not on $PATH */
+  char *path_env;	/* $PATH when this was built */
+  time_t built;
+
+  int nscreens;
+  Screen **screens;	/* ssi->screen of each screen when this was built */
+  Bool *usable_p;	/* [screen * nhacks + hack] */
+  int *usable;		/* [screen * nhacks + i]: the usable hacks, in order */
+  int *nusable;		/* [screen]: how many of those there are */
+};
+
+
+static void
+free_hack_catalogue (struct hack_catalogue *c)
+{
+  int i;
+  if (!c) return;
+  for (i = 0; i < c->nhacks; i++)
+    if (c->paths[i]) free (c->paths[i]);
+  if (c->paths) free (c->paths);
+  if (c->path_env) free (c->path_env);
+  if (c->screens) free (c->screens);
+  if (c->usable_p) free (c->usable_p);
+  if (c->usable) free (c->usable);
+  if (c->nusable) free (c->nusable);
+  free (c);
+}
+
+
+static void discard_warm_screenhack (saver_screen_info *ssi);
+
+/* Called when the list of hacks may have changed. */
+void
+invalidate_hack_catalogue (saver_info *si)
+{
+  int i;
+  free_hack_catalogue (si->catalogue);
+  si->catalogue = 0;
+
+  /* Any hacks started ahead of time were picked from the old list. */
+  for (i = 0; i < si->nscreens; i++)
+    discard_warm_screenhack (&si->screens[i]);
+}
+
+
+static Bool
+hack_catalogue_stale_p (saver_info *si, struct hack_catalogue *c)
+{
+  saver_preferences *p = &si->prefs;
+  const char *path = getenv ("PATH");
+  int i;
+
+  if (c->hacks != p->screenhacks ||
+      c->nhacks != p->screenhacks_count ||
+      c->nscreens != si->nscreens)
+    return True;
+  if (!path != !c->path_env ||
+      (path && strcmp (path, c->path_env)))
+    return True;
+  for (i = 0; i < c->nscreens; i++)
+    if (c->screens[i] != si->screens[i].screen)
+      return True;
+  return False;
+}
+
+
+/* Whether the load governor has given up on this hack.  Those are
+   remembered by command rather than by index, so that they stay out of
+   the running when the init file is reloaded.
+ */
+static Bool
+heavy_hack_p (saver_info *si, screenhack *hack)
+{
+  int i;
+  for (i = 0; i < si->nheavy_hacks; i++)
+    if (!strcmp (si->heavy_hacks[i], hack->command))
+      return True;
+  return False;
+}
+
+
+static struct hack_catalogue *
+make_hack_catalogue (saver_info *si)
+{
+  saver_preferences *p = &si->prefs;
+  struct hack_catalogue *c;
+  const char *path = getenv ("PATH");
+  int nhacks = p->screenhacks_count;
+  int nscreens = si->nscreens;
+  int i, j;
+
+  c = (struct hack_catalogue *) calloc (1, sizeof(*c));
+  if (!c) return 0;
+  c->hacks = p->screenhacks;
+  c->nhacks = nhacks;
+  c->nscreens = nscreens;
+  c->built = time ((time_t *) 0);
+  c->path_env = (path ? strdup (path) : 0);
+  c->paths    = (char **)   calloc (nhacks + 1, sizeof(*c->paths));
+  c->screens  = (Screen **) calloc (nscreens + 1, sizeof(*c->screens));
+  c->usable_p = (Bool *)    calloc (nscreens * nhacks + 1, sizeof(Bool));
+  c->usable   = (int *)     calloc (nscreens * nhacks + 1, sizeof(int));
+  c->nusable  = (int *)     calloc (nscreens + 1, sizeof(int));
+  if (!c->paths || !c->screens || !c->usable_p || !c->usable || !c->nusable)
+    {
+      free_hack_catalogue (c);
+      return 0;
+    }
+
+  for (i = 0; i < nhacks; i++)
+    {
+      screenhack *hack = p->screenhacks[i];
+      if (hack->enabled_p && !heavy_hack_p (si, hack))
+        c->paths[i] = find_on_path (hack->command);
+    }
+
+  for (j = 0; j < nscreens; j++)
+    {
+      saver_screen_info *ssi = &si->screens[j];
+      c->screens[j] = ssi->screen;
+      for (i = 0; i < nhacks; i++)
+        {
+          screenhack *hack = p->screenhacks[i];
+          if (c->paths[i] && find_visual (ssi, hack->visual, 0))
+            {
+              c->usable_p[j * nhacks + i] = True;
+              c->usable[j * nhacks + c->nusable[j]++] = i;
+            }
+          else if (c->paths[i] && p->verbose_p)
+            fprintf (stderr, "%s: %d: no \"%s\" visual; skipping \"%s\".\n",
+                     blurb(), ssi->number,
+                     (hack->visual && *hack->visual ? hack->visual : "???"),
+                     hack->command);
+        }
+    }
+
+  if (p->verbose_p)
+    for (j = 0; j < nscreens; j++)
+      fprintf (stderr, "%s: %d: %d of %d programs usable.\n",
+               blurb(), j, c->nusable[j], nhacks);
+
+  return c;
+}
+
+
+static struct hack_catalogue *
+hack_catalogue (saver_info *si)
+{
+  if (si->catalogue && hack_catalogue_stale_p (si, si->catalogue))
+    invalidate_hack_catalogue (si);
+  else if (si->catalogue &&
+           time ((time_t *) 0) - si->catalogue->built >= CATALOGUE_LIFETIME)
+    {
+      /* Only the programs on disk may have changed, so any warm hacks
+         are still fine. */
+      free_hack_catalogue (si->catalogue);
+      si->catalogue = 0;
+    }
+  if (!si->catalogue)
+    si->catalogue = make_hack_catalogue (si);
+  return si->catalogue;
+}
+
+
+/* Takes a hack out of the running on this screen, e.g., because
+   select_visual() failed on it after all.
+ */
+static void
+hack_catalogue_drop (struct hack_catalogue *c, int screen, int hack)
+{
+  int *usable = c->usable + screen * c->nhacks;
+  int i;
+  if (!c->usable_p[screen * c->nhacks + hack]) return;
+  c->usable_p[screen * c->nhacks + hack] = False;
+  for (i = 0; i < c->nusable[screen]; i++)
+    if (usable[i] == hack)
+      {
+        memmove (usable + i, usable + i + 1,
+                 (c->nusable[screen] - i - 1) * sizeof(*usable));
+        c->nusable[screen]--;
+        break;
+      }
+}
+
+
+/* Returns a random usable hack other than `current', if there is one. */
+static int
+hack_catalogue_random (struct hack_catalogue *c, int screen, int current)
+{
+  int *usable = c->usable + screen * c->nhacks;
+  int n = c->nusable[screen];
+  int i;
+  if (n <= 0) return -1;
+  i = random() % n;
+  if (usable[i] == current && n > 1)
+    i = (i + 1 + random() % (n - 1)) % n;
+  return usable[i];
+}
+
+
+/* Returns the next (or previous) usable hack after `current', wrapping. */
+static int
+hack_catalogue_step (struct hack_catalogue *c, int screen, int current,
+                     int dir)
+{
+  int n = c->nhacks;
+  int i, h = current;
+  if (c->nusable[screen] <= 0) return -1;
+  if (h < 0) h = (dir > 0 ? -1 : n);
+  for (i = 0; i < n; i++)
+    {
+      h = (h + dir + n) % n;
+      if (c->usable_p[screen * n + h])
+        return h;
+    }
+  return -1;
+}
+
+
+
+/* Warm launching.
+
+   Starting a hack takes a while: it has to connect to the display, parse
+   its resources, allocate colors, and maybe create a GL context, and the
+   screen sits there black while it does.  So with the "warmLaunch"
+   preference, WARM_LEAD msecs before the cycle timer is due to go off,
+   we pick the next hack and start it in an unmapped child window of the
+   saver window.  After WARM_SETTLE msecs, when it is presumably done
+   initializing, we stop it.  When the cycle timer goes off, we just map
+   that window and let the hack continue.
+
+   This only happens in random mode: if the user asks for a particular
+   hack, or "next" or "prev", the parked hack is thrown away.
+ */
+
+#define WARM_LEAD   10000
+#define WARM_SETTLE  3000
+
+static Bool
+warm_launch_p (saver_info *si)
+{
+  saver_preferences *p = &si->prefs;
+  return (p->warm_launch_p &&
+          p->mode == RANDOM_HACKS &&
+          p->screenhacks_count > 1 &&
+          si->selection_mode == 0 &&
+          !si->demoing_p);
+}
+
+
+static Bool
+warm_screenhack_ready_p (saver_screen_info *ssi)
+{
+  struct screenhack_job *job;
+  if (!ssi->warm_pid || !warm_launch_p (ssi->global))
+    return False;
+  job = find_job (ssi->warm_pid);
+  return (job &&
+          (job->status == job_running || job->status == job_stopped));
+}
+
+
+static void
+kill_warm_screenhack (saver_screen_info *ssi)
+{
+  saver_info *si = ssi->global;
+  struct screenhack_job *job;
+  if (!ssi->warm_pid) return;
+  job = find_job (ssi->warm_pid);
+#ifdef SIGSTOP
+  /* A stopped process won't act on SIGTERM until it is continued. */
+  if (job && job->status == job_stopped)
+    {
+      kill_job (si, ssi->warm_pid, SIGCONT);
+      job = find_job (ssi->warm_pid);
+    }
+#endif /* SIGSTOP */
+  if (job && job->status == job_running)
+    kill_job (si, ssi->warm_pid, SIGTERM);
+  ssi->warm_pid = 0;
+}
+
+
+static void
+discard_warm_screenhack (saver_screen_info *ssi)
+{
+  kill_warm_screenhack (ssi);
+  destroy_hack_window (ssi, ssi->warm_window, ssi->warm_cmap);
+  ssi->warm_window = 0;
+  ssi->warm_cmap = 0;
+}
+
+
+static void
+forget_hack_window (saver_screen_info *ssi)
+{
+  destroy_hack_window (ssi, ssi->hack_window, ssi->hack_cmap);
+  ssi->hack_window = 0;
+  ssi->hack_cmap = 0;
+}
+
+
+/* Called when the screen unblanks. */
+void
+discard_warm_screenhacks (saver_info *si)
+{
+  int i;
+  if (si->warm_id)
+    {
+      saver_remove_timeout (si, si->warm_id);
+      si->warm_id = 0;
+    }
+  for (i = 0; i < si->nscreens; i++)
+    {
+      discard_warm_screenhack (&si->screens[i]);
+      forget_hack_window (&si->screens[i]);
+    }
+}
+
+
+static void
+start_warm_screenhack (saver_screen_info *ssi)
+{
+  saver_info *si = ssi->global;
+  saver_preferences *p = &si->prefs;
+  struct hack_catalogue *c = hack_catalogue (si);
+  screenhack *hack;
+  Visual *visual;
+  Window window;
+  Colormap cmap;
+  pid_t forked;
+  int next;
+
+  if (!c) return;
+  next = hack_catalogue_random (c, ssi->number, ssi->current_hack);
+  if (next < 0 || next == ssi->current_hack) return;
+
+  hack = p->screenhacks[next];
+  visual = find_visual (ssi, hack->visual, 0);
+  window = (visual ? make_hack_window (ssi, visual, &cmap) : 0);
+  if (!window)
+    {
+      if (p->verbose_p)
+        fprintf (stderr, "%s: %d: not starting \"%s\" ahead of time.\n",
+                 blurb(), ssi->number, hack->command);
+      return;
+    }
+  XSync (si->dpy, False);   /* the window must exist before the hack runs */
+
+  forked = fork_and_exec_1 (ssi, hack->command, c->paths[next], window);
+  if (forked <= 0)
+    {
+      destroy_hack_window (ssi, window, cmap);
+      return;
+    }
+
+  ssi->warm_hack   = next;
+  ssi->warm_pid    = forked;
+  ssi->warm_window = window;
+  ssi->warm_cmap   = cmap;
+}
+
+
+/* First starts the next hacks, then, WARM_SETTLE later, parks them.
+ */
+static void
+warm_timer (XtPointer closure, XtIntervalId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  Bool started_p = False;
+  int i;
+
+  si->warm_id = 0;
+  if (!si->screen_blanked_p || si->throttled_p || !warm_launch_p (si))
+    return;
+
+  for (i = 0; i < si->nscreens; i++)
+    {
+      saver_screen_info *ssi = &si->screens[i];
+      struct screenhack_job *job =
+        (ssi->warm_pid ? find_job (ssi->warm_pid) : 0);
+      if (job && job->status == job_running)
+        {
+#ifdef SIGSTOP
+          kill_job (si, ssi->warm_pid, SIGSTOP);
+#endif /* SIGSTOP */
+        }
+      else if (!ssi->warm_pid && ssi->pid)
+        {
+          start_warm_screenhack (ssi);
+          if (ssi->warm_pid)
+            started_p = True;
+        }
+    }
+
+  if (started_p)
+    si->warm_id = saver_add_timeout (si, WARM_SETTLE, warm_timer,
+                                     (XtPointer) si);
+}
+
+
+static void
+schedule_warm_screenhacks (saver_info *si)
+{
+  saver_preferences *p = &si->prefs;
+  if (si->warm_id || !warm_launch_p (si) || p->cycle <= WARM_LEAD * 2)
+    return;
+  si->warm_id = saver_add_timeout (si, p->cycle - WARM_LEAD, warm_timer,
+                                   (XtPointer) si);
+}
+
+
+/* Shows the hack that was started ahead of time on this screen, and
+   lets it run.
+ */
+static void
+use_warm_screenhack (saver_screen_info *ssi)
+{
+  saver_info *si = ssi->global;
+  saver_preferences *p = &si->prefs;
+  Window old_w = ssi->hack_window;
+  Colormap old_c = ssi->hack_cmap;
+
+  XMapRaised (si->dpy, ssi->warm_window);
+  if (ssi->stderr_overlay_window)
+    XRaiseWindow (si->dpy, ssi->stderr_overlay_window);
+#ifdef SIGSTOP
+  kill_job (si, ssi->warm_pid, SIGCONT);
+#endif /* SIGSTOP */
+
+  if (p->verbose_p)
+    fprintf (stderr, "%s: %d: switching to \"%s\" (pid %lu), "
+             "started ahead of time.\n",
+             blurb(), ssi->number, p->screenhacks[ssi->warm_hack]->command,
+             (unsigned long) ssi->warm_pid);
+
+  ssi->current_hack = ssi->warm_hack;
+  ssi->pid          = ssi->warm_pid;
+  ssi->hack_window  = ssi->warm_window;
+  ssi->hack_cmap    = ssi->warm_cmap;
+  ssi->warm_pid     = 0;
+  ssi->warm_window  = 0;
+  ssi->warm_cmap    = 0;
+
+  /* The old hack has already been killed; its last frame was on screen
+     until the new window covered it. */
+  destroy_hack_window (ssi, old_w, old_c);
+}
+
+
+/* The load governor.
+
+   With the "loadBudget" preference, every GOVERN_INTERVAL msecs while the
+   screen is blanked, we look at how much CPU time each running hack has
+   used since last time, as a percentage of one CPU.  A hack that is over
+   budget is first niced GOVERN_NICE levels further.  If it is still over
+   budget the next time, we give up on it: it won't be picked again this
+   session.  In random mode it is replaced right away; otherwise (one
+   hack, the same hack on every screen, demo mode, or nothing else left
+   to run) it keeps running until the next cycle, and is not logged again.
+
+   Hacks built on screenhack.c also report their frame rate through the
+   _XSCREENSAVER_FPS property on their window, which we log along with
+   those decisions.
+ */
+
+#define GOVERN_INTERVAL 10000
+#define GOVERN_NICE     5
+
+static double
+double_time (void)
+{
+  struct timeval now;
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  struct timezone tzp;
+  gettimeofday(&now, &tzp);
+# else
+  gettimeofday(&now);
+# endif
+  return (now.tv_sec + ((double) now.tv_usec * 0.000001));
+}
+
+
+/* The user and system CPU time of the process, in clock ticks.
+   Only works where there is a Linux-style /proc.
+ */
+static Bool
+hack_cpu_ticks (pid_t pid, unsigned long *ticks)
+{
+  char file[100];
+  char buf[1024];
+  unsigned long utime, stime;
+  char *s;
+  int fd, n;
+
+  sprintf (file, "/proc/%lu/stat", (unsigned long) pid);
+  fd = open (file, O_RDONLY);
+  if (fd < 0) return False;
+  n = read (fd, buf, sizeof(buf) - 1);
+  close (fd);
+  if (n <= 0) return False;
+  buf[n] = 0;
+
+  /* The command name is in parens, and may contain spaces or parens. */
+  s = strrchr (buf, ')');
+  if (!s ||
+      2 != sscanf (s + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u"
+                   " %lu %lu", &utime, &stime))
+    return False;
+
+  *ticks = utime + stime;
+  return True;
+}
+
+
+/* The frame rate that the hack last reported, times 100, or -1.
+ */
+static long
+hack_frame_rate (saver_info *si, Window window, Bool delete_p)
+{
+  static Atom XA_FPS = 0;
+  Atom type;
+  int format;
+  unsigned long nitems, bytesafter;
+  unsigned char *data = 0;
+  long fps = -1;
+
+  if (!XA_FPS)
+    XA_FPS = XInternAtom (si->dpy, "_XSCREENSAVER_FPS", False);
+
+  if (XGetWindowProperty (si->dpy, window, XA_FPS, 0, 1, delete_p,
+                          XA_CARDINAL, &type, &format, &nitems, &bytesafter,
+                          &data)
+      == Success
+      && type == XA_CARDINAL && format == 32 && nitems == 1 && data)
+    fps = *((long *) data);
+  if (data) XFree (data);
+  return fps;
+}
+
+
+static void schedule_load_governor (saver_info *);
+
+/* Takes this hack out of the running for the rest of this session. */
+static void
+give_up_on_screenhack (saver_screen_info *ssi, screenhack *hack)
+{
+  saver_info *si = ssi->global;
+  saver_preferences *p = &si->prefs;
+  struct hack_catalogue *c = hack_catalogue (si);
+  int hack_number = ssi->current_hack;
+  int i;
+
+  if (!heavy_hack_p (si, hack))
+    {
+      char **h = (char **) realloc (si->heavy_hacks,
+                                    (si->nheavy_hacks + 1) * sizeof(*h));
+      if (h)
+        {
+          si->heavy_hacks = h;
+          si->heavy_hacks[si->nheavy_hacks++] = strdup (hack->command);
+        }
+    }
+
+  for (i = 0; i < si->nscreens; i++)
+    {
+      saver_screen_info *ssi2 = &si->screens[i];
+      if (c && i < c->nscreens)
+        hack_catalogue_drop (c, i, hack_number);
+      if (ssi2->warm_pid && ssi2->warm_hack == hack_number)
+        discard_warm_screenhack (ssi2);
+    }
+
+  if (p->mode == RANDOM_HACKS &&
+      si->selection_mode == 0 &&
+      !si->demoing_p &&
+      c && c->nusable[ssi->number] > 0)
+    {
+      fprintf (stderr, "%s: %d: replacing \"%s\".\n",
+               blurb(), ssi->number, hack->command);
+      kill_screenhack (ssi);
+      spawn_screenhack (ssi);
+    }
+}
+
+
+static void
+govern_screenhack (saver_screen_info *ssi)
+{
+  saver_info *si = ssi->global;
+  saver_preferences *p = &si->prefs;
+  Window window = (ssi->hack_window
+                   ? ssi->hack_window
+                   : ssi->screensaver_window);
+  double now = double_time();
+  screenhack *hack;
+  unsigned long ticks;
+  long fps;
+  int cpu;
+  char fps_buf[50];
+
+  if (!ssi->pid || !hack_cpu_ticks (ssi->pid, &ticks))
+    {
+      ssi->load_pid = 0;
+      return;
+    }
+
+  /* A new hack: start counting, and throw away the last one's report. */
+  if (ssi->load_pid != ssi->pid)
+    {
+      ssi->load_pid     = ssi->pid;
+      ssi->load_ticks   = ticks;
+      ssi->load_time    = now;
+      ssi->load_strikes = 0;
+      hack_frame_rate (si, window, True);
+      return;
+    }
+
+  if (now <= ssi->load_time) return;
+  cpu = (int) (100 * (ticks - ssi->load_ticks)
+               / (double) sysconf (_SC_CLK_TCK)
+               / (now - ssi->load_time));
+  ssi->load_ticks = ticks;
+  ssi->load_time  = now;
+
+  if (cpu <= p->load_budget)
+    {
+      ssi->load_strikes = 0;
+      return;
+    }
+
+  if (ssi->current_hack < 0 || ssi->current_hack >= p->screenhacks_count)
+    return;
+  hack = p->screenhacks[ssi->current_hack];
+
+  /* Already given up on, but left running: we've said so once. */
+  if (heavy_hack_p (si, hack))
+    return;
+
+  fps = hack_frame_rate (si, window, False);
+  if (fps >= 0)
+    sprintf (fps_buf, " at %.1f fps", fps / 100.0);
+  else
+    *fps_buf = 0;
+
+  fprintf (stderr, "%s: %d: \"%s\" (pid %lu) is using %d%% of a CPU%s;"
+           " budget is %d%%.\n",
+           blurb(), ssi->number, hack->command, (unsigned long) ssi->pid,
+           cpu, fps_buf, p->load_budget);
+
+  if (++ssi->load_strikes == 1)
+    {
+#if defined(HAVE_SETPRIORITY) && defined(PRIO_PROCESS)
+      int nice_level;
+      errno = 0;
+      nice_level = getpriority (PRIO_PROCESS, ssi->pid);
+      if (errno == 0 &&
+          setpriority (PRIO_PROCESS, ssi->pid, nice_level + GOVERN_NICE) == 0)
+        fprintf (stderr, "%s: %d: lowering its priority to %d.\n",
+                 blurb(), ssi->number, nice_level + GOVERN_NICE);
+#endif /* HAVE_SETPRIORITY && PRIO_PROCESS */
+    }
+  else
+    {
+      fprintf (stderr, "%s: %d: \"%s\" is too heavy for this machine;"
+               " not running it again.\n",
+               blurb(), ssi->number, hack->command);
+      give_up_on_screenhack (ssi, hack);
+    }
+}
+
+
+static void
+govern_timer (XtPointer closure, XtIntervalId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  int i;
+
+  si->govern_id = 0;
+  if (!si->screen_blanked_p)
+    return;
+  for (i = 0; i < si->nscreens; i++)
+    govern_screenhack (&si->screens[i]);
+  schedule_load_governor (si);
+}
+
+
+static void
+schedule_load_governor (saver_info *si)
+{
+  saver_preferences *p = &si->prefs;
+  if (si->govern_id || p->load_budget <= 0)
+    return;
+  si->govern_id = saver_add_timeout (si, GOVERN_INTERVAL, govern_timer,
+                                     (XtPointer) si);
+}
+
+
 void
 spawn_screenhack (saver_screen_info *ssi)
 {
@@ -887,6 +1625,10 @@ spawn_screenhack (saver_screen_info *ssi)
   saver_preferences *p = &si->prefs;
   XFlush (si->dpy);
 
+  /* The windows aren't up yet: fade_timer() will start the hacks. */
+  if (si->fading_out_p)
+    return;
+
   if (!monitor_powered_on_p (si))
     {
       if (si->prefs.verbose_p)
@@ -896,14 +1638,37 @@ spawn_screenhack (saver_screen_info *ssi)
       return;
     }
 
+  schedule_load_governor (si);
+
   if (p->screenhacks_count)
     {
+      struct hack_catalogue *c = hack_catalogue (si);
       screenhack *hack;
       pid_t forked;
       char buf [255];
       int new_hack = -1;
-      int retry_count = 0;
       Bool force = False;
+      Bool usable_p;
+      struct stat st;
+
+      if (!c)
+        {
+          if (p->verbose_p)
+            fprintf (stderr, "%s: out of memory\n", blurb());
+          return;
+        }
+
+      if (warm_screenhack_ready_p (ssi))
+        {
+          use_warm_screenhack (ssi);
+          schedule_warm_screenhacks (si);
+          store_saver_status (si);  /* store current hack number */
+          return;
+        }
+
+      /* Otherwise, the hack will be drawing on the saver window itself. */
+      discard_warm_screenhack (ssi);
+      forget_hack_window (ssi);
 
     AGAIN:
 
@@ -919,17 +1684,15 @@ spawn_screenhack (saver_screen_info *ssi)
         }
       else if (si->selection_mode == -1)
         {
-          /* Select the next hack, wrapping. */
-          new_hack = (ssi->current_hack + 1) % p->screenhacks_count;
+          /* Select the next usable hack, wrapping. */
+          new_hack = hack_catalogue_step (c, ssi->number,
+                                          ssi->current_hack, 1);
         }
       else if (si->selection_mode == -2)
         {
-          /* Select the previous hack, wrapping. */
-          if (ssi->current_hack < 0)
-            new_hack = p->screenhacks_count - 1;
-          else
-            new_hack = ((ssi->current_hack + p->screenhacks_count - 1)
-                        % p->screenhacks_count);
+          /* Select the previous usable hack, wrapping. */
+          new_hack = hack_catalogue_step (c, ssi->number,
+                                          ssi->current_hack, -1);
         }
       else if (si->selection_mode > 0)
 	{
@@ -958,12 +1721,19 @@ spawn_screenhack (saver_screen_info *ssi)
 	}
       else  /* (p->mode == RANDOM_HACKS) */
 	{
-	  /* Select a random hack (but not the one we just ran.) */
-	  while ((new_hack = random () % p->screenhacks_count)
-		 == ssi->current_hack)
-	    ;
+	  /* Select a random usable hack (but not the one we just ran.) */
+          new_hack = hack_catalogue_random (c, ssi->number,
+                                            ssi->current_hack);
 	}
 
+      if (new_hack < 0 && !force &&
+          p->screenhacks_count > 0 &&
+          p->mode != BLANK_ONLY && p->mode != DONT_BLANK &&
+          p->verbose_p)
+        fprintf (stderr,
+                 "%s: %d: no programs enabled, or no suitable visuals.\n",
+                 blurb(), ssi->number);
+
       if (new_hack < 0)   /* don't run a hack */
         {
           ssi->current_hack = -1;
@@ -978,32 +1748,40 @@ spawn_screenhack (saver_screen_info *ssi)
       /* If the hack is disabled, or there is no visual for this hack,
 	 then try again (move forward, or backward, or re-randomize.)
 	 Unless this hack was specified explicitly, in which case,
-	 use it regardless.
+	 use it regardless.  The catalogue has already weeded out most
+	 of those, but select_visual() can still fail, in which case
+	 don't consider this hack on this screen again.
        */
+      usable_p = c->usable_p[ssi->number * c->nhacks + new_hack];
       if (force)
         select_visual_of_hack (ssi, hack);
-        
-      if (!force &&
-	  (!hack->enabled_p ||
-	   !on_path_p (hack->command) ||
-	   !select_visual_of_hack (ssi, hack)))
-	{
-	  if (++retry_count > (p->screenhacks_count*4))
-	    {
-	      /* Uh, oops.  Odds are, there are no suitable visuals,
-		 and we're looping.  Give up.  (This is totally lame,
-		 what we should do is make a list of suitable hacks at
-		 the beginning, then only loop over them.)
-	      */
-	      if (p->verbose_p)
-		fprintf(stderr,
-		      "%s: %d: no programs enabled, or no suitable visuals.\n",
-			blurb(), ssi->number);
-	      return;
-	    }
-	  else
-	    goto AGAIN;
-	}
+      else if (!usable_p)
+        {
+          /* Only possible with exactly one hack, or "same hack on every
+             screen" when screen 0's hack can't run here. */
+          if (p->verbose_p)
+            fprintf (stderr,
+                     "%s: %d: no programs enabled, or no suitable visuals.\n",
+                     blurb(), ssi->number);
+          return;
+        }
+      else if (c->paths[new_hack] && stat (c->paths[new_hack], &st))
+        {
+          /* It has been uninstalled since the catalogue was made.  Look
+             for everything again next time, in case it moved. */
+          if (p->verbose_p)
+            fprintf (stderr, "%s: %d: \"%s\" is gone; skipping \"%s\".\n",
+                     blurb(), ssi->number, c->paths[new_hack],
+                     hack->command);
+          hack_catalogue_drop (c, ssi->number, new_hack);
+          c->built = 0;
+          goto AGAIN;
+        }
+      else if (!select_visual_of_hack (ssi, hack))
+        {
+          hack_catalogue_drop (c, ssi->number, new_hack);
+          goto AGAIN;
+        }
 
       /* Turn off "next" and "prev" modes now, but "demo" mode is only
 	 turned off by explicit action.
@@ -1011,7 +1789,9 @@ spawn_screenhack (saver_screen_info *ssi)
       if (si->selection_mode < 0)
 	si->selection_mode = 0;
 
-      forked = fork_and_exec (ssi, hack->command);
+      forked = fork_and_exec_1 (ssi, hack->command,
+                                c->paths[new_hack],
+                                ssi->screensaver_window);
       switch ((int) forked)
 	{
 	case -1: /* fork failed */
@@ -1026,6 +1806,8 @@ spawn_screenhack (saver_screen_info *ssi)
 	  ssi->pid = forked;
 	  break;
 	}
+
+      schedule_warm_screenhacks (si);
     }
 
   store_saver_status (si);  /* store current hack number */
@@ -1070,6 +1852,7 @@ emergency_kill_subproc (saver_info *si)
 	  kill_job (si, ssi->pid, SIGTERM);
 	  ssi->pid = 0;
 	}
+      kill_warm_screenhack (ssi);
     }
 }
 
@@ -1122,7 +1905,8 @@ hack_environment (saver_info *si)
 
 
 void
-hack_subproc_environment (Screen *screen, Window saver_window)
+hack_subproc_environment (Screen *screen, Window saver_window,
+                          double render_scale)
 {
   /* Store $DISPLAY into the environment, so that the $DISPLAY variable that
      the spawned processes inherit is correct.  First, it must be on the same
@@ -1136,6 +1920,9 @@ hack_subproc_environment (Screen *screen, Window saver_window)
      Likewise, store a window ID in $XSCREENSAVER_WINDOW -- this will allow
      us to (eventually) run multiple hacks in Xinerama mode, where each hack
      has the same $DISPLAY but a different piece of glass.
+
+     And if GL hacks should draw smaller than their windows, say how much
+     smaller in $XSCREENSAVER_RENDER_SCALE; see init_GL().
    */
   Display *dpy = DisplayOfScreen (screen);
   const char *odpy = DisplayString (dpy);
@@ -1167,6 +1954,14 @@ hack_subproc_environment (Screen *screen, Window saver_window)
   if (putenv (nssw))
     abort ();
 
+  if (render_scale > 0 && render_scale < 1)
+    {
+      char *nscale = (char *) malloc (50);
+      sprintf (nscale, "XSCREENSAVER_RENDER_SCALE=%g", render_scale);
+      if (putenv (nscale))
+        abort ();
+    }
+
   /* don't free ndpy/nssw -- some implementations of putenv (BSD 4.4,
      glibc 2.0) copy the argument, but some (libc4,5, glibc 2.1.2)
      do not.  So we must leak it (and/or the previous setting). Yay.
@@ -1175,16 +1970,177 @@ hack_subproc_environment (Screen *screen, Window saver_window)
 }
 
 
-/* GL crap */
+/* GL crap
+
+   To find out which visual GL programs should use, we run
+   xscreensaver-gl-helper, which has to load and initialize the GL
+   libraries.  With some drivers that takes a second or more, per screen.
+   So the answers are remembered: in memory for the life of this process,
+   and in ~/.xscreensaver-gl between runs.  On disk, each screen is known
+   by the display name, the X server's vendor and release, and a checksum
+   of that screen's visuals.  We can't ask for the GL renderer without
+   doing what the helper does, but a new GL driver brings a new set of
+   visuals with it.
+
+   When the file doesn't have the answer, the helpers for all screens are
+   started at once, in the background, as soon as the screens are known.
+   We only wait for them when a GL hack is actually about to run.  If a
+   helper finds nothing, it is asked again after GL_PROBE_RETRY seconds.
+ */
 
-Visual *
-get_best_gl_visual (saver_info *si, Screen *screen)
+struct gl_probe {
+  Bool done_p;		/* Whether `visual' is the answer. */
+  Visual *visual;
+  pid_t pid;		/* The helper, while it runs. */
+  int fd;		/* Its stdout. */
+  time_t failed;	/* When it last found no visual. */
+  char key[200];	/* What this screen is called in the cache file. */
+};
+
+#define GL_CACHE_FILE ".xscreensaver-gl"
+#define GL_CACHE_MAX_LINES 50
+#define GL_PROBE_RETRY (60 * 10)
+
+
+static unsigned long
+gl_cache_hash (unsigned long h, const char *s)
 {
+  while (*s)
+    h = (h * 33) ^ (unsigned char) *s++;
+  return h & 0xFFFFFFFFL;
+}
+
+
+static void
+gl_cache_key (Screen *screen, char *key)
+{
+  Display *dpy = DisplayOfScreen (screen);
+  XVisualInfo vi_in, *vi;
+  unsigned long sum = 5381;
+  int i, n = 0;
+
+  vi_in.screen = screen_number (screen);
+  vi = XGetVisualInfo (dpy, VisualScreenMask, &vi_in, &n);
+  for (i = 0; i < n; i++)
+    {
+      char buf[80];
+      sprintf (buf, "%lx %d %d %d", (unsigned long) vi[i].visualid,
+               vi[i].depth, vi[i].class, vi[i].bits_per_rgb);
+      sum = gl_cache_hash (sum, buf);
+    }
+  if (vi) XFree (vi);
+
+  sprintf (key, "%.100s %d %08lx %d %d %08lx",
+           DisplayString (dpy), screen_number (screen),
+           gl_cache_hash (5381, ServerVendor (dpy)), VendorRelease (dpy),
+           n, sum);
+}
+
+
+static char *
+gl_cache_file (void)
+{
+  const char *home = getenv ("HOME");
+  char *file;
+  if (!home || !*home) return 0;
+  file = (char *) malloc (strlen (home) + sizeof(GL_CACHE_FILE) + 2);
+  if (!file) return 0;
+  sprintf (file, "%s/%s", home, GL_CACHE_FILE);
+  return file;
+}
+
+
+/* Returns the cached visual ID for this key, or 0. */
+static unsigned long
+read_gl_cache (const char *key)
+{
+  char *file = gl_cache_file ();
+  FILE *in = (file ? fopen (file, "r") : 0);
+  int L = strlen (key);
+  unsigned long id = 0;
+  char buf[300];
+
+  if (file) free (file);
+  if (!in) return 0;
+  while (fgets (buf, sizeof(buf), in))
+    if (!strncmp (buf, key, L) && buf[L] == ' ')
+      {
+        if (1 != sscanf (buf + L + 1, "0x%lx", &id))
+          id = 0;
+        break;
+      }
+  fclose (in);
+  return id;
+}
+
+
+/* Replaces this key's line in the cache file, keeping the most recently
+   written few others.
+ */
+static void
+write_gl_cache (saver_info *si, const char *key, unsigned long id)
+{
+  char *file = gl_cache_file ();
+  char *tmp;
+  char *lines[GL_CACHE_MAX_LINES];
+  int nlines = 0, i;
+  int L = strlen (key);
+  char buf[300];
+  FILE *f;
+
+  if (!file) return;
+
+  f = fopen (file, "r");
+  if (f)
+    {
+      while (fgets (buf, sizeof(buf), f))
+        {
+          if (!strncmp (buf, key, L) && buf[L] == ' ')
+            continue;
+          if (nlines == GL_CACHE_MAX_LINES - 1)
+            {
+              free (lines[0]);
+              memmove (lines, lines + 1, --nlines * sizeof(*lines));
+            }
+          lines[nlines++] = strdup (buf);
+        }
+      fclose (f);
+    }
+
+  tmp = (char *) malloc (strlen (file) + 5);
+  sprintf (tmp, "%s.tmp", file);
+  f = fopen (tmp, "w");
+  if (f)
+    {
+      for (i = 0; i < nlines; i++)
+        fputs (lines[i], f);
+      fprintf (f, "%s 0x%lx\n", key, id);
+      if (fclose (f) == 0 && rename (tmp, file) == 0)
+        {
+          if (si->prefs.verbose_p)
+            fprintf (stderr, "%s: wrote %s\n", blurb(), file);
+        }
+      else
+        unlink (tmp);
+    }
+
+  for (i = 0; i < nlines; i++)
+    free (lines[i]);
+  free (tmp);
+  free (file);
+}
+
+
+/* The helper runs on the X screen of this ssi, and is listed among the
+   jobs as belonging to it.
+ */
+static void
+start_gl_probe (saver_screen_info *ssi, struct gl_probe *g)
+{
+  saver_info *si = ssi->global;
+  Screen *screen = ssi->screen;
   pid_t forked;
   int fds [2];
-  int in, out;
-  int errfds[2];
-  int errin = -1, errout = -1;
   char buf[1024];
 
   char *av[10];
@@ -1193,32 +2149,17 @@ get_best_gl_visual (saver_info *si, Screen *screen)
   av[ac++] = "xscreensaver-gl-helper";
   av[ac] = 0;
 
+  g->fd = -1;
+  g->visual = 0;
+  g->done_p = False;
   if (pipe (fds))
     {
       perror ("error creating pipe:");
-      return 0;
-    }
-
-  in = fds [0];
-  out = fds [1];
-
-  if (!si->prefs.verbose_p)
-    {
-      if (pipe (errfds))
-        {
-          perror ("error creating pipe:");
-          return 0;
-        }
-
-      errin = errfds [0];
-      errout = errfds [1];
+      g->done_p = True;
+      g->failed = time ((time_t *) 0);
+      return;
     }
 
-  block_sigchld();   /* This blocks it in the parent and child, to avoid
-                        racing.  It is never unblocked in the child before
-                        the child exits, but that doesn't matter.
-                      */
-
   switch ((int) (forked = fork ()))
     {
     case -1:
@@ -1229,26 +2170,23 @@ get_best_gl_visual (saver_info *si, Screen *screen)
       }
     case 0:
       {
-        close (in);  /* don't need this one */
+        close (fds[0]);  /* don't need this one */
         close (ConnectionNumber (si->dpy));	/* close display fd */
 
-        if (dup2 (out, STDOUT_FILENO) < 0)	/* pipe stdout */
+        if (dup2 (fds[1], STDOUT_FILENO) < 0)	/* pipe stdout */
           {
             perror ("could not dup() a new stdout:");
-            return 0;
+            exit (1);
           }
 
         if (! si->prefs.verbose_p)
           {
-            close(errin);
-            if (dup2 (errout, STDERR_FILENO) < 0)
-              {
-                perror ("could not dup() a new stderr:");
-                return 0;
-              }
+            int null = open ("/dev/null", O_WRONLY);
+            if (null >= 0)
+              dup2 (null, STDERR_FILENO);
           }
 
-        hack_subproc_environment (screen, 0);	/* set $DISPLAY */
+        hack_subproc_environment (screen, 0, 1);   /* set $DISPLAY */
 
         execvp (av[0], av);			/* shouldn't return. */
 
@@ -1258,71 +2196,154 @@ get_best_gl_visual (saver_info *si, Screen *screen)
                Issue all other exec errors, though. */
             sprintf (buf, "%s: running %s", blurb(), av[0]);
             perror (buf);
+            exit (1);                           /* exits fork */
           }
-        exit (1);                               /* exits fork */
+        exit (0);                               /* quietly, too */
         break;
       }
     default:
-      {
-        int result = 0;
-        int wait_status = 0;
+      close (fds[1]);  /* don't need this one */
+# if defined(HAVE_FCNTL) && defined(FD_CLOEXEC)
+      /* Don't let the hacks inherit it. */
+      fcntl (fds[0], F_SETFD, FD_CLOEXEC);
+# endif
+      g->pid = forked;
+      g->fd = fds[0];
+      (void) make_job (forked, ssi->number, av[0]);
+      break;
+    }
+}
 
-        FILE *f = fdopen (in, "r");
-        unsigned long v = 0;
-        char c;
 
-        close (out);  /* don't need this one */
+/* Waits for the helper to say which visual it likes.
+ */
+static void
+finish_gl_probe (saver_info *si, Screen *screen, struct gl_probe *g)
+{
+  const char *helper = "xscreensaver-gl-helper";
+  char buf[1024];
+  int L = 0;
+  unsigned long v = 0;
+  char c;
 
-        *buf = 0;
-        if (! fgets (buf, sizeof(buf)-1, f))
-          *buf = 0;
-        fclose (f);
+  *buf = 0;
+  while (g->fd >= 0 && L < sizeof(buf) - 1)
+    {
+      int n = read (g->fd, buf + L, sizeof(buf) - 1 - L);
+      if (n < 0 && errno == EINTR)   /* e.g., SIGCHLD from the helper */
+        continue;
+      if (n <= 0)
+        break;
+      L += n;
+    }
+  buf[L] = 0;
+  if (g->fd >= 0)
+    close (g->fd);
+  g->fd = -1;
+  g->pid = 0;
+  g->done_p = True;
+
+  if (1 == sscanf (buf, "0x%lx %c", &v, &c))
+    g->visual = id_to_visual (screen, (int) v);
+
+  if (! g->visual)
+    {
+      g->failed = time ((time_t *) 0);
+      if (si->prefs.verbose_p)
+        {
+          fprintf (stderr, "%s: %s did not report a GL visual!\n",
+                   blurb(), helper);
+
+          if (L && buf[L-1] == '\n')
+            buf[--L] = 0;
+          if (*buf)
+            fprintf (stderr, "%s: %s said: \"%s\"\n",
+                     blurb(), helper, buf);
+        }
+    }
+  else
+    {
+      if (si->prefs.verbose_p)
+        fprintf (stderr, "%s: %d: %s: GL visual is 0x%lX%s.\n",
+                 blurb(), screen_number (screen),
+                 helper, v,
+                 (g->visual == DefaultVisualOfScreen (screen)
+                  ? " (default)" : ""));
+
+      /* Only remember successes: if GL isn't working now, maybe it
+         will be after the next restart. */
+      write_gl_cache (si, g->key, v);
+    }
+}
 
-        if (! si->prefs.verbose_p)
-          {
-            close (errout);
-            close (errin);
-          }
 
-        /* Wait for the child to die. */
-        waitpid (-1, &wait_status, 0);
+/* Starts finding the GL visual of this ssi's X screen, if nobody has yet.
+   The answers are kept by X screen, since that is what the visual belongs
+   to, and the number of those never changes.
+ */
+static struct gl_probe *
+start_gl_visual_probe (saver_screen_info *ssi)
+{
+  saver_info *si = ssi->global;
+  Screen *screen = ssi->screen;
+  struct gl_probe *g;
+  unsigned long id;
 
-        unblock_sigchld();   /* child is dead and waited, unblock now. */
+  if (!si->gl_probes)
+    {
+      si->gl_probes = (struct gl_probe *)
+        calloc (ScreenCount (si->dpy), sizeof(*si->gl_probes));
+      if (!si->gl_probes) abort();
+    }
 
-        if (1 == sscanf (buf, "0x%lx %c", &v, &c))
-          result = (int) v;
+  g = &si->gl_probes[screen_number (screen)];
+  if (*g->key) return g;
 
-        if (result == 0)
-          {
-            if (si->prefs.verbose_p)
-              {
-                int L = strlen(buf);
-                fprintf (stderr, "%s: %s did not report a GL visual!\n",
-                         blurb(), av[0]);
-
-                if (L && buf[L-1] == '\n')
-                  buf[--L] = 0;
-                if (*buf)
-                  fprintf (stderr, "%s: %s said: \"%s\"\n",
-                           blurb(), av[0], buf);
-              }
-            return 0;
-          }
-        else
-          {
-            Visual *v = id_to_visual (screen, result);
-            if (si->prefs.verbose_p)
-              fprintf (stderr, "%s: %d: %s: GL visual is 0x%X%s.\n",
-                       blurb(), screen_number (screen),
-                       av[0], result,
-                       (v == DefaultVisualOfScreen (screen)
-                        ? " (default)" : ""));
-            return v;
-          }
-      }
+  g->fd = -1;
+  gl_cache_key (screen, g->key);
+  id = read_gl_cache (g->key);
+  if (id)
+    g->visual = id_to_visual (screen, (int) id);
+
+  if (g->visual)
+    {
+      g->done_p = True;
+      if (si->prefs.verbose_p)
+        fprintf (stderr, "%s: %d: GL visual is 0x%lX%s (cached).\n",
+                 blurb(), ssi->number, id,
+                 (g->visual == DefaultVisualOfScreen (screen)
+                  ? " (default)" : ""));
     }
+  else
+    start_gl_probe (ssi, g);
+  return g;
+}
+
+
+/* Starts finding the GL visuals of all screens, if not already started.
+ */
+void
+start_gl_visual_probes (saver_info *si)
+{
+  int i;
+  for (i = 0; i < si->nscreens; i++)
+    start_gl_visual_probe (&si->screens[i]);
+}
+
+
+Visual *
+get_best_gl_visual (saver_screen_info *ssi)
+{
+  struct gl_probe *g = start_gl_visual_probe (ssi);
+
+  /* Maybe GL works now: e.g., the driver was still loading last time. */
+  if (g->done_p && !g->visual &&
+      time ((time_t *) 0) - g->failed >= GL_PROBE_RETRY)
+    start_gl_probe (ssi, g);
 
-  abort();
+  if (! g->done_p)
+    finish_gl_probe (ssi->global, ssi->screen, g);
+  return g->visual;
 }
 
 
@@ -1350,6 +2371,7 @@ save_argv (int argc, char **argv)
 void
 restart_process (saver_info *si)
 {
+  finish_fade (si);   /* the new process won't know the real gamma */
   fflush (stdout);
   fflush (stderr);
   shutdown_stderr (si);
@@ -50,6 +50,15 @@ Bool blank_screen (saver_info *si) {return False;}
 void unblank_screen (saver_info *si) {}
 void reset_watchdog_timer(saver_info *si, Bool on_p) {}
 Bool select_visual (saver_screen_info *ssi, const char *v) { return False; }
+Visual *find_visual (saver_screen_info *ssi, const char *v, Bool *i) {return 0;}
+Window make_hack_window (saver_screen_info *ssi, Visual *v, Colormap *c)
+  { return 0; }
+void destroy_hack_window (saver_screen_info *ssi, Window w, Colormap c) {}
+XtIntervalId saver_add_timeout (saver_info *si, unsigned long msecs,
+                                XtTimerCallbackProc p, XtPointer c)
+  { return 0; }
+void saver_remove_timeout (saver_info *si, XtIntervalId id) {}
+void finish_fade (saver_info *si) {}
 Bool window_exists_p (Display *dpy, Window window) {return True;}
 void start_notice_events_timer (saver_info *si, Window w, Bool b) {}
 Bool handle_clientmessage (saver_info *si, XEvent *e, Bool u) { return False; }
@@ -65,6 +74,9 @@ void shutdown_stderr (saver_info *si) { }
 void resize_screensaver_window (saver_info *si) { }
 void describe_monitor_layout (saver_info *si) { }
 Bool update_screen_layout (saver_info *si) { return 0; }
+#ifdef HAVE_RANDR
+Bool handle_randr_event (saver_info *si, XEvent *e) { return False; }
+#endif
 Bool in_signal_handler_p = 0;
 
 const char *blurb(void) { return progname; }
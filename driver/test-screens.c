@@ -44,7 +44,7 @@ const char *blurb(void) { return progname; }
 
 Bool safe_XF86VidModeGetViewPort(Display *d, int i, int *x, int *y) { abort(); }
 void initialize_screen_root_widget(saver_screen_info *ssi) { abort(); }
-Visual *get_best_gl_visual (saver_info *si, Screen *sc) { abort(); }
+Visual *get_best_gl_visual (saver_screen_info *ssi) { abort(); }
 
 
 static const char *
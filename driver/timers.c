@@ -46,6 +46,21 @@
 #include <X11/extensions/Xrandr.h>
 #endif /* HAVE_RANDR */
 
+#ifdef HAVE_XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif /* HAVE_XINPUT2 */
+
+#ifdef HAVE_LINUX_INPUT_H
+# include <linux/input.h>
+# include <dirent.h>
+# include <fcntl.h>
+# include <errno.h>
+# include <sys/ioctl.h>
+# ifdef HAVE_SYS_INOTIFY_H
+#  include <sys/inotify.h>
+# endif
+#endif /* HAVE_LINUX_INPUT_H */
+
 #include "xscreensaver.h"
 
 #undef ABS
@@ -55,6 +70,177 @@
 #define MAX(x,y)((x)>(y)?(x):(y))
 
 
+/* All of the driver's own timers (idle, pointer polling, cycle, lock,
+   watchdog, notice_events, de-race) go through here instead of being
+   separate Xt timeouts.  We keep them in one list sorted by deadline, and
+   only ever have one Xt timeout pending: for the earliest deadline, plus
+   however late that timer can afford to be.  When it goes off, every timer
+   that is due by then runs, so timers that are due within a fraction of a
+   second of each other share a single wakeup.
+
+   A timer may run up to 1/16th of its interval late (but never more than
+   a second late); it never runs early.
+
+   The ids handed out are not Xt ids, but they are unique and non-zero, so
+   the callbacks can compare them against the ones they saved, as before.
+ */
+
+typedef struct saver_timer saver_timer;
+struct saver_timer {
+  XtIntervalId id;
+  double when, slack;		/* seconds */
+  XtTimerCallbackProc proc;
+  XtPointer closure;
+  saver_timer *next;
+};
+
+static double
+double_time (void)
+{
+  struct timeval now;
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  struct timezone tzp;
+  gettimeofday(&now, &tzp);
+# else
+  gettimeofday(&now);
+# endif
+  return (now.tv_sec + ((double) now.tv_usec * 0.000001));
+}
+
+static void timer_queue_cb (XtPointer closure, XtIntervalId *id);
+
+/* Makes the one Xt timeout go off when the first timer is due.
+ */
+static void
+timer_queue_rearm (saver_info *si)
+{
+  saver_timer *t;
+  double when = 0;
+
+  if (si->timer_queue_id)
+    {
+      XtRemoveTimeOut (si->timer_queue_id);
+      si->timer_queue_id = 0;
+    }
+
+  if (!si->timer_queue)
+    return;
+
+  /* Wake up as late as every pending timer will tolerate. */
+  for (t = si->timer_queue; t; t = t->next)
+    {
+      if (when && t->when > when)
+        break;			/* sorted: nothing later can be earlier */
+      if (!when || t->when + t->slack < when)
+        when = t->when + t->slack;
+    }
+
+  when -= double_time();
+  si->timer_queue_id =
+    XtAppAddTimeOut (si->app,
+                     (when <= 0 ? 0 : (unsigned long) (when * 1000)),
+                     timer_queue_cb, (XtPointer) si);
+}
+
+
+static void
+timer_queue_cb (XtPointer closure, XtIntervalId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  double now = double_time();
+  unsigned long serial = si->timer_serial;
+
+  si->timer_queue_id = 0;
+  si->timer_wakeups++;
+
+  /* Run every timer that is due, oldest first.  The callbacks may add and
+     remove timers, so start over from the head each time, and leave alone
+     any that were added while we're in here. */
+  while (1)
+    {
+      saver_timer *t, **tp;
+      for (tp = &si->timer_queue; *tp; tp = &(*tp)->next)
+        if ((*tp)->when <= now && (*tp)->id <= serial)
+          break;
+      t = *tp;
+      if (!t) break;
+
+      *tp = t->next;
+      {
+        XtIntervalId tid = t->id;
+        XtTimerCallbackProc proc = t->proc;
+        XtPointer tclosure = t->closure;
+        free (t);
+        proc (tclosure, &tid);
+      }
+    }
+
+  timer_queue_rearm (si);
+}
+
+
+XtIntervalId
+saver_add_timeout (saver_info *si, unsigned long msecs,
+                   XtTimerCallbackProc proc, XtPointer closure)
+{
+  saver_timer *t = (saver_timer *) calloc (1, sizeof(*t));
+  saver_timer **tp;
+  if (!t) abort();
+
+  t->id      = ++si->timer_serial;
+  t->when    = double_time() + msecs / 1000.0;
+  t->slack   = msecs / 16000.0;
+  if (t->slack > 1) t->slack = 1;
+  t->proc    = proc;
+  t->closure = closure;
+
+  for (tp = &si->timer_queue; *tp; tp = &(*tp)->next)
+    if ((*tp)->when > t->when)
+      break;
+  t->next = *tp;
+  *tp = t;
+
+  timer_queue_rearm (si);
+  return t->id;
+}
+
+
+void
+saver_remove_timeout (saver_info *si, XtIntervalId id)
+{
+  saver_timer *t, **tp;
+  for (tp = &si->timer_queue; *tp; tp = &(*tp)->next)
+    if ((*tp)->id == id)
+      {
+        t = *tp;
+        *tp = t->next;
+        free (t);
+        timer_queue_rearm (si);
+        return;
+      }
+}
+
+
+/* How many times the timer queue has woken us up per minute, since the
+   last reset.  Printed in -verbose mode, to see what we cost when idle.
+ */
+double
+timer_wakeups_per_minute (saver_info *si, Bool reset_p)
+{
+  time_t now = time ((time_t *) 0);
+  double secs = now - si->timer_wakeups_since;
+  double rate = (si->timer_wakeups_since && secs > 0
+                 ? si->timer_wakeups * 60 / secs
+                 : 0);
+  if (reset_p)
+    {
+      si->timer_wakeups = 0;
+      si->timer_wakeups_since = now;
+    }
+  return rate;
+}
+
+
 #ifdef HAVE_PROC_INTERRUPTS
 static Bool proc_interrupts_activity_p (saver_info *si);
 #endif /* HAVE_PROC_INTERRUPTS */
@@ -105,8 +291,8 @@ schedule_wakeup_event (saver_info *si, Time when, Bool verbose_p)
     }
 
   /* Wake up periodically to ask the server if we are idle. */
-  si->timer_id = XtAppAddTimeOut (si->app, when, idle_timer,
-                                  (XtPointer) si);
+  si->timer_id = saver_add_timeout (si, when, idle_timer,
+                                    (XtPointer) si);
 
   if (verbose_p)
     fprintf (stderr, "%s: starting idle_timer (%ld, %ld)\n",
@@ -160,6 +346,10 @@ notice_events (saver_info *si, Window window, Bool top_p)
      count as activity...  Fortunately, /proc/interrupts helps, on
      systems that have it.  Oh, if it's a PS/2 mouse, not serial or USB.
      This sucks!
+
+     None of this happens if the server has XInput2: then we select raw
+     events on the root window once, and get all of those.  See
+     init_xinput2_extension().
    */
   XSelectInput (si->dpy, window, SubstructureNotifyMask | events);
 
@@ -227,8 +417,8 @@ start_notice_events_timer (saver_info *si, Window w, Bool verbose_p)
     (struct notice_events_timer_arg *) malloc(sizeof(*arg));
   arg->si = si;
   arg->w = w;
-  XtAppAddTimeOut (si->app, p->notice_events_timeout, notice_events_timer,
-		   (XtPointer) arg);
+  saver_add_timeout (si, p->notice_events_timeout, notice_events_timer,
+		     (XtPointer) arg);
 
   if (verbose_p)
     fprintf (stderr, "%s: starting notice_events_timer for 0x%X (%lu)\n",
@@ -284,8 +474,8 @@ cycle_timer (XtPointer closure, XtIntervalId *id)
 
   if (how_long > 0)
     {
-      si->cycle_id = XtAppAddTimeOut (si->app, how_long, cycle_timer,
-                                      (XtPointer) si);
+      si->cycle_id = saver_add_timeout (si, how_long, cycle_timer,
+                                        (XtPointer) si);
 
       if (p->debug_p)
         fprintf (stderr, "%s: starting cycle_timer (%ld, %ld)\n",
@@ -326,7 +516,7 @@ reset_timers (saver_info *si)
       if (p->debug_p)
         fprintf (stderr, "%s: killing idle_timer  (%ld, %ld)\n",
                  blurb(), p->timeout, si->timer_id);
-      XtRemoveTimeOut (si->timer_id);
+      saver_remove_timeout (si, si->timer_id);
       si->timer_id = 0;
     }
 
@@ -514,11 +704,11 @@ check_pointer_timer (XtPointer closure, XtIntervalId *id)
     si->check_pointer_timer_id = 0;
 
   if (si->check_pointer_timer_id)		/* only queue one at a time */
-    XtRemoveTimeOut (si->check_pointer_timer_id);
+    saver_remove_timeout (si, si->check_pointer_timer_id);
 
   si->check_pointer_timer_id =			/* now re-queue */
-    XtAppAddTimeOut (si->app, p->pointer_timeout, check_pointer_timer,
-		     (XtPointer) si);
+    saver_add_timeout (si, p->pointer_timeout, check_pointer_timer,
+		       (XtPointer) si);
 
   for (i = 0; i < si->nscreens; i++)
     {
@@ -672,6 +862,89 @@ swallow_unlock_typeahead_events (saver_info *si, XEvent *e)
 }
 
 
+#ifdef HAVE_RANDR
+
+/* Changing modes or plugging in a monitor sends a burst of RANDR events:
+   one for the screen, and one for each CRTC and output involved.  Rather
+   than rescanning the monitors for each of them, wait this long after the
+   first one, and then rescan once.
+ */
+#define LAYOUT_SETTLE 250
+
+static void
+layout_timer (XtPointer closure, XtIntervalId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  saver_preferences *p = &si->prefs;
+
+  si->layout_id = 0;
+
+  /* Resize the existing xscreensaver windows and cached ssi data. */
+  if (update_screen_layout (si))
+    {
+      if (p->verbose_p)
+        {
+          fprintf (stderr, "%s: new layout:\n", blurb());
+          describe_monitor_layout (si);
+        }
+      resize_screensaver_window (si);
+    }
+}
+
+
+/* Returns True if this was a RANDR event, after arranging for the saver
+   windows to follow the new layout of the monitors.
+ */
+Bool
+handle_randr_event (saver_info *si, XEvent *event)
+{
+  saver_preferences *p = &si->prefs;
+
+  if (! si->using_randr_extension)
+    return False;
+
+  if (event->type == si->randr_event_number + RRScreenChangeNotify)
+    {
+      /* The Resize and Rotate extension sends an event when the
+         size, rotation, or refresh rate of any screen has changed.
+       */
+      if (p->verbose_p)
+        {
+          /* XRRRootToScreen is in Xrandr.h 1.4, 2001/06/07 */
+          int screen = XRRRootToScreen (si->dpy, event->xany.window);
+          fprintf (stderr, "%s: %d: screen change event received\n",
+                   blurb(), screen);
+        }
+
+# ifdef RRScreenChangeNotifyMask
+      /* Inform Xlib that it's ok to update its data structures. */
+      XRRUpdateConfiguration (event); /* Xrandr.h 1.9, 2002/09/29 */
+# endif /* RRScreenChangeNotifyMask */
+    }
+# ifdef RRNotify
+  else if (event->type == si->randr_event_number + RRNotify)
+    {
+      /* RANDR 1.2 also tells us when a CRTC or output changes, which
+         covers monitors being moved or switched on and off without the
+         size of the root window changing. */
+      if (p->verbose_p)
+        fprintf (stderr, "%s: %d: CRTC or output change event received\n",
+                 blurb(),
+                 XRRRootToScreen (si->dpy, event->xany.window));
+    }
+# endif /* RRNotify */
+  else
+    return False;
+
+  if (! si->layout_id)
+    si->layout_id = saver_add_timeout (si, LAYOUT_SETTLE, layout_timer,
+                                       (XtPointer) si);
+  return True;
+}
+
+#endif /* HAVE_RANDR */
+
+
 /* methods of detecting idleness:
 
       explicitly informed by SGI SCREEN_SAVER server event;
@@ -703,19 +976,18 @@ sleep_until_idle (saver_info *si, Bool until_idle_p)
    */
   union {
     XEvent x_event;
-# ifdef HAVE_RANDR
-    XRRScreenChangeNotifyEvent xrr_event;
-# endif /* HAVE_RANDR */
 # ifdef HAVE_MIT_SAVER_EXTENSION
     XScreenSaverNotifyEvent sevent;
 # endif /* HAVE_MIT_SAVER_EXTENSION */
   } event;
 
   /* We need to select events on all windows if we're not using any extensions.
-     Otherwise, we don't need to. */
+     Otherwise, we don't need to.  XInput2 raw events are delivered to the
+     root window no matter what, so they count as an extension here. */
   Bool scanning_all_windows = !(si->using_xidle_extension ||
                                 si->using_mit_saver_extension ||
-                                si->using_sgi_saver_extension);
+                                si->using_sgi_saver_extension ||
+                                si->using_xinput2);
 
   /* We need to periodically wake up and check for idleness if we're not using
      any extensions, or if we're using the XIDLE extension.  The other two
@@ -986,6 +1258,59 @@ sleep_until_idle (saver_info *si, Bool until_idle_p)
 
       default:
 
+#ifdef HAVE_XINPUT2
+        if (si->using_xinput2 &&
+            event.x_event.type == GenericEvent &&
+            event.x_event.xcookie.extension == si->xinput2_opcode &&
+            (event.x_event.xcookie.evtype == XI_RawKeyPress ||
+             event.x_event.xcookie.evtype == XI_RawButtonPress ||
+             event.x_event.xcookie.evtype == XI_RawMotion))
+          {
+            /* We only need the event type, not the payload, so there's
+               no XGetEventData() round trip here. */
+            int evtype = event.x_event.xcookie.evtype;
+
+            if (p->debug_p && evtype != XI_RawMotion)
+              fprintf (stderr, "%s: %s\n", blurb(),
+                       (evtype == XI_RawKeyPress
+                        ? "XI_RawKeyPress" : "XI_RawButtonPress"));
+
+            if (!until_idle_p)
+              {
+                if (evtype == XI_RawMotion)
+                  {
+                    /* As with MotionNotify, ignore jitter: only count it
+                       if the pointer has really moved on some screen. */
+                    Bool moved_p = False;
+                    int i;
+                    for (i = 0; i < si->nscreens; i++)
+                      if (pointer_moved_p (&si->screens[i], False))
+                        moved_p = True;
+                    if (!moved_p)
+                      continue;
+                  }
+
+                if (si->demoing_p && evtype == XI_RawMotion)
+                  /* When we're demoing a single hack, mouse motion doesn't
+                     cause deactivation.  Only clicks and keypresses do. */
+                  ;
+                else
+                  {
+                    why = (evtype == XI_RawMotion ? "XI2 mouse motion" :
+                           evtype == XI_RawKeyPress ? "XI2 keyboard activity" :
+                           "XI2 mouse click");
+                    goto DONE;
+                  }
+              }
+            else if (si->last_activity_time != time ((time_t *) 0))
+              /* Idleness is counted in seconds, and raw motion can arrive
+                 hundreds of times a second, so re-arm the idle timer at
+                 most once a second. */
+              reset_timers (si);
+          }
+        else
+#endif /* HAVE_XINPUT2 */
+
 #ifdef HAVE_MIT_SAVER_EXTENSION
 	if (event.x_event.type == si->mit_saver_ext_event_number)
 	  {
@@ -1147,37 +1472,8 @@ sleep_until_idle (saver_info *si, Bool until_idle_p)
 #endif /* HAVE_XINPUT */
 
 #ifdef HAVE_RANDR
-        if (si->using_randr_extension &&
-            (event.x_event.type == 
-             (si->randr_event_number + RRScreenChangeNotify)))
-          {
-            /* The Resize and Rotate extension sends an event when the
-               size, rotation, or refresh rate of any screen has changed.
-             */
-            if (p->verbose_p)
-              {
-                /* XRRRootToScreen is in Xrandr.h 1.4, 2001/06/07 */
-                int screen = XRRRootToScreen (si->dpy, event.xrr_event.window);
-                fprintf (stderr, "%s: %d: screen change event received\n",
-                         blurb(), screen);
-              }
-
-# ifdef RRScreenChangeNotifyMask
-            /* Inform Xlib that it's ok to update its data structures. */
-            XRRUpdateConfiguration (&event.x_event); /* Xrandr.h 1.9, 2002/09/29 */
-# endif /* RRScreenChangeNotifyMask */
-
-            /* Resize the existing xscreensaver windows and cached ssi data. */
-            if (update_screen_layout (si))
-              {
-                if (p->verbose_p)
-                  {
-                    fprintf (stderr, "%s: new layout:\n", blurb());
-                    describe_monitor_layout (si);
-                  }
-                resize_screensaver_window (si);
-              }
-          }
+        if (handle_randr_event (si, &event.x_event))
+          ;
         else
 #endif /* HAVE_RANDR */
 
@@ -1193,7 +1489,12 @@ sleep_until_idle (saver_info *si, Bool until_idle_p)
       fprintf (stderr, "%s: %s (%s)\n", blurb(),
                (until_idle_p ? "user is idle" : "user is active"),
                why);
+      fprintf (stderr, "%s: %.1f timer wakeups per minute while %s.\n",
+               blurb(), timer_wakeups_per_minute (si, True),
+               (until_idle_p ? "active" : "blanked"));
     }
+  else
+    timer_wakeups_per_minute (si, True);
 
   /* If there's a user event on the queue, swallow it.
      If we're using a server extension, and the user becomes active, we
@@ -1214,12 +1515,12 @@ sleep_until_idle (saver_info *si, Bool until_idle_p)
 
   if (si->check_pointer_timer_id)
     {
-      XtRemoveTimeOut (si->check_pointer_timer_id);
+      saver_remove_timeout (si, si->check_pointer_timer_id);
       si->check_pointer_timer_id = 0;
     }
   if (si->timer_id)
     {
-      XtRemoveTimeOut (si->timer_id);
+      saver_remove_timeout (si, si->timer_id);
       si->timer_id = 0;
     }
 
@@ -1489,6 +1790,313 @@ proc_interrupts_activity_p (saver_info *si)
 
 #endif /* HAVE_PROC_INTERRUPTS */
 
+
+/* Linux input devices.
+
+   If we can read /dev/input/event*, that's a much better way to notice
+   console activity than /proc/interrupts: it works for USB keyboards
+   and mice, not just PS/2 ones, and since the device fds are just added
+   to the Xt event loop, we don't wake up to poll anything, or parse any
+   text.  We are told about activity when it happens.
+
+   Usually those devices are only readable by root and the "input" group,
+   in which case we fall back to /proc/interrupts.
+
+   We only open devices that look like keyboards, mice or touchpads:
+   something with relative axes, letter keys, or mouse or touch buttons.
+   That leaves out lid switches, power buttons, and accelerometers that
+   send a steady stream of absolute-axis events.
+
+   New devices are noticed by watching /dev/input with inotify.  Devices
+   that go away are noticed when reading them fails.
+ */
+
+#ifdef HAVE_LINUX_INPUT_H
+
+#define EVDEV_DIR "/dev/input"
+
+typedef struct {
+  int fd;
+  int number;			/* N in /dev/input/eventN */
+  XtInputId id;
+} evdev_device;
+
+static evdev_device *evdev_devices = 0;
+static int evdev_count = 0, evdev_size = 0;
+
+#define EVDEV_BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define EVDEV_TEST_BIT(bit, array) \
+  ((array[(bit) / EVDEV_BITS_PER_LONG] >> ((bit) % EVDEV_BITS_PER_LONG)) & 1)
+
+
+/* Whether this device is something a person types on or pushes around. */
+static Bool
+evdev_interesting_p (int fd)
+{
+  unsigned long evbits[(EV_MAX / EVDEV_BITS_PER_LONG) + 1];
+  unsigned long keybits[(KEY_MAX / EVDEV_BITS_PER_LONG) + 1];
+
+  memset (evbits, 0, sizeof(evbits));
+  memset (keybits, 0, sizeof(keybits));
+
+  if (ioctl (fd, EVIOCGBIT (0, sizeof(evbits)), evbits) < 0)
+    return False;
+
+  if (EVDEV_TEST_BIT (EV_REL, evbits))
+    return True;
+
+  if (EVDEV_TEST_BIT (EV_KEY, evbits) &&
+      ioctl (fd, EVIOCGBIT (EV_KEY, sizeof(keybits)), keybits) >= 0 &&
+      (EVDEV_TEST_BIT (KEY_A, keybits) ||
+       EVDEV_TEST_BIT (KEY_SPACE, keybits) ||
+       EVDEV_TEST_BIT (BTN_LEFT, keybits) ||
+       EVDEV_TEST_BIT (BTN_TOUCH, keybits)))
+    return True;
+
+  return False;
+}
+
+
+/* Returns N if the file name is "eventN", else -1. */
+static int
+evdev_number (const char *name)
+{
+  const char *s;
+  if (strncmp (name, "event", 5) || !name[5] || strlen (name) > 12)
+    return -1;
+  for (s = name + 5; *s; s++)
+    if (*s < '0' || *s > '9')
+      return -1;
+  return atoi (name + 5);
+}
+
+
+static void evdev_device_cb (XtPointer closure, int *fd, XtInputId *id);
+
+static int
+evdev_open_file (const char *name)
+{
+  char file[sizeof(EVDEV_DIR) + 20];
+  int fd;
+  sprintf (file, "%s/%s", EVDEV_DIR, name);
+  fd = open (file, O_RDONLY | O_NONBLOCK);
+  if (fd < 0) return fd;
+
+# if defined(HAVE_FCNTL) && defined(FD_CLOEXEC)
+  /* Close this fd upon exec instead of inheriting / leaking it. */
+  if (fcntl (fd, F_SETFD, FD_CLOEXEC) != 0)
+    perror ("fcntl: CLOEXEC:");
+# endif
+
+  if (!evdev_interesting_p (fd))
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+
+static void
+evdev_open (saver_info *si, const char *name)
+{
+  int n = evdev_number (name);
+  int fd, i;
+  evdev_device *d;
+
+  if (n < 0) return;
+  for (i = 0; i < evdev_count; i++)
+    if (evdev_devices[i].number == n)
+      return;			/* already have it */
+
+  fd = evdev_open_file (name);
+  if (fd < 0) return;
+
+  if (evdev_count >= evdev_size)
+    {
+      int size = (evdev_size ? evdev_size * 2 : 8);
+      evdev_device *dd = (evdev_device *)
+        realloc (evdev_devices, size * sizeof(*dd));
+      if (!dd)
+        {
+          close (fd);
+          return;
+        }
+      evdev_devices = dd;
+      evdev_size = size;
+    }
+
+  d = &evdev_devices[evdev_count++];
+  d->fd = fd;
+  d->number = n;
+  d->id = XtAppAddInput (si->app, fd, (XtPointer) XtInputReadMask,
+                         evdev_device_cb, (XtPointer) si);
+
+  if (si->prefs.verbose_p)
+    fprintf (stderr, "%s: watching %s/%s for activity.\n",
+             blurb(), EVDEV_DIR, name);
+}
+
+
+static void
+evdev_close (saver_info *si, int fd)
+{
+  int i;
+  for (i = 0; i < evdev_count; i++)
+    if (evdev_devices[i].fd == fd)
+      {
+        if (si->prefs.verbose_p)
+          fprintf (stderr, "%s: %s/event%d went away.\n", blurb(),
+                   EVDEV_DIR, evdev_devices[i].number);
+        XtRemoveInput (evdev_devices[i].id);
+        close (fd);
+        evdev_devices[i] = evdev_devices[--evdev_count];
+        return;
+      }
+}
+
+
+/* Called from the Xt event loop when a device has something to say.
+ */
+static void
+evdev_device_cb (XtPointer closure, int *fd, XtInputId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  struct input_event ev[64];
+  Bool active_p = False;
+
+  while (1)
+    {
+      int i, n = read (*fd, ev, sizeof(ev));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0 && errno == EAGAIN)
+        break;
+      if (n <= 0)
+        {
+          evdev_close (si, *fd);   /* ENODEV: unplugged */
+          return;
+        }
+
+      for (i = 0; i < n / (int) sizeof(*ev); i++)
+        if ((ev[i].type == EV_KEY && ev[i].value != 0) ||  /* not release */
+            ev[i].type == EV_REL ||
+            ev[i].type == EV_ABS)
+          active_p = True;
+    }
+
+  /* We only need to push back the idle timer: when the screen is blanked,
+     activity is noticed through the X events from our grabs.  Idleness is
+     counted in seconds, so don't re-arm the timer more often than that. */
+  if (active_p &&
+      !si->screen_blanked_p &&
+      si->last_activity_time != time ((time_t *) 0))
+    {
+      if (si->prefs.debug_p)
+        fprintf (stderr, "%s: input device activity\n", blurb());
+      reset_timers (si);
+    }
+}
+
+
+#ifdef HAVE_SYS_INOTIFY_H
+static void
+evdev_inotify_cb (XtPointer closure, int *fd, XtInputId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  char buf[4096];
+  int n;
+
+  while ((n = read (*fd, buf, sizeof(buf))) > 0)
+    {
+      char *s = buf;
+      while (s < buf + n)
+        {
+          struct inotify_event *e = (struct inotify_event *) s;
+          /* udev creates the node, then fixes its permissions, so try
+             again on IN_ATTRIB. */
+          if (e->len && (e->mask & (IN_CREATE | IN_ATTRIB)))
+            evdev_open (si, e->name);
+          s += sizeof(*e) + e->len;
+        }
+    }
+}
+#endif /* HAVE_SYS_INOTIFY_H */
+
+
+Bool
+query_evdev_available (saver_info *si, const char **why)
+{
+  DIR *dir;
+  struct dirent *de;
+  Bool ok = False;
+
+  if (why) *why = 0;
+
+  if (!display_is_on_console_p (si))
+    {
+      if (why) *why = "not on primary console";
+      return False;
+    }
+
+  dir = opendir (EVDEV_DIR);
+  if (!dir)
+    {
+      if (why) *why = "does not exist";
+      return False;
+    }
+
+  while (!ok && (de = readdir (dir)))
+    if (evdev_number (de->d_name) >= 0)
+      {
+        int fd = evdev_open_file (de->d_name);
+        if (fd >= 0)
+          {
+            ok = True;
+            close (fd);
+          }
+      }
+  closedir (dir);
+
+  if (!ok && why) *why = "no readable keyboards or mice";
+  return ok;
+}
+
+
+void
+init_evdev (saver_info *si)
+{
+  DIR *dir = opendir (EVDEV_DIR);
+  struct dirent *de;
+
+  if (dir)
+    {
+      while ((de = readdir (dir)))
+        evdev_open (si, de->d_name);
+      closedir (dir);
+    }
+
+# ifdef HAVE_SYS_INOTIFY_H
+  {
+    int fd = inotify_init ();
+    if (fd >= 0)
+      {
+        fcntl (fd, F_SETFL, O_NONBLOCK);
+#  ifdef FD_CLOEXEC
+        fcntl (fd, F_SETFD, FD_CLOEXEC);
+#  endif
+        if (inotify_add_watch (fd, EVDEV_DIR, IN_CREATE | IN_ATTRIB) < 0)
+          close (fd);
+        else
+          XtAppAddInput (si->app, fd, (XtPointer) XtInputReadMask,
+                         evdev_inotify_cb, (XtPointer) si);
+      }
+  }
+# endif /* HAVE_SYS_INOTIFY_H */
+}
+
+#endif /* HAVE_LINUX_INPUT_H */
+
 
 /* This timer goes off every few minutes, whether the user is idle or not,
    to try and clean up anything that has gone wrong.
@@ -1574,14 +2182,14 @@ reset_watchdog_timer (saver_info *si, Bool on_p)
 
   if (si->watchdog_id)
     {
-      XtRemoveTimeOut (si->watchdog_id);
+      saver_remove_timeout (si, si->watchdog_id);
       si->watchdog_id = 0;
     }
 
   if (on_p && p->watchdog_timeout)
     {
-      si->watchdog_id = XtAppAddTimeOut (si->app, p->watchdog_timeout,
-					 watchdog_timer, (XtPointer) si);
+      si->watchdog_id = saver_add_timeout (si, p->watchdog_timeout,
+					   watchdog_timer, (XtPointer) si);
 
       if (p->debug_p)
 	fprintf (stderr, "%s: restarting watchdog_timer (%ld, %ld)\n",
@@ -1671,7 +2279,7 @@ de_race_timer (XtPointer closure, XtIntervalId *id)
     }
   else
     {
-      si->de_race_id = XtAppAddTimeOut (si->app, secs * 1000,
-                                        de_race_timer, closure);
+      si->de_race_id = saver_add_timeout (si, secs * 1000,
+                                          de_race_timer, closure);
     }
 }
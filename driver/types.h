@@ -93,6 +93,8 @@ struct saver_preferences {
   Bool capture_stderr_p;	/* whether to redirect stdout/stderr  */
   Bool ignore_uninstalled_p;	/* whether to avoid displaying or complaining
                                    about hacks that are not on $PATH */
+  Bool warm_launch_p;		/* whether to start the next hack before
+                                   the cycle timer goes off */
   Bool debug_p;			/* pay no mind to the man behind the curtain */
   Bool xsync_p;			/* whether XSynchronize has been called */
 
@@ -119,6 +121,8 @@ struct saver_preferences {
 
   int nice_inferior;		/* nice value for subprocs */
   int inferior_memory_limit;	/* setrlimit(LIMIT_AS) value for subprocs */
+  int load_budget;		/* percent of a CPU a subproc may use, or 0 */
+  double render_scale;		/* how much smaller GL subprocs should draw */
 
   Time initial_delay;		/* how long to sleep after launch */
   Time splash_duration;		/* how long the splash screen stays up */
@@ -186,7 +190,9 @@ struct saver_info {
   saver_screen_info *screens;
   saver_screen_info *default_screen;	/* ...on which dialogs will appear. */
   monitor **monitor_layout;		/* private to screens.c */
-  Visual **best_gl_visuals;		/* visuals for GL hacks on screen N */
+  struct gl_probe *gl_probes;		/* GL visuals of X screen N; these
+					   are private to subprocs.c */
+  struct hack_catalogue *catalogue;	/* private to subprocs.c */
 
   /* =======================================================================
      global connection info
@@ -203,6 +209,7 @@ struct saver_info {
   Bool using_mit_saver_extension;  /* Note that `p->use_*' is the *request*, */
   Bool using_sgi_saver_extension;  /* and `si->using_*' is the *reality*.    */
   Bool using_proc_interrupts;
+  Bool using_evdev;		   /* /dev/input, in place of /proc/interrupts */
 
 # ifdef HAVE_MIT_SAVER_EXTENSION
   int mit_saver_ext_event_number;
@@ -230,6 +237,11 @@ struct saver_info {
   int num_xinput_devices;
 # endif
 
+  Bool using_xinput2;		   /* XI2 raw events instead of window scan */
+#ifdef HAVE_XINPUT2
+  int xinput2_opcode;
+#endif
+
   /* =======================================================================
      blanking
      ======================================================================= */
@@ -315,9 +327,23 @@ struct saver_info {
   XtIntervalId watchdog_id;	/* Timer to implement `prefs.watchdog */
   XtIntervalId check_pointer_timer_id;	/* `prefs.pointer_timeout' */
 
+  XtIntervalId warm_id;		/* Timer to start or park the next hacks */
+  XtIntervalId fade_id;		/* Timer to step `fade' */
+  XtIntervalId layout_id;	/* Timer to coalesce RANDR events */
+  XtIntervalId govern_id;	/* Timer to implement `prefs.load_budget' */
+  char **heavy_hacks;		/* Commands that went over that budget */
+  int nheavy_hacks;
+  struct fade_state *fade;	/* The fade in progress, if any */
+  Bool fading_out_p;		/* Whether that is a fade to black */
   XtIntervalId de_race_id;	/* Timer to make sure screen un-blanks */
   int de_race_ticks;
 
+  struct saver_timer *timer_queue;	/* All of the above, by deadline; */
+  XtIntervalId timer_queue_id;		/* the one Xt timer that serves them. */
+  unsigned long timer_serial;
+  int timer_wakeups;			/* For the wakeups-per-minute count. */
+  time_t timer_wakeups_since;
+
   time_t last_activity_time;		   /* Used only when no server exts. */
   time_t last_wall_clock_time;             /* Used to detect laptop suspend. */
   saver_screen_info *last_activity_screen;
@@ -362,6 +388,8 @@ struct saver_screen_info {
 
   int x, y, width, height;	/* The size and position of this rectangle
                                    on its underlying X screen. */
+  Bool layout_changed_p;	/* Whether the last update_screen_layout()
+                                   moved or resized this rectangle. */
 
   Bool real_screen_p;		/* This will be true of exactly one ssi per
                                    X screen. */
@@ -428,6 +456,20 @@ struct saver_screen_info {
 
   int current_hack;		/* Index into `prefs.screenhacks' */
   pid_t pid;
+  Window hack_window;		/* If the hack was started ahead of time, the
+				   child of screensaver_window that it draws
+				   on; else 0, and it draws on that window. */
+  Colormap hack_cmap;
+
+  int warm_hack;		/* The next hack, started ahead of time and */
+  pid_t warm_pid;		/* parked in this unmapped window until the */
+  Window warm_window;		/* cycle timer goes off.  See subprocs.c. */
+  Colormap warm_cmap;
+
+  pid_t load_pid;		/* The hack that the load governor last */
+  unsigned long load_ticks;	/* looked at, the CPU time it had used, */
+  double load_time;		/* when, and how many times in a row it */
+  int load_strikes;		/* was over `prefs.load_budget'. */
 
   int stderr_text_x;
   int stderr_text_y;
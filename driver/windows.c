@@ -865,6 +865,7 @@ saver_exit (saver_info *si, int status, const char *dump_core_reason)
 
   exiting = True;
   
+  finish_fade (si);   /* don't leave the screen dimmed */
   vrs = restore_real_vroot (si);
   emergency_kill_subproc (si);
   shutdown_stderr (si);
@@ -1373,6 +1374,7 @@ initialize_screensaver_window (saver_info *si)
    the size of the screen has changed while the screen was blanked.
    Call update_screen_layout() first, then call this to synchronize
    the size of the saver windows to the new sizes of the screens.
+   Screens whose monitors didn't change are left alone, hacks and all.
  */
 void
 resize_screensaver_window (saver_info *si)
@@ -1385,6 +1387,9 @@ resize_screensaver_window (saver_info *si)
       saver_screen_info *ssi = &si->screens[i];
       XWindowAttributes xgwa;
 
+      if (! ssi->layout_changed_p && ssi->screensaver_window)
+        continue;
+
       /* Make sure a window exists -- it might not if a monitor was just
          added for the first time.
        */
@@ -1428,6 +1433,15 @@ resize_screensaver_window (saver_info *si)
             fprintf (stderr, "%s: %d: someone horked our saver window"
                      " (0x%lx)!  Unable to resize it!\n",
                      blurb(), i, (unsigned long) ssi->screensaver_window);
+
+          /* Hacks that were started ahead of time have windows of their
+             own on top of the saver window. */
+          if (ssi->hack_window)
+            XResizeWindow (si->dpy, ssi->hack_window,
+                           ssi->width, ssi->height);
+          if (ssi->warm_window)
+            XResizeWindow (si->dpy, ssi->warm_window,
+                           ssi->width, ssi->height);
         }
 
       /* Now (if blanked) make sure that it's mapped and running a hack --
@@ -1476,6 +1490,84 @@ resize_screensaver_window (saver_info *si)
 }
 
 
+/* What raise_window() does once the saver windows are up.
+ */
+static void
+windows_raised (saver_info *si)
+{
+  int i;
+  for (i = 0; i < si->nscreens; i++)
+    {
+      saver_screen_info *ssi = &si->screens[i];
+#ifdef HAVE_MIT_SAVER_EXTENSION
+      if (ssi->server_mit_saver_window &&
+          window_exists_p (si->dpy, ssi->server_mit_saver_window))
+        XUnmapWindow (si->dpy, ssi->server_mit_saver_window);
+#endif /* HAVE_MIT_SAVER_EXTENSION */
+      if (ssi->cmap)
+	XInstallColormap (si->dpy, ssi->cmap);
+    }
+}
+
+
+/* Steps the fade started by raise_window() or unblank_screen().  When a
+   fade to black is done, fade_finish() has mapped the saver windows, so
+   this starts the hacks that spawn_screenhack() held back.
+ */
+static void
+fade_timer (XtPointer closure, XtIntervalId *id)
+{
+  saver_info *si = (saver_info *) closure;
+  unsigned long msecs;
+  Bool out_p;
+  int i;
+
+  si->fade_id = 0;
+  if (!si->fade) return;
+
+  msecs = fade_step (si->fade);
+  if (msecs)
+    {
+      si->fade_id = saver_add_timeout (si, msecs, fade_timer, (XtPointer) si);
+      return;
+    }
+
+  out_p = si->fading_out_p;
+  finish_fade (si);
+  if (!out_p) return;
+
+  windows_raised (si);
+  if (si->screen_blanked_p && !si->throttled_p)
+    for (i = 0; i < si->nscreens; i++)
+      if (!si->screens[i].pid)
+        spawn_screenhack (&si->screens[i]);
+}
+
+
+/* Skips to the end of the fade in progress, if any.  For a fade to black,
+   that maps the saver windows, but it's up to the caller to start hacks.
+ */
+void
+finish_fade (saver_info *si)
+{
+  Bool out_p = si->fading_out_p;
+  if (si->fade_id)
+    {
+      saver_remove_timeout (si, si->fade_id);
+      si->fade_id = 0;
+    }
+  si->fading_out_p = False;
+  if (si->fade)
+    {
+      fade_finish (si->fade);
+      si->fade = 0;
+      if (si->prefs.verbose_p)
+        fprintf (stderr, "%s: %s done.\n", blurb(),
+                 (out_p ? "fading" : "unfading"));
+    }
+}
+
+
 void 
 raise_window (saver_info *si,
 	      Bool inhibit_fade, Bool between_hacks_p, Bool dont_clear)
@@ -1483,6 +1575,14 @@ raise_window (saver_info *si,
   saver_preferences *p = &si->prefs;
   int i;
 
+  /* If we're still fading out, the windows will go up when that's done. */
+  if (si->fading_out_p && inhibit_fade)
+    return;
+
+  /* If we're blanking again before the last unfade finished, put the
+     gamma back first, so that it's what gets saved and faded out. */
+  finish_fade (si);
+
   if (si->demoing_p)
     inhibit_fade = True;
 
@@ -1516,8 +1616,6 @@ raise_window (saver_info *si,
 
       if (p->verbose_p) fprintf (stderr, "%s: fading...\n", blurb());
 
-      XGrabServer (si->dpy);			/* ############ DANGER! */
-
       /* Clear the stderr layer on each screen.
        */
       if (!dont_clear)
@@ -1530,6 +1628,25 @@ raise_window (saver_info *si,
 	      clear_stderr (ssi);
 	  }
 
+      /* If we can do it by fading the gamma, do it from a timer, as with
+         the unfade: then the server isn't grabbed for several seconds,
+         and activity during the fade is noticed as soon as it happens.
+         fade_timer() raises the windows and starts the hacks at the end.
+       */
+      si->fade = fade_start (si->dpy, current_windows, si->nscreens,
+                             p->fade_seconds/1000, p->fade_ticks,
+                             True, !dont_clear);
+      if (si->fade)
+        {
+          free(current_maps);
+          free(current_windows);
+          si->fading_out_p = True;
+          fade_timer ((XtPointer) si, 0);
+          return;
+        }
+
+      XGrabServer (si->dpy);			/* ############ DANGER! */
+
       /* Note!  The server is grabbed, and this will take several seconds
 	 to complete! */
       fade_screens (si->dpy, current_maps,
@@ -1543,16 +1660,6 @@ raise_window (saver_info *si,
 
       if (p->verbose_p) fprintf (stderr, "%s: fading done.\n", blurb());
 
-#ifdef HAVE_MIT_SAVER_EXTENSION
-      for (i = 0; i < si->nscreens; i++)
-	{
-	  saver_screen_info *ssi = &si->screens[i];
-	  if (ssi->server_mit_saver_window &&
-	      window_exists_p (si->dpy, ssi->server_mit_saver_window))
-	    XUnmapWindow (si->dpy, ssi->server_mit_saver_window);
-	}
-#endif /* HAVE_MIT_SAVER_EXTENSION */
-
       XUngrabServer (si->dpy);
       XSync (si->dpy, False);			/* ###### (danger over) */
     }
@@ -1566,20 +1673,10 @@ raise_window (saver_info *si,
 	  if (!dont_clear || ssi->stderr_overlay_window)
 	    clear_stderr (ssi);
 	  XMapRaised (si->dpy, ssi->screensaver_window);
-#ifdef HAVE_MIT_SAVER_EXTENSION
-	  if (ssi->server_mit_saver_window &&
-	      window_exists_p (si->dpy, ssi->server_mit_saver_window))
-	    XUnmapWindow (si->dpy, ssi->server_mit_saver_window);
-#endif /* HAVE_MIT_SAVER_EXTENSION */
 	}
     }
 
-  for (i = 0; i < si->nscreens; i++)
-    {
-      saver_screen_info *ssi = &si->screens[i];
-      if (ssi->cmap)
-	XInstallColormap (si->dpy, ssi->cmap);
-    }
+  windows_raised (si);
 }
 
 
@@ -1697,6 +1794,10 @@ unblank_screen (saver_info *si)
   Bool unfade_p = (si->fading_possible_p && p->unfade_p);
   int i;
 
+  /* Activity during the fade to black: put the gamma back first, so
+     that it's what gets saved and faded in. */
+  finish_fade (si);
+
   monitor_power_on (si, True);
   reset_watchdog_timer (si, False);
 
@@ -1736,15 +1837,28 @@ unblank_screen (saver_info *si)
       XUngrabServer (si->dpy);
       XSync (si->dpy, False);			/* ###### (danger over) */
 
-      fade_screens (si->dpy, 0,
-                    current_windows, si->nscreens,
-		    p->fade_seconds/1000, p->fade_ticks,
-		    False, False);
+      /* If we can do it by fading the gamma, do it from a timer, so that
+         the desktop is usable while it fades in, instead of us sitting
+         here ignoring everything for several seconds.  (This snaps the
+         hack to black first, rather than fading it out.)
+       */
+      si->fade = fade_start (si->dpy, current_windows, si->nscreens,
+                             p->fade_seconds/1000, p->fade_ticks,
+                             False, False);
+      if (si->fade)
+        fade_timer ((XtPointer) si, 0);
+      else
+        {
+          fade_screens (si->dpy, 0,
+                        current_windows, si->nscreens,
+                        p->fade_seconds/1000, p->fade_ticks,
+                        False, False);
+          if (p->verbose_p)
+            fprintf (stderr, "%s: unfading done.\n", blurb());
+        }
 
       free(current_windows);
       current_windows = 0;
-
-      if (p->verbose_p) fprintf (stderr, "%s: unfading done.\n", blurb());
     }
   else
     {
@@ -1802,6 +1916,8 @@ unblank_screen (saver_info *si)
   for (i = 0; i < si->nscreens; i++)
     XUnmapWindow (si->dpy, si->screens[i].screensaver_window);
 
+  discard_warm_screenhacks (si);
+
   si->screen_blanked_p = False;
   si->blank_time = time ((time_t *) 0);
   si->last_wall_clock_time = 0;
@@ -1850,54 +1966,17 @@ maybe_transfer_grabs (saver_screen_info *ssi,
 }
 
 
-static Visual *
-get_screen_gl_visual (saver_info *si, int real_screen_number)
-{
-  int i;
-  int nscreens = ScreenCount (si->dpy);
-
-  if (! si->best_gl_visuals)
-    si->best_gl_visuals = (Visual **) 
-      calloc (nscreens + 1, sizeof (*si->best_gl_visuals));
-
-  for (i = 0; i < nscreens; i++)
-    if (! si->best_gl_visuals[i])
-      si->best_gl_visuals[i] = 
-        get_best_gl_visual (si, ScreenOfDisplay (si->dpy, i));
-
-  if (real_screen_number < 0 || real_screen_number >= nscreens) abort();
-  return si->best_gl_visuals[real_screen_number];
-}
-
-
-Bool
-select_visual (saver_screen_info *ssi, const char *visual_name)
+/* Returns the visual that select_visual() would use for the given name,
+   or 0 if there isn't one, without changing any windows.  Sets
+   *install_cmap_p if the name says to use, or not use, a private colormap.
+ */
+Visual *
+find_visual (saver_screen_info *ssi, const char *visual_name,
+             Bool *install_cmap_p)
 {
-  XWindowAttributes xgwa;
   saver_info *si = ssi->global;
   saver_preferences *p = &si->prefs;
-  Bool install_cmap_p = p->install_cmap_p;
-  Bool was_installed_p = (ssi->cmap != DefaultColormapOfScreen(ssi->screen));
   Visual *new_v = 0;
-  Bool got_it;
-
-  /* On some systems (most recently, MacOS X) OpenGL programs get confused
-     when you kill one and re-start another on the same window.  So maybe
-     it's best to just always destroy and recreate the xscreensaver window
-     when changing hacks, instead of trying to reuse the old one?
-   */
-  Bool always_recreate_window_p = True;
-
-  get_screen_gl_visual (si, 0);   /* let's probe all the GL visuals early */
-
-  /* We make sure the existing window is actually on ssi->screen before
-     trying to use it, in case things moved around radically when monitors
-     were added or deleted.  If we don't do this we could get a BadMatch
-     even though the depths match.  I think.
-   */
-  memset (&xgwa, 0, sizeof(xgwa));
-  if (ssi->screensaver_window)
-    XGetWindowAttributes (si->dpy, ssi->screensaver_window, &xgwa);
 
   if (visual_name && *visual_name)
     {
@@ -1907,20 +1986,20 @@ select_visual (saver_screen_info *ssi, const char *visual_name)
           )
 	{
 	  visual_name = "default";
-	  install_cmap_p = True;
+	  if (install_cmap_p) *install_cmap_p = True;
 	}
       else if (!strcmp(visual_name, "default-n") ||
                !strcmp(visual_name, "Default-n") ||
                !strcmp(visual_name, "Default-N"))
 	{
 	  visual_name = "default";
-	  install_cmap_p = False;
+	  if (install_cmap_p) *install_cmap_p = False;
 	}
       else if (!strcmp(visual_name, "gl") ||
                !strcmp(visual_name, "Gl") ||
                !strcmp(visual_name, "GL"))
         {
-          new_v = get_screen_gl_visual (si, ssi->real_screen_number);
+          new_v = get_best_gl_visual (ssi);
           if (!new_v && p->verbose_p)
             fprintf (stderr, "%s: no GL visuals.\n", progname);
         }
@@ -1933,6 +2012,41 @@ select_visual (saver_screen_info *ssi, const char *visual_name)
       new_v = ssi->default_visual;
     }
 
+  return new_v;
+}
+
+
+Bool
+select_visual (saver_screen_info *ssi, const char *visual_name)
+{
+  XWindowAttributes xgwa;
+  saver_info *si = ssi->global;
+  saver_preferences *p = &si->prefs;
+  Bool install_cmap_p = p->install_cmap_p;
+  Bool was_installed_p = (ssi->cmap != DefaultColormapOfScreen(ssi->screen));
+  Visual *new_v = 0;
+  Bool got_it;
+
+  /* On some systems (most recently, MacOS X) OpenGL programs get confused
+     when you kill one and re-start another on the same window.  So maybe
+     it's best to just always destroy and recreate the xscreensaver window
+     when changing hacks, instead of trying to reuse the old one?
+   */
+  Bool always_recreate_window_p = True;
+
+  start_gl_visual_probes (si);   /* let's probe all the GL visuals early */
+
+  /* We make sure the existing window is actually on ssi->screen before
+     trying to use it, in case things moved around radically when monitors
+     were added or deleted.  If we don't do this we could get a BadMatch
+     even though the depths match.  I think.
+   */
+  memset (&xgwa, 0, sizeof(xgwa));
+  if (ssi->screensaver_window)
+    XGetWindowAttributes (si->dpy, ssi->screensaver_window, &xgwa);
+
+  new_v = find_visual (ssi, visual_name, &install_cmap_p);
+
   got_it = !!new_v;
 
   if (new_v && new_v != DefaultVisualOfScreen(ssi->screen))
@@ -1999,3 +2113,65 @@ select_visual (saver_screen_info *ssi, const char *visual_name)
 
   return got_it;
 }
+
+
+/* Creates an unmapped window covering the saver window, as its child, for
+   a hack that is started before it is shown (see spawn_screenhack().)
+   Only TrueColor visuals are supported, since nothing will install the
+   colormap.  Returns 0 if the window can't be made.
+ */
+Window
+make_hack_window (saver_screen_info *ssi, Visual *visual, Colormap *cmap_ret)
+{
+  saver_info *si = ssi->global;
+  XSetWindowAttributes attrs;
+  unsigned long attrmask;
+  Colormap cmap;
+  XColor black;
+  Window w;
+
+  *cmap_ret = 0;
+  if (!ssi->screensaver_window ||
+      visual_class (ssi->screen, visual) != TrueColor)
+    return 0;
+
+  if (visual == DefaultVisualOfScreen (ssi->screen))
+    cmap = DefaultColormapOfScreen (ssi->screen);
+  else
+    cmap = XCreateColormap (si->dpy, RootWindowOfScreen (ssi->screen),
+                            visual, AllocNone);
+
+  black.red = black.green = black.blue = 0;
+  if (! XAllocColor (si->dpy, cmap, &black))
+    black.pixel = 0;
+
+  attrmask = (CWBackingStore | CWColormap | CWBackPixel | CWBorderPixel);
+  attrs.backing_store = NotUseful;
+  attrs.colormap = cmap;
+  attrs.background_pixel = black.pixel;
+  attrs.border_pixel = black.pixel;
+
+  w = XCreateWindow (si->dpy, ssi->screensaver_window,
+                     0, 0, ssi->width, ssi->height, 0,
+                     visual_depth (ssi->screen, visual), InputOutput,
+                     visual, attrmask, &attrs);
+  if (!si->demoing_p && ssi->cursor)
+    XDefineCursor (si->dpy, w, ssi->cursor);
+
+  *cmap_ret = cmap;
+  return w;
+}
+
+
+/* Destroys a window made by make_hack_window().  It's not an error if the
+   window is already gone, as it will be if the saver window was recreated.
+ */
+void
+destroy_hack_window (saver_screen_info *ssi, Window w, Colormap cmap)
+{
+  saver_info *si = ssi->global;
+  if (w)
+    safe_XDestroyWindow (si->dpy, w);
+  if (cmap && cmap != DefaultColormapOfScreen (ssi->screen))
+    XFreeColormap (si->dpy, cmap);
+}
@@ -886,7 +886,7 @@ initialize_per_screen_info (saver_info *si, Widget toplevel_shell)
         }
     }
 
-#ifdef HAVE_XF86VMODE_GAMMA
+#if defined(HAVE_XF86VMODE_GAMMA) || defined(HAVE_RANDR_12)
   si->fading_possible_p = True;  /* if we can gamma fade, go for it */
 #endif
 }
@@ -905,12 +905,14 @@ initialize_server_extensions (saver_info *si)
   Bool server_has_mit_saver_extension_p = False;
   Bool system_has_proc_interrupts_p = False;
   Bool server_has_xinput_extension_p = False;
+  Bool server_has_xinput2_p = False;
   const char *piwhy = 0;
 
   si->using_xidle_extension = p->use_xidle_extension;
   si->using_sgi_saver_extension = p->use_sgi_saver_extension;
   si->using_mit_saver_extension = p->use_mit_saver_extension;
   si->using_proc_interrupts = p->use_proc_interrupts;
+  si->using_evdev = False;
   si->using_xinput_extension = p->use_xinput_extension;
 
 #ifdef HAVE_XIDLE_EXTENSION
@@ -938,6 +940,9 @@ initialize_server_extensions (saver_info *si)
 #ifdef HAVE_XINPUT
   server_has_xinput_extension_p = query_xinput_extension (si);
 #endif
+#ifdef HAVE_XINPUT2
+  server_has_xinput2_p = query_xinput2_extension (si);
+#endif
 
   if (!server_has_xidle_extension_p)
     si->using_xidle_extension = False;
@@ -988,7 +993,11 @@ initialize_server_extensions (saver_info *si)
       for (i = 0; i < nscreens; i++)
 #  ifdef RRScreenChangeNotifyMask                 /* randr.h 1.5, 2002/09/29 */
         XRRSelectInput (si->dpy, RootWindow (si->dpy, i),
-                        RRScreenChangeNotifyMask);
+                        RRScreenChangeNotifyMask
+#   ifdef RRCrtcChangeNotifyMask                  /* randr.h 1.2, 2006 */
+                        | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask
+#   endif /* RRCrtcChangeNotifyMask */
+                        );
 #  else  /* !RRScreenChangeNotifyMask */          /* Xrandr.h 1.4, 2001/06/07 */
         XRRScreenChangeSelectInput (si->dpy, RootWindow (si->dpy, i), True);
 #  endif /* !RRScreenChangeNotifyMask */
@@ -1017,6 +1026,46 @@ initialize_server_extensions (saver_info *si)
     }
 #endif
 
+  /* XI2 raw events are only a replacement for selecting events on every
+     window, so don't bother with them if an idle extension is in use. */
+  si->using_xinput2 = (server_has_xinput2_p &&
+                       !(si->using_xidle_extension ||
+                         si->using_mit_saver_extension ||
+                         si->using_sgi_saver_extension));
+#ifdef HAVE_XINPUT2
+  if (si->using_xinput2)
+    {
+      init_xinput2_extension (si);
+      if (p->verbose_p)
+        fprintf (stderr, "%s: selecting XInput2 raw events.\n", blurb());
+    }
+#endif
+
+#ifdef HAVE_LINUX_INPUT_H
+  /* If we can read the input devices directly, /proc/interrupts is
+     redundant: it only knows about PS/2, and has to be polled.  But the
+     input devices only push back the idle timer, so they're useless if
+     the server is keeping track of idleness for us. */
+  if (p->use_proc_interrupts &&
+      !si->using_mit_saver_extension &&
+      !si->using_sgi_saver_extension)
+    {
+      const char *evwhy = 0;
+      if (query_evdev_available (si, &evwhy))
+        {
+          si->using_evdev = True;
+          system_has_proc_interrupts_p = False;
+          piwhy = 0;
+          init_evdev (si);
+          if (p->verbose_p)
+            fprintf (stderr, "%s: watching /dev/input for activity.\n",
+                     blurb());
+        }
+      else if (p->verbose_p && evwhy)
+        fprintf (stderr, "%s: not using /dev/input: %s.\n", blurb(), evwhy);
+    }
+#endif
+
   if (!system_has_proc_interrupts_p)
     {
       si->using_proc_interrupts = False;
@@ -1053,7 +1102,7 @@ debug_multiscreen_timer (XtPointer closure, XtIntervalId *id)
         }
       resize_screensaver_window (si);
     }
-  XtAppAddTimeOut (si->app, 1000*4, debug_multiscreen_timer, (XtPointer) si);
+  saver_add_timeout (si, 1000*4, debug_multiscreen_timer, (XtPointer) si);
 }
 #endif /* DEBUG_MULTISCREEN */
 
@@ -1072,7 +1121,8 @@ select_events (saver_info *si)
 
   if (si->using_xidle_extension ||
       si->using_mit_saver_extension ||
-      si->using_sgi_saver_extension)
+      si->using_sgi_saver_extension ||
+      si->using_xinput2)
     return;
 
   if (p->initial_delay)
@@ -1128,6 +1178,7 @@ maybe_reload_init_file (saver_info *si)
 		 blurb(), init_file_name());
 
       load_init_file (si->dpy, p);
+      invalidate_hack_catalogue (si);
 
       /* If a server extension is in use, and p->timeout has changed,
 	 we need to inform the server of the new timeout. */
@@ -1214,7 +1265,7 @@ main_loop (saver_info *si)
           if (p->verbose_p)
             fprintf (stderr, "%s: stopping de-race timer (%d remaining.)\n",
                      blurb(), si->de_race_ticks);
-          XtRemoveTimeOut (si->de_race_id);
+          saver_remove_timeout (si, si->de_race_id);
           si->de_race_id = 0;
         }
 
@@ -1287,13 +1338,13 @@ main_loop (saver_info *si)
 
       /* Don't start the cycle timer in demo mode. */
       if (!si->demoing_p && p->cycle)
-	si->cycle_id = XtAppAddTimeOut (si->app,
-                                        (si->selection_mode
-                                         /* see comment in cycle_timer() */
-                                         ? 1000 * 60 * 60
-                                         : p->cycle),
-                                        cycle_timer,
-					(XtPointer) si);
+	si->cycle_id = saver_add_timeout (si,
+                                          (si->selection_mode
+                                           /* see comment in cycle_timer() */
+                                           ? 1000 * 60 * 60
+                                           : p->cycle),
+                                          cycle_timer,
+					  (XtPointer) si);
 
 
 #ifndef NO_LOCKING
@@ -1328,9 +1379,9 @@ main_loop (saver_info *si)
         if (p->lock_p &&
             !si->locked_p &&
             lock_timeout > 0)
-          si->lock_id = XtAppAddTimeOut (si->app, lock_timeout,
-                                         activate_lock_timer,
-                                         (XtPointer) si);
+          si->lock_id = saver_add_timeout (si, lock_timeout,
+                                           activate_lock_timer,
+                                           (XtPointer) si);
       }
 #endif /* !NO_LOCKING */
 
@@ -1342,6 +1393,10 @@ main_loop (saver_info *si)
 	sleep_until_idle (si, False);		/* until not idle */
         check_for_leaks ("blanked B");
 
+        /* If that was during the fade to black, end it now, so that the
+           unlock dialog doesn't come up at a dimmed gamma. */
+        finish_fade (si);
+
 	maybe_reload_init_file (si);
 
 #ifndef NO_LOCKING
@@ -1374,7 +1429,7 @@ main_loop (saver_info *si)
                    had kicked in.  But DPMS is off now, so bring back the hack)
                  */
                 if (si->cycle_id)
-                  XtRemoveTimeOut (si->cycle_id);
+                  saver_remove_timeout (si, si->cycle_id);
                 si->cycle_id = 0;
                 cycle_timer ((XtPointer) si, 0);
               }
@@ -1410,13 +1465,13 @@ main_loop (saver_info *si)
 
       if (si->cycle_id)
 	{
-	  XtRemoveTimeOut (si->cycle_id);
+	  saver_remove_timeout (si, si->cycle_id);
 	  si->cycle_id = 0;
 	}
 
       if (si->lock_id)
 	{
-	  XtRemoveTimeOut (si->lock_id);
+	  saver_remove_timeout (si, si->lock_id);
 	  si->lock_id = 0;
 	}
 
@@ -1502,6 +1557,7 @@ main (int argc, char **argv)
   load_init_file(si->dpy, p); /* must be before initialize_per_screen_info() */
   blurb_timestamp_p = p->timestamp_p;  /* kludge */
   initialize_per_screen_info (si, shell); /* also sets si->fading_possible_p */
+  start_gl_visual_probes (si);	/* in the background */
 
   /* We can only issue this warning now. */
   if (p->verbose_p && !si->fading_possible_p && (p->fade_p || p->unfade_p))
@@ -1858,7 +1914,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
 	  si->throttled_p = False;
 
 	  if (si->cycle_id)
-	    XtRemoveTimeOut (si->cycle_id);
+	    saver_remove_timeout (si, si->cycle_id);
 	  si->cycle_id = 0;
 	  cycle_timer ((XtPointer) si, 0);
 	  return False;
@@ -1884,7 +1940,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
       if (! until_idle_p)
 	{
 	  if (si->cycle_id)
-	    XtRemoveTimeOut (si->cycle_id);
+	    saver_remove_timeout (si, si->cycle_id);
 	  si->cycle_id = 0;
 	  cycle_timer ((XtPointer) si, 0);
 	}
@@ -1920,7 +1976,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
       if (! until_idle_p)
 	{
 	  if (si->cycle_id)
-	    XtRemoveTimeOut (si->cycle_id);
+	    saver_remove_timeout (si, si->cycle_id);
 	  si->cycle_id = 0;
 	  cycle_timer ((XtPointer) si, 0);
 	}
@@ -2050,7 +2106,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
 
 	  if (si->lock_id)	/* we're doing it now, so lose the timeout */
 	    {
-	      XtRemoveTimeOut (si->lock_id);
+	      saver_remove_timeout (si, si->lock_id);
 	      si->lock_id = 0;
 	    }
 
@@ -2096,7 +2152,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
           if (! until_idle_p)
             {
               if (si->cycle_id)
-                XtRemoveTimeOut (si->cycle_id);
+                saver_remove_timeout (si, si->cycle_id);
               si->cycle_id = 0;
               cycle_timer ((XtPointer) si, 0);
             }
@@ -2122,7 +2178,7 @@ handle_clientmessage (saver_info *si, XEvent *event, Bool until_idle_p)
           if (! until_idle_p)
             {
               if (si->cycle_id)
-                XtRemoveTimeOut (si->cycle_id);
+                saver_remove_timeout (si, si->cycle_id);
               si->cycle_id = 0;
               cycle_timer ((XtPointer) si, 0);
             }
@@ -46,11 +46,21 @@ extern Bool ensure_no_screensaver_running (Display *, Screen *);
 extern Bool query_proc_interrupts_available (saver_info *, const char **why);
 #endif
 
+#ifdef HAVE_LINUX_INPUT_H
+extern Bool query_evdev_available (saver_info *, const char **why);
+extern void init_evdev (saver_info *);
+#endif
+
 #ifdef HAVE_XINPUT
 extern Bool query_xinput_extension (saver_info *);
 extern void init_xinput_extension (saver_info *si);
 #endif
 
+#ifdef HAVE_XINPUT2
+extern Bool query_xinput2_extension (saver_info *);
+extern void init_xinput2_extension (saver_info *);
+#endif
+
 /* Display Power Management System (DPMS) interface. */
 extern Bool monitor_powered_on_p (saver_info *si);
 extern void monitor_power_on (saver_info *si, Bool on_p);
@@ -130,6 +140,14 @@ extern void idle_timer (XtPointer si, XtIntervalId *id);
 extern void de_race_timer (XtPointer si, XtIntervalId *id);
 extern void sleep_until_idle (saver_info *si, Bool until_idle_p);
 extern void reset_timers (saver_info *si);
+extern XtIntervalId saver_add_timeout (saver_info *, unsigned long msecs,
+                                       void (*) (XtPointer, XtIntervalId *),
+                                       XtPointer);
+extern void saver_remove_timeout (saver_info *, XtIntervalId);
+extern double timer_wakeups_per_minute (saver_info *, Bool reset_p);
+#ifdef HAVE_RANDR
+extern Bool handle_randr_event (saver_info *, XEvent *);
+#endif /* HAVE_RANDR */
 extern void schedule_wakeup_event (saver_info *si, Time when, Bool verbose_p);
 
 
@@ -152,7 +170,8 @@ extern void handle_signals (saver_info *si);
 #endif /* !HAVE_SIGACTION */
 extern void unblock_sigchld (void);
 extern void hack_environment (saver_info *si);
-extern void hack_subproc_environment (Screen *, Window saver_window);
+extern void hack_subproc_environment (Screen *, Window saver_window,
+                                      double render_scale);
 extern void init_sigchld (void);
 extern void spawn_screenhack (saver_screen_info *ssi);
 extern pid_t fork_and_exec (saver_screen_info *ssi, const char *command);
@@ -161,6 +180,15 @@ extern void suspend_screenhack (saver_screen_info *ssi, Bool suspend_p);
 extern Bool screenhack_running_p (saver_info *si);
 extern void emergency_kill_subproc (saver_info *si);
 extern Bool select_visual (saver_screen_info *ssi, const char *visual_name);
+extern Visual *find_visual (saver_screen_info *ssi, const char *visual_name,
+                            Bool *install_cmap_p);
+extern void invalidate_hack_catalogue (saver_info *si);
+extern void discard_warm_screenhacks (saver_info *si);
+extern void finish_fade (saver_info *si);
+extern Window make_hack_window (saver_screen_info *ssi, Visual *visual,
+                                Colormap *cmap_ret);
+extern void destroy_hack_window (saver_screen_info *ssi, Window w,
+                                 Colormap cmap);
 extern void store_saver_status (saver_info *si);
 extern const char *signal_name (int signal);
 
@@ -192,7 +220,8 @@ extern Bool window_exists_p (Display *dpy, Window window);
 extern Bool in_signal_handler_p;
 extern char *timestring (void);
 extern Bool display_is_on_console_p (saver_info *si);
-extern Visual *get_best_gl_visual (saver_info *si, Screen *screen);
+extern void start_gl_visual_probes (saver_info *si);
+extern Visual *get_best_gl_visual (saver_screen_info *ssi);
 extern void check_for_leaks (const char *where);
 extern void describe_monitor_layout (saver_info *si);
 
@@ -241,6 +241,71 @@ close_xinput_extension (saver_info *si)
 #endif
 #endif /* HAVE_XINPUT */
 
+
+#ifdef HAVE_XINPUT2
+/* XInput2 raw events.
+
+   Raw events are selected once, on the root window, and are delivered
+   for every key press, button press and motion on any device, regardless
+   of which window has focus or what it has selected.  So when this is
+   available we don't need to walk the window tree selecting KeyPress on
+   every window (and every new window), and unlike that scheme, we also
+   notice mouse clicks and scroll wheels.
+ */
+
+# include <X11/extensions/XInput2.h>
+
+Bool
+query_xinput2_extension (saver_info *si)
+{
+  int ev, err;
+  int major = 2, minor = 1;
+  if (! XQueryExtension (si->dpy, "XInputExtension", &si->xinput2_opcode,
+                         &ev, &err))
+    return False;
+
+  /* Before 2.1, raw events are not delivered while some other client has
+     the keyboard or mouse grabbed.  Ask for 2.1; a 2.0 server answers
+     with 2.0, but an older libXi may refuse outright, so try again. */
+  if (XIQueryVersion (si->dpy, &major, &minor) != Success)
+    {
+      major = 2;
+      minor = 0;
+      if (XIQueryVersion (si->dpy, &major, &minor) != Success)
+        return False;
+    }
+  if (si->prefs.verbose_p && major == 2 && minor < 1)
+    fprintf (stderr, "%s: XInput %d.%d: activity during grabs is missed\n",
+             blurb(), major, minor);
+  return (major >= 2);
+}
+
+void
+init_xinput2_extension (saver_info *si)
+{
+  unsigned char mask[XIMaskLen (XI_LASTEVENT)];
+  XIEventMask evmask;
+  int i;
+
+  memset (mask, 0, sizeof(mask));
+  XISetMask (mask, XI_RawKeyPress);
+  XISetMask (mask, XI_RawButtonPress);
+  XISetMask (mask, XI_RawMotion);
+
+  evmask.deviceid = XIAllMasterDevices;
+  evmask.mask_len = sizeof(mask);
+  evmask.mask = mask;
+
+  for (i = 0; i < si->nscreens; i++)
+    {
+      saver_screen_info *ssi = &si->screens[i];
+      if (ssi->real_screen_p)
+        XISelectEvents (si->dpy, RootWindowOfScreen (ssi->screen),
+                        &evmask, 1);
+    }
+}
+#endif /* HAVE_XINPUT2 */
+
 
 /* SGI SCREEN_SAVER server extension hackery.
  */
@@ -76,6 +76,14 @@
 #include "grabscreen.h"
 #include "visual.h"
 
+/* SSE2 is part of the baseline x86-64 instruction set, so there is nothing
+   to probe for at runtime: if the compiler targets it, every CPU that can
+   run the binary has it. */
+#if defined(__SSE2__) && !defined(ANALOGTV_NO_SSE2)
+# define ANALOGTV_SSE2
+# include <emmintrin.h>
+#endif
+
 /* #define DEBUG 1 */
 
 #if defined(DEBUG) && (defined(__linux) || defined(__FreeBSD__))
@@ -422,6 +430,25 @@ analogtv_reconfigure(analogtv *it)
 /* Can be any power-of-two <= 32. 16 a slightly better choice for 2-3 threads. */
 #define ANALOGTV_SUBTOTAL_LEN 32
 
+/* analogtv_add_signal looks this many input samples back for the ghosting
+   FIR. */
+#define ANALOGTV_MIX_HISTORY 16
+#define ANALOGTV_MIX_SPAN (ANALOGTV_MIX_HISTORY + ANALOGTV_H)
+
+struct analogtv_mix_key_s {
+  const analogtv_input *input;
+  unsigned ofs;
+  double level, hfloss;
+  double ghostfir[ANALOGTV_GHOSTFIR_LEN];
+};
+
+struct analogtv_mix_line_s {
+  int valid;
+  unsigned rec_count, rec_alloc;
+  struct analogtv_mix_key_s *keys;  /* [rec_alloc] */
+  signed char *samples;             /* [rec_alloc][ANALOGTV_MIX_SPAN] */
+};
+
 typedef struct analogtv_thread_s
 {
   analogtv *it;
@@ -479,6 +506,7 @@ analogtv_allocate(Display *dpy, Window window)
   if (!it) return 0;
   it->threads.count=0;
   it->rx_signal=NULL;
+  it->rx_mix=NULL;
   it->signal_subtotals=NULL;
 
   it->dpy=dpy;
@@ -488,6 +516,15 @@ analogtv_allocate(Display *dpy, Window window)
                     sizeof(it->rx_signal[0]) * rx_signal_len))
     goto fail;
 
+  if (thread_malloc((void **)&it->rx_mix, dpy,
+                    sizeof(it->rx_mix[0]) * ANALOGTV_SIGNAL_LEN))
+    goto fail;
+
+  it->mix_lines=(struct analogtv_mix_line_s *)
+    calloc(ANALOGTV_V, sizeof(*it->mix_lines));
+  if (!it->mix_lines)
+    goto fail;
+
   assert(!(ANALOGTV_SIGNAL_LEN % ANALOGTV_SUBTOTAL_LEN));
   if (thread_malloc((void **)&it->signal_subtotals, dpy,
                     sizeof(it->signal_subtotals[0]) *
@@ -584,6 +621,8 @@ analogtv_allocate(Display *dpy, Window window)
     if(it->threads.count)
       threadpool_destroy(&it->threads);
     thread_free(it->signal_subtotals);
+    free(it->mix_lines);
+    thread_free(it->rx_mix);
     thread_free(it->rx_signal);
     free(it);
   }
@@ -593,6 +632,8 @@ analogtv_allocate(Display *dpy, Window window)
 void
 analogtv_release(analogtv *it)
 {
+  int i;
+
   if (it->image) {
     if (it->use_shm) {
 #ifdef HAVE_XSHM_EXTENSION
@@ -610,6 +651,12 @@ analogtv_release(analogtv *it)
   if (it->n_colors) XFreeColors(it->dpy, it->colormap, it->colors, it->n_colors, 0L);
   it->n_colors=0;
   threadpool_destroy(&it->threads);
+  for (i=0; i<ANALOGTV_V; i++) {
+    free(it->mix_lines[i].keys);
+    free(it->mix_lines[i].samples);
+  }
+  free(it->mix_lines);
+  thread_free(it->rx_mix);
   thread_free(it->rx_signal);
   thread_free(it->signal_subtotals);
   free(it);
@@ -771,19 +818,22 @@ static void
 analogtv_ntsc_to_yiq(const analogtv *it, int lineno, const float *signal,
                      int start, int end, struct analogtv_yiq_s *it_yiq)
 {
-  enum {MAXDELAY=32};
   int i;
   const float *sp;
   int phasecorr=(signal-it->rx_signal)&3;
   struct analogtv_yiq_s *yiq;
-  int colormode;
   float agclevel=it->agclevel;
   float brightadd=it->brightness_control*100.0 - ANALOGTV_BLACK_LEVEL;
-  float delay[MAXDELAY+ANALOGTV_PIC_LEN], *dp;
-  float multiq2[4];
+  int colormode;
 
-  {
+  /* The demodulation matrix for this line: for each of the 4 phases of
+     the color subcarrier, the gain applied to the incoming sample before
+     it enters the Y, I and Q filters. The tint rotation is the same for
+     the whole frame, so only the colorburst part is worked out here. */
+  float phasecoef[4][4];
 
+  {
+    float multiq2[4];
     double cb_i=(it->line_cb_phase[lineno][(2+phasecorr)&3]-
                  it->line_cb_phase[lineno][(0+phasecorr)&3])/16.0;
     double cb_q=(it->line_cb_phase[lineno][(3+phasecorr)&3]-
@@ -792,98 +842,146 @@ analogtv_ntsc_to_yiq(const analogtv *it, int lineno, const float *signal,
     colormode = (cb_i * cb_i + cb_q * cb_q) > 2.8;
 
     if (colormode) {
-      double tint_i = -cos((103 + it->color_control)*3.1415926/180);
-      double tint_q = sin((103 + it->color_control)*3.1415926/180);
-
-      multiq2[0] = (cb_i*tint_i - cb_q*tint_q) * it->color_control;
-      multiq2[1] = (cb_q*tint_i + cb_i*tint_q) * it->color_control;
+      multiq2[0] = (cb_i*it->tint_i - cb_q*it->tint_q) * it->color_control;
+      multiq2[1] = (cb_q*it->tint_i + cb_i*it->tint_q) * it->color_control;
       multiq2[2]=-multiq2[0];
       multiq2[3]=-multiq2[1];
+    } else {
+      multiq2[0]=multiq2[1]=multiq2[2]=multiq2[3]=0.0f;
     }
-  }
 
-#if 0
-  if (lineno==100) {
-    printf("multiq = [%0.3f %0.3f %0.3f %0.3f] ",
-           it->multiq[60],it->multiq[61],it->multiq[62],it->multiq[63]);
-    printf("it->line_cb_phase = [%0.3f %0.3f %0.3f %0.3f]\n",
-           it->line_cb_phase[lineno][0],it->line_cb_phase[lineno][1],
-           it->line_cb_phase[lineno][2],it->line_cb_phase[lineno][3]);
-    printf("multiq2 = [%0.3f %0.3f %0.3f %0.3f]\n",
-           multiq2[0],multiq2[1],multiq2[2],multiq2[3]);
+    for (i=0; i<4; i++) {
+      phasecoef[i][0] = 0.0469904257251935f * agclevel;
+      phasecoef[i][1] = multiq2[i] * 0.0833333333333f;
+      phasecoef[i][2] = multiq2[(i+3)&3] * 0.0833333333333f;
+      phasecoef[i][3] = 0.0f;
+    }
   }
-#endif
-
-  dp=delay+ANALOGTV_PIC_LEN-MAXDELAY;
-  for (i=0; i<5; i++) dp[i]=0.0f;
 
   assert(start>=0);
   assert(end < ANALOGTV_PIC_LEN+10);
 
-  dp=delay+ANALOGTV_PIC_LEN-MAXDELAY;
-  for (i=0; i<24; i++) dp[i]=0.0;
-  for (i=start, yiq=it_yiq+start, sp=signal+start;
-       i<end;
-       i++, dp--, yiq++, sp++) {
-
-    /* Now filter them. These are infinite impulse response filters
-       calculated by the script at
-       http://www-users.cs.york.ac.uk/~fisher/mkfilter. This is
-       fixed-point integer DSP, son. No place for wimps. We do it in
-       integer because you can count on integer being faster on most
-       CPUs. We care about speed because we need to recalculate every
-       time we blink text, and when we spew random bytes into screen
-       memory. This is roughly 16.16 fixed point arithmetic, but we
-       scale some filter values up by a few bits to avoid some nasty
-       precision errors. */
-
-    /* Filter Y with a 4-pole low-pass Butterworth filter at 3.5 MHz
-       with an extra zero at 3.5 MHz, from
-       mkfilter -Bu -Lp -o 4 -a 2.1428571429e-01 0 -Z 2.5e-01 -l
-       Delay about 2 */
-
-    dp[0] = sp[0] * 0.0469904257251935f * agclevel;
-    dp[8] = (+1.0f*(dp[6]+dp[0])
-             +4.0f*(dp[5]+dp[1])
-             +7.0f*(dp[4]+dp[2])
-             +8.0f*(dp[3])
-             -0.0176648f*dp[12]
-             -0.4860288f*dp[10]);
-    yiq->y = dp[8] + brightadd;
-  }
-
-  if (colormode) {
+  /* Now filter them. These are infinite impulse response filters
+     calculated by the script at
+     http://www-users.cs.york.ac.uk/~fisher/mkfilter. This is
+     fixed-point integer DSP, son. No place for wimps. We do it in
+     integer because you can count on integer being faster on most
+     CPUs. We care about speed because we need to recalculate every
+     time we blink text, and when we spew random bytes into screen
+     memory. This is roughly 16.16 fixed point arithmetic, but we
+     scale some filter values up by a few bits to avoid some nasty
+     precision errors.
+
+     Y gets a 4-pole low-pass Butterworth filter at 3.5 MHz
+     with an extra zero at 3.5 MHz, from
+     mkfilter -Bu -Lp -o 4 -a 2.1428571429e-01 0 -Z 2.5e-01 -l
+     Delay about 2.
+
+     I and Q get a 3-pole low-pass Butterworth filter at
+     1.5 MHz with an extra zero at 3.5 MHz, from
+     mkfilter -Bu -Lp -o 3 -a 1.0714285714e-01 0 -Z 2.5000000000e-01 -l
+     Delay about 3.
+  */
+
+#ifdef ANALOGTV_SSE2
+  {
+    /* The three filters have the same shape (7 feed-forward taps, feedback
+       from 2 and 4 samples back) if the I/Q filter's missing taps are
+       treated as zero, so they run side by side in the lanes of one
+       vector: lane 0 is Y, lane 1 is I, lane 2 is Q, lane 3 is idle. */
+    const __m128 a0=_mm_setr_ps(1.0f, 1.0f, 1.0f, 0.0f);
+    const __m128 a1=_mm_setr_ps(4.0f, 3.0f, 3.0f, 0.0f);
+    const __m128 a2=_mm_setr_ps(7.0f, 4.0f, 4.0f, 0.0f);
+    const __m128 a3=_mm_setr_ps(8.0f, 4.0f, 4.0f, 0.0f);
+    const __m128 a4=_mm_setr_ps(7.0f, 3.0f, 3.0f, 0.0f);
+    const __m128 a5=_mm_setr_ps(4.0f, 1.0f, 1.0f, 0.0f);
+    const __m128 a6=_mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    const __m128 b2=_mm_setr_ps(-0.4860288f, -0.3333333333f,
+                                -0.3333333333f, 0.0f);
+    const __m128 b4=_mm_setr_ps(-0.0176648f, 0.0f, 0.0f, 0.0f);
+    const __m128 bright=_mm_setr_ps(brightadd, 0.0f, 0.0f, 0.0f);
+    __m128 coef[4];
+    __m128 x0, x1, x2, x3, x4, x5, x6;
+    __m128 y1, y2, y3, y4, out;
+
+    for (i=0; i<4; i++)
+      coef[i]=_mm_loadu_ps(phasecoef[i]);
+
+    x1=x2=x3=x4=x5=x6=_mm_setzero_ps();
+    y1=y2=y3=y4=_mm_setzero_ps();
+
+    for (i=start, yiq=it_yiq+start, sp=signal+start;
+         i<end;
+         i++, yiq++, sp++) {
+      x0=_mm_mul_ps(_mm_set1_ps(*sp), coef[i&3]);
+
+      out=_mm_add_ps(
+        _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x0, a0), _mm_mul_ps(x1, a1)),
+          _mm_add_ps(_mm_mul_ps(x2, a2), _mm_mul_ps(x3, a3))),
+        _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x4, a4), _mm_mul_ps(x5, a5)),
+          _mm_add_ps(_mm_mul_ps(x6, a6),
+                     _mm_add_ps(_mm_mul_ps(y2, b2), _mm_mul_ps(y4, b4)))));
+
+      x6=x5; x5=x4; x4=x3; x3=x2; x2=x1; x1=x0;
+      y4=y3; y3=y2; y2=y1; y1=out;
+
+      out=_mm_add_ps(out, bright);
+      _mm_store_ss(&yiq->y, out);
+      _mm_storel_pi((__m64 *)&yiq->i,
+                    _mm_shuffle_ps(out, out, _MM_SHUFFLE(3,3,2,1)));
+    }
+  }
+#else /* !ANALOGTV_SSE2 */
+  {
+    enum {MAXDELAY=32};
+    float delay[MAXDELAY+ANALOGTV_PIC_LEN], *dp;
+
     dp=delay+ANALOGTV_PIC_LEN-MAXDELAY;
-    for (i=0; i<27; i++) dp[i]=0.0;
+    for (i=0; i<27; i++) dp[i]=0.0f;
 
     for (i=start, yiq=it_yiq+start, sp=signal+start;
          i<end;
          i++, dp--, yiq++, sp++) {
-      float sig=*sp;
-
-      /* Filter I and Q with a 3-pole low-pass Butterworth filter at
-         1.5 MHz with an extra zero at 3.5 MHz, from
-         mkfilter -Bu -Lp -o 3 -a 1.0714285714e-01 0 -Z 2.5000000000e-01 -l
-         Delay about 3.
-      */
-
-      dp[0] = sig*multiq2[i&3] * 0.0833333333333f;
-      yiq->i=dp[8] = (dp[5] + dp[0]
-                      +3.0f*(dp[4] + dp[1])
-                      +4.0f*(dp[3] + dp[2])
-                      -0.3333333333f * dp[10]);
-
-      dp[16] = sig*multiq2[(i+3)&3] * 0.0833333333333f;
-      yiq->q=dp[24] = (dp[16+5] + dp[16+0]
-                       +3.0f*(dp[16+4] + dp[16+1])
-                       +4.0f*(dp[16+3] + dp[16+2])
-                       -0.3333333333f * dp[24+2]);
+      dp[0] = sp[0] * phasecoef[0][0];
+      dp[8] = (+1.0f*(dp[6]+dp[0])
+               +4.0f*(dp[5]+dp[1])
+               +7.0f*(dp[4]+dp[2])
+               +8.0f*(dp[3])
+               -0.0176648f*dp[12]
+               -0.4860288f*dp[10]);
+      yiq->y = dp[8] + brightadd;
     }
-  } else {
-    for (i=start, yiq=it_yiq+start; i<end; i++, yiq++) {
-      yiq->i = yiq->q = 0.0f;
+
+    if (colormode) {
+      dp=delay+ANALOGTV_PIC_LEN-MAXDELAY;
+      for (i=0; i<27; i++) dp[i]=0.0f;
+
+      for (i=start, yiq=it_yiq+start, sp=signal+start;
+           i<end;
+           i++, dp--, yiq++, sp++) {
+        float sig=*sp;
+
+        dp[0] = sig * phasecoef[i&3][1];
+        yiq->i=dp[8] = (dp[5] + dp[0]
+                        +3.0f*(dp[4] + dp[1])
+                        +4.0f*(dp[3] + dp[2])
+                        -0.3333333333f * dp[10]);
+
+        dp[16] = sig * phasecoef[i&3][2];
+        yiq->q=dp[24] = (dp[16+5] + dp[16+0]
+                         +3.0f*(dp[16+4] + dp[16+1])
+                         +4.0f*(dp[16+3] + dp[16+2])
+                         -0.3333333333f * dp[24+2]);
+      }
+    } else {
+      for (i=start, yiq=it_yiq+start; i<end; i++, yiq++) {
+        yiq->i = yiq->q = 0.0f;
+      }
     }
   }
+#endif /* !ANALOGTV_SSE2 */
 }
 
 void
@@ -1197,11 +1295,14 @@ static unsigned int rnd_seek(unsigned a, unsigned c, unsigned rnd, unsigned dist
   return a * rnd + c;
 }
 
+/* Fills in the received signal: noise, on top of the mixed receptions
+   from analogtv_thread_mix_lines(). */
 static void analogtv_init_signal(const analogtv *it, double noiselevel, unsigned start, unsigned end)
 {
   float *ps=it->rx_signal + start;
   float *pe=it->rx_signal + end;
   float *p=ps;
+  const float *mix=it->rx_mix + start;
   unsigned int fastrnd=rnd_seek(FASTRND_A, FASTRND_C, it->random0, start);
   unsigned int fastrnd_offset;
   float nm1,nm2;
@@ -1214,15 +1315,15 @@ static void analogtv_init_signal(const analogtv *it, double noiselevel, unsigned
     fastrnd = (fastrnd*FASTRND_A+FASTRND_C) & 0xffffffffu;
     fastrnd_offset = fastrnd - 0x7fffffff;
     nm1 = (fastrnd_offset <= INT_MAX ? (int)fastrnd_offset : -1 - (int)(UINT_MAX - fastrnd_offset)) * noisemul;
-    *p++ = nm1*nm2;
+    *p++ = nm1*nm2 + *mix++;
   }
 }
 
-static void analogtv_add_signal(const analogtv *it, const analogtv_reception *rec, unsigned start, unsigned end, int ec)
+static void analogtv_add_signal(const analogtv *it, float *rx, const analogtv_reception *rec, unsigned start, unsigned end, int ec)
 {
   analogtv_input *inp=rec->input;
-  float *ps=it->rx_signal + start;
-  float *pe=it->rx_signal + end;
+  float *ps=rx + start;
+  float *pe=rx + end;
   float *p=ps;
   signed char *ss=&inp->signal[0][0];
   signed char *se=&inp->signal[0][0] + ANALOGTV_SIGNAL_LEN;
@@ -1310,6 +1411,120 @@ static void analogtv_add_signal(const analogtv *it, const analogtv_reception *re
   assert(p == pe);
 }
 
+/*
+  Mixing the receptions together is most of the work of building the
+  received signal, and most of the time -- text screens, crash dumps, test
+  patterns -- the input lines haven't changed since the last frame. So the
+  mix is kept line by line in rx_mix, along with a copy of the input samples
+  and the reception parameters it was made from, and a line is only mixed
+  again when one of those has changed. Noise changes every frame, so it
+  goes on top later, in analogtv_init_signal.
+ */
+
+/* Updates the copy of the input samples in 'dst' that the line starting at
+   'pos' will be mixed from. Returns 1 if nothing changed. */
+static int
+analogtv_mix_sync_samples(const analogtv_input *inp, unsigned pos,
+                          signed char *dst)
+{
+  const signed char *src=&inp->signal[0][0];
+  unsigned n=ANALOGTV_MIX_SPAN;
+  int same=1;
+
+  pos %= ANALOGTV_SIGNAL_LEN;
+  while (n) {
+    unsigned len=ANALOGTV_SIGNAL_LEN - pos;
+    if (len > n) len=n;
+    if (memcmp(dst, src+pos, len)) {
+      memcpy(dst, src+pos, len);
+      same=0;
+    }
+    dst += len;
+    n -= len;
+    pos = 0;
+  }
+  return same;
+}
+
+static int
+analogtv_mix_sync_key(struct analogtv_mix_key_s *key,
+                      const analogtv_reception *rec)
+{
+  int same=(key->input == rec->input &&
+            key->ofs == (unsigned)rec->ofs &&
+            key->level == rec->level &&
+            key->hfloss == rec->hfloss &&
+            !memcmp(key->ghostfir, rec->ghostfir, sizeof(key->ghostfir)));
+
+  key->input=rec->input;
+  key->ofs=(unsigned)rec->ofs;
+  key->level=rec->level;
+  key->hfloss=rec->hfloss;
+  memcpy(key->ghostfir, rec->ghostfir, sizeof(key->ghostfir));
+  return same;
+}
+
+static void
+analogtv_mix_line(const analogtv *it, unsigned lineno)
+{
+  struct analogtv_mix_line_s *ml=&it->mix_lines[lineno];
+  unsigned start=lineno*ANALOGTV_H, end=start+ANALOGTV_H;
+  unsigned i;
+  /* The channel change transition is noise, not signal. */
+  int cacheable=!(it->rec_count && it->channel_change_cycles > start);
+  int same=ml->valid && ml->rec_count == it->rec_count;
+
+  if (it->rec_count > ml->rec_alloc) {
+    struct analogtv_mix_key_s *keys=(struct analogtv_mix_key_s *)
+      realloc(ml->keys, it->rec_count * sizeof(*keys));
+    signed char *samples;
+    if (keys) ml->keys=keys;
+    samples=(signed char *)
+      realloc(ml->samples, it->rec_count * ANALOGTV_MIX_SPAN);
+    if (samples) ml->samples=samples;
+    if (keys && samples) {
+      ml->rec_alloc=it->rec_count;
+    } else {
+      cacheable=0;
+    }
+    same=0;
+  }
+
+  if (cacheable) {
+    for (i=0; i!=it->rec_count; i++) {
+      const analogtv_reception *rec=it->recs[i];
+      if (!analogtv_mix_sync_key(&ml->keys[i], rec))
+        same=0;
+      if (!analogtv_mix_sync_samples(rec->input,
+                                     start + (unsigned)rec->ofs +
+                                     ANALOGTV_SIGNAL_LEN - ANALOGTV_MIX_HISTORY,
+                                     ml->samples + i*ANALOGTV_MIX_SPAN))
+        same=0;
+    }
+    if (same) return;
+  }
+
+  memset(it->rx_mix + start, 0, ANALOGTV_H * sizeof(it->rx_mix[0]));
+  for (i=0; i!=it->rec_count; i++) {
+    analogtv_add_signal(it, it->rx_mix, it->recs[i], start, end,
+                        !i ? it->channel_change_cycles : 0);
+  }
+
+  ml->valid=cacheable;
+  ml->rec_count=it->rec_count;
+}
+
+static void analogtv_thread_mix_lines(void *thread_raw)
+{
+  const analogtv_thread *thread = (analogtv_thread *)thread_raw;
+  const analogtv *it = thread->it;
+  unsigned lineno;
+
+  for (lineno=thread->thread_id; lineno<ANALOGTV_V;
+       lineno += it->threads.count)
+    analogtv_mix_line(it, lineno);
+}
+
 static void analogtv_thread_add_signals(void *thread_raw)
 {
   const analogtv_thread *thread = (analogtv_thread *)thread_raw;
@@ -1330,11 +1545,6 @@ static void analogtv_thread_add_signals(void *thread_raw)
 
     analogtv_init_signal (it, it->noiselevel, start, end);
 
-    for (i = 0; i != it->rec_count; ++i) {
-      analogtv_add_signal (it, it->recs[i], start, end,
-                           !i ? it->channel_change_cycles : 0);
-    }
-
     assert (!(start % ANALOGTV_SUBTOTAL_LEN));
     assert (!(end % ANALOGTV_SUBTOTAL_LEN));
 
@@ -1596,6 +1806,11 @@ static void analogtv_thread_draw_lines(void *thread_raw)
     }
 
     if (it->use_cmap) {
+      /* The demodulated line is the same for every screen row it covers;
+         only the level multipliers change. */
+      analogtv_ntsc_to_yiq(it, lineno, signal,
+                           (scanstart_i>>16)-10, (scanend_i>>16)+10, yiq);
+
       for (y=ytop; y<ybot; y++) {
         int level=analogtv_level(it, y, ytop, ybot);
         float levelmult=analogtv_levelmult(it, level);
@@ -1603,8 +1818,6 @@ static void analogtv_thread_draw_lines(void *thread_raw)
           * puramp(it, 1.0f, 0.0f, 1.0f) / (0.5f+0.5f*it->puheight) * 0.070f;
         float levelmult_iq = levelmult * 0.090f;
 
-        analogtv_ntsc_to_yiq(it, lineno, signal,
-                             (scanstart_i>>16)-10, (scanend_i>>16)+10, yiq);
         pixmultinc=pixrate;
 
         x=0;
@@ -1766,11 +1979,16 @@ analogtv_draw(analogtv *it, double noiselevel,
   analogtv_setup_frame(it);
   analogtv_set_demod(it);
 
+  it->tint_i = -cos((103 + it->color_control)*3.1415926/180);
+  it->tint_q = sin((103 + it->color_control)*3.1415926/180);
+
   it->random0 = random();
   it->random1 = random();
   it->noiselevel = noiselevel;
   it->recs = recs;
   it->rec_count = rec_count;
+  threadpool_run(&it->threads, analogtv_thread_mix_lines);
+  threadpool_wait(&it->threads);
   threadpool_run(&it->threads, analogtv_thread_add_signals);
   threadpool_wait(&it->threads);
 
@@ -217,6 +217,10 @@ typedef struct analogtv_s {
   double rx_signal_level;
   float *rx_signal;
 
+  /* The receptions mixed together before noise, cached line by line. */
+  float *rx_mix;
+  struct analogtv_mix_line_s *mix_lines;
+
   struct {
     int index;
     double value;
@@ -227,6 +231,7 @@ typedef struct analogtv_s {
   double noiselevel;
   const analogtv_reception *const *recs;
   unsigned rec_count;
+  float tint_i, tint_q;
 
   float *signal_subtotals;
 
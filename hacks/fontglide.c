@@ -1992,13 +1992,14 @@ fontglide_draw (Display *dpy, Window window, void *closure)
 static void
 drain_input (state *s)
 {
-  while (s->buf_tail < sizeof(s->buf) - 2)
+  int room = sizeof(s->buf) - 2 - s->buf_tail;
+  if (room > 0)
     {
-      int c = textclient_getc (s->tc);
-      if (c > 0)
-        s->buf[s->buf_tail++] = (char) c;
-      else
-        break;
+      int i, j, n = textclient_read (s->tc, s->buf + s->buf_tail, room);
+      for (i = j = s->buf_tail; i < s->buf_tail + n; i++)
+        if (s->buf[i])			/* a NUL would end the string */
+          s->buf[j++] = s->buf[i];
+      s->buf_tail = j;
     }
 }
 
@@ -176,7 +176,6 @@ init_bubble3d(ModeInfo * mi)
 		init(c);
 		reshape_bubble3d(mi, MI_WIDTH(mi), MI_HEIGHT(mi));
 		do_display(c);
-		glFinish();
 		glXSwapBuffers(display, window);
 	} else
 		MI_CLEARWINDOW(mi);
@@ -204,7 +203,6 @@ draw_bubble3d(ModeInfo * mi)
         mi->polygon_count = glb_config.polygon_count;
 
         if (mi->fps_p) do_fps (mi);
-	glFinish();
 	glXSwapBuffers(display, window);
 }
 
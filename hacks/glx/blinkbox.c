@@ -587,7 +587,6 @@ draw_ball (ModeInfo *mi)
 
    glPopMatrix();
   if (mi->fps_p) do_fps (mi);
-   glFinish();
    glXSwapBuffers(dpy, window);
 
 }
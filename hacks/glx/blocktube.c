@@ -440,7 +440,6 @@ draw_blocktube (ModeInfo *mi)
     tick(lp);
 
     if (mi->fps_p) do_fps (mi);
-    glFinish();
     glXSwapBuffers(dpy, window);
 }
 
@@ -644,7 +644,6 @@ draw_boing (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
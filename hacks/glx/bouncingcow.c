@@ -503,7 +503,6 @@ draw_cow (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
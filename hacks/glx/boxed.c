@@ -1315,7 +1315,6 @@ draw_boxed(ModeInfo * mi)
    draw(mi);
    
    if (mi->fps_p) do_fps (mi);
-   glFinish();
    glXSwapBuffers(display, window);
 }
 
@@ -541,7 +541,6 @@ loading_msg (ModeInfo *mi, int n)
 
   glMatrixMode(GL_MODELVIEW);
 
-  glFinish();
   glXSwapBuffers (MI_DISPLAY (mi), MI_WINDOW(mi));
 }
 
@@ -900,7 +899,6 @@ draw_carousel (ModeInfo *mi)
   glPopMatrix();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers (MI_DISPLAY (mi), MI_WINDOW(mi));
 }
 
@@ -2065,7 +2065,6 @@ ENTRYPOINT void draw_circuit(ModeInfo *mi)
   display(mi);
 
   if(mi->fps_p) do_fps(mi);
-  glFinish(); 
   glXSwapBuffers(disp, w);
 }
 
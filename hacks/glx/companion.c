@@ -574,7 +574,6 @@ draw_cube (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
@@ -1455,7 +1455,6 @@ ENTRYPOINT void draw_crackberg (ModeInfo *mi)
     glEnd();
 #endif
 
-    glFinish();
     glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
 }
 
@@ -17,7 +17,6 @@
 
 
 # define refresh_cube 0
-# define release_cube 0
 #undef countof
 #define countof(x) (sizeof((x))/sizeof((*x)))
 
@@ -25,6 +24,8 @@
 #include "colors.h"
 #include "rotator.h"
 #include "gltrackball.h"
+#include "gllist.h"
+#include "instances.h"
 #include <ctype.h>
 
 #ifdef USE_GL /* whole file */
@@ -47,7 +48,8 @@ typedef struct {
   Bool button_down_p;
   Bool clear_p;
 
-  GLuint cube_list;
+  struct gllist cube;
+  instances *cubes;
 
   int ncolors;
   XColor *colors;
@@ -86,56 +88,84 @@ static argtype vars[] = {
 ENTRYPOINT ModeSpecOpt cube_opts = {countof(opts), opts, countof(vars), vars, NULL};
 
 
+/* Rotates p by 90 degrees about the X, Y or Z axis, n times. */
 static void
-draw_face (ModeInfo *mi)
+rotate_90 (GLfloat *p, int axis, int n)
 {
-  int wire = MI_IS_WIREFRAME(mi);
+  while (n-- > 0)
+    {
+      GLfloat a, b;
+      switch (axis) {
+      case 0:  a = p[1]; b = p[2]; p[1] = -b; p[2] = a;  break;
+      case 1:  a = p[0]; b = p[2]; p[0] = b;  p[2] = -a; break;
+      default: a = p[0]; b = p[1]; p[0] = -b; p[1] = a;  break;
+      }
+    }
+}
 
-  int i;
+/* Each face of the cube is a frame of 4 bevelled sides, each two quads.
+ */
+static void
+make_cube (ModeInfo *mi)
+{
+  cube_configuration *bp = &bps[MI_SCREEN(mi)];
+  /* Each face is the first, turned this many times about Y, after
+     this many times about X. */
+  static const int face_rot[6][2] = {
+    { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 3, 1 }, { 3, 3 }
+  };
   GLfloat t = thickness / 2;
   GLfloat a = -0.5;
   GLfloat b =  0.5;
+  GLfloat side[2][5][3];	/* normal, and 4 points */
+  GLfloat *data, *p;
+  int f, i, q, k;
 
   if (t <= 0) t = 0.001;
   else if (t > 0.5) t = 0.5;
 
-  glPushMatrix();
-  glFrontFace(GL_CW);
-
-  for (i = 0; i < 4; i++)
+  side[0][0][0] = 0;   side[0][0][1] = 0;   side[0][0][2] = -1;
+  side[0][1][0] = a;   side[0][1][1] = a;   side[0][1][2] = a;
+  side[0][2][0] = b;   side[0][2][1] = a;   side[0][2][2] = a;
+  side[0][3][0] = b-t; side[0][3][1] = a+t; side[0][3][2] = a;
+  side[0][4][0] = a+t; side[0][4][1] = a+t; side[0][4][2] = a;
+
+  side[1][0][0] = 0;   side[1][0][1] = 1;   side[1][0][2] = 0;
+  side[1][1][0] = b-t; side[1][1][1] = a+t; side[1][1][2] = a;
+  side[1][2][0] = b-t; side[1][2][1] = a+t; side[1][2][2] = a+t;
+  side[1][3][0] = a+t; side[1][3][1] = a+t; side[1][3][2] = a+t;
+  side[1][4][0] = a+t; side[1][4][1] = a+t; side[1][4][2] = a;
+
+  data = (GLfloat *) malloc (6 * 4 * 2 * 4 * 6 * sizeof(*data));
+  bp->cubes = instances_new (&bp->cube, MI_IS_WIREFRAME(mi));
+  if (!data || !bp->cubes)
     {
-      glNormal3f (0, 0, -1);
-      glBegin (wire ? GL_LINE_LOOP : GL_QUADS);
-      glVertex3f (a,   a,   a);
-      glVertex3f (b,   a,   a);
-      glVertex3f (b-t, a+t, a);
-      glVertex3f (a+t, a+t, a);
-      glEnd();
-
-      glNormal3f (0, 1, 0);
-      glBegin (wire ? GL_LINE_LOOP : GL_QUADS);
-      glVertex3f (b-t, a+t, a);
-      glVertex3f (b-t, a+t, a+t);
-      glVertex3f (a+t, a+t, a+t);
-      glVertex3f (a+t, a+t, a);
-      glEnd();
-
-      glRotatef(90, 0, 0, 1);
+      fprintf(stderr, "%s: out of memory\n", progname);
+      exit(1);
     }
-  glPopMatrix();
-}
 
-static void
-draw_faces (ModeInfo *mi)
-{
-  glPushMatrix();
-  draw_face (mi);
-  glRotatef (90,  0, 1, 0); draw_face (mi);
-  glRotatef (90,  0, 1, 0); draw_face (mi);
-  glRotatef (90,  0, 1, 0); draw_face (mi);
-  glRotatef (90,  1, 0, 0); draw_face (mi);
-  glRotatef (180, 1, 0, 0); draw_face (mi);
-  glPopMatrix();
+  p = data;
+  for (f = 0; f < 6; f++)
+    for (i = 0; i < 4; i++)
+      for (q = 0; q < 2; q++)
+        for (k = 1; k < 5; k++)
+          {
+            p[0] = side[q][0][0]; p[1] = side[q][0][1]; p[2] = side[q][0][2];
+            p[3] = side[q][k][0]; p[4] = side[q][k][1]; p[5] = side[q][k][2];
+            rotate_90 (p,     2, i);
+            rotate_90 (p + 3, 2, i);
+            rotate_90 (p,     0, face_rot[f][1]);
+            rotate_90 (p + 3, 0, face_rot[f][1]);
+            rotate_90 (p,     1, face_rot[f][0]);
+            rotate_90 (p + 3, 1, face_rot[f][0]);
+            p += 6;
+          }
+
+  bp->cube.format = GL_N3F_V3F;
+  bp->cube.primitive = GL_QUADS;
+  bp->cube.points = (p - data) / 6;
+  bp->cube.data = data;
+  bp->cube.next = 0;
 }
 
 
@@ -286,10 +316,7 @@ init_cube (ModeInfo *mi)
       glLightfv(GL_LIGHT0, GL_SPECULAR, spc);
     }
 
-  bp->cube_list = glGenLists (1);
-  glNewList (bp->cube_list, GL_COMPILE);
-  draw_faces (mi);
-  glEndList ();
+  make_cube (mi);
 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -317,6 +344,7 @@ draw_cube (ModeInfo *mi)
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_NORMALIZE);
   glEnable(GL_CULL_FACE);
+  glFrontFace(GL_CW);
 
   if (bp->clear_p)   /* we're in "no vapor trails" mode */
     {
@@ -347,11 +375,17 @@ draw_cube (ModeInfo *mi)
 
   glScalef (4.0, 4.0, 4.0);
 
-  for (i = 0; i < MI_COUNT(mi); i++)
+  if (!wire)
     {
-      GLfloat bcolor[4] = {0.0, 0.0, 0.0, 1.0};
       GLfloat bspec[4]  = {1.0, 1.0, 1.0, 1.0};
       GLfloat bshiny    = 128.0;
+      glMaterialfv (GL_FRONT, GL_SPECULAR,            bspec);
+      glMateriali  (GL_FRONT, GL_SHININESS,           bshiny);
+    }
+
+  for (i = 0; i < MI_COUNT(mi); i++)
+    {
+      GLfloat bcolor[4] = {0.0, 0.0, 0.0, 1.0};
 
       glPushMatrix();
 
@@ -375,28 +409,48 @@ draw_cube (ModeInfo *mi)
       if (bp->subcubes[i].ccolor >= bp->ncolors)
         bp->subcubes[i].ccolor = 0;
 
-      if (wire)
-        glColor3f (bcolor[0], bcolor[1], bcolor[2]);
-      else
-        {
-          glMaterialfv (GL_FRONT, GL_SPECULAR,            bspec);
-          glMateriali  (GL_FRONT, GL_SHININESS,           bshiny);
-          glMaterialfv (GL_FRONT, GL_AMBIENT_AND_DIFFUSE, bcolor);
-        }
-
-      glCallList (bp->cube_list);
+      instances_add (bp->cubes, bcolor);
       mi->polygon_count += (4 * 2 * 6);
 
       glPopMatrix();
     }
 
+  instances_draw (bp->cubes);
+
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   if (dbuf_p)
     glXSwapBuffers(dpy, window);
+  else
+    glFlush();
+}
+
+ENTRYPOINT void
+release_cube (ModeInfo *mi)
+{
+  if (bps)
+    {
+      int screen;
+      for (screen = 0; screen < MI_NUM_SCREENS(mi); screen++)
+        {
+          cube_configuration *bp = &bps[screen];
+          int i;
+          if (bp->subcubes)
+            {
+              for (i = 0; i < MI_COUNT(mi); i++)
+                if (bp->subcubes[i].rot)
+                  free_rotator (bp->subcubes[i].rot);
+              free (bp->subcubes);
+            }
+          if (bp->colors) free (bp->colors);
+          if (bp->cube.data) free ((void *) bp->cube.data);
+          instances_free (bp->cubes);
+        }
+      free (bps);
+      bps = 0;
+    }
 }
 
 XSCREENSAVER_MODULE_2 ("CubeStorm", cubestorm, cube)
@@ -346,7 +346,6 @@ draw_ball (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
@@ -2458,7 +2458,6 @@ draw_logo (ModeInfo *mi)
     dc->wire_overlay--;
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
@@ -955,7 +955,6 @@ ENTRYPOINT void draw_chess(ModeInfo *mi)
   display(mi, cs);
 
   if(mi->fps_p) do_fps(mi);
-  glFinish(); 
   glXSwapBuffers(disp, w);
 }
 
@@ -978,7 +978,6 @@ ENTRYPOINT void draw_engine(ModeInfo *mi)
                            1, e->engine_name);
 
   if(mi->fps_p) do_fps(mi);
-  glFinish(); 
   glXSwapBuffers(disp, w);
 }
 
@@ -449,7 +449,6 @@ draw_flipflop(ModeInfo *mi)
         do_fps(mi);
     }
 
-    glFinish();
     glXSwapBuffers(disp, w);
 
 
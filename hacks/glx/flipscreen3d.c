@@ -509,7 +509,6 @@ ENTRYPOINT void draw_screenflip(ModeInfo *mi)
   display(c, MI_IS_WIREFRAME(mi));
 
   if(mi->fps_p) do_fps(mi);
-  glFinish(); 
   glXSwapBuffers(disp, w);
 }
 
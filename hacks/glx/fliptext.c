@@ -21,7 +21,6 @@
 		 "*showFPS:      False      \n" \
 		 "*wireframe:    False      \n" \
 		 "*usePty:       False      \n" \
-		 "*texFontCacheSize: 60     \n" \
 		 "*font:       " DEF_FONT  "\n" \
 		 ".foreground: " DEF_COLOR "\n" \
 		 "*program: xscreensaver-text --cols 0"  /* don't wrap */
@@ -970,7 +969,6 @@ draw_fliptext (ModeInfo *mi)
   glPopMatrix();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers(dpy, window);
 }
 
@@ -48,11 +48,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <GL/gl.h>
 #include <GL/glu.h>
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#include "texcache.h"
+
+/* How many different smoke textures to keep in the texture cache. */
+#define TEXTURE_VARIANTS 8
+
 static GLubyte smallTextureArray[32][32];
 static GLubyte bigTextureArray[256][256][2];
+static texture_cache *textureCache = 0;
 GLuint theTexture = 0;
 
 /* simple smoothing routine */
@@ -187,7 +195,7 @@ static void AverageLastAndFirstTextures(void)
     }
 }
 
-void MakeTexture()
+static void MakeBigTexture(void)
 {
     int i,j;
     for (i=0;i<8;i++)
@@ -205,6 +213,21 @@ void MakeTexture()
             CopySmallTextureToBigTexture(i*32,j*32);
         }
     }
+}
+
+void MakeTexture(Display *dpy)
+{
+    GLubyte *data;
+    char params[20];
+
+    sprintf(params, "smoke %d", (int) (random() % TEXTURE_VARIANTS));
+    textureCache = texture_cache_open(dpy, "flurry", params, 256, 256,
+                                      GL_LUMINANCE_ALPHA);
+    data = (textureCache ? texture_cache_buffer(textureCache) : 0);
+    if (data || !textureCache)
+        MakeBigTexture();
+    if (data)
+        memcpy(data, bigTextureArray, sizeof(bigTextureArray));
 
     glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 
@@ -219,6 +242,25 @@ void MakeTexture()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
 
-    gluBuild2DMipmaps(GL_TEXTURE_2D, 2, 256, 256, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, bigTextureArray);
+    if (textureCache)
+        texture_cache_load(textureCache, True);
+    else
+        gluBuild2DMipmaps(GL_TEXTURE_2D, 2, 256, 256, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, bigTextureArray);
     glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 }
+
+/* Loads the mipmaps once the texture cache has made them. */
+void UpdateTexture(void)
+{
+    if (textureCache && texture_cache_done(textureCache))
+    {
+        texture_cache_free(textureCache);
+        textureCache = 0;
+    }
+}
+
+void FreeTexture(void)
+{
+    texture_cache_free(textureCache);
+    textureCache = 0;
+}
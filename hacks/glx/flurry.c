@@ -515,11 +515,12 @@ draw_flurry(ModeInfo * mi)
 	return;
 
     if (first) {
-	MakeTexture();
+	MakeTexture(display);
 	first = 0;
     }
     glDrawBuffer(GL_BACK);
     glXMakeCurrent(display, window, *(global->glx_context));
+    UpdateTexture();
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -534,7 +535,6 @@ draw_flurry(ModeInfo * mi)
 
     if (mi->fps_p) do_fps (mi);
 
-    glFinish();
     glXSwapBuffers(display, window);
 }
 
@@ -558,6 +558,7 @@ release_flurry(ModeInfo * mi)
 	}
 	(void) free((void *) flurry_info);
 	flurry_info = NULL;
+	FreeTexture();
     }
     FreeAllGL(mi);
 }
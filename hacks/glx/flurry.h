@@ -211,7 +211,9 @@ static vector float FastDistance2DV(vector float x, vector float y) {
 
 extern GLuint theTexture;
 
-void MakeTexture(void);
+void MakeTexture(Display *dpy);
+void UpdateTexture(void);
+void FreeTexture(void);
 
 #define OPT_MODE_SCALAR_BASE		0x0
 
@@ -839,7 +839,6 @@ draw_toasters (ModeInfo *mi)
     draw_floater (mi, &F);
     glPopMatrix ();
     if (mi->fps_p) do_fps (mi);
-    glFinish();
     glXSwapBuffers(dpy, window);
     return;
   }
@@ -862,7 +861,6 @@ draw_toasters (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
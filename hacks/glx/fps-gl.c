@@ -39,6 +39,8 @@ typedef struct {
   texture_font_data *texfont;
   int line_height;
   Bool top_p;
+  double gpu_wait;	/* seconds waited for the GPU since the last update */
+  int frames;
 } gl_fps_data;
 
 
@@ -67,6 +69,27 @@ xlockmore_gl_compute_fps (Display *dpy, Window w, fps_state *fpst,
     }
 
   fps_compute (fpst, mi->polygon_count, mi->recursion_depth);
+
+  /* Add how long, on average, each frame waited for the GPU to finish
+     the one before it.  fps_compute() just rewrote the string if it
+     reset frame_count. */
+  {
+    gl_fps_data *data = (gl_fps_data *) fpst->gl_fps_data;
+    double wait = xlockmore_gl_gpu_wait (w);
+    if (wait >= 0)
+      {
+        data->gpu_wait += wait;
+        data->frames++;
+        if (fpst->frame_count == 0)
+          {
+            sprintf (fpst->string + strlen (fpst->string),
+                     "\nGPU wait: %.1f ms ",
+                     1000 * data->gpu_wait / data->frames);
+            data->gpu_wait = 0;
+            data->frames = 0;
+          }
+      }
+  }
 }
 
 
@@ -79,22 +102,22 @@ xlockmore_gl_draw_fps (ModeInfo *mi)
   if (st)   /* might be too early */
     {
       gl_fps_data *data = (gl_fps_data *) st->gl_fps_data;
-      XWindowAttributes xgwa;
       int lines = 1;
       const char *s;
       int y = st->y;
 
-      XGetWindowAttributes (st->dpy, st->window, &xgwa);
+      /* Not XGetWindowAttributes: with -render-scale, the hack is drawing
+         in less than the whole window. */
       for (s = st->string; *s; s++) 
         if (*s == '\n') lines++;
 
       if (y < 0)
-        y = xgwa.height + y - (lines * data->line_height);
+        y = mi->xgwa.height + y - (lines * data->line_height);
       y += lines * data->line_height;
 
       glColor3f (1, 1, 1);
       print_texture_label (st->dpy, data->texfont,
-                           xgwa.width, xgwa.height,
+                           mi->xgwa.width, mi->xgwa.height,
                            (data->top_p ? 1 : 2),
                            st->string);
     }
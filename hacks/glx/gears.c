@@ -901,7 +901,6 @@ draw_gears (ModeInfo *mi)
       }
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
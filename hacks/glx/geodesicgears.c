@@ -16,7 +16,6 @@
 			"*count:        4           \n" \
 			"*wireframe:    False       \n" \
 			"*showFPS:      False       \n" \
-		        "*texFontCacheSize: 100     \n" \
 		"*font:  -*-helvetica-medium-r-normal-*-*-160-*-*-*-*-*-*\n" \
 
 # define refresh_geodesic 0
@@ -1762,7 +1761,6 @@ draw_geodesic (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
@@ -601,7 +601,6 @@ draw_glblur (ModeInfo *mi)
   glFlush ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
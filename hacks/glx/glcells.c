@@ -27,13 +27,13 @@
 #include <sys/time.h> /* gettimeofday */
 
 #include "xlockmore.h"
+#include "meshnormals.h"
 #include <math.h>
 
 /**********************************
   DEFINES
  **********************************/
 
-#define INDEX_OFFSET 100000
 #define NUM_CELL_SHAPES 10
 
 #define refresh_glcells 0
@@ -68,10 +68,7 @@
   TYPEDEFS
  **********************************/
  
-typedef struct    /* a 3-D vector */
-{
-  double x, y, z;   /* 3-D coordinates (we don't need w here) */
-} Vector;
+typedef XYZ Vector;  /* a 3-D vector (we don't need w here) */
 
 typedef struct    /* a triangle (indexes of vertexes in some list) */
 {
@@ -141,6 +138,7 @@ typedef struct    /* hacks state */
   int pause_counter;
   int wire;             /* draw wireframe? */
   Object *sphere;       /* the raw undisturbed sphere */
+  mesh_normals *normals; /* the sphere's triangles around each vertex */
   double *disturbance;  /* disturbance values for the vertexes */
   int *food;            /* our petri dish (e.g. screen) */
   GLubyte *texture;     /* texture data for nucleus */
@@ -222,14 +220,12 @@ static void vector_sub( Vector *a, Vector *b );
 static void vector_mul( Vector *a, double fac );
 /* a.x = a.y = a.z = 0 */
 static void vector_clear( Vector *a );
-/* return crossproduct a*b in out */
-static void vector_crossprod( Vector *a, Vector *b, Vector *out );
 /* return 1 if vectors are equal (epsilon compare) otherwise 0 */
 static int vector_compare( Vector *a, Vector *b );
-/* compute normal vector of given triangle and return in out */
-static void triangle_normal( Vector *a, Vector *b, Vector *c, Vector *out );
+/* hash of a vector, for finding exact copies of it */
+static unsigned long vector_hash( Vector *a );
 /* take an Object and create an ObjectSmooth out of it */
-static ObjectSmooth *create_ObjectSmooth( Object * );
+static ObjectSmooth *create_ObjectSmooth( Object *, mesh_normals * );
 /* Subdivide the Object once (assuming it's supposed to be a shpere */
 static Object *subdivide( Object *obj );
 /* free an Object */
@@ -319,14 +315,6 @@ static inline void vector_normalize( Vector *vec )
   }
 }
 
-/* crossproduct */
-static inline void vector_crossprod( Vector *a, Vector *b, Vector *out )
-{
-  out->x = a->y*b->z - a->z*b->y;
-  out->y = a->z*b->x - a->x*b->z;
-  out->z = a->x*b->y - a->y*b->x;
-}
-
 /* epsilon compare of two vectors */
 static inline int vector_compare( Vector *a, Vector *b )
 {
@@ -343,6 +331,26 @@ static inline int vector_compare( Vector *a, Vector *b )
   return 0;
 }
 
+/* hash of the bits of a vector. Adding 0 makes -0 into 0, which
+   vector_compare says are the same.
+*/
+static unsigned long vector_hash( Vector *vec )
+{
+  double d[3];
+  unsigned char *b = (unsigned char *) d;
+  unsigned long h = 2166136261UL;
+  int i;
+  
+  d[0] = vec->x + 0.0;
+  d[1] = vec->y + 0.0;
+  d[2] = vec->z + 0.0;
+  for (i=0; i<(int)sizeof(d); ++i) {
+    h = (h ^ b[i]) * 16777619UL;
+  }
+  
+  return h;
+}
+
 /* check if given cell is capable of dividing 
    needs space, must be old enough, grown up and healthy
 */
@@ -362,19 +370,6 @@ static inline int can_divide( State *st, Cell *cell )
   FUNCTIONS
  **********************************/
 
-/* compute normal vector of given 
-   triangle spanned by the points a, b, c 
-*/
-static void triangle_normal( Vector *a, Vector *b, Vector *c, Vector *out )
-{
-  Vector v1 = *a;
-  Vector v2 = *a;
-  
-  vector_sub( &v1, b );
-  vector_sub( &v2, c );
-  vector_crossprod( &v1, &v2, out );
-}
-
 /* free */
 static void free_Object( Object *obj )
 {
@@ -459,12 +454,11 @@ static VertexArray *array_from_ObjectSmooth( ObjectSmooth *obj )
 
 /* create a smoothed version of the given Object
    by computing average normal vectors for the vertexes 
+   (mn knows which triangles are around which vertex)
 */
-static ObjectSmooth *create_ObjectSmooth( Object *obj )
+static ObjectSmooth *create_ObjectSmooth( Object *obj, mesh_normals *mn )
 {
-  int t, v, i;
-  Vector *t_normal = 
-      (Vector *) malloc( obj->num_triangle*sizeof(Vector) );
+  int t, v;
   ObjectSmooth *ret = 
       (ObjectSmooth *) malloc( sizeof( ObjectSmooth ) );
   
@@ -486,52 +480,32 @@ static ObjectSmooth *create_ObjectSmooth( Object *obj )
     ret->triangle[t] = obj->triangle[t];
   }
   
-  /* create normals (triangles) */
-  for (t=0; t<ret->num_triangle; ++t) {
-    triangle_normal( &ret->vertex[ret->triangle[t].i[0]],
-                     &ret->vertex[ret->triangle[t].i[1]],
-                     &ret->vertex[ret->triangle[t].i[2]],
-                     &t_normal[t] );
-  }
-  
   /* create normals (vertex) by averaging triangle 
      normals at vertex
   */
+  mesh_normals_compute( mn, ret->vertex, ret->normal );
+  
   for (v=0; v<ret->num_vertex; ++v) {
-    vector_clear( &ret->normal[v] );
-    for (t=0; t<ret->num_triangle; ++t) {
-      for (i=0; i<3; ++i) {
-        if (ret->triangle[t].i[i] == v) {
-          vector_add( &ret->normal[v], &t_normal[t] );
-        }
-      }
-    }
     /* as we have only a half sphere we force the
        normals at the bortder to be perpendicular to z.
        the simple algorithm above makes an error here.
     */
     if (fabs(ret->vertex[v].z) < 0.0001) {
       ret->normal[v].z = 0.0;
+      vector_normalize( &ret->normal[v] );
     }  
-    
-    vector_normalize( &ret->normal[v] );
   }
   
-  free( t_normal );
-  
   return ret;
 }
 
 /* subdivide the triangles of the object once
-   The order of this algorithm is probably something like O(n^42) :)
-   but I can't think of something smarter at the moment 
 */
 static Object *subdivide( Object *obj )
 {
   /* create for worst case (which I dont't know) */
   int start, t, i, v;
-  int index_list[1000];
-  int index_cnt, index_found;
+  int hash_size, *hash, *index_map;
   Object *tmp = (Object *)malloc( sizeof(Object) );
   Object *ret = (Object *)malloc( sizeof(Object) );
   Object *c_ret;
@@ -601,70 +575,43 @@ static Object *subdivide( Object *obj )
     tmp->triangle[tmp->num_triangle++].i[2] = start+5;
   }
   
-  /* compress object eliminating double vertexes 
-     (welcome to the not so smart section)
+  /* compress object eliminating double vertexes.
+     The copies of a vertex are exact copies, and the two triangles
+     on an edge compute its midpoint the same way, so the doubles
+     can be found by hashing.
   */
-  /* copy original triangle list */
-  for (t=0; t<tmp->num_triangle; ++t) {
-    ret->triangle[t] = tmp->triangle[t];
-  }
-  ret->num_triangle = tmp->num_triangle;
+  hash_size = 1;
+  while (hash_size < 2*tmp->num_vertex) hash_size <<= 1;
+  hash = (int *)malloc( hash_size*sizeof( int ) );
+  index_map = (int *)malloc( tmp->num_vertex*sizeof( int ) );
+  for (i=0; i<hash_size; ++i) hash[i] = -1;
   
-  /* copy unique vertexes and correct triangle list */
+  /* copy unique vertexes, remembering where each one went */
   for (v=0; v<tmp->num_vertex; ++v) {
-    /* create list of vertexes that are the same */
-    index_cnt = 0;
-    for (i=0; i<tmp->num_vertex; ++i) {
-      /* check if i and v are the same
-         first in the list is the smallest index
-      */
-      if (vector_compare( &tmp->vertex[v], &tmp->vertex[i] )) {
-        index_list[index_cnt++] = i;
-      }
+    i = vector_hash( &tmp->vertex[v] ) & (hash_size-1);
+    while (hash[i] != -1 &&
+           !vector_compare( &ret->vertex[hash[i]], &tmp->vertex[v] )) {
+      i = (i+1) & (hash_size-1);
     }
-    
-    /* check if vertex unknown so far */
-    index_found = 0;
-    for (i=0; i<ret->num_vertex; ++i) {
-      if (vector_compare( &ret->vertex[i],
-          &tmp->vertex[index_list[0]] )) {
-        index_found = 1;
-        break;
-      }
+    if (hash[i] == -1) {
+      hash[i] = ret->num_vertex;
+      ret->vertex[ret->num_vertex++] = tmp->vertex[v];
     }
-    
-    if (!index_found) {
-      ret->vertex[ret->num_vertex] = tmp->vertex[index_list[0]];
-      
-      /* correct triangles 
-         (we add an offset to the index, so we can tell them apart)
-      */
-      for (t=0; t<ret->num_triangle; ++t) {
-        for (i=0; i<index_cnt; ++i) {
-          if (ret->triangle[t].i[0] == index_list[i]) {
-            ret->triangle[t].i[0] = ret->num_vertex+INDEX_OFFSET;
-          }
-          if (ret->triangle[t].i[1] == index_list[i]) {
-            ret->triangle[t].i[1] = ret->num_vertex+INDEX_OFFSET;
-          }
-          if (ret->triangle[t].i[2] == index_list[i]) {
-            ret->triangle[t].i[2] = ret->num_vertex+INDEX_OFFSET;
-          }
-        }
-      }
-      ret->num_vertex++;
+    index_map[v] = hash[i];
+  }
+  
+  /* copy triangle list, pointing at the unique vertexes */
+  for (t=0; t<tmp->num_triangle; ++t) {
+    for (i=0; i<3; ++i) {
+      ret->triangle[t].i[i] = index_map[tmp->triangle[t].i[i]];
     }
   }
+  ret->num_triangle = tmp->num_triangle;
   
+  free( hash );
+  free( index_map );
   free_Object( tmp );
   
-  /* correct index offset */
-  for (t=0; t<ret->num_triangle; ++t) {
-    ret->triangle[t].i[0] -= INDEX_OFFSET;
-    ret->triangle[t].i[1] -= INDEX_OFFSET;
-    ret->triangle[t].i[2] -= INDEX_OFFSET;
-  }
-  
   /* normalize vertexes */
   for (v=0; v<ret->num_vertex; ++v) {
     vector_normalize( &ret->vertex[v] );
@@ -867,7 +814,7 @@ static int create_list( State *st, double fac )
   }
   
   /* compute normals */
-  smooth = create_ObjectSmooth( obj );
+  smooth = create_ObjectSmooth( obj, st->normals );
   free_Object( obj );
   
   /* Create display list */
@@ -1273,6 +1220,13 @@ init_glcells( ModeInfo *mi )
   st->food = 0;
   
   st->sphere = create_sphere( st, divisions );
+  st->normals = mesh_normals_new( MI_DISPLAY(mi), st->sphere->num_vertex,
+                                  st->sphere->num_triangle,
+                                  &st->sphere->triangle[0].i[0] );
+  if (!st->normals) {
+    fprintf( stderr, "%s: out of memory\n", progname );
+    exit( 1 );
+  }
   st->disturbance = 
       (double *) malloc( st->sphere->num_vertex*sizeof(double) );
   for (i=0; i<st->sphere->num_vertex; ++i) {
@@ -1301,7 +1255,6 @@ draw_glcells( ModeInfo *mi )
   
   if (mi->fps_p) do_fps (mi);
   
-  glFinish();
   glXSwapBuffers( dpy, window );
 }
 
@@ -1313,6 +1266,7 @@ release_glcells( ModeInfo *mi )
   
   /* nuke everything before exit */
   if (st->sphere) free_Object( st->sphere );
+  if (st->normals) mesh_normals_free( st->normals );
   if (st->food)   free( st->food );
   for (i=0; i<NUM_CELL_SHAPES; ++i) {
     if (st->cell_list[i] != -1) {
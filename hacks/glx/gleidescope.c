@@ -1576,7 +1576,6 @@ draw_gleidescope(ModeInfo * mi)
 		do_fps (mi);
 	}
 
-	glFinish();
 	glXSwapBuffers(display, window);
 
 #ifdef GRAB
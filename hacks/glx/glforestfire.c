@@ -1028,7 +1028,6 @@ ENTRYPOINT void draw_fire(ModeInfo * mi)
     reshape_fire(mi,MI_WIDTH(mi),MI_HEIGHT(mi)); /* xscreensaver mode */
 #endif
 
-    glFinish();
     glXSwapBuffers(display, window);
 }
 
@@ -1985,7 +1985,6 @@ ENTRYPOINT void draw_glhanoi(ModeInfo * mi)
 	if(mi->fps_p) {
 		do_fps(mi);
 	}
-	glFinish();
 
 	glXSwapBuffers(dpy, window);
 }
@@ -593,7 +593,6 @@ draw_planet (ModeInfo * mi)
   glPopMatrix();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers(dpy, window);
 }
 
@@ -215,7 +215,6 @@ draw_glschool(ModeInfo *mi)
 	if (mi->fps_p)
 		do_fps(mi);
 
-	glFinish();
 	glXSwapBuffers(dpy, window);
 }
 
@@ -269,6 +269,4 @@ glschool_drawSchool(XColor *colors, School *s,
 		}
 		glPopMatrix();
 	}
-
-	glFinish();
 }
@@ -1211,7 +1211,6 @@ draw_slideshow (ModeInfo *mi)
 
   if (mi->fps_p) do_fps (mi);
 
-  glFinish();
   glXSwapBuffers (MI_DISPLAY (mi), MI_WINDOW(mi));
   ss->prev_frame_time = ss->now;
   ss->redisplay_needed_p = False;
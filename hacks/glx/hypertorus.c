@@ -100,6 +100,7 @@ static const char sccsid[] = "@(#)hypertorus.c  1.2 05/09/28 xlockmore";
 #endif
 
 #include "gltrackball.h"
+#include "surface4d.h"
 
 
 #ifdef USE_MODULES
@@ -208,6 +209,8 @@ typedef struct {
   GLXContext *glx_context;
   /* 4D rotation angles */
   float alpha, beta, delta, zeta, eta, theta;
+  /* The hypertorus, sampled once */
+  surface4d *surface;
   /* Aspect ratio of the current window */
   float aspect;
   /* Trackball states */
@@ -402,14 +405,10 @@ static void quats_to_rotmat(float p[4], float q[4], float m[4][4])
 
 
 /* Compute a fully saturated and bright color based on an angle. */
-static void color(double angle)
+static void color(double angle, float color[4])
 {
   int s;
   double t;
-  float color[4];
-
-  if (colors != COLORS_COLORWHEEL)
-    return;
 
   if (angle >= 0.0)
     angle = fmod(angle,2*M_PI);
@@ -456,29 +455,89 @@ static void color(double angle)
     color[3] = 0.7;
   else
     color[3] = 1.0;
-  glColor3fv(color);
-  glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,color);
 }
 
 
-/* Draw a hypertorus projected into 3D.  Note that the spirals appearance
-   will only work correctly if numu and numv are set to 64 or any higher
-   power of 2.  Similarly, the banded appearance will only work correctly
-   if numu and numv are divisible by 4. */
-static int hypertorus(ModeInfo *mi, double umin, double umax, double vmin,
-                       double vmax, int numu, int numv)
+/* Set up the hypertorus coordinates and colors.  Note that the spirals
+   appearance will only work correctly if numu and numv are set to 64 or
+   any higher power of 2.  Similarly, the banded appearance will only work
+   correctly if numu and numv are divisible by 4. */
+static void setup_hypertorus(ModeInfo *mi, double umin, double umax,
+                             double vmin, double vmax, int numu, int numv)
+{
+  int i, j, b, skew;
+  double u, v, ur, vr;
+  double cu, su, cv, sv;
+  float x[4], xu[4], xv[4], col[4];
+  hypertorusstruct *hp = &hyper[MI_SCREEN(mi)];
+
+  surface4d_free(hp->surface);
+  hp->surface = surface4d_new(numu,numv);
+  if (!hp->surface)
+  {
+    fprintf(stderr,"%s: out of memory\n",progname);
+    exit(1);
+  }
+
+  skew = num_spirals;
+  ur = umax-umin;
+  vr = vmax-vmin;
+  for (i=0; i<=numu; i++)
+  {
+    for (j=0; j<=numv; j++)
+    {
+      u = ur*i/numu+umin;
+      v = vr*j/numv+vmin;
+      if (appearance == APPEARANCE_SPIRALS)
+      {
+        u += 4.0*skew/numv*v;
+        b = ((i/4)&(skew-1))*(numu/(4*skew));
+        color(ur*4*b/numu+umin,col);
+      }
+      else
+      {
+        color(u,col);
+      }
+      cu = cos(u);
+      su = sin(u);
+      cv = cos(v);
+      sv = sin(v);
+      x[0] = cu;
+      x[1] = su;
+      x[2] = cv;
+      x[3] = sv;
+      xu[0] = -su;
+      xu[1] = cu;
+      xu[2] = 0.0;
+      xu[3] = 0.0;
+      xv[0] = 0.0;
+      xv[1] = 0.0;
+      xv[2] = -sv;
+      xv[3] = cv;
+      surface4d_set_point(hp->surface,i,j,x,xu,xv);
+      if (colors == COLORS_COLORWHEEL)
+        surface4d_set_color(hp->surface,i,j,col);
+    }
+  }
+
+  for (i=0; i<numu; i++)
+  {
+    if ((appearance == APPEARANCE_BANDS ||
+         appearance == APPEARANCE_SPIRALS) && ((i & 3) >= 2))
+      continue;
+    surface4d_add_strip(hp->surface,i,False);
+  }
+}
+
+
+/* Draw a hypertorus projected into 3D. */
+static int hypertorus(ModeInfo *mi)
 {
-  int polys = 0;
   static const GLfloat mat_diff_red[]         = { 1.0, 0.0, 0.0, 1.0 };
   static const GLfloat mat_diff_green[]       = { 0.0, 1.0, 0.0, 1.0 };
   static const GLfloat mat_diff_trans_red[]   = { 1.0, 0.0, 0.0, 0.7 };
   static const GLfloat mat_diff_trans_green[] = { 0.0, 1.0, 0.0, 0.7 };
-  float p[3], pu[3], pv[3], n[3], mat[4][4];
-  int i, j, k, l, m, b, skew;
-  double u, v, ur, vr;
-  double cu, su, cv, sv;
-  double xx[4], xxu[4], xxv[4], x[4], xu[4], xv[4];
-  double r, s, t;
+  float mat[4][4];
   float q1[4], q2[4], r1[4][4], r2[4][4];
   hypertorusstruct *hp = &hyper[MI_SCREEN(mi)];
 
@@ -505,104 +564,9 @@ static int hypertorus(ModeInfo *mi, double umin, double umax, double vmin,
     }
   }
 
-  skew = num_spirals;
-  ur = umax-umin;
-  vr = vmax-vmin;
-  for (i=0; i<numu; i++)
-  {
-    if ((appearance == APPEARANCE_BANDS ||
-         appearance == APPEARANCE_SPIRALS) && ((i & 3) >= 2))
-      continue;
-    if (display_mode == DISP_WIREFRAME)
-      glBegin(GL_QUAD_STRIP);
-    else
-      glBegin(GL_TRIANGLE_STRIP);
-    for (j=0; j<=numv; j++)
-    {
-      for (k=0; k<=1; k++)
-      {
-        l = (i+k);
-        m = j;
-        u = ur*l/numu+umin;
-        v = vr*m/numv+vmin;
-        if (appearance == APPEARANCE_SPIRALS)
-        {
-          u += 4.0*skew/numv*v;
-          b = ((i/4)&(skew-1))*(numu/(4*skew));
-          color(ur*4*b/numu+umin);
-        }
-        else
-        {
-          color(u);
-        }
-        cu = cos(u);
-        su = sin(u);
-        cv = cos(v);
-        sv = sin(v);
-        xx[0] = cu;
-        xx[1] = su;
-        xx[2] = cv;
-        xx[3] = sv;
-        xxu[0] = -su;
-        xxu[1] = cu;
-        xxu[2] = 0.0;
-        xxu[3] = 0.0;
-        xxv[0] = 0.0;
-        xxv[1] = 0.0;
-        xxv[2] = -sv;
-        xxv[3] = cv;
-        for (l=0; l<4; l++)
-        {
-          r = 0.0;
-          s = 0.0;
-          t = 0.0;
-          for (m=0; m<4; m++)
-          {
-            r += mat[l][m]*xx[m];
-            s += mat[l][m]*xxu[m];
-            t += mat[l][m]*xxv[m];
-          }
-          x[l] = r;
-          xu[l] = s;
-          xv[l] = t;
-        }
-        if (projection_4d == DISP_4D_ORTHOGRAPHIC)
-        {
-          for (l=0; l<3; l++)
-          {
-            p[l] = (x[l]+offset4d[l])/1.5+offset3d[l];
-            pu[l] = xu[l];
-            pv[l] = xv[l];
-          }
-        }
-        else
-        {
-          s = x[3]+offset4d[3];
-          t = s*s;
-          for (l=0; l<3; l++)
-          {
-            r = x[l]+offset4d[l];
-            p[l] = r/s+offset3d[l];
-            pu[l] = (xu[l]*s-r*xu[3])/t;
-            pv[l] = (xv[l]*s-r*xv[3])/t;
-          }
-        }
-        n[0] = pu[1]*pv[2]-pu[2]*pv[1];
-        n[1] = pu[2]*pv[0]-pu[0]*pv[2];
-        n[2] = pu[0]*pv[1]-pu[1]*pv[0];
-        t = sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
-        n[0] /= t;
-        n[1] /= t;
-        n[2] /= t;
-        glNormal3fv(n);
-        glVertex3fv(p);
-        polys++;
-      }
-    }
-    glEnd();
-  }
-  polys /= 2;
-  return polys;
+  surface4d_project(hp->surface,mat,offset4d,offset3d,1.0/1.5,
+                    projection_4d == DISP_4D_PERSPECTIVE);
+  return surface4d_draw(hp->surface,display_mode == DISP_WIREFRAME);
 }
 
 
@@ -622,6 +586,8 @@ static void init(ModeInfo *mi)
   hp->eta = 0.0;
   hp->theta = 0.0;
 
+  setup_hypertorus(mi,0.0,2.0*M_PI,0.0,2.0*M_PI,64,64);
+
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
   if (projection_3d == DISP_3D_PERSPECTIVE)
@@ -727,7 +693,7 @@ static void display_hypertorus(ModeInfo *mi)
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
 
-  mi->polygon_count = hypertorus(mi,0.0,2.0*M_PI,0.0,2.0*M_PI,64,64);
+  mi->polygon_count = hypertorus(mi);
 }
 
 
@@ -1006,6 +972,7 @@ ENTRYPOINT void release_hypertorus(ModeInfo *mi)
 
       if (hp->glx_context)
         hp->glx_context = (GLXContext *)NULL;
+      surface4d_free(hp->surface);
     }
     (void) free((void *)hyper);
     hyper = (hypertorusstruct *)NULL;
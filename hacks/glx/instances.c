@@ -0,0 +1,228 @@
+/* instances, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *
+ * This is instancing without shaders: the hacks use the fixed-function
+ * pipeline, which has no way to give each copy of the object its own
+ * matrix.  So the copies are transformed into eye coordinates here, all
+ * into one array, and drawn with an identity modelview matrix.  Normals
+ * are transformed by the cofactor matrix, which is the inverse transpose
+ * scaled by the determinant, so non-uniform scaling lights correctly.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "instances.h"
+
+struct instances {
+  const struct gllist *list;
+  int wire_p;
+  int count, size;		/* copies added, and room for */
+  GLfloat *matrices;		/* 16 per copy */
+  GLfloat *colors;		/* 4 per copy */
+
+  int points;			/* room for, in the arrays below */
+  GLfloat *vertices;		/* GL_N3F_V3F */
+  GLfloat *vcolors;		/* 4 per point */
+};
+
+
+instances *
+instances_new (const struct gllist *list, int wire_p)
+{
+  instances *inst = (instances *) calloc (1, sizeof(*inst));
+  if (!inst) return 0;
+  inst->list = list;
+  inst->wire_p = wire_p;
+  return inst;
+}
+
+
+void
+instances_free (instances *inst)
+{
+  if (!inst) return;
+  if (inst->matrices) free (inst->matrices);
+  if (inst->colors)   free (inst->colors);
+  if (inst->vertices) free (inst->vertices);
+  if (inst->vcolors)  free (inst->vcolors);
+  free (inst);
+}
+
+
+static void
+render_node (const struct gllist *node, int wire_p)
+{
+  struct gllist one = *node;
+  one.next = 0;
+  renderList (&one, wire_p);
+}
+
+
+void
+instances_add (instances *inst, const GLfloat color[4])
+{
+  if (inst->count >= inst->size)
+    {
+      int size = inst->size ? inst->size * 2 : 64;
+      GLfloat *m = (GLfloat *)
+        realloc (inst->matrices, size * 16 * sizeof(*m));
+      GLfloat *c;
+      if (m) inst->matrices = m;
+      c = (GLfloat *) realloc (inst->colors, size * 4 * sizeof(*c));
+      if (c) inst->colors = c;
+
+      if (!m || !c)
+        {
+          /* No room to remember it: just draw it now. */
+          glColor4fv (color);
+          glMaterialfv (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, color);
+          renderList (inst->list, inst->wire_p);
+          return;
+        }
+      inst->size = size;
+    }
+
+  glGetFloatv (GL_MODELVIEW_MATRIX, inst->matrices + inst->count * 16);
+  memcpy (inst->colors + inst->count * 4, color, 4 * sizeof(*color));
+  inst->count++;
+}
+
+
+static int
+batch_p (const struct gllist *node, int wire_p)
+{
+  return (node->format == GL_N3F_V3F &&
+          (node->primitive == GL_LINES ||
+           (!wire_p &&
+            (node->primitive == GL_TRIANGLES ||
+             node->primitive == GL_QUADS))));
+}
+
+
+/* Fills in the arrays with every copy of the node.  The matrices are
+   assumed to be affine, as modelview matrices are.
+ */
+static void
+transform_node (instances *inst, const struct gllist *node)
+{
+  const GLfloat *in0 = (const GLfloat *) node->data;
+  GLfloat *out = inst->vertices;
+  GLfloat *oc = inst->vcolors;
+  int i, j;
+
+  for (i = 0; i < inst->count; i++)
+    {
+      const GLfloat *m = inst->matrices + i * 16;
+      const GLfloat *c = inst->colors + i * 4;
+      const GLfloat *in = in0;
+      GLfloat n[9], d;
+
+      /* Columns of the cofactor matrix of the upper 3x3. */
+      n[0] = m[5] * m[10] - m[6] * m[9];
+      n[1] = m[6] * m[8]  - m[4] * m[10];
+      n[2] = m[4] * m[9]  - m[5] * m[8];
+      n[3] = m[9] * m[2]  - m[10] * m[1];
+      n[4] = m[10] * m[0] - m[8] * m[2];
+      n[5] = m[8] * m[1]  - m[9] * m[0];
+      n[6] = m[1] * m[6]  - m[2] * m[5];
+      n[7] = m[2] * m[4]  - m[0] * m[6];
+      n[8] = m[0] * m[5]  - m[1] * m[4];
+
+      /* If the matrix is a reflection, they point inside out. */
+      d = m[0] * n[0] + m[1] * n[1] + m[2] * n[2];
+      if (d < 0)
+        for (j = 0; j < 9; j++)
+          n[j] = -n[j];
+
+      for (j = 0; j < node->points; j++, in += 6, out += 6, oc += 4)
+        {
+          GLfloat nx = in[0] * n[0] + in[1] * n[3] + in[2] * n[6];
+          GLfloat ny = in[0] * n[1] + in[1] * n[4] + in[2] * n[7];
+          GLfloat nz = in[0] * n[2] + in[1] * n[5] + in[2] * n[8];
+          d = sqrt (nx*nx + ny*ny + nz*nz);
+          if (d > 0) d = 1 / d;
+          out[0] = nx * d;
+          out[1] = ny * d;
+          out[2] = nz * d;
+          out[3] = in[3] * m[0] + in[4] * m[4] + in[5] * m[8]  + m[12];
+          out[4] = in[3] * m[1] + in[4] * m[5] + in[5] * m[9]  + m[13];
+          out[5] = in[3] * m[2] + in[4] * m[6] + in[5] * m[10] + m[14];
+          oc[0] = c[0];
+          oc[1] = c[1];
+          oc[2] = c[2];
+          oc[3] = c[3];
+        }
+    }
+}
+
+
+int
+instances_draw (instances *inst)
+{
+  const struct gllist *node;
+  int count = inst->count;
+  int i;
+
+  if (!count) return 0;
+
+  glPushMatrix();
+  glColorMaterial (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+  glEnable (GL_COLOR_MATERIAL);
+
+  for (node = inst->list; node; node = node->next)
+    {
+      int ok = batch_p (node, inst->wire_p);
+
+      if (ok && node->points * count > inst->points)
+        {
+          int points = node->points * count;
+          GLfloat *v = (GLfloat *)
+            realloc (inst->vertices, points * 6 * sizeof(*v));
+          GLfloat *c;
+          if (v) inst->vertices = v;
+          c = (GLfloat *) realloc (inst->vcolors, points * 4 * sizeof(*c));
+          if (c) inst->vcolors = c;
+          if (v && c)
+            inst->points = points;
+          else
+            ok = 0;
+        }
+
+      if (ok)
+        {
+          transform_node (inst, node);
+          glLoadIdentity();
+          glInterleavedArrays (GL_N3F_V3F, 0, inst->vertices);
+          glEnableClientState (GL_COLOR_ARRAY);
+          glColorPointer (4, GL_FLOAT, 0, inst->vcolors);
+          glDrawArrays (node->primitive, 0, node->points * count);
+          glDisableClientState (GL_COLOR_ARRAY);
+        }
+      else
+        for (i = 0; i < count; i++)
+          {
+            glLoadMatrixf (inst->matrices + i * 16);
+            glColor4fv (inst->colors + i * 4);
+            render_node (node, inst->wire_p);
+          }
+    }
+
+  glDisable (GL_COLOR_MATERIAL);
+  glPopMatrix();
+
+  inst->count = 0;
+  return count;
+}
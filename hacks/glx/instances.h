@@ -0,0 +1,60 @@
+/* instances, Copyright (c) 2026 agent <agent@local>
+ * Draws many copies of one object in a few calls.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#ifndef __INSTANCES_H__
+#define __INSTANCES_H__
+
+#include "gllist.h"
+
+/* Hacks that draw a swarm of the same object usually do, for each one,
+   glPushMatrix, some transformations, a glMaterial, a glCallList and a
+   glPopMatrix.  It is the number of GL calls that limits how many objects
+   there can be, not the number of polygons.  Instead:
+
+     instances *inst = instances_new (&my_gllist, wire);
+     ...
+     for (i = 0; i < count; i++)
+       {
+         glPushMatrix();
+         glRotatef (...);
+         instances_add (inst, color[i]);
+         glPopMatrix();
+       }
+     instances_draw (inst);
+
+   instances_add remembers the modelview matrix and the color.  Then
+   instances_draw transforms all the copies of the object itself and draws
+   them with one glDrawArrays per node of the list.
+
+   Nodes that are GL_N3F_V3F GL_TRIANGLES, GL_QUADS or GL_LINES are done
+   that way, except that in wireframe only the GL_LINES ones are, since
+   renderList outlines the others one polygon at a time.  The rest are
+   drawn one copy at a time, as renderList would.
+ */
+
+typedef struct instances instances;
+
+/* The list is not copied.  Returns 0 if out of memory. */
+extern instances *instances_new (const struct gllist *, int wire_p);
+extern void instances_free (instances *);
+
+/* Adds a copy of the object, as it would be drawn now, with the given
+   color as both its glColor and its ambient and diffuse material.
+ */
+extern void instances_add (instances *, const GLfloat color[4]);
+
+/* Draws all the copies added since the last draw, and forgets them.
+   Returns the number of copies.
+ */
+extern int instances_draw (instances *);
+
+#endif /* __INSTANCES_H__ */
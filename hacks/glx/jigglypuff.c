@@ -989,7 +989,6 @@ ENTRYPOINT void draw_jigglypuff(ModeInfo *mi)
     mi->polygon_count = jigglypuff_render(js);
     if(MI_IS_FPS(mi))
 	do_fps(mi);
-    glFinish();
     update_shape(js);
     glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
 }
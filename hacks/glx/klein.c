@@ -147,6 +147,7 @@ static const char sccsid[] = "@(#)klein.c  1.1 08/10/04 xlockmore";
 #endif
 
 #include "gltrackball.h"
+#include "surface4d.h"
 
 
 #ifdef USE_MODULES
@@ -276,16 +277,8 @@ typedef struct {
   float offset4d[4];
   /* The viewing offset in 3d */
   float offset3d[4];
-  /* The 4d coordinates of the Klein bottle and their derivatives */
-  float x[(NUMU+1)*(NUMV+1)][4];
-  float xu[(NUMU+1)*(NUMV+1)][4];
-  float xv[(NUMU+1)*(NUMV+1)][4];
-  float pp[(NUMU+1)*(NUMV+1)][3];
-  float pn[(NUMU+1)*(NUMV+1)][3];
-  /* The precomputed colors of the Klein bottle */
-  float col[(NUMU+1)*(NUMV+1)][4];
-  /* The precomputed texture coordinates of the Klein bottle */
-  float tex[(NUMU+1)*(NUMV+1)][2];
+  /* The surface, sampled once */
+  surface4d *surface;
   /* The "curlicue" texture */
   GLuint tex_name;
   /* Aspect ratio of the current window */
@@ -817,9 +810,10 @@ static void color(double angle, float col[4])
 static void setup_figure8(ModeInfo *mi, double umin, double umax, double vmin,
                           double vmax)
 {
-  int i, j, k, l;
+  int i, j, l;
   double u, v, ur, vr;
   double cu, su, cv, sv, cv2, sv2, c2u, s2u;
+  float x[4], xu[4], xv[4], col[4], tex[2];
   kleinstruct *kb = &klein[MI_SCREEN(mi)];
 
   ur = umax-umin;
@@ -828,15 +822,14 @@ static void setup_figure8(ModeInfo *mi, double umin, double umax, double vmin,
   {
     for (j=0; j<=NUMV; j++)
     {
-      k = i*(NUMV+1)+j;
       u = -ur*j/NUMU+umin;
       v = vr*i/NUMV+vmin;
       if (colors == COLORS_DEPTH)
-        color((cos(u)+1.0)*M_PI*2.0/3.0,kb->col[k]);
+        color((cos(u)+1.0)*M_PI*2.0/3.0,col);
       else
-        color(v,kb->col[k]);
-      kb->tex[k][0] = -32*u/(2.0*M_PI);
-      kb->tex[k][1] = 32*v/(2.0*M_PI);
+        color(v,col);
+      tex[0] = -32*u/(2.0*M_PI);
+      tex[1] = 32*v/(2.0*M_PI);
       cu = cos(u);
       su = sin(u);
       cv = cos(v);
@@ -845,26 +838,30 @@ static void setup_figure8(ModeInfo *mi, double umin, double umax, double vmin,
       sv2 = sin(0.5*v);
       c2u = cos(2.0*u);
       s2u = sin(2.0*u);
-      kb->x[k][0] = (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*cv;
-      kb->x[k][1] = (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*sv;
-      kb->x[k][2] = su*sv2+s2u*cv2;
-      kb->x[k][3] = cu;
-      kb->xu[k][0] = (cu*cv2-2.0*c2u*sv2)*cv;
-      kb->xu[k][1] = (cu*cv2-2.0*c2u*sv2)*sv;
-      kb->xu[k][2] = cu*sv2+2.0*c2u*cv2;
-      kb->xu[k][3] = -su;
-      kb->xv[k][0] = ((-0.5*su*sv2-0.5*s2u*cv2)*cv-
-                      (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*sv);
-      kb->xv[k][1] = ((-0.5*su*sv2-0.5*s2u*cv2)*sv+
-                      (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*cv);
-      kb->xv[k][2] = 0.5*su*cv2-0.5*s2u*sv2;
-      kb->xv[k][3] = 0.0;
+      x[0] = (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*cv;
+      x[1] = (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*sv;
+      x[2] = su*sv2+s2u*cv2;
+      x[3] = cu;
+      xu[0] = (cu*cv2-2.0*c2u*sv2)*cv;
+      xu[1] = (cu*cv2-2.0*c2u*sv2)*sv;
+      xu[2] = cu*sv2+2.0*c2u*cv2;
+      xu[3] = -su;
+      xv[0] = ((-0.5*su*sv2-0.5*s2u*cv2)*cv-
+               (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*sv);
+      xv[1] = ((-0.5*su*sv2-0.5*s2u*cv2)*sv+
+               (su*cv2-s2u*sv2+FIGURE_8_RADIUS)*cv);
+      xv[2] = 0.5*su*cv2-0.5*s2u*sv2;
+      xv[3] = 0.0;
       for (l=0; l<4; l++)
       {
-        kb->x[k][l] /= FIGURE_8_RADIUS+1.25;
-        kb->xu[k][l] /= FIGURE_8_RADIUS+1.25;
-        kb->xv[k][l] /= FIGURE_8_RADIUS+1.25;
+        x[l] /= FIGURE_8_RADIUS+1.25;
+        xu[l] /= FIGURE_8_RADIUS+1.25;
+        xv[l] /= FIGURE_8_RADIUS+1.25;
       }
+      surface4d_set_point(kb->surface,i,j,x,xu,xv);
+      if (colors != COLORS_TWOSIDED)
+        surface4d_set_color(kb->surface,i,j,col);
+      surface4d_set_texcoord(kb->surface,i,j,tex);
     }
   }
 }
@@ -874,9 +871,10 @@ static void setup_figure8(ModeInfo *mi, double umin, double umax, double vmin,
 static void setup_squeezed_torus(ModeInfo *mi, double umin, double umax,
                                  double vmin, double vmax)
 {
-  int i, j, k, l;
+  int i, j, l;
   double u, v, ur, vr;
   double cu, su, cv, sv, cv2, sv2;
+  float x[4], xu[4], xv[4], col[4], tex[2];
   kleinstruct *kb = &klein[MI_SCREEN(mi)];
 
   ur = umax-umin;
@@ -885,39 +883,42 @@ static void setup_squeezed_torus(ModeInfo *mi, double umin, double umax,
   {
     for (j=0; j<=NUMV; j++)
     {
-      k = i*(NUMV+1)+j;
       u = -ur*j/NUMU+umin;
       v = vr*i/NUMV+vmin;
       if (colors == COLORS_DEPTH)
-        color((sin(u)*sin(0.5*v)+1.0)*M_PI*2.0/3.0,kb->col[k]);
+        color((sin(u)*sin(0.5*v)+1.0)*M_PI*2.0/3.0,col);
       else
-        color(v,kb->col[k]);
-      kb->tex[k][0] = -32*u/(2.0*M_PI);
-      kb->tex[k][1] = 32*v/(2.0*M_PI);
+        color(v,col);
+      tex[0] = -32*u/(2.0*M_PI);
+      tex[1] = 32*v/(2.0*M_PI);
       cu = cos(u);
       su = sin(u);
       cv = cos(v);
       sv = sin(v);
       cv2 = cos(0.5*v);
       sv2 = sin(0.5*v);
-      kb->x[k][0] = (SQUEEZED_TORUS_RADIUS+cu)*cv;
-      kb->x[k][1] = (SQUEEZED_TORUS_RADIUS+cu)*sv;
-      kb->x[k][2] = su*cv2;
-      kb->x[k][3] = su*sv2;
-      kb->xu[k][0] = -su*cv;
-      kb->xu[k][1] = -su*sv;
-      kb->xu[k][2] = cu*cv2;
-      kb->xu[k][3] = cu*sv2;
-      kb->xv[k][0] = -(SQUEEZED_TORUS_RADIUS+cu)*sv;
-      kb->xv[k][1] = (SQUEEZED_TORUS_RADIUS+cu)*cv;
-      kb->xv[k][2] = -0.5*su*sv2;
-      kb->xv[k][3] = 0.5*su*cv2;
+      x[0] = (SQUEEZED_TORUS_RADIUS+cu)*cv;
+      x[1] = (SQUEEZED_TORUS_RADIUS+cu)*sv;
+      x[2] = su*cv2;
+      x[3] = su*sv2;
+      xu[0] = -su*cv;
+      xu[1] = -su*sv;
+      xu[2] = cu*cv2;
+      xu[3] = cu*sv2;
+      xv[0] = -(SQUEEZED_TORUS_RADIUS+cu)*sv;
+      xv[1] = (SQUEEZED_TORUS_RADIUS+cu)*cv;
+      xv[2] = -0.5*su*sv2;
+      xv[3] = 0.5*su*cv2;
       for (l=0; l<4; l++)
       {
-        kb->x[k][l] /= SQUEEZED_TORUS_RADIUS+1.25;
-        kb->xu[k][l] /= SQUEEZED_TORUS_RADIUS+1.25;
-        kb->xv[k][l] /= SQUEEZED_TORUS_RADIUS+1.25;
+        x[l] /= SQUEEZED_TORUS_RADIUS+1.25;
+        xu[l] /= SQUEEZED_TORUS_RADIUS+1.25;
+        xv[l] /= SQUEEZED_TORUS_RADIUS+1.25;
       }
+      surface4d_set_point(kb->surface,i,j,x,xu,xv);
+      if (colors != COLORS_TWOSIDED)
+        surface4d_set_color(kb->surface,i,j,col);
+      surface4d_set_texcoord(kb->surface,i,j,tex);
     }
   }
 }
@@ -927,9 +928,10 @@ static void setup_squeezed_torus(ModeInfo *mi, double umin, double umax,
 static void setup_lawson(ModeInfo *mi, double umin, double umax, double vmin,
                          double vmax)
 {
-  int i, j, k;
+  int i, j;
   double u, v, ur, vr;
   double cu, su, cv, sv, cv2, sv2;
+  float x[4], xu[4], xv[4], col[4], tex[2];
   kleinstruct *kb = &klein[MI_SCREEN(mi)];
 
   ur = umax-umin;
@@ -938,33 +940,36 @@ static void setup_lawson(ModeInfo *mi, double umin, double umax, double vmin,
   {
     for (j=0; j<=NUMU; j++)
     {
-      k = i*(NUMU+1)+j;
       u = -ur*j/NUMU+umin;
       v = vr*i/NUMV+vmin;
       if (colors == COLORS_DEPTH)
-        color((sin(u)*cos(0.5*v)+1.0)*M_PI*2.0/3.0,kb->col[k]);
+        color((sin(u)*cos(0.5*v)+1.0)*M_PI*2.0/3.0,col);
       else
-        color(v,kb->col[k]);
-      kb->tex[k][0] = -32*u/(2.0*M_PI);
-      kb->tex[k][1] = 32*v/(2.0*M_PI);
+        color(v,col);
+      tex[0] = -32*u/(2.0*M_PI);
+      tex[1] = 32*v/(2.0*M_PI);
       cu = cos(u);
       su = sin(u);
       cv = cos(v);
       sv = sin(v);
       cv2 = cos(0.5*v);
       sv2 = sin(0.5*v);
-      kb->x[k][0] = cu*cv;
-      kb->x[k][1] = cu*sv;
-      kb->x[k][2] = su*sv2;
-      kb->x[k][3] = su*cv2;
-      kb->xu[k][0] = -su*cv;
-      kb->xu[k][1] = -su*sv;
-      kb->xu[k][2] = cu*sv2;
-      kb->xu[k][3] = cu*cv2;
-      kb->xv[k][0] = -cu*sv;
-      kb->xv[k][1] = cu*cv;
-      kb->xv[k][2] = su*cv2*0.5;
-      kb->xv[k][3] = -su*sv2*0.5;
+      x[0] = cu*cv;
+      x[1] = cu*sv;
+      x[2] = su*sv2;
+      x[3] = su*cv2;
+      xu[0] = -su*cv;
+      xu[1] = -su*sv;
+      xu[2] = cu*sv2;
+      xu[3] = cu*cv2;
+      xv[0] = -cu*sv;
+      xv[1] = cu*cv;
+      xv[2] = su*cv2*0.5;
+      xv[3] = -su*sv2*0.5;
+      surface4d_set_point(kb->surface,i,j,x,xu,xv);
+      if (colors != COLORS_TWOSIDED)
+        surface4d_set_color(kb->surface,i,j,col);
+      surface4d_set_texcoord(kb->surface,i,j,tex);
     }
   }
 }
@@ -974,13 +979,12 @@ static void setup_lawson(ModeInfo *mi, double umin, double umax, double vmin,
 static int figure8(ModeInfo *mi, double umin, double umax, double vmin,
                    double vmax)
 {
-  int polys = 0;
   static const GLfloat mat_diff_red[]         = { 1.0, 0.0, 0.0, 1.0 };
   static const GLfloat mat_diff_green[]       = { 0.0, 1.0, 0.0, 1.0 };
   static const GLfloat mat_diff_trans_red[]   = { 1.0, 0.0, 0.0, 0.7 };
   static const GLfloat mat_diff_trans_green[] = { 0.0, 1.0, 0.0, 0.7 };
   float p[3], pu[3], pv[3], pm[3], n[3], b[3], mat[4][4];
-  int i, j, k, l, m, o;
+  int l, m;
   double u, v;
   double xx[4], xxu[4], xxv[4], y[4], yu[4], yv[4];
   double q, r, s, t;
@@ -1142,52 +1146,8 @@ static int figure8(ModeInfo *mi, double umin, double umax, double vmin,
   }
 
   /* Project the points from 4D to 3D. */
-  for (i=0; i<=NUMU; i++)
-  {
-    for (j=0; j<=NUMV; j++)
-    {
-      o = i*(NUMV+1)+j;
-      for (l=0; l<4; l++)
-      {
-        y[l] = (mat[l][0]*kb->x[o][0]+mat[l][1]*kb->x[o][1]+
-                mat[l][2]*kb->x[o][2]+mat[l][3]*kb->x[o][3]);
-        yu[l] = (mat[l][0]*kb->xu[o][0]+mat[l][1]*kb->xu[o][1]+
-                 mat[l][2]*kb->xu[o][2]+mat[l][3]*kb->xu[o][3]);
-        yv[l] = (mat[l][0]*kb->xv[o][0]+mat[l][1]*kb->xv[o][1]+
-                 mat[l][2]*kb->xv[o][2]+mat[l][3]*kb->xv[o][3]);
-      }
-      if (projection_4d == DISP_4D_ORTHOGRAPHIC)
-      {
-        for (l=0; l<3; l++)
-        {
-          kb->pp[o][l] = (y[l]+kb->offset4d[l])+kb->offset3d[l];
-          pu[l] = yu[l];
-          pv[l] = yv[l];
-        }
-      }
-      else
-      {
-        s = y[3]+kb->offset4d[3];
-        q = 1.0/s;
-        t = q*q;
-        for (l=0; l<3; l++)
-        {
-          r = y[l]+kb->offset4d[l];
-          kb->pp[o][l] = r*q+kb->offset3d[l];
-          pu[l] = (yu[l]*s-r*yu[3])*t;
-          pv[l] = (yv[l]*s-r*yv[3])*t;
-        }
-      }
-      kb->pn[o][0] = pu[1]*pv[2]-pu[2]*pv[1];
-      kb->pn[o][1] = pu[2]*pv[0]-pu[0]*pv[2];
-      kb->pn[o][2] = pu[0]*pv[1]-pu[1]*pv[0];
-      t = 1.0/sqrt(kb->pn[o][0]*kb->pn[o][0]+kb->pn[o][1]*kb->pn[o][1]+
-                   kb->pn[o][2]*kb->pn[o][2]);
-      kb->pn[o][0] *= t;
-      kb->pn[o][1] *= t;
-      kb->pn[o][2] *= t;
-    }
-  }
+  surface4d_project(kb->surface,mat,kb->offset4d,kb->offset3d,1.0,
+                    projection_4d == DISP_4D_PERSPECTIVE);
 
   if (colors == COLORS_TWOSIDED)
   {
@@ -1205,36 +1165,7 @@ static int figure8(ModeInfo *mi, double umin, double umax, double vmin,
   }
   glBindTexture(GL_TEXTURE_2D,kb->tex_name);
 
-  for (i=0; i<NUMU; i++)
-  {
-    if (appearance == APPEARANCE_BANDS && ((i & (NUMB-1)) >= NUMB/2))
-      continue;
-    if (display_mode == DISP_WIREFRAME)
-      glBegin(GL_QUAD_STRIP);
-    else
-      glBegin(GL_TRIANGLE_STRIP);
-    for (j=0; j<=NUMV; j++)
-    {
-      for (k=0; k<=1; k++)
-      {
-        l = (i+k);
-        m = j;
-        o = l*(NUMV+1)+m;
-        glNormal3fv(kb->pn[o]);
-        glTexCoord2fv(kb->tex[o]);
-        if (colors != COLORS_TWOSIDED)
-        {
-          glColor3fv(kb->col[o]);
-          glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,kb->col[o]);
-        }
-        glVertex3fv(kb->pp[o]);
-        polys++;
-      }
-    }
-    glEnd();
-  }
-  polys /= 2;
-  return polys;
+  return surface4d_draw(kb->surface,display_mode == DISP_WIREFRAME);
 }
 
 
@@ -1242,13 +1173,12 @@ static int figure8(ModeInfo *mi, double umin, double umax, double vmin,
 static int squeezed_torus(ModeInfo *mi, double umin, double umax, double vmin,
                           double vmax)
 {
-  int polys = 0;
   static const GLfloat mat_diff_red[]         = { 1.0, 0.0, 0.0, 1.0 };
   static const GLfloat mat_diff_green[]       = { 0.0, 1.0, 0.0, 1.0 };
   static const GLfloat mat_diff_trans_red[]   = { 1.0, 0.0, 0.0, 0.7 };
   static const GLfloat mat_diff_trans_green[] = { 0.0, 1.0, 0.0, 0.7 };
   float p[3], pu[3], pv[3], pm[3], n[3], b[3], mat[4][4];
-  int i, j, k, l, m, o;
+  int l, m;
   double u, v;
   double xx[4], xxu[4], xxv[4], y[4], yu[4], yv[4];
   double q, r, s, t;
@@ -1404,52 +1334,8 @@ static int squeezed_torus(ModeInfo *mi, double umin, double umax, double vmin,
   }
 
   /* Project the points from 4D to 3D. */
-  for (i=0; i<=NUMU; i++)
-  {
-    for (j=0; j<=NUMV; j++)
-    {
-      o = i*(NUMV+1)+j;
-      for (l=0; l<4; l++)
-      {
-        y[l] = (mat[l][0]*kb->x[o][0]+mat[l][1]*kb->x[o][1]+
-                mat[l][2]*kb->x[o][2]+mat[l][3]*kb->x[o][3]);
-        yu[l] = (mat[l][0]*kb->xu[o][0]+mat[l][1]*kb->xu[o][1]+
-                 mat[l][2]*kb->xu[o][2]+mat[l][3]*kb->xu[o][3]);
-        yv[l] = (mat[l][0]*kb->xv[o][0]+mat[l][1]*kb->xv[o][1]+
-                 mat[l][2]*kb->xv[o][2]+mat[l][3]*kb->xv[o][3]);
-      }
-      if (projection_4d == DISP_4D_ORTHOGRAPHIC)
-      {
-        for (l=0; l<3; l++)
-        {
-          kb->pp[o][l] = (y[l]+kb->offset4d[l])+kb->offset3d[l];
-          pu[l] = yu[l];
-          pv[l] = yv[l];
-        }
-      }
-      else
-      {
-        s = y[3]+kb->offset4d[3];
-        q = 1.0/s;
-        t = q*q;
-        for (l=0; l<3; l++)
-        {
-          r = y[l]+kb->offset4d[l];
-          kb->pp[o][l] = r*q+kb->offset3d[l];
-          pu[l] = (yu[l]*s-r*yu[3])*t;
-          pv[l] = (yv[l]*s-r*yv[3])*t;
-        }
-      }
-      kb->pn[o][0] = pu[1]*pv[2]-pu[2]*pv[1];
-      kb->pn[o][1] = pu[2]*pv[0]-pu[0]*pv[2];
-      kb->pn[o][2] = pu[0]*pv[1]-pu[1]*pv[0];
-      t = 1.0/sqrt(kb->pn[o][0]*kb->pn[o][0]+kb->pn[o][1]*kb->pn[o][1]+
-                   kb->pn[o][2]*kb->pn[o][2]);
-      kb->pn[o][0] *= t;
-      kb->pn[o][1] *= t;
-      kb->pn[o][2] *= t;
-    }
-  }
+  surface4d_project(kb->surface,mat,kb->offset4d,kb->offset3d,1.0,
+                    projection_4d == DISP_4D_PERSPECTIVE);
 
   if (colors == COLORS_TWOSIDED)
   {
@@ -1467,36 +1353,7 @@ static int squeezed_torus(ModeInfo *mi, double umin, double umax, double vmin,
   }
   glBindTexture(GL_TEXTURE_2D,kb->tex_name);
 
-  for (i=0; i<NUMU; i++)
-  {
-    if (appearance == APPEARANCE_BANDS && ((i & (NUMB-1)) >= NUMB/2))
-      continue;
-    if (display_mode == DISP_WIREFRAME)
-      glBegin(GL_QUAD_STRIP);
-    else
-      glBegin(GL_TRIANGLE_STRIP);
-    for (j=0; j<=NUMV; j++)
-    {
-      for (k=0; k<=1; k++)
-      {
-        l = (i+k);
-        m = j;
-        o = l*(NUMV+1)+m;
-        glNormal3fv(kb->pn[o]);
-        glTexCoord2fv(kb->tex[o]);
-        if (colors != COLORS_TWOSIDED)
-        {
-          glColor3fv(kb->col[o]);
-          glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,kb->col[o]);
-        }
-        glVertex3fv(kb->pp[o]);
-        polys++;
-      }
-    }
-    glEnd();
-  }
-  polys /= 2;
-  return polys;
+  return surface4d_draw(kb->surface,display_mode == DISP_WIREFRAME);
 }
 
 
@@ -1504,13 +1361,12 @@ static int squeezed_torus(ModeInfo *mi, double umin, double umax, double vmin,
 static int lawson(ModeInfo *mi, double umin, double umax, double vmin,
                   double vmax)
 {
-  int polys = 0;
   static const GLfloat mat_diff_red[]         = { 1.0, 0.0, 0.0, 1.0 };
   static const GLfloat mat_diff_green[]       = { 0.0, 1.0, 0.0, 1.0 };
   static const GLfloat mat_diff_trans_red[]   = { 1.0, 0.0, 0.0, 0.7 };
   static const GLfloat mat_diff_trans_green[] = { 0.0, 1.0, 0.0, 0.7 };
   float p[3], pu[3], pv[3], pm[3], n[3], b[3], mat[4][4];
-  int i, j, k, l, m, o;
+  int l, m;
   double u, v;
   double cu, su, cv, sv, cv2, sv2;
   double xx[4], xxu[4], xxv[4], y[4], yu[4], yv[4];
@@ -1658,52 +1514,8 @@ static int lawson(ModeInfo *mi, double umin, double umax, double vmin,
   }
 
   /* Project the points from 4D to 3D. */
-  for (i=0; i<=NUMV; i++)
-  {
-    for (j=0; j<=NUMU; j++)
-    {
-      o = i*(NUMU+1)+j;
-      for (l=0; l<4; l++)
-      {
-        y[l] = (mat[l][0]*kb->x[o][0]+mat[l][1]*kb->x[o][1]+
-                mat[l][2]*kb->x[o][2]+mat[l][3]*kb->x[o][3]);
-        yu[l] = (mat[l][0]*kb->xu[o][0]+mat[l][1]*kb->xu[o][1]+
-                 mat[l][2]*kb->xu[o][2]+mat[l][3]*kb->xu[o][3]);
-        yv[l] = (mat[l][0]*kb->xv[o][0]+mat[l][1]*kb->xv[o][1]+
-                 mat[l][2]*kb->xv[o][2]+mat[l][3]*kb->xv[o][3]);
-      }
-      if (projection_4d == DISP_4D_ORTHOGRAPHIC)
-      {
-        for (l=0; l<3; l++)
-        {
-          kb->pp[o][l] = (y[l]+kb->offset4d[l])+kb->offset3d[l];
-          pu[l] = yu[l];
-          pv[l] = yv[l];
-        }
-      }
-      else
-      {
-        s = y[3]+kb->offset4d[3];
-        q = 1.0/s;
-        t = q*q;
-        for (l=0; l<3; l++)
-        {
-          r = y[l]+kb->offset4d[l];
-          kb->pp[o][l] = r*q+kb->offset3d[l];
-          pu[l] = (yu[l]*s-r*yu[3])*t;
-          pv[l] = (yv[l]*s-r*yv[3])*t;
-        }
-      }
-      kb->pn[o][0] = pu[1]*pv[2]-pu[2]*pv[1];
-      kb->pn[o][1] = pu[2]*pv[0]-pu[0]*pv[2];
-      kb->pn[o][2] = pu[0]*pv[1]-pu[1]*pv[0];
-      t = 1.0/sqrt(kb->pn[o][0]*kb->pn[o][0]+kb->pn[o][1]*kb->pn[o][1]+
-                   kb->pn[o][2]*kb->pn[o][2]);
-      kb->pn[o][0] *= t;
-      kb->pn[o][1] *= t;
-      kb->pn[o][2] *= t;
-    }
-  }
+  surface4d_project(kb->surface,mat,kb->offset4d,kb->offset3d,1.0,
+                    projection_4d == DISP_4D_PERSPECTIVE);
 
   if (colors == COLORS_TWOSIDED)
   {
@@ -1721,36 +1533,7 @@ static int lawson(ModeInfo *mi, double umin, double umax, double vmin,
   }
   glBindTexture(GL_TEXTURE_2D,kb->tex_name);
 
-  for (i=0; i<NUMV; i++)
-  {
-    if (appearance == APPEARANCE_BANDS && ((i & (NUMB-1)) >= NUMB/2))
-      continue;
-    if (display_mode == DISP_WIREFRAME)
-      glBegin(GL_QUAD_STRIP);
-    else
-      glBegin(GL_TRIANGLE_STRIP);
-    for (j=0; j<=NUMU; j++)
-    {
-      for (k=0; k<=1; k++)
-      {
-        l = (i+k);
-        m = j;
-        o = l*(NUMU+1)+m;
-        glNormal3fv(kb->pn[o]);
-        glTexCoord2fv(kb->tex[o]);
-        if (colors != COLORS_TWOSIDED)
-        {
-          glColor3fv(kb->col[o]);
-          glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,kb->col[o]);
-        }
-        glVertex3fv(kb->pp[o]);
-        polys++;
-      }
-    }
-    glEnd();
-  }
-  polys /= 2;
-  return polys;
+  return surface4d_draw(kb->surface,display_mode == DISP_WIREFRAME);
 }
 
 
@@ -1779,6 +1562,7 @@ static void init(ModeInfo *mi)
   static const GLfloat light_specular[] = { 1.0, 1.0, 1.0, 1.0 };
   static const GLfloat light_position[] = { 1.0, 1.0, 1.0, 0.0 };
   static const GLfloat mat_specular[]   = { 1.0, 1.0, 1.0, 1.0 };
+  int i, n;
   kleinstruct *kb = &klein[MI_SCREEN(mi)];
 
   if (walk_speed == 0.0)
@@ -1854,12 +1638,35 @@ static void init(ModeInfo *mi)
   }
 
   gen_texture(mi);
+  surface4d_free(kb->surface);
+  /* The Lawson bottle's rows go in the v direction, the others' in u. */
+  if (bottle_type == KLEIN_BOTTLE_LAWSON)
+  {
+    n = NUMV;
+    kb->surface = surface4d_new(NUMV,NUMU);
+  }
+  else
+  {
+    n = NUMU;
+    kb->surface = surface4d_new(NUMU,NUMV);
+  }
+  if (!kb->surface)
+  {
+    fprintf(stderr,"%s: out of memory\n",progname);
+    exit(1);
+  }
   if (bottle_type == KLEIN_BOTTLE_FIGURE_8)
     setup_figure8(mi,0.0,2.0*M_PI,0.0,2.0*M_PI);
   else if (bottle_type == KLEIN_BOTTLE_SQUEEZED_TORUS)
     setup_squeezed_torus(mi,0.0,2.0*M_PI,0.0,2.0*M_PI);
   else /* bottle_type == KLEIN_BOTTLE_LAWSON */
     setup_lawson(mi,0.0,2.0*M_PI,0.0,2.0*M_PI);
+  for (i=0; i<n; i++)
+  {
+    if (appearance == APPEARANCE_BANDS && ((i & (NUMB-1)) >= NUMB/2))
+      continue;
+    surface4d_add_strip(kb->surface,i,False);
+  }
 
   if (marks)
     glEnable(GL_TEXTURE_2D);
@@ -2364,6 +2171,7 @@ ENTRYPOINT void release_klein(ModeInfo *mi)
 
       if (kb->glx_context)
         kb->glx_context = (GLXContext *)NULL;
+      surface4d_free(kb->surface);
     }
     (void) free((void *)klein);
     klein = (kleinstruct *)NULL;
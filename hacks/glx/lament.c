@@ -1779,7 +1779,6 @@ draw_lament (ModeInfo *mi)
   draw(mi);
   if (mi->fps_p) do_fps (mi);
 
-  glFinish();
   glXSwapBuffers(dpy, window);
 
   if (!lc->ffwdp && lc->anim_pause)
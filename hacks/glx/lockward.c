@@ -812,7 +812,6 @@ draw_lockward (ModeInfo *mi)
 	glPopMatrix ();
 
 	if (MI_IS_FPS (mi)) do_fps (mi);
-	glFinish();
 
 	glXSwapBuffers (dpy, window);
 }
@@ -0,0 +1,238 @@
+/* meshnormals, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *
+ * The triangles around each vertex are kept as one array, sorted by vertex,
+ * with the index of each vertex's first one alongside.  Computing the
+ * normals is then two passes: one over the triangles, for their normals,
+ * and one over the vertexes, adding up the normals of their triangles.
+ * Neither pass writes anything that another part of it reads, so each can
+ * be split among threads.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef HAVE_COCOA
+# include "jwxyz.h"
+#else
+# include <X11/Xlib.h>
+#endif
+
+#include "thread_util.h"
+#include "meshnormals.h"
+
+/* Below this, the threads would take longer to wake up than the work. */
+#define MIN_THREADED_TRIANGLES 16384
+
+struct mesh_normals_thread {
+  mesh_normals *mn;
+  unsigned id;
+};
+
+struct mesh_normals {
+  int nvertices, ntriangles;
+  int *triangles;		/* 3 vertexes each */
+  int *first;			/* per vertex, its first entry in faces */
+  int *faces;			/* the triangles around each vertex */
+  XYZ *face_normals;
+
+  const XYZ *vertices;		/* during mesh_normals_compute */
+  XYZ *normals;
+
+  struct threadpool pool;	/* count is 0 if unthreaded */
+};
+
+
+static void
+face_normals (mesh_normals *mn, int from, int to)
+{
+  const XYZ *v = mn->vertices;
+  int t;
+  for (t = from; t < to; t++)
+    {
+      const int *tri = mn->triangles + t * 3;
+      const XYZ *a = &v[tri[0]], *b = &v[tri[1]], *c = &v[tri[2]];
+      double ux = b->x - a->x, uy = b->y - a->y, uz = b->z - a->z;
+      double vx = c->x - a->x, vy = c->y - a->y, vz = c->z - a->z;
+
+      /* Not normalized: its length is twice the triangle's area. */
+      mn->face_normals[t].x = uy * vz - uz * vy;
+      mn->face_normals[t].y = uz * vx - ux * vz;
+      mn->face_normals[t].z = ux * vy - uy * vx;
+    }
+}
+
+
+static void
+vertex_normals (mesh_normals *mn, int from, int to)
+{
+  int v;
+  for (v = from; v < to; v++)
+    {
+      double x = 0, y = 0, z = 0, d;
+      int f;
+      for (f = mn->first[v]; f < mn->first[v+1]; f++)
+        {
+          const XYZ *n = &mn->face_normals[mn->faces[f]];
+          x += n->x;
+          y += n->y;
+          z += n->z;
+        }
+
+      d = sqrt (x*x + y*y + z*z);
+      if (d > 0)
+        {
+          d = 1 / d;
+          x *= d;
+          y *= d;
+          z *= d;
+        }
+      mn->normals[v].x = x;
+      mn->normals[v].y = y;
+      mn->normals[v].z = z;
+    }
+}
+
+
+static int
+mesh_normals_thread_create (void *self_raw, struct threadpool *pool,
+                            unsigned id)
+{
+  struct mesh_normals_thread *self = (struct mesh_normals_thread *) self_raw;
+  mesh_normals *mn = GET_PARENT_OBJ (mesh_normals, pool, pool);
+  self->mn = mn;
+  self->id = id;
+  return 0;
+}
+
+static void
+mesh_normals_thread_destroy (void *self_raw)
+{
+}
+
+/* This thread's share of 0 ... n. */
+static void
+thread_range (struct mesh_normals_thread *self, int n, int *from, int *to)
+{
+  unsigned count = self->mn->pool.count;
+  *from = (int) ((double) n * self->id / count);
+  *to   = (int) ((double) n * (self->id + 1) / count);
+}
+
+static void
+face_normals_thread (void *self_raw)
+{
+  struct mesh_normals_thread *self = (struct mesh_normals_thread *) self_raw;
+  int from, to;
+  thread_range (self, self->mn->ntriangles, &from, &to);
+  face_normals (self->mn, from, to);
+}
+
+static void
+vertex_normals_thread (void *self_raw)
+{
+  struct mesh_normals_thread *self = (struct mesh_normals_thread *) self_raw;
+  int from, to;
+  thread_range (self, self->mn->nvertices, &from, &to);
+  vertex_normals (self->mn, from, to);
+}
+
+
+mesh_normals *
+mesh_normals_new (Display *dpy, int nvertices, int ntriangles,
+                  const int *triangles)
+{
+  mesh_normals *mn = (mesh_normals *) calloc (1, sizeof(*mn));
+  int i;
+
+  if (!mn) return 0;
+  mn->nvertices = nvertices;
+  mn->ntriangles = ntriangles;
+  mn->triangles = (int *) malloc (ntriangles * 3 * sizeof(*mn->triangles));
+  mn->first = (int *) calloc (nvertices + 1, sizeof(*mn->first));
+  mn->faces = (int *) malloc (ntriangles * 3 * sizeof(*mn->faces));
+  mn->face_normals = (XYZ *) malloc (ntriangles * sizeof(*mn->face_normals));
+  if (!mn->triangles || !mn->first || !mn->faces || !mn->face_normals)
+    {
+      mesh_normals_free (mn);
+      return 0;
+    }
+
+  memcpy (mn->triangles, triangles, ntriangles * 3 * sizeof(*triangles));
+
+  /* Count the triangles around each vertex, then turn the counts into
+     where each vertex's list ends, then fill the lists in backwards so
+     that first[v] ends up where its list begins. */
+  for (i = 0; i < ntriangles * 3; i++)
+    mn->first[triangles[i]]++;
+  for (i = 1; i < nvertices; i++)
+    mn->first[i] += mn->first[i - 1];
+  mn->first[nvertices] = ntriangles * 3;
+  for (i = ntriangles * 3 - 1; i >= 0; i--)
+    mn->faces[--mn->first[triangles[i]]] = i / 3;
+
+  if (ntriangles >= MIN_THREADED_TRIANGLES &&
+      threads_available (dpy) > 0 &&
+      hardware_concurrency (dpy) > 1)
+    {
+      static const struct threadpool_class cls = {
+        sizeof(struct mesh_normals_thread),
+        mesh_normals_thread_create,
+        mesh_normals_thread_destroy
+      };
+      if (threadpool_create (&mn->pool, &cls, dpy, hardware_concurrency (dpy)))
+        mn->pool.count = 0;  /* Do it on this thread, then. */
+    }
+
+  return mn;
+}
+
+
+void
+mesh_normals_free (mesh_normals *mn)
+{
+  if (!mn) return;
+  if (mn->pool.count)
+    threadpool_destroy (&mn->pool);
+  if (mn->triangles)    free (mn->triangles);
+  if (mn->first)        free (mn->first);
+  if (mn->faces)        free (mn->faces);
+  if (mn->face_normals) free (mn->face_normals);
+  free (mn);
+}
+
+
+void
+mesh_normals_compute (mesh_normals *mn, const XYZ *vertices, XYZ *normals)
+{
+  mn->vertices = vertices;
+  mn->normals = normals;
+
+  if (mn->pool.count)
+    {
+      threadpool_run (&mn->pool, face_normals_thread);
+      threadpool_wait (&mn->pool);
+      threadpool_run (&mn->pool, vertex_normals_thread);
+      threadpool_wait (&mn->pool);
+    }
+  else
+    {
+      face_normals (mn, 0, mn->ntriangles);
+      vertex_normals (mn, 0, mn->nvertices);
+    }
+
+  mn->vertices = 0;
+  mn->normals = 0;
+}
@@ -0,0 +1,49 @@
+/* meshnormals, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *
+ * Smooth vertex normals for triangle meshes built at run time.
+ */
+
+#ifndef __MESHNORMALS_H__
+#define __MESHNORMALS_H__
+
+#include "normals.h"
+
+/* A vertex normal is the sum of the normals of the triangles around the
+   vertex, each as long as its triangle is big, normalized.  Rather than
+   searching every triangle for every vertex, this finds which triangles
+   are around which vertex once, when the mesh is made; after that, the
+   normals can be computed in time proportional to the size of the mesh,
+   as often as the vertexes move:
+
+     mesh_normals *mn = mesh_normals_new (dpy, nverts, ntris, tris);
+     mesh_normals_compute (mn, verts, normals);
+     ...
+     mesh_normals_free (mn);
+
+   Big meshes are done on several threads.
+ */
+
+typedef struct mesh_normals mesh_normals;
+
+/* The triangles are 3 vertex indexes each, counterclockwise seen from
+   the front.  They are copied.  Returns 0 if out of memory.
+ */
+extern mesh_normals *mesh_normals_new (Display *, int nvertices,
+                                       int ntriangles, const int *triangles);
+extern void mesh_normals_free (mesh_normals *);
+
+/* Fills in the unit normal of each vertex.  A vertex that is on no
+   triangle, or only on degenerate ones, gets 0,0,0.
+ */
+extern void mesh_normals_compute (mesh_normals *, const XYZ *vertices,
+                                  XYZ *normals);
+
+#endif /* __MESHNORMALS_H__ */
@@ -1729,7 +1729,6 @@ draw_mirrorblob(ModeInfo * mi)
   glXMakeCurrent(display, window, *(gp->glx_context));
   draw_scene(mi);
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers(display, window);
 }
 
@@ -418,7 +418,6 @@ draw_mgears (ModeInfo *mi)
 #endif
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
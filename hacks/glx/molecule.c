@@ -1222,7 +1222,6 @@ startup_blurb (ModeInfo *mi)
   print_texture_label (mi->dpy, mc->title_font,
                        mi->xgwa.width, mi->xgwa.height,
                        0, s);
-  glFinish();
   glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
 }
 
@@ -1664,7 +1663,6 @@ draw_molecule (ModeInfo *mi)
   mi->polygon_count = mc->polygon_count;
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
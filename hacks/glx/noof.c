@@ -406,10 +406,11 @@ draw_noof (ModeInfo *mi)
   }
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   if (dbuf_p)
     glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
+  else
+    glFlush();
 }
 
 
@@ -381,7 +381,6 @@ loading_msg (ModeInfo *mi)
 
   glMatrixMode(GL_MODELVIEW);
 
-  glFinish();
   glXSwapBuffers (MI_DISPLAY (mi), MI_WINDOW(mi));
 }
 
@@ -778,7 +777,6 @@ draw_photopile (ModeInfo *mi)
   }
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers (MI_DISPLAY (mi), MI_WINDOW(mi));
 }
 
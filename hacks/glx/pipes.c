@@ -1146,7 +1146,6 @@ draw_pipes (ModeInfo * mi)
     glPopMatrix();
 
     if (mi->fps_p) do_fps (mi);
-    glFinish();
 
     glXSwapBuffers(display, window);
 }
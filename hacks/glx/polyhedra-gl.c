@@ -188,7 +188,6 @@ startup_blurb (ModeInfo *mi)
   print_texture_label (mi->dpy, f,
                        mi->xgwa.width, mi->xgwa.height,
                        0, s);
-  glFinish();
   glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
 }
 
@@ -663,7 +662,6 @@ draw_polyhedra (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
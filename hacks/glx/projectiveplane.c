@@ -229,6 +229,7 @@ static const char sccsid[] = "@(#)projectiveplane.c  1.1 14/01/01 xlockmore";
 #endif
 
 #include "gltrackball.h"
+#include "surface4d.h"
 
 #include <float.h>
 
@@ -350,16 +351,8 @@ typedef struct {
   float offset4d[4];
   /* The viewing offset in 3d */
   float offset3d[4];
-  /* The 4d coordinates of the projective plane and their derivatives */
-  float x[(NUMU+1)*(NUMV+1)][4];
-  float xu[(NUMU+1)*(NUMV+1)][4];
-  float xv[(NUMU+1)*(NUMV+1)][4];
-  float pp[(NUMU+1)*(NUMV+1)][3];
-  float pn[(NUMU+1)*(NUMV+1)][3];
-  /* The precomputed colors of the projective plane */
-  float col[(NUMU+1)*(NUMV+1)][4];
-  /* The precomputed texture coordinates of the projective plane */
-  float tex[(NUMU+1)*(NUMV+1)][2];
+  /* The surface, sampled once */
+  surface4d *surface;
   /* The "curlicue" texture */
   GLuint tex_name;
   /* Aspect ratio of the current window */
@@ -891,9 +884,10 @@ static void color(double angle, float col[4])
 static void setup_projective_plane(ModeInfo *mi, double umin, double umax,
                                    double vmin, double vmax)
 {
-  int i, j, k;
+  int i, j;
   double u, v, ur, vr;
   double cu, su, cv2, sv2, cv4, sv4, c2u, s2u;
+  float x[4], xu[4], xv[4], col[4], tex[2];
   projectiveplanestruct *pp = &projectiveplane[MI_SCREEN(mi)];
 
   ur = umax-umin;
@@ -902,7 +896,6 @@ static void setup_projective_plane(ModeInfo *mi, double umin, double umax,
   {
     for (j=0; j<=NUMU; j++)
     {
-      k = i*(NUMU+1)+j;
       if (appearance != APPEARANCE_DIRECTION_BANDS)
         u = -ur*j/NUMU+umin;
       else
@@ -916,34 +909,38 @@ static void setup_projective_plane(ModeInfo *mi, double umin, double umax,
       cv4 = cos(0.25*v);
       sv4 = sin(0.25*v);
       if (colors == COLORS_DEPTH)
-        color(((su*su*sv4*sv4-cv4*cv4)+1.0)*M_PI*2.0/3.0,pp->col[k]);
+        color(((su*su*sv4*sv4-cv4*cv4)+1.0)*M_PI*2.0/3.0,col);
       else if (colors == COLORS_DIRECTION)
-        color(2.0*M_PI+fmod(2.0*u,2.0*M_PI),pp->col[k]);
+        color(2.0*M_PI+fmod(2.0*u,2.0*M_PI),col);
       else /* colors == COLORS_DISTANCE */
-        color(v*(5.0/6.0),pp->col[k]);
-      pp->tex[k][0] = -32*u/(2.0*M_PI);
+        color(v*(5.0/6.0),col);
+      tex[0] = -32*u/(2.0*M_PI);
       if (appearance != APPEARANCE_DISTANCE_BANDS)
-        pp->tex[k][1] = 32*v/(2.0*M_PI);
+        tex[1] = 32*v/(2.0*M_PI);
       else
-        pp->tex[k][1] = 32*v/(2.0*M_PI)-0.5;
-      pp->x[k][0] = 0.5*s2u*sv4*sv4;
-      pp->x[k][1] = 0.5*su*sv2;
-      pp->x[k][2] = 0.5*cu*sv2;
-      pp->x[k][3] = 0.5*(su*su*sv4*sv4-cv4*cv4);
+        tex[1] = 32*v/(2.0*M_PI)-0.5;
+      x[0] = 0.5*s2u*sv4*sv4;
+      x[1] = 0.5*su*sv2;
+      x[2] = 0.5*cu*sv2;
+      x[3] = 0.5*(su*su*sv4*sv4-cv4*cv4);
       /* Avoid degenerate tangential plane basis vectors. */
       if (v < FLT_EPSILON)
         v = FLT_EPSILON;
       cv2 = cos(0.5*v);
       sv2 = sin(0.5*v);
       sv4 = sin(0.25*v);
-      pp->xu[k][0] = c2u*sv4*sv4;
-      pp->xu[k][1] = 0.5*cu*sv2;
-      pp->xu[k][2] = -0.5*su*sv2;
-      pp->xu[k][3] = 0.5*s2u*sv4*sv4;
-      pp->xv[k][0] = 0.125*s2u*sv2;
-      pp->xv[k][1] = 0.25*su*cv2;
-      pp->xv[k][2] = 0.25*cu*cv2;
-      pp->xv[k][3] = 0.125*(su*su+1.0)*sv2;
+      xu[0] = c2u*sv4*sv4;
+      xu[1] = 0.5*cu*sv2;
+      xu[2] = -0.5*su*sv2;
+      xu[3] = 0.5*s2u*sv4*sv4;
+      xv[0] = 0.125*s2u*sv2;
+      xv[1] = 0.25*su*cv2;
+      xv[2] = 0.25*cu*cv2;
+      xv[3] = 0.125*(su*su+1.0)*sv2;
+      surface4d_set_point(pp->surface,i,j,x,xu,xv);
+      if (colors != COLORS_TWOSIDED)
+        surface4d_set_color(pp->surface,i,j,col);
+      surface4d_set_texcoord(pp->surface,i,j,tex);
     }
   }
 }
@@ -953,13 +950,12 @@ static void setup_projective_plane(ModeInfo *mi, double umin, double umax,
 static int projective_plane(ModeInfo *mi, double umin, double umax,
                             double vmin, double vmax)
 {
-  int polys = 0;
   static const GLfloat mat_diff_red[]         = { 1.0, 0.0, 0.0, 1.0 };
   static const GLfloat mat_diff_green[]       = { 0.0, 1.0, 0.0, 1.0 };
   static const GLfloat mat_diff_trans_red[]   = { 1.0, 0.0, 0.0, 0.7 };
   static const GLfloat mat_diff_trans_green[] = { 0.0, 1.0, 0.0, 0.7 };
   float p[3], pu[3], pv[3], pm[3], n[3], b[3], mat[4][4];
-  int i, j, k, l, m, o;
+  int l, m;
   double u, v;
   double xx[4], xxu[4], xxv[4], y[4], yu[4], yv[4];
   double q, r, s, t;
@@ -1114,52 +1110,8 @@ static int projective_plane(ModeInfo *mi, double umin, double umax,
   }
 
   /* Project the points from 4D to 3D. */
-  for (i=0; i<=NUMV; i++)
-  {
-    for (j=0; j<=NUMU; j++)
-    {
-      o = i*(NUMU+1)+j;
-      for (l=0; l<4; l++)
-      {
-        y[l] = (mat[l][0]*pp->x[o][0]+mat[l][1]*pp->x[o][1]+
-                mat[l][2]*pp->x[o][2]+mat[l][3]*pp->x[o][3]);
-        yu[l] = (mat[l][0]*pp->xu[o][0]+mat[l][1]*pp->xu[o][1]+
-                 mat[l][2]*pp->xu[o][2]+mat[l][3]*pp->xu[o][3]);
-        yv[l] = (mat[l][0]*pp->xv[o][0]+mat[l][1]*pp->xv[o][1]+
-                 mat[l][2]*pp->xv[o][2]+mat[l][3]*pp->xv[o][3]);
-      }
-      if (projection_4d == DISP_4D_ORTHOGRAPHIC)
-      {
-        for (l=0; l<3; l++)
-        {
-          pp->pp[o][l] = (y[l]+pp->offset4d[l])+pp->offset3d[l];
-          pu[l] = yu[l];
-          pv[l] = yv[l];
-        }
-      }
-      else
-      {
-        s = y[3]+pp->offset4d[3];
-        q = 1.0/s;
-        t = q*q;
-        for (l=0; l<3; l++)
-        {
-          r = y[l]+pp->offset4d[l];
-          pp->pp[o][l] = r*q+pp->offset3d[l];
-          pu[l] = (yu[l]*s-r*yu[3])*t;
-          pv[l] = (yv[l]*s-r*yv[3])*t;
-        }
-      }
-      pp->pn[o][0] = pu[1]*pv[2]-pu[2]*pv[1];
-      pp->pn[o][1] = pu[2]*pv[0]-pu[0]*pv[2];
-      pp->pn[o][2] = pu[0]*pv[1]-pu[1]*pv[0];
-      t = 1.0/sqrt(pp->pn[o][0]*pp->pn[o][0]+pp->pn[o][1]*pp->pn[o][1]+
-                   pp->pn[o][2]*pp->pn[o][2]);
-      pp->pn[o][0] *= t;
-      pp->pn[o][1] *= t;
-      pp->pn[o][2] *= t;
-    }
-  }
+  surface4d_project(pp->surface,mat,pp->offset4d,pp->offset3d,1.0,
+                    projection_4d == DISP_4D_PERSPECTIVE);
 
   if (colors == COLORS_TWOSIDED)
   {
@@ -1177,72 +1129,7 @@ static int projective_plane(ModeInfo *mi, double umin, double umax,
   }
   glBindTexture(GL_TEXTURE_2D,pp->tex_name);
 
-  if (appearance != APPEARANCE_DIRECTION_BANDS)
-  {
-    for (i=0; i<NUMV; i++)
-    {
-      if (appearance == APPEARANCE_DISTANCE_BANDS &&
-          ((i & (NUMB-1)) >= NUMB/4) && ((i & (NUMB-1)) < 3*NUMB/4))
-        continue;
-      if (display_mode == DISP_WIREFRAME)
-        glBegin(GL_QUAD_STRIP);
-      else
-        glBegin(GL_TRIANGLE_STRIP);
-      for (j=0; j<=NUMU; j++)
-      {
-        for (k=0; k<=1; k++)
-        {
-          l = (i+k);
-          m = j;
-          o = l*(NUMU+1)+m;
-          glNormal3fv(pp->pn[o]);
-          glTexCoord2fv(pp->tex[o]);
-          if (colors != COLORS_TWOSIDED)
-          {
-            glColor3fv(pp->col[o]);
-            glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,pp->col[o]);
-          }
-          glVertex3fv(pp->pp[o]);
-          polys++;
-        }
-      }
-      glEnd();
-    }
-  }
-  else /* appearance == APPEARANCE_DIRECTION_BANDS */
-  {
-    for (j=0; j<NUMU; j++)
-    {
-      if ((j & (NUMB-1)) >= NUMB/2)
-        continue;
-      if (display_mode == DISP_WIREFRAME)
-        glBegin(GL_QUAD_STRIP);
-      else
-        glBegin(GL_TRIANGLE_STRIP);
-      for (i=0; i<=NUMV; i++)
-      {
-        for (k=0; k<=1; k++)
-        {
-          l = i;
-          m = (j+k);
-          o = l*(NUMU+1)+m;
-          glNormal3fv(pp->pn[o]);
-          glTexCoord2fv(pp->tex[o]);
-          if (colors != COLORS_TWOSIDED)
-          {
-            glColor3fv(pp->col[o]);
-            glMaterialfv(GL_FRONT_AND_BACK,GL_AMBIENT_AND_DIFFUSE,pp->col[o]);
-          }
-          glVertex3fv(pp->pp[o]);
-          polys++;
-        }
-      }
-      glEnd();
-    }
-  }
-
-  polys /= 2;
-  return polys;
+  return surface4d_draw(pp->surface,display_mode == DISP_WIREFRAME);
 }
 
 
@@ -1271,6 +1158,7 @@ static void init(ModeInfo *mi)
   static const GLfloat light_specular[] = { 1.0, 1.0, 1.0, 1.0 };
   static const GLfloat light_position[] = { 1.0, 1.0, 1.0, 0.0 };
   static const GLfloat mat_specular[]   = { 1.0, 1.0, 1.0, 1.0 };
+  int i;
   projectiveplanestruct *pp = &projectiveplane[MI_SCREEN(mi)];
 
   if (walk_speed == 0.0)
@@ -1314,7 +1202,33 @@ static void init(ModeInfo *mi)
   pp->offset3d[3] = 0.0;
 
   gen_texture(mi);
+  surface4d_free(pp->surface);
+  pp->surface = surface4d_new(NUMV,NUMU);
+  if (!pp->surface)
+  {
+    fprintf(stderr,"%s: out of memory\n",progname);
+    exit(1);
+  }
   setup_projective_plane(mi,0.0,2.0*M_PI,0.0,2.0*M_PI);
+  if (appearance != APPEARANCE_DIRECTION_BANDS)
+  {
+    for (i=0; i<NUMV; i++)
+    {
+      if (appearance == APPEARANCE_DISTANCE_BANDS &&
+          ((i & (NUMB-1)) >= NUMB/4) && ((i & (NUMB-1)) < 3*NUMB/4))
+        continue;
+      surface4d_add_strip(pp->surface,i,False);
+    }
+  }
+  else /* appearance == APPEARANCE_DIRECTION_BANDS */
+  {
+    for (i=0; i<NUMU; i++)
+    {
+      if ((i & (NUMB-1)) >= NUMB/2)
+        continue;
+      surface4d_add_strip(pp->surface,i,True);
+    }
+  }
 
   if (marks)
     glEnable(GL_TEXTURE_2D);
@@ -1814,6 +1728,7 @@ ENTRYPOINT void release_projectiveplane(ModeInfo *mi)
 
       if (pp->glx_context)
         pp->glx_context = (GLXContext *)NULL;
+      surface4d_free(pp->surface);
     }
     (void) free((void *)projectiveplane);
     projectiveplane = (projectiveplanestruct *)NULL;
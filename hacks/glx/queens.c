@@ -595,7 +595,6 @@ ENTRYPOINT void draw_queens(ModeInfo *mi)
   mi->recursion_depth = qs->BOARDSIZE;
 
   if(mi->fps_p) do_fps(mi);
-  glFinish(); 
   glXSwapBuffers(disp, w);
 }
 
@@ -746,7 +746,6 @@ ENTRYPOINT void draw_sballs(ModeInfo * mi)
     reshape_sballs(mi,MI_WIDTH(mi),MI_HEIGHT(mi)); /* xscreensaver mode */
 #endif
 
-    glFinish();
     glXSwapBuffers(display, window);
 }
 
@@ -542,7 +542,6 @@ draw_gasket(ModeInfo * mi)
   glXMakeCurrent(display, window, *(gp->glx_context));
   draw(mi);
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers(display, window);
 }
 
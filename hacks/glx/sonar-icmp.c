@@ -47,7 +47,6 @@
 # include <unistd.h>
 # include <sys/stat.h>
 # include <limits.h>
-# include <signal.h>
 # include <fcntl.h>
 # include <sys/types.h>
 # include <sys/time.h>
@@ -105,6 +104,9 @@ sonar_init_ping (Display *dpy, char **error_ret, char **desc_ret,
 
 #else /* HAVE_PING -- whole file */
 
+#include <errno.h>
+#include "async_netdb.h"
+
 
 #if defined(__DECC) || defined(_IP_VHL)
    /* This is how you do it on DEC C, and possibly some BSD systems. */
@@ -120,9 +122,16 @@ sonar_init_ping (Display *dpy, char **error_ret, char **desc_ret,
  */
 static int global_icmpsock = 0;
 
-/* Set by a signal handler. */
-static int timer_expired;
+/* Re-ping a given host every this many seconds, if that doesn't mean
+   sending more than MAX_PINGS_PER_SECOND.  No more than this many
+   pings are sent at once, when we've fallen behind.
+ */
+#define PING_CYCLE           10
+#define MAX_PINGS_PER_SECOND 1000
+#define MAX_PINGS_PER_SCAN   200
 
+/* How many reverse DNS lookups can be running at a time. */
+#define MAX_LOOKUPS 4
 
 
 static u_short checksum(u_short *, int);
@@ -130,6 +139,7 @@ static long delta(struct timeval *, struct timeval *);
 
 
 typedef struct {
+  Display *dpy;
   char *version;		/* short version number of xscreensaver */
   int icmpsock;			/* socket for sending pings */
   int pid;			/* our process ID */
@@ -142,6 +152,16 @@ typedef struct {
   sonar_bogie *last_pinged;	/* pointer into 'targets' list */
   double last_ping_time;
 
+  /* Open-addressed hash table of 'targets' by address, so that a reply
+     can be matched to its target without walking the list. */
+  int table_size;
+  sonar_bogie **table;
+
+  /* Targets whose names are being looked up.  With -dns, a host's name
+     is only looked up once it has answered a ping, and only a few at a
+     time, so that sweeping a big subnet doesn't wait on the DNS. */
+  sonar_bogie *lookups[MAX_LOOKUPS];
+
   Bool resolve_p;
   Bool times_p;
   Bool debug_p;
@@ -150,6 +170,8 @@ typedef struct {
 
 typedef struct {
   struct sockaddr address;	/* ip address */
+  Bool resolved_p;		/* whether the name needs no lookup */
+  async_name_from_addr_t lookup;
 } ping_bogie;
 
 
@@ -182,7 +204,9 @@ unpack_addr (unsigned long addr,
 
 
 /* Resolves the bogie's name (either a hostname or ip address string)
-   to a hostent.  Returns 1 if successful, 0 if it failed to resolve.
+   to an address.  Returns 1 if successful, 0 if it failed to resolve.
+   If resolve_p, the names of ip addresses are looked up later, by
+   start_lookup().
  */
 static int
 resolve_bogie_hostname (ping_data *pd, sonar_bogie *sb, Bool resolve_p)
@@ -211,21 +235,7 @@ resolve_bogie_hostname (ping_data *pd, sonar_bogie *sb, Bool resolve_p)
         }
 
       iaddr->sin_addr.s_addr = pack_addr (ip[0], ip[1], ip[2], ip[3]);
-      if (resolve_p)
-        hent = gethostbyaddr ((const char *) &iaddr->sin_addr.s_addr,
-                              sizeof(iaddr->sin_addr.s_addr),
-                              AF_INET);
-      else
-        hent = 0;
-
-      if (pd->debug_p > 1)
-        fprintf (stderr, "%s:   %s => %s\n",
-                 progname, sb->name,
-                 ((hent && hent->h_name && *hent->h_name)
-                  ? hent->h_name : "<unknown>"));
-
-      if (hent && hent->h_name && *hent->h_name)
-        sb->name = strdup (hent->h_name);
+      pb->resolved_p = !resolve_p;
     }
   else
     {
@@ -269,6 +279,7 @@ resolve_bogie_hostname (ping_data *pd, sonar_bogie *sb, Bool resolve_p)
 
       memcpy (&iaddr->sin_addr, hent->h_addr_list[0],
               sizeof(iaddr->sin_addr));
+      pb->resolved_p = True;
 
       if (pd->debug_p > 1)
         {
@@ -459,46 +470,108 @@ read_hosts_file (sonar_sensor_data *ssd, const char *filename)
 #endif /* READ_FILES */
 
 
+static unsigned long
+bogie_addr (const sonar_bogie *b)
+{
+  ping_bogie *pb = (ping_bogie *) b->closure;
+  return ((struct sockaddr_in *) &pb->address)->sin_addr.s_addr;
+}
+
+
+static unsigned int
+hash_addr (unsigned long ip, int size)
+{
+  unsigned long h = ip * 2654435761UL;
+  return (unsigned int) ((h ^ (h >> 16)) & (size - 1));
+}
+
+
+/* Deletes the hosts whose addresses are already on the list, and
+   enters the rest in pd->table.
+ */
 static sonar_bogie *
-delete_duplicate_hosts (sonar_sensor_data *ssd, sonar_bogie *list)
+index_targets (sonar_sensor_data *ssd, sonar_bogie *list)
 {
   ping_data *pd = (ping_data *) ssd->closure;
-  sonar_bogie *head = list;
+  sonar_bogie *head = 0;
+  sonar_bogie **tail = &head;
   sonar_bogie *sb;
+  int n = 0;
+
+  for (sb = list; sb; sb = sb->next)
+    n++;
+
+  /* Keep the table under half full. */
+  pd->table_size = 64;
+  while (pd->table_size < n * 2)
+    pd->table_size *= 2;
+  pd->table = (sonar_bogie **)
+    calloc (pd->table_size, sizeof(*pd->table));
+  if (! pd->table)
+    {
+      pd->table_size = 0;
+      return list;
+    }
 
-  for (sb = head; sb; sb = sb->next)
+  sb = list;
+  while (sb)
     {
-      ping_bogie *pb = (ping_bogie *) sb->closure;
-      struct sockaddr_in *i1 = (struct sockaddr_in *) &(pb->address);
-      unsigned long ip1 = i1->sin_addr.s_addr;
+      sonar_bogie *next = sb->next;
+      unsigned long ip = bogie_addr (sb);
+      unsigned int h = hash_addr (ip, pd->table_size);
+
+      while (pd->table[h] && bogie_addr (pd->table[h]) != ip)
+        h = (h + 1) & (pd->table_size - 1);
 
-      sonar_bogie *sb2;
-      for (sb2 = sb; sb2; sb2 = sb2->next)
+      if (pd->table[h])
         {
-          if (sb2 && sb2->next)
+          if (pd->debug_p)
             {
-              ping_bogie *pb2 = (ping_bogie *) sb2->next->closure;
-              struct sockaddr_in *i2 = (struct sockaddr_in *) &(pb2->address);
-              unsigned long ip2 = i2->sin_addr.s_addr;
-
-              if (ip1 == ip2)
-                {
-                  if (pd->debug_p)
-                    {
-                      fprintf (stderr, "%s: deleted duplicate: ", progname);
-                      print_host (stderr, ip2, sb2->next->name);
-                    }
-                  sb2->next = sb2->next->next;
-                  /* #### sb leaked */
-                }
+              fprintf (stderr, "%s: deleted duplicate: ", progname);
+              print_host (stderr, ip, sb->name);
             }
+          sonar_free_bogie (ssd, sb);
+        }
+      else
+        {
+          pd->table[h] = sb;
+          *tail = sb;
+          tail = &sb->next;
         }
+      sb = next;
     }
 
+  *tail = 0;
   return head;
 }
 
 
+/* Returns the target with this address (in network order), or 0.
+ */
+static sonar_bogie *
+find_target (ping_data *pd, unsigned long ip)
+{
+  unsigned int h;
+  if (! pd->table_size)
+    {
+      sonar_bogie *sb;
+      for (sb = pd->targets; sb; sb = sb->next)
+        if (bogie_addr (sb) == ip)
+          return sb;
+      return 0;
+    }
+
+  h = hash_addr (ip, pd->table_size);
+  while (pd->table[h])
+    {
+      if (bogie_addr (pd->table[h]) == ip)
+        return pd->table[h];
+      h = (h + 1) & (pd->table_size - 1);
+    }
+  return 0;
+}
+
+
 static unsigned int
 width_mask (int width)
 {
@@ -534,18 +607,17 @@ subnet_hosts (sonar_sensor_data *ssd, char **error_ret, char **desc_ret,
   unsigned long h_mask;   /* host order */
   unsigned long h_base;   /* host order */
   char address[BUFSIZ];
-  char *p;
-  int i;
+  long i, n;
   sonar_bogie *new;
   sonar_bogie *list = 0;
   char buf[1024];
 
-  if (subnet_width < 24)
+  if (subnet_width < 16)
     {
       sprintf (buf,
                "Pinging %lu hosts is a bad\n"
                "idea.  Please use a subnet\n"
-               "mask of 24 bits or more.",
+               "mask of 16 bits or more.",
                (unsigned long) (1L << (32 - subnet_width)) - 1);
       *error_ret = strdup(buf);
       return 0;
@@ -726,22 +798,23 @@ subnet_hosts (sonar_sensor_data *ssd, char **error_ret, char **desc_ret,
     unpack_addr (bb, &a, &b, &c, &d);
     if (subnet_width > 24)
       sprintf (buf, "%u.%u.%u.%u/%d", a, b, c, d, subnet_width);
-    else
+    else if (subnet_width > 16)
       sprintf (buf, "%u.%u.%u/%d", a, b, c, subnet_width);
+    else
+      sprintf (buf, "%u.%u/%d", a, b, subnet_width);
     *desc_ret = strdup (buf);
   }
 
-  for (i = 255; i >= 0; i--) {
+  n = 1L << (32 - subnet_width);
+  for (i = n-1; i >= 0; i--) {
     unsigned int a, b, c, d;
-    int ip = (h_base & 0xFFFFFF00L) | i;     /* host order */
-      
-    if ((ip & h_mask) != (h_base & h_mask))  /* skip out-of-subnet host */
-      continue;
-    else if (subnet_width == 31)	     /* 1-bit bridge: 2 hosts */
+    unsigned long ip = (h_base & h_mask) | i;     /* host order */
+
+    if (subnet_width == 31)		     /* 1-bit bridge: 2 hosts */
       ;
-    else if ((ip & ~h_mask) == 0)	     /* skip network address */
+    else if (i == 0)			     /* skip network address */
       continue;
-    else if ((ip & ~h_mask) == ~h_mask)	     /* skip broadcast address */
+    else if (i == n-1)			     /* skip broadcast address */
       continue;
 
     unpack_addr (htonl (ip), &a, &b, &c, &d);
@@ -761,9 +834,6 @@ subnet_hosts (sonar_sensor_data *ssd, char **error_ret, char **desc_ret,
                  subnet_width);
       }
 
-    p = address + strlen(address) + 1;
-    sprintf(p, "%d", i);
-
     new = bogie_for_host (ssd, address, pd->resolve_p);
     if (new)
       {
@@ -782,20 +852,18 @@ static void
 send_ping (ping_data *pd, const sonar_bogie *b)
 {
   ping_bogie *pb = (ping_bogie *) b->closure;
-  u_char *packet;
+  u_char packet[sizeof(struct ICMP) + sizeof(struct timeval) + 200];
   struct ICMP *icmph;
   const char *token = "org.jwz.xscreensaver.sonar";
-
-  int pcktsiz = (sizeof(struct ICMP) + sizeof(struct timeval) + 
-                 strlen(b->name) + 1 +
-                 strlen(token) + 1 + 
-                 strlen(pd->version) + 1);
+  char *payload = (char *) &packet[sizeof(struct ICMP) +
+                                   sizeof(struct timeval)];
+  struct timeval now;
+  unsigned int a, bb, c, d;
+  int pcktsiz;
 
   /* Create the ICMP packet */
 
-  if (! (packet = (u_char *) calloc(1, pcktsiz)))
-    return;  /* Out of memory */
-
+  memset (packet, 0, sizeof(packet));
   icmph = (struct ICMP *) packet;
   ICMP_TYPE(icmph) = ICMP_ECHO;
   ICMP_CODE(icmph) = 0;
@@ -803,20 +871,23 @@ send_ping (ping_data *pd, const sonar_bogie *b)
   ICMP_ID(icmph) = pd->pid;
   ICMP_SEQ(icmph) = pd->seq++;
 # ifdef GETTIMEOFDAY_TWO_ARGS
-  gettimeofday((struct timeval *) &packet[sizeof(struct ICMP)],
-               (struct timezone *) 0);
+  gettimeofday(&now, (struct timezone *) 0);
 # else
-  gettimeofday((struct timeval *) &packet[sizeof(struct ICMP)]);
+  gettimeofday(&now);
 # endif
+  memcpy (&packet[sizeof(struct ICMP)], &now, sizeof(now));
 
-  /* We store the name of the host we're pinging in the packet, and parse
-     that out of the return packet later (see get_ping() for why).
+  /* We store the address of the host we're pinging in the packet, and
+     parse that out of the return packet later (see get_ping() for why).
      After that, we also include the name and version of this program,
      just to give a clue to anyone sniffing and wondering what's up.
    */
-  sprintf ((char *) &packet[sizeof(struct ICMP) + sizeof(struct timeval)],
-           "%.100s%c%.20s %.20s",
-           b->name, 0, token, pd->version);
+  unpack_addr (bogie_addr (b), &a, &bb, &c, &d);
+  sprintf (payload, "%u.%u.%u.%u", a, bb, c, d);
+  sprintf (payload + strlen (payload) + 1, "%.20s %.20s", token, pd->version);
+  pcktsiz = (sizeof(struct ICMP) + sizeof(struct timeval) +
+             strlen (payload) + 1 +
+             strlen (payload + strlen (payload) + 1) + 1);
 
   ICMP_CHECKSUM(icmph) = checksum((u_short *)packet, pcktsiz);
 
@@ -834,13 +905,6 @@ send_ping (ping_data *pd, const sonar_bogie *b)
     }
 }
 
-/* signal handler */
-static void
-sigcatcher (int sig)
-{
-  timer_expired = 1;
-}
-
 
 /* Compute the checksum on a ping packet.
  */
@@ -898,6 +962,68 @@ copy_ping_bogie (sonar_sensor_data *ssd, const sonar_bogie *b)
 }
 
 
+/* Starts looking up the name of this target, if that hasn't been done,
+   and not too many lookups are running already.  If they are, we'll try
+   again the next time this host answers.
+ */
+static void
+start_lookup (ping_data *pd, sonar_bogie *b)
+{
+  ping_bogie *pb = (ping_bogie *) b->closure;
+  int i;
+
+  if (pb->resolved_p || pb->lookup)
+    return;
+
+  for (i = 0; i < MAX_LOOKUPS; i++)
+    if (! pd->lookups[i])
+      break;
+  if (i >= MAX_LOOKUPS)
+    return;
+
+  pb->lookup = async_name_from_addr_start (pd->dpy, &pb->address,
+                                           sizeof(struct sockaddr_in));
+  if (pb->lookup)
+    pd->lookups[i] = b;
+}
+
+
+/* Renames the targets whose lookups have finished.  Their replies from
+   now on show up under the new name.
+ */
+static void
+finish_lookups (ping_data *pd)
+{
+  int i;
+  for (i = 0; i < MAX_LOOKUPS; i++)
+    {
+      sonar_bogie *b = pd->lookups[i];
+      ping_bogie *pb;
+      char *host = 0;
+
+      if (! b) continue;
+      pb = (ping_bogie *) b->closure;
+      if (! async_name_from_addr_is_done (pb->lookup))
+        continue;
+
+      if (! async_name_from_addr_finish (pb->lookup, &host, 0) &&
+          host && *host)
+        {
+          if (pd->debug_p > 1)
+            fprintf (stderr, "%s:   %s => %s\n", progname, b->name, host);
+          free (b->name);
+          b->name = host;
+        }
+      else if (host)
+        free (host);
+
+      pb->lookup = 0;
+      pb->resolved_p = True;
+      pd->lookups[i] = 0;
+    }
+}
+
+
 /* Look for all outstanding ping replies.
  */
 static sonar_bogie *
@@ -909,164 +1035,154 @@ get_ping (sonar_sensor_data *ssd)
   int result;
   u_char packet[1024];
   struct timeval now;
-  struct timeval *then;
+  struct timeval then;
   struct ip *ip;
   int iphdrlen;
   struct ICMP *icmph;
   sonar_bogie *bl = 0;
   sonar_bogie *new = 0;
-  struct sigaction sa;
-  struct itimerval it;
   fd_set rfds;
   struct timeval tv;
 
-  /* Set up a signal to interrupt our wait for a packet */
-
-  sigemptyset(&sa.sa_mask);
-  sa.sa_flags = 0;
-  sa.sa_handler = sigcatcher;
-  if (sigaction(SIGALRM, &sa, 0) == -1) 
-    {
-      char msg[1024];
-      sprintf(msg, "%s: unable to trap SIGALRM", progname);
-      perror(msg);
-      exit(1);
-    }
-
-  /* Set up a timer to interupt us if we don't get a packet */
-
-  it.it_interval.tv_sec = 0;
-  it.it_interval.tv_usec = 0;
-  it.it_value.tv_sec = 0;
-  it.it_value.tv_usec = pd->timeout;
-  timer_expired = 0;
-  setitimer(ITIMER_REAL, &it, 0);
-
-  /* Wait for a result packet */
-
-  fromlen = sizeof(from);
-  while (! timer_expired)
-    {
-      tv.tv_usec = pd->timeout;
-      tv.tv_sec = 0;
+  /* Wait a little while for the first reply, then read everything that
+     has arrived.  The socket is non-blocking.
+   */
+  tv.tv_usec = pd->timeout;
+  tv.tv_sec = 0;
 #if 0
-      /* This breaks on BSD, which uses bzero() in the definition of FD_ZERO */
-      FD_ZERO(&rfds);
+  /* This breaks on BSD, which uses bzero() in the definition of FD_ZERO */
+  FD_ZERO(&rfds);
 #else
-      memset (&rfds, 0, sizeof(rfds));
+  memset (&rfds, 0, sizeof(rfds));
 #endif
-      FD_SET(pd->icmpsock, &rfds);
-      /* only wait a little while, in case we raced with the timer expiration.
-         From Valentijn Sessink <valentyn@openoffice.nl> */
-      if (select(pd->icmpsock + 1, &rfds, 0, 0, &tv) >0)
-        {
-          result = recvfrom (pd->icmpsock, packet, sizeof(packet),
-                             0, &from, &fromlen);
+  FD_SET(pd->icmpsock, &rfds);
+  if (select(pd->icmpsock + 1, &rfds, 0, 0, &tv) <= 0)
+    return 0;
+
+  while (1)
+    {
+      fromlen = sizeof(from);
+      result = recvfrom (pd->icmpsock, packet, sizeof(packet) - 1,
+                         0, &from, &fromlen);
+      if (result < 0 && errno == EINTR)
+        continue;
+      if (result <= 0)
+        break;			/* EAGAIN: that's all of them */
 
-          /* Check the packet */
+      /* Ensure that a maliciously-crafted return packet can't
+         make us overflow in sscanf. */
+      packet[result] = 0;
+
+      /* Check the packet */
 
 # ifdef GETTIMEOFDAY_TWO_ARGS
-          gettimeofday(&now, (struct timezone *) 0);
+      gettimeofday(&now, (struct timezone *) 0);
 # else
-          gettimeofday(&now);
+      gettimeofday(&now);
 # endif
-          ip = (struct ip *) packet;
-          iphdrlen = IP_HDRLEN(ip) << 2;
-          icmph = (struct ICMP *) &packet[iphdrlen];
-          then  = (struct timeval *) &packet[iphdrlen + sizeof(struct ICMP)];
 
+      /* Raw sockets, and datagram sockets on some systems, hand us the
+         IP header too.  Linux datagram sockets don't: they fill in the
+         ICMP id themselves, and only give us replies to our own pings.
+       */
+      ip = (struct ip *) packet;
+      iphdrlen = ((packet[0] >> 4) == 4 ? IP_HDRLEN(ip) << 2 : 0);
+      if (result < (iphdrlen + (int) sizeof(struct ICMP) +
+                    (int) sizeof(struct timeval)))
+        continue;
+      icmph = (struct ICMP *) &packet[iphdrlen];
+      memcpy (&then, &packet[iphdrlen + sizeof(struct ICMP)], sizeof(then));
 
-          /* Ignore anything but ICMP Replies */
-          if (ICMP_TYPE(icmph) != ICMP_ECHOREPLY) 
-            continue;
+      /* Ignore anything but ICMP Replies */
+      if (ICMP_TYPE(icmph) != ICMP_ECHOREPLY) 
+        continue;
 
-          /* Ignore packets not set from us */
-          if (ICMP_ID(icmph) != pd->pid)
-	    continue;
+      /* Ignore packets not set from us */
+      if (iphdrlen && ICMP_ID(icmph) != pd->pid)
+        continue;
 
-          /* Find the bogie in 'targets' that corresponds to this packet
-             and copy it, so that this bogie stays in the same spot (th)
-             on the screen, and so that we don't have to resolve it again.
+      /* Find the bogie in 'targets' that corresponds to this packet
+         and copy it, so that this bogie stays in the same spot (th)
+         on the screen, and so that we don't have to resolve it again.
 
-             We could find the bogie by comparing ip->ip_src.s_addr to
-             pb->address, but it is possible that, in certain weird router
-             or NAT situations, that the reply will come back from a 
-             different address than the one we sent it to.  So instead,
-             we parse the name out of the reply packet payload.
-           */
+         We could find the bogie by the address that the reply came
+         from, but it is possible that, in certain weird router or NAT
+         situations, that the reply will come back from a different
+         address than the one we sent it to.  So instead, we parse the
+         address we sent it to out of the reply packet payload.
+       */
+      {
+        const char *payload = (char *) &packet[iphdrlen +
+                                               sizeof(struct ICMP) +
+                                               sizeof(struct timeval)];
+        unsigned long from_ip =
+          ((struct sockaddr_in *) &from)->sin_addr.s_addr;
+        unsigned int n0, n1, n2, n3;
+        sonar_bogie *b = 0;
+
+        if (4 == sscanf (payload, "%u.%u.%u.%u", &n0, &n1, &n2, &n3))
+          b = find_target (pd, pack_addr (n0, n1, n2, n3));
+        if (! b)
+          b = find_target (pd, from_ip);
+
+        if (! b)      /* not in targets? */
           {
-            const char *name = (char *) &packet[iphdrlen +
-                                                sizeof(struct ICMP) +
-                                                sizeof(struct timeval)];
-            sonar_bogie *b;
-
-            /* Ensure that a maliciously-crafted return packet can't
-               make us overflow in strcmp. */
-            packet[sizeof(packet)-1] = 0;
-
-            for (b = pd->targets; b; b = b->next)
-              if (!strcmp (name, b->name))
-                {
-                  new = copy_ping_bogie (ssd, b);
-                  break;
-                }
+            unsigned int a, b, c, d;
+            unpack_addr (from_ip, &a, &b, &c, &d);
+            fprintf (stderr, 
+                     "%s: UNEXPECTED PING REPLY! "
+                     "%4d bytes, icmp_seq=%-4d from %d.%d.%d.%d\n",
+                     progname, result, ICMP_SEQ(icmph), a, b, c, d);
+            continue;
           }
 
-          if (! new)      /* not in targets? */
-            {
-              unsigned int a, b, c, d;
-              unpack_addr (ip->ip_src.s_addr, &a, &b, &c, &d);
-              fprintf (stderr, 
-                       "%s: UNEXPECTED PING REPLY! "
-                       "%4d bytes, icmp_seq=%-4d from %d.%d.%d.%d\n",
-                       progname, result, ICMP_SEQ(icmph), a, b, c, d);
-              continue;
-            }
+        start_lookup (pd, b);
+        new = copy_ping_bogie (ssd, b);
+      }
 
-          new->next = bl;
-          bl = new;
+      new->next = bl;
+      bl = new;
 
-          {
-            double msec = delta(then, &now) / 1000.0;
+      {
+        double msec = delta(&then, &now) / 1000.0;
 
-            if (pd->times_p)
-              {
-                if (new->desc) free (new->desc);
-                new->desc = (char *) malloc (30);
-                if      (msec > 99) sprintf (new->desc, "%.0f ms", msec);
-                else if (msec >  9) sprintf (new->desc, "%.1f ms", msec);
-                else if (msec >  1) sprintf (new->desc, "%.2f ms", msec);
-                else                sprintf (new->desc, "%.3f ms", msec);
-              }
+        if (pd->times_p)
+          {
+            if (new->desc) free (new->desc);
+            new->desc = (char *) malloc (30);
+            if      (msec > 99) sprintf (new->desc, "%.0f ms", msec);
+            else if (msec >  9) sprintf (new->desc, "%.1f ms", msec);
+            else if (msec >  1) sprintf (new->desc, "%.2f ms", msec);
+            else                sprintf (new->desc, "%.3f ms", msec);
+          }
 
-            if (pd->debug_p && pd->times_p)  /* ping-like stdout log */
+        if (pd->debug_p && pd->times_p)  /* ping-like stdout log */
+          {
+            char *s = strdup(new->name);
+            char *s2 = s;
+            if (strlen(s) > 28)
               {
-                char *s = strdup(new->name);
-                char *s2 = s;
-                if (strlen(s) > 28)
-                  {
-                    s2 = s + strlen(s) - 28;
-                    strncpy (s2, "...", 3);
-                  }
-                fprintf (stdout, 
-                         "%3d bytes from %28s: icmp_seq=%-4d time=%s\n",
-                         result, s2, ICMP_SEQ(icmph), new->desc);
-                fflush (stdout);
-                free(s);
+                s2 = s + strlen(s) - 28;
+                strncpy (s2, "...", 3);
               }
+            fprintf (stdout, 
+                     "%3d bytes from %28s: icmp_seq=%-4d time=%s\n",
+                     result, s2, ICMP_SEQ(icmph), new->desc);
+            fflush (stdout);
+            free(s);
+          }
 
-            /* The radius must be between 0.0 and 1.0.
-               We want to display ping times on a logarithmic scale,
-               with the three rings being 2.5, 70 and 2,000 milliseconds.
-             */
-            if (msec <= 0) msec = 0.001;
-            new->r = log (msec * 10) / log (20000);
+        /* The radius must be between 0.0 and 1.0.
+           We want to display ping times on a logarithmic scale,
+           with the three rings being 2.5, 70 and 2,000 milliseconds.
+         */
+        if (msec <= 0) msec = 0.001;
+        new->r = log (msec * 10) / log (20000);
 
-            /* Don't put anyone *too* close to the center of the screen. */
-            if (new->r < 0) new->r = 0;
-            if (new->r < 0.1) new->r += 0.1;
-          }
-        }
+        /* Don't put anyone *too* close to the center of the screen. */
+        if (new->r < 0) new->r = 0;
+        if (new->r < 0.1) new->r += 0.1;
+      }
     }
 
   return bl;
@@ -1088,12 +1204,20 @@ ping_free_data (sonar_sensor_data *ssd, void *closure)
 {
   ping_data *pd = (ping_data *) closure;
   sonar_bogie *b = pd->targets;
+  int i;
+
+  for (i = 0; i < MAX_LOOKUPS; i++)
+    if (pd->lookups[i])
+      async_name_from_addr_cancel (((ping_bogie *) pd->lookups[i]->closure)
+                                   ->lookup);
+
   while (b)
     {
       sonar_bogie *b2 = b->next;
       sonar_free_bogie (ssd, b);
       b = b2;
     }
+  if (pd->table) free (pd->table);
   free (pd);
 }
 
@@ -1121,7 +1245,7 @@ double_time (void)
 }
 
 
-/* Pings the next bogie, if it's time.
+/* Pings the next bogies, if it's time.
    Returns all outstanding ping replies.
  */
 static sonar_bogie *
@@ -1129,19 +1253,36 @@ ping_scan (sonar_sensor_data *ssd)
 {
   ping_data *pd = (ping_data *) ssd->closure;
   double now = double_time();
-  double ping_cycle = 10;   /* re-ping a given host every 10 seconds */
-  double ping_interval = ping_cycle / pd->target_count;
+  double ping_interval = (double) PING_CYCLE / pd->target_count;
+
+  if (ping_interval < 1.0 / MAX_PINGS_PER_SECOND)
+    ping_interval = 1.0 / MAX_PINGS_PER_SECOND;
+  if (pd->last_ping_time == 0)
+    pd->last_ping_time = now - ping_interval;
 
+  /* With a big subnet, several hosts may be due since the last frame. */
   if (now > pd->last_ping_time + ping_interval)   /* time to ping someone */
     {
-      if (pd->last_pinged)
-        pd->last_pinged = pd->last_pinged->next;
-      if (! pd->last_pinged)
-        pd->last_pinged = pd->targets;
-      send_ping (pd, pd->last_pinged);
-      pd->last_ping_time = now;
+      int n = (now - pd->last_ping_time) / ping_interval;
+      if (n > MAX_PINGS_PER_SCAN)
+        {
+          n = MAX_PINGS_PER_SCAN;
+          pd->last_ping_time = now;
+        }
+      else
+        pd->last_ping_time += n * ping_interval;
+
+      while (n-- > 0)
+        {
+          if (pd->last_pinged)
+            pd->last_pinged = pd->last_pinged->next;
+          if (! pd->last_pinged)
+            pd->last_pinged = pd->targets;
+          send_ping (pd, pd->last_pinged);
+        }
     }
 
+  finish_lookups (pd);
   return get_ping (ssd);
 }
 
@@ -1290,6 +1431,7 @@ sonar_init_ping (Display *dpy, char **error_ret, char **desc_ret,
   Bool socket_initted_p = False;
   Bool socket_raw_p     = False;
 
+  pd->dpy       = dpy;
   pd->resolve_p = resolve_p;
   pd->times_p   = times_p;
   pd->debug_p   = debug_p;
@@ -1340,6 +1482,9 @@ sonar_init_ping (Display *dpy, char **error_ret, char **desc_ret,
 
   if (socket_initted_p)
     {
+      /* get_ping() reads until there's nothing left. */
+      fcntl (pd->icmpsock, F_SETFL,
+             fcntl (pd->icmpsock, F_GETFL, 0) | O_NONBLOCK);
       global_icmpsock = pd->icmpsock;
       socket_initted_p = True;
       if (debug_p)
@@ -1360,7 +1505,7 @@ sonar_init_ping (Display *dpy, char **error_ret, char **desc_ret,
 
   pd->targets = parse_mode (ssd, error_ret, desc_ret, subnet,
                             socket_initted_p);
-  pd->targets = delete_duplicate_hosts (ssd, pd->targets);
+  pd->targets = index_targets (ssd, pd->targets);
 
   if (debug_p)
     {
@@ -72,7 +72,6 @@
 			"*font:       " DEF_FONT   "\n" \
 			"*showFPS:      False       \n" \
 			"*wireframe:    False       \n" \
-			"*texFontCacheSize: 300     \n" \
 			THREAD_DEFAULTS_XLOCK
 
 
@@ -1146,7 +1145,6 @@ draw_sonar (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 
@@ -38,9 +38,26 @@
 #include "sphere.h"
 
 typedef struct { GLfloat x, y, z; } XYZ;
+typedef struct { XYZ p; XYZ n; GLfloat s, t; } sphere_vertex;
 
-static int
-unit_sphere_1 (int stacks, int slices, int wire_p, int half_p)
+/* Spheres of a given size are the same every time, and many hacks draw
+   dozens of them a frame, so the vertex arrays are built once for each
+   combination of parameters and kept for the life of the process.
+ */
+typedef struct sphere_mesh sphere_mesh;
+struct sphere_mesh {
+  int stacks, slices, wire_p, half_p;
+  GLenum mode;
+  int count, polys;
+  sphere_vertex *array;
+  sphere_mesh *next;
+};
+
+static sphere_mesh *sphere_meshes = 0;
+
+
+static sphere_mesh *
+make_sphere_mesh (int stacks, int slices, int wire_p, int half_p)
 {
   int polys = 0;
   int i,j;
@@ -55,7 +72,14 @@ unit_sphere_1 (int stacks, int slices, int wire_p, int half_p)
   int mode = (wire_p ? GL_LINE_STRIP : GL_TRIANGLE_STRIP);
 
   int arraysize, out;
-  struct { XYZ p; XYZ n; GLfloat s, t; } *array;
+  sphere_vertex *array;
+  sphere_mesh *m = (sphere_mesh *) calloc (1, sizeof(*m));
+  if (! m) abort();
+
+  m->stacks = stacks;
+  m->slices = slices;
+  m->wire_p = wire_p;
+  m->half_p = half_p;
 
   if (r < 0)
     r = -r;
@@ -126,19 +150,50 @@ unit_sphere_1 (int stacks, int slices, int wire_p, int half_p)
 
  END:
 
+  m->mode  = mode;
+  m->count = out;
+  m->polys = polys;
+  m->array = array;
+  return m;
+}
+
+
+static sphere_mesh *
+find_sphere_mesh (int stacks, int slices, int wire_p, int half_p)
+{
+  sphere_mesh *m;
+  for (m = sphere_meshes; m; m = m->next)
+    if (m->stacks == stacks && m->slices == slices &&
+        m->wire_p == wire_p && m->half_p == half_p)
+      return m;
+
+  m = make_sphere_mesh (stacks, slices, wire_p, half_p);
+  m->next = sphere_meshes;
+  sphere_meshes = m;
+  return m;
+}
+
+
+static void
+sphere_mesh_arrays (sphere_mesh *m)
+{
   glEnableClientState (GL_VERTEX_ARRAY);
   glEnableClientState (GL_NORMAL_ARRAY);
   glEnableClientState (GL_TEXTURE_COORD_ARRAY);
 
-  glVertexPointer   (3, GL_FLOAT, sizeof(*array), &array[0].p);
-  glNormalPointer   (   GL_FLOAT, sizeof(*array), &array[0].n);
-  glTexCoordPointer (2, GL_FLOAT, sizeof(*array), &array[0].s);
-
-  glDrawArrays (mode, 0, out);
+  glVertexPointer   (3, GL_FLOAT, sizeof(*m->array), &m->array[0].p);
+  glNormalPointer   (   GL_FLOAT, sizeof(*m->array), &m->array[0].n);
+  glTexCoordPointer (2, GL_FLOAT, sizeof(*m->array), &m->array[0].s);
+}
 
-  free (array);
 
-  return polys;
+static int
+unit_sphere_1 (int stacks, int slices, int wire_p, int half_p)
+{
+  sphere_mesh *m = find_sphere_mesh (stacks, slices, wire_p, half_p);
+  sphere_mesh_arrays (m);
+  glDrawArrays (m->mode, 0, m->count);
+  return m->polys;
 }
 
 
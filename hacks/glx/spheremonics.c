@@ -863,7 +863,6 @@ draw_spheremonics (ModeInfo *mi)
   glPopMatrix();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
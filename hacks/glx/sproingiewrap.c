@@ -200,7 +200,6 @@ draw_sproingies (ModeInfo * mi)
     glPopMatrix();
 
     if (mi->fps_p) do_fps (mi);
-    glFinish();
     glXSwapBuffers(MI_DISPLAY(mi), MI_WINDOW(mi));
 }
 
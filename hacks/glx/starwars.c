@@ -41,7 +41,6 @@
 		 "*showFPS:  False     \n" \
 		 "*fpsTop:   True      \n" \
 		 "*usePty:   False     \n" \
-		 "*texFontCacheSize: 300\n" \
 		 "*font:   " DEF_FONT "\n" \
 		 "*textLiteral: " DEF_TEXT "\n" \
 		 "*program: xscreensaver-text --cols 0"  /* don't wrap */
@@ -280,14 +279,14 @@ get_more_lines (sws_configuration *sc)
 
   /* Fill as much as we can into sc->buf.
    */
-  while (target > 0)
+  if (target > 0)
     {
-      int c = textclient_getc (sc->tc);
-      if (c <= 0)
-        break;
-      sc->buf[sc->buf_tail++] = (char) c;
+      int i, j, n = textclient_read (sc->tc, sc->buf + sc->buf_tail, target);
+      for (i = j = sc->buf_tail; i < sc->buf_tail + n; i++)
+        if (sc->buf[i])			/* a NUL would end the string */
+          sc->buf[j++] = sc->buf[i];
+      sc->buf_tail = j;
       sc->buf[sc->buf_tail] = 0;
-      target--;
     }
 
   while (sc->total_lines < max_lines)
@@ -989,7 +988,6 @@ draw_sws (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
   glXSwapBuffers(dpy, window);
 
   sc->star_theta += star_spin;
@@ -121,7 +121,6 @@ draw_stonerview (ModeInfo *mi)
 
   mi->polygon_count = NUM_ELS;
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(MI_DISPLAY (mi), MI_WINDOW(mi));
 }
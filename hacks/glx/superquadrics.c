@@ -741,7 +741,6 @@ init_superquadrics(ModeInfo * mi)
 		ReshapeSuperquadrics(MI_WIDTH(mi), MI_HEIGHT(mi));
 
 		DisplaySuperquadrics(sp);
-		glFinish();
 		glXSwapBuffers(display, window);
 	} else {
 		MI_CLEARWINDOW(mi);
@@ -763,7 +762,6 @@ draw_superquadrics(ModeInfo * mi)
     mi->polygon_count = NextSuperquadricDisplay(sp);
 
     if (mi->fps_p) do_fps (mi);
-	glFinish();
 	glXSwapBuffers(display, window);
 }
 
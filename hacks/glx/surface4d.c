@@ -0,0 +1,483 @@
+/* surface4d, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *
+ * The samples are kept one array per coordinate, so that the projection
+ * can do four vertices at a time with SSE.  The projected points and
+ * normals come out with four floats per vertex, which is what the SSE
+ * code produces, and which GL can take with a stride.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef HAVE_COCOA
+# ifdef USE_IPHONE
+#  include "jwzgles.h"
+# else
+#  include <OpenGL/gl.h>
+# endif
+#elif defined(HAVE_ANDROID)
+# include <GLES/gl.h>
+# include "jwzgles.h"
+#else
+# include <GL/glx.h>
+#endif
+
+#ifdef HAVE_JWZGLES
+# include "jwzgles.h"
+#endif /* HAVE_JWZGLES */
+
+#include "aligned_malloc.h"
+#include "surface4d.h"
+
+#ifndef HAVE_JWZGLES /* glDrawElements unimplemented... */
+# define USE_VERTEX_ARRAY
+#endif
+
+/* SSE2 is part of the baseline x86-64 instruction set, so there is nothing
+   to probe for at runtime. */
+#if defined(__SSE2__) && !defined(SURFACE4D_NO_SSE2)
+# define SURFACE4D_SSE2
+# include <emmintrin.h>
+#endif
+
+/* Indexes into the sample arrays. */
+enum { X0, X1, X2, X3, XU0, XU1, XU2, XU3, XV0, XV1, XV2, XV3, NSAMPLES };
+
+struct surface4d {
+  int rows, cols;
+  int count, padded;		/* vertices, rounded up to a multiple of 4 */
+
+  float *samples;		/* NSAMPLES arrays of padded floats */
+  float *points;		/* projected, x y z 0 per vertex */
+  float *normals;		/* unit normals, x y z 0 per vertex */
+  float *colors;		/* r g b a, or 0 */
+  float *tex;			/* s t, or 0 */
+
+  int *strips;			/* n, or -1-n for column n */
+  int nstrips, strips_size;
+
+  GLuint *index;		/* for the last mode drawn */
+  int nindex;
+  Bool index_wire_p;
+  Bool index_dirty_p;
+};
+
+
+surface4d *
+surface4d_new (int rows, int cols)
+{
+  surface4d *s = (surface4d *) calloc (1, sizeof(*s));
+  if (!s) return 0;
+  s->rows = rows;
+  s->cols = cols;
+  s->count = (rows + 1) * (cols + 1);
+  s->padded = (s->count + 3) & ~3;
+
+  if (aligned_malloc ((void **) &s->samples, 16,
+                      NSAMPLES * s->padded * sizeof(float)))
+    s->samples = 0;
+  if (aligned_malloc ((void **) &s->points, 16,
+                      4 * s->padded * sizeof(float)))
+    s->points = 0;
+  if (aligned_malloc ((void **) &s->normals, 16,
+                      4 * s->padded * sizeof(float)))
+    s->normals = 0;
+  if (!s->samples || !s->points || !s->normals)
+    {
+      surface4d_free (s);
+      return 0;
+    }
+
+  memset (s->samples, 0, NSAMPLES * s->padded * sizeof(float));
+  return s;
+}
+
+
+void
+surface4d_free (surface4d *s)
+{
+  if (!s) return;
+  if (s->samples) aligned_free (s->samples);
+  if (s->points)  aligned_free (s->points);
+  if (s->normals) aligned_free (s->normals);
+  if (s->colors)  free (s->colors);
+  if (s->tex)     free (s->tex);
+  if (s->strips)  free (s->strips);
+  if (s->index)   free (s->index);
+  free (s);
+}
+
+
+void
+surface4d_set_point (surface4d *s, int i, int j,
+                     const float x[4], const float xu[4], const float xv[4])
+{
+  int k = i * (s->cols + 1) + j;
+  int l;
+  for (l = 0; l < 4; l++)
+    {
+      s->samples[(X0  + l) * s->padded + k] = x[l];
+      s->samples[(XU0 + l) * s->padded + k] = xu[l];
+      s->samples[(XV0 + l) * s->padded + k] = xv[l];
+    }
+}
+
+
+void
+surface4d_set_color (surface4d *s, int i, int j, const float color[4])
+{
+  int k = i * (s->cols + 1) + j;
+  if (!s->colors)
+    {
+      s->colors = (float *) calloc (s->count, 4 * sizeof(float));
+      if (!s->colors) return;
+    }
+  memcpy (s->colors + 4 * k, color, 4 * sizeof(float));
+}
+
+
+void
+surface4d_set_texcoord (surface4d *s, int i, int j, const float tex[2])
+{
+  int k = i * (s->cols + 1) + j;
+  if (!s->tex)
+    {
+      s->tex = (float *) calloc (s->count, 2 * sizeof(float));
+      if (!s->tex) return;
+    }
+  s->tex[2 * k]     = tex[0];
+  s->tex[2 * k + 1] = tex[1];
+}
+
+
+void
+surface4d_add_strip (surface4d *s, int n, Bool column_p)
+{
+  if (s->nstrips >= s->strips_size)
+    {
+      int size = (s->strips_size ? s->strips_size * 2 : 64);
+      int *strips = (int *) realloc (s->strips, size * sizeof(*strips));
+      if (!strips) return;
+      s->strips = strips;
+      s->strips_size = size;
+    }
+  s->strips[s->nstrips++] = (column_p ? -1 - n : n);
+  s->index_dirty_p = True;
+}
+
+
+/* Vertex m of the two sides of the strip: (n,m) and (n+1,m) for rows,
+   (m,n) and (m,n+1) for columns.
+ */
+static void
+strip_vertices (surface4d *s, int strip, int m, int *a, int *b)
+{
+  int n = s->strips[strip];
+  int w = s->cols + 1;
+  if (n >= 0)
+    {
+      *a = n * w + m;
+      *b = (n + 1) * w + m;
+    }
+  else
+    {
+      n = -1 - n;
+      *a = m * w + n;
+      *b = m * w + n + 1;
+    }
+}
+
+static int
+strip_length (surface4d *s, int strip)
+{
+  return (s->strips[strip] >= 0 ? s->cols : s->rows);
+}
+
+
+#ifdef USE_VERTEX_ARRAY
+static void
+make_index (surface4d *s, Bool wire_p)
+{
+  int i, m, n = 0;
+  GLuint *index;
+
+  for (i = 0; i < s->nstrips; i++)
+    n += strip_length (s, i);
+  n *= (wire_p ? 4 : 6);
+
+  index = (GLuint *) realloc (s->index, (n ? n : 1) * sizeof(*index));
+  if (!index) return;
+  s->index = index;
+  s->nindex = n;
+  s->index_wire_p = wire_p;
+  s->index_dirty_p = False;
+
+  for (i = 0; i < s->nstrips; i++)
+    for (m = 0; m < strip_length (s, i); m++)
+      {
+        int a0, b0, a1, b1;
+        strip_vertices (s, i, m,     &a0, &b0);
+        strip_vertices (s, i, m + 1, &a1, &b1);
+        if (wire_p)
+          {
+            /* Ending on the vertex that GL_QUAD_STRIP would have ended on
+               keeps the same colors under GL_FLAT. */
+            *index++ = a1;
+            *index++ = a0;
+            *index++ = b0;
+            *index++ = b1;
+          }
+        else
+          {
+            *index++ = a0;
+            *index++ = b0;
+            *index++ = a1;
+            *index++ = a1;
+            *index++ = b0;
+            *index++ = b1;
+          }
+      }
+}
+#endif /* USE_VERTEX_ARRAY */
+
+
+void
+surface4d_project (surface4d *s, float m[4][4],
+                   const float offset4d[4], const float offset3d[3],
+                   float scale, Bool perspective_p)
+{
+  const float *in = s->samples;
+  int np = s->padded;
+  int k = 0;
+
+#ifdef SURFACE4D_SSE2
+  {
+    __m128 mm[4][4], o4[4], o3[3], sc;
+    int l, c;
+
+    for (l = 0; l < 4; l++)
+      {
+        for (c = 0; c < 4; c++)
+          mm[l][c] = _mm_set1_ps (m[l][c]);
+        o4[l] = _mm_set1_ps (offset4d[l]);
+      }
+    for (l = 0; l < 3; l++)
+      o3[l] = _mm_set1_ps (offset3d[l]);
+    sc = _mm_set1_ps (scale);
+
+    for (; k < np; k += 4)
+      {
+        __m128 x[4], xu[4], xv[4], y[4], yu[4], yv[4];
+        __m128 p[4], pu[3], pv[3], n[4], len;
+
+        for (c = 0; c < 4; c++)
+          {
+            x[c]  = _mm_load_ps (in + (X0  + c) * np + k);
+            xu[c] = _mm_load_ps (in + (XU0 + c) * np + k);
+            xv[c] = _mm_load_ps (in + (XV0 + c) * np + k);
+          }
+
+        for (l = 0; l < 4; l++)
+          {
+            y[l]  = _mm_mul_ps (mm[l][0], x[0]);
+            yu[l] = _mm_mul_ps (mm[l][0], xu[0]);
+            yv[l] = _mm_mul_ps (mm[l][0], xv[0]);
+            for (c = 1; c < 4; c++)
+              {
+                y[l]  = _mm_add_ps (y[l],  _mm_mul_ps (mm[l][c], x[c]));
+                yu[l] = _mm_add_ps (yu[l], _mm_mul_ps (mm[l][c], xu[c]));
+                yv[l] = _mm_add_ps (yv[l], _mm_mul_ps (mm[l][c], xv[c]));
+              }
+          }
+
+        if (perspective_p)
+          {
+            /* The tangents are off by a factor of 1/w^2, which doesn't
+               matter to the normal. */
+            __m128 w = _mm_add_ps (y[3], o4[3]);
+            __m128 q = _mm_div_ps (_mm_set1_ps (1.0), w);
+            for (l = 0; l < 3; l++)
+              {
+                __m128 r = _mm_add_ps (y[l], o4[l]);
+                p[l]  = _mm_add_ps (_mm_mul_ps (r, q), o3[l]);
+                pu[l] = _mm_sub_ps (_mm_mul_ps (yu[l], w),
+                                    _mm_mul_ps (r, yu[3]));
+                pv[l] = _mm_sub_ps (_mm_mul_ps (yv[l], w),
+                                    _mm_mul_ps (r, yv[3]));
+              }
+          }
+        else
+          {
+            for (l = 0; l < 3; l++)
+              {
+                p[l] = _mm_add_ps (_mm_mul_ps (_mm_add_ps (y[l], o4[l]), sc),
+                                   o3[l]);
+                pu[l] = yu[l];
+                pv[l] = yv[l];
+              }
+          }
+
+        n[0] = _mm_sub_ps (_mm_mul_ps (pu[1], pv[2]),
+                           _mm_mul_ps (pu[2], pv[1]));
+        n[1] = _mm_sub_ps (_mm_mul_ps (pu[2], pv[0]),
+                           _mm_mul_ps (pu[0], pv[2]));
+        n[2] = _mm_sub_ps (_mm_mul_ps (pu[0], pv[1]),
+                           _mm_mul_ps (pu[1], pv[0]));
+        len = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (n[0], n[0]),
+                                                   _mm_mul_ps (n[1], n[1])),
+                                       _mm_mul_ps (n[2], n[2])));
+        for (l = 0; l < 3; l++)
+          n[l] = _mm_div_ps (n[l], len);
+
+        p[3] = n[3] = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS (p[0], p[1], p[2], p[3]);
+        _MM_TRANSPOSE4_PS (n[0], n[1], n[2], n[3]);
+        for (l = 0; l < 4; l++)
+          {
+            _mm_store_ps (s->points  + 4 * (k + l), p[l]);
+            _mm_store_ps (s->normals + 4 * (k + l), n[l]);
+          }
+      }
+  }
+#endif /* SURFACE4D_SSE2 */
+
+  for (; k < s->count; k++)
+    {
+      float y[4], yu[4], yv[4], pu[3], pv[3];
+      float *p = s->points  + 4 * k;
+      float *n = s->normals + 4 * k;
+      float t;
+      int l;
+
+      for (l = 0; l < 4; l++)
+        {
+          y[l]  = (m[l][0] * in[X0 * np + k] + m[l][1] * in[X1 * np + k] +
+                   m[l][2] * in[X2 * np + k] + m[l][3] * in[X3 * np + k]);
+          yu[l] = (m[l][0] * in[XU0 * np + k] + m[l][1] * in[XU1 * np + k] +
+                   m[l][2] * in[XU2 * np + k] + m[l][3] * in[XU3 * np + k]);
+          yv[l] = (m[l][0] * in[XV0 * np + k] + m[l][1] * in[XV1 * np + k] +
+                   m[l][2] * in[XV2 * np + k] + m[l][3] * in[XV3 * np + k]);
+        }
+
+      if (perspective_p)
+        {
+          float w = y[3] + offset4d[3];
+          float q = 1.0 / w;
+          for (l = 0; l < 3; l++)
+            {
+              float r = y[l] + offset4d[l];
+              p[l]  = r * q + offset3d[l];
+              pu[l] = yu[l] * w - r * yu[3];
+              pv[l] = yv[l] * w - r * yv[3];
+            }
+        }
+      else
+        {
+          for (l = 0; l < 3; l++)
+            {
+              p[l]  = (y[l] + offset4d[l]) * scale + offset3d[l];
+              pu[l] = yu[l];
+              pv[l] = yv[l];
+            }
+        }
+      p[3] = 0;
+
+      n[0] = pu[1] * pv[2] - pu[2] * pv[1];
+      n[1] = pu[2] * pv[0] - pu[0] * pv[2];
+      n[2] = pu[0] * pv[1] - pu[1] * pv[0];
+      t = 1.0 / sqrt (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      n[0] *= t;
+      n[1] *= t;
+      n[2] *= t;
+      n[3] = 0;
+    }
+}
+
+
+int
+surface4d_draw (surface4d *s, Bool wire_p)
+{
+  int i, polys = 0;
+
+  for (i = 0; i < s->nstrips; i++)
+    polys += strip_length (s, i);
+
+#ifdef USE_VERTEX_ARRAY
+  if (s->index_dirty_p || s->index_wire_p != wire_p || !s->index)
+    make_index (s, wire_p);
+  if (!s->index) return 0;
+
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glEnableClientState (GL_NORMAL_ARRAY);
+  glVertexPointer (3, GL_FLOAT, 4 * sizeof(float), s->points);
+  glNormalPointer (GL_FLOAT, 4 * sizeof(float), s->normals);
+  if (s->tex)
+    {
+      glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+      glTexCoordPointer (2, GL_FLOAT, 0, s->tex);
+    }
+  if (s->colors)
+    {
+      glEnableClientState (GL_COLOR_ARRAY);
+      glColorPointer (4, GL_FLOAT, 0, s->colors);
+      glColorMaterial (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+      glEnable (GL_COLOR_MATERIAL);
+    }
+
+  glDrawElements ((wire_p ? GL_QUADS : GL_TRIANGLES), s->nindex,
+                  GL_UNSIGNED_INT, s->index);
+
+  if (s->colors)
+    {
+      glDisable (GL_COLOR_MATERIAL);
+      glDisableClientState (GL_COLOR_ARRAY);
+    }
+  if (s->tex)
+    glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState (GL_NORMAL_ARRAY);
+  glDisableClientState (GL_VERTEX_ARRAY);
+
+#else  /* !USE_VERTEX_ARRAY */
+
+  for (i = 0; i < s->nstrips; i++)
+    {
+      int m, k;
+      glBegin (wire_p ? GL_QUAD_STRIP : GL_TRIANGLE_STRIP);
+      for (m = 0; m <= strip_length (s, i); m++)
+        {
+          int ab[2];
+          strip_vertices (s, i, m, &ab[0], &ab[1]);
+          for (k = 0; k < 2; k++)
+            {
+              int o = ab[k];
+              glNormal3fv (s->normals + 4 * o);
+              if (s->tex)
+                glTexCoord2fv (s->tex + 2 * o);
+              if (s->colors)
+                {
+                  glColor4fv (s->colors + 4 * o);
+                  glMaterialfv (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE,
+                                s->colors + 4 * o);
+                }
+              glVertex3fv (s->points + 4 * o);
+            }
+        }
+      glEnd();
+    }
+#endif /* !USE_VERTEX_ARRAY */
+
+  return polys;
+}
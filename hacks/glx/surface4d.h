@@ -0,0 +1,68 @@
+/* surface4d, Copyright (c) 2026 agent <agent@local>
+ * Parametric surfaces in 4D, projected into 3D.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#ifndef __SURFACE4D_H__
+#define __SURFACE4D_H__
+
+/* The hacks that show surfaces rotating in 4D (klein, projectiveplane,
+   hypertorus) sample the surface on a grid once, at startup: the points
+   and their two tangent vectors.  Each frame, only the 4D rotation
+   changes.  This keeps the samples, rotates and projects them all in one
+   pass, and draws the result with one glDrawElements.
+
+   The grid has (rows + 1) x (cols + 1) vertices.  The surface is drawn
+   as strips between adjacent rows or columns, which need not all be
+   there, for hacks that draw bands.
+ */
+
+typedef struct surface4d surface4d;
+
+extern surface4d *surface4d_new (int rows, int cols);
+extern void surface4d_free (surface4d *);
+
+/* The point at row i, column j, and the derivatives of the surface
+   there in the two parameter directions, which determine the normal.
+ */
+extern void surface4d_set_point (surface4d *, int i, int j,
+                                 const float x[4], const float xu[4],
+                                 const float xv[4]);
+
+/* Optional.  If colors are set, each vertex is drawn with its color as
+   both glColor and the ambient and diffuse material; if not, with
+   whatever the current color and materials are.
+ */
+extern void surface4d_set_color (surface4d *, int i, int j,
+                                 const float color[4]);
+extern void surface4d_set_texcoord (surface4d *, int i, int j,
+                                    const float tex[2]);
+
+/* Adds the strip between row n and row n+1, or between column n and
+   column n+1.  The triangles are wound as a GL_TRIANGLE_STRIP that goes
+   from (n,0) to (n+1,0) to (n,1) and so on would wind them.
+ */
+extern void surface4d_add_strip (surface4d *, int n, Bool column_p);
+
+/* Rotates the points with m, then moves them by offset4d.  If
+   perspective_p, they are divided by their w; otherwise, w is dropped
+   and they are multiplied by scale.  Then they are moved by offset3d.
+ */
+extern void surface4d_project (surface4d *, float m[4][4],
+                               const float offset4d[4],
+                               const float offset3d[3],
+                               float scale, Bool perspective_p);
+
+/* Draws the strips as triangles, or if wire_p, as quads, to be drawn
+   with glPolygonMode GL_LINE.  Returns the number of quads.
+ */
+extern int surface4d_draw (surface4d *, Bool wire_p);
+
+#endif /* __SURFACE4D_H__ */
@@ -623,7 +623,6 @@ ENTRYPOINT void draw_surface(ModeInfo * mi)
   draw(mi);
   if (mi->fps_p)
     do_fps(mi);
-  glFinish();
   glXSwapBuffers(display, window);
 }
 
@@ -0,0 +1,479 @@
+/* texcache, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ *
+ * A cache file holds one texture and all of its mipmap levels, largest
+ * first, after a one-line text header naming what it is.  The pixels are
+ * bytes, so the files are the same on every architecture.  They are
+ * mapped rather than read, when possible.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+# include <sys/mman.h>
+#endif
+
+#ifdef HAVE_COCOA
+# ifdef USE_IPHONE
+#  include "jwzgles.h"
+# else
+#  include <OpenGL/gl.h>
+# endif
+#elif defined(HAVE_ANDROID)
+# include <GLES/gl.h>
+# include "jwzgles.h"
+#else
+# include <GL/glx.h>
+#endif
+
+#ifdef HAVE_JWZGLES
+# include "jwzgles.h"
+#endif /* HAVE_JWZGLES */
+
+#include "thread_util.h"
+#include "texcache.h"
+
+#define TEXTURE_CACHE_MAGIC "XSTEX1"
+
+struct texture_cache {
+  struct io_thread io;
+  Bool thread_p;		/* worker is running */
+  Bool pending_p;		/* levels 1+ are yet to be loaded */
+
+  Display *dpy;
+  char *header;			/* first line of the file, with the \n */
+  char *file;			/* 0 if there's nowhere to cache things */
+
+  int width, height, bpp, nlevels;
+  GLenum format;
+
+  GLubyte *data;		/* every level, largest first */
+  size_t size;
+  void *map;			/* if data is in the mapped file */
+  size_t map_size;
+  Bool hit_p;
+
+  GLuint texture;
+  GLint min_filter;
+};
+
+
+static int
+level_width (texture_cache *tc, int level)
+{
+  int w = tc->width >> level;
+  return (w < 1 ? 1 : w);
+}
+
+static int
+level_height (texture_cache *tc, int level)
+{
+  int h = tc->height >> level;
+  return (h < 1 ? 1 : h);
+}
+
+static size_t
+level_size (texture_cache *tc, int level)
+{
+  return (size_t) level_width (tc, level) * level_height (tc, level) * tc->bpp;
+}
+
+static GLubyte *
+level_data (texture_cache *tc, int level)
+{
+  GLubyte *d = tc->data;
+  int i;
+  for (i = 0; i < level; i++)
+    d += level_size (tc, i);
+  return d;
+}
+
+
+/* The directory where texture files go, created if necessary,
+   following the conventions of xscreensaver-getimage-file.
+ */
+static char *
+cache_dir (void)
+{
+  const char *home = getenv ("HOME");
+  struct stat st;
+  char *dir;
+
+  if (!home || !*home) return 0;
+  dir = (char *) malloc (strlen (home) + 60);
+  if (!dir) return 0;
+
+  sprintf (dir, "%s/Library/Caches", home);		/* MacOS */
+  if (!stat (dir, &st) && S_ISDIR (st.st_mode))
+    strcat (dir, "/org.jwz.xscreensaver.textures");
+  else
+    {
+      sprintf (dir, "%s/.cache", home);			/* XDG */
+      if (stat (dir, &st) || !S_ISDIR (st.st_mode))
+        {
+          free (dir);
+          return 0;
+        }
+      strcat (dir, "/xscreensaver");
+      mkdir (dir, 0755);
+      strcat (dir, "/textures");
+    }
+
+  if (mkdir (dir, 0755) && errno != EEXIST)
+    {
+      free (dir);
+      return 0;
+    }
+  return dir;
+}
+
+
+/* Fills in tc->data from the cache file, if it is there and is the
+   texture we want.
+ */
+static void
+read_cache (texture_cache *tc)
+{
+  size_t hlen = strlen (tc->header);
+  struct stat st;
+  char *buf = 0;
+  int fd;
+
+  if (!tc->file) return;
+  fd = open (tc->file, O_RDONLY);
+  if (fd < 0) return;
+  if (fstat (fd, &st) || (size_t) st.st_size != hlen + tc->size)
+    goto DONE;
+
+# ifdef HAVE_UNISTD_H
+  {
+    void *map = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED)
+      {
+        if (!memcmp (map, tc->header, hlen))
+          {
+            tc->map = map;
+            tc->map_size = st.st_size;
+            tc->data = (GLubyte *) map + hlen;
+            tc->hit_p = True;
+          }
+        else
+          munmap (map, st.st_size);
+        goto DONE;
+      }
+  }
+# endif /* HAVE_UNISTD_H */
+
+  /* Can't map it: read it. */
+  if (thread_malloc ((void **) &tc->data, tc->dpy, tc->size))
+    {
+      tc->data = 0;
+      goto DONE;
+    }
+  buf = (char *) malloc (hlen);
+  if (buf &&
+      read (fd, buf, hlen) == (ssize_t) hlen &&
+      !memcmp (buf, tc->header, hlen) &&
+      read (fd, tc->data, tc->size) == (ssize_t) tc->size)
+    tc->hit_p = True;
+
+ DONE:
+  if (buf) free (buf);
+  close (fd);
+}
+
+
+/* Writes the file under a temporary name and renames it, so that no
+   other process can see half of one.
+ */
+static void
+write_cache (texture_cache *tc)
+{
+  size_t hlen = strlen (tc->header);
+  char *tmp;
+  int fd;
+  Bool ok;
+
+  if (!tc->file) return;
+  tmp = (char *) malloc (strlen (tc->file) + 20);
+  if (!tmp) return;
+  sprintf (tmp, "%s.%lu", tc->file, (unsigned long) getpid());
+
+  fd = open (tmp, O_WRONLY | O_CREAT | O_EXCL, 0644);
+  if (fd < 0)
+    {
+      free (tmp);
+      return;
+    }
+
+  ok = (write (fd, tc->header, hlen) == (ssize_t) hlen &&
+        write (fd, tc->data, tc->size) == (ssize_t) tc->size);
+  if (close (fd)) ok = False;
+  if (!ok || rename (tmp, tc->file))
+    unlink (tmp);
+  free (tmp);
+}
+
+
+/* Box-filters each level down from the one above it.
+   Odd rows and columns at the edges are dropped.
+ */
+static void
+build_mipmaps (texture_cache *tc)
+{
+  int level;
+  for (level = 1; level < tc->nlevels; level++)
+    {
+      const GLubyte *src = level_data (tc, level - 1);
+      GLubyte *dst = level_data (tc, level);
+      int sw = level_width (tc, level - 1);
+      int sh = level_height (tc, level - 1);
+      int w  = level_width (tc, level);
+      int h  = level_height (tc, level);
+      int bpp = tc->bpp;
+      int dx = (sw > 1 ? bpp : 0);
+      int dy = (sh > 1 ? sw * bpp : 0);
+      int x, y, i;
+
+      for (y = 0; y < h; y++)
+        {
+          const GLubyte *s = src + (y * (sh > 1 ? 2 : 1)) * sw * bpp;
+          for (x = 0; x < w; x++)
+            {
+              for (i = 0; i < bpp; i++)
+                *dst++ = (s[i] + s[i + dx] + s[i + dy] + s[i + dx + dy] + 2)
+                  >> 2;
+              s += (sw > 1 ? 2 : 1) * bpp;
+            }
+        }
+    }
+}
+
+
+static void
+destroy_cache (texture_cache *tc)
+{
+# ifdef HAVE_UNISTD_H
+  if (tc->map)
+    munmap (tc->map, tc->map_size);
+  else
+# endif
+  if (tc->data)
+    thread_free (tc->data);
+  if (tc->header) free (tc->header);
+  if (tc->file) free (tc->file);
+  thread_free (tc);
+}
+
+
+#if HAVE_PTHREAD
+static void *
+texture_cache_thread (void *self_raw)
+{
+  texture_cache *tc = (texture_cache *) self_raw;
+  build_mipmaps (tc);
+  write_cache (tc);
+  if (io_thread_return (&tc->io))
+    destroy_cache (tc);
+  return NULL;
+}
+#endif /* HAVE_PTHREAD */
+
+
+texture_cache *
+texture_cache_open (Display *dpy, const char *hack, const char *params,
+                    int width, int height, GLenum format)
+{
+  texture_cache *tc;
+  unsigned long hash = 2166136261UL;
+  const unsigned char *s;
+  char *dir;
+  int i;
+
+  if (thread_malloc ((void **) &tc, dpy, sizeof(*tc)))
+    return 0;
+  memset (tc, 0, sizeof(*tc));
+
+  if (width < 1)  width = 1;
+  if (height < 1) height = 1;
+  if (!params) params = "";
+
+  tc->dpy = dpy;
+  tc->width = width;
+  tc->height = height;
+  tc->format = format;
+  switch (format) {
+  case GL_RGBA:            tc->bpp = 4; break;
+  case GL_RGB:             tc->bpp = 3; break;
+  case GL_LUMINANCE_ALPHA: tc->bpp = 2; break;
+  default:                 tc->bpp = 1; break;
+  }
+
+  for (i = (width > height ? width : height); i > 0; i >>= 1)
+    tc->nlevels++;
+  for (i = 0; i < tc->nlevels; i++)
+    tc->size += level_size (tc, i);
+
+  tc->header = (char *) malloc (strlen (TEXTURE_CACHE_MAGIC) + strlen (hack) +
+                                strlen (params) + 60);
+  if (!tc->header) goto FAIL;
+  sprintf (tc->header, "%s %s %dx%d %04x %s\n", TEXTURE_CACHE_MAGIC,
+           hack, width, height, (unsigned int) format, params);
+
+  /* FNV-1a, to keep file names short whatever the params are. */
+  for (s = (const unsigned char *) tc->header; *s; s++)
+    hash = ((hash ^ *s) * 16777619UL) & 0xFFFFFFFFUL;
+
+  dir = cache_dir();
+  if (dir)
+    {
+      tc->file = (char *) malloc (strlen (dir) + strlen (hack) + 20);
+      if (tc->file)
+        sprintf (tc->file, "%s/%s-%08lx.tex", dir, hack, hash);
+      free (dir);
+    }
+
+  read_cache (tc);
+  if (!tc->hit_p && !tc->data)
+    {
+      if (thread_malloc ((void **) &tc->data, dpy, tc->size))
+        {
+          tc->data = 0;
+          goto FAIL;
+        }
+    }
+  return tc;
+
+ FAIL:
+  destroy_cache (tc);
+  return 0;
+}
+
+
+GLubyte *
+texture_cache_buffer (texture_cache *tc)
+{
+  return (tc->hit_p ? 0 : tc->data);
+}
+
+
+static void
+load_levels (texture_cache *tc, int from, int to)
+{
+  int i;
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+  for (i = from; i < to; i++)
+    glTexImage2D (GL_TEXTURE_2D, i, tc->format,
+                  level_width (tc, i), level_height (tc, i), 0,
+                  tc->format, GL_UNSIGNED_BYTE, level_data (tc, i));
+}
+
+
+/* Loads the smaller levels into the texture, which need not be bound.
+ */
+static void
+load_rest (texture_cache *tc)
+{
+  GLint old = 0;
+  if (!tc->pending_p) return;
+  tc->pending_p = False;
+
+  glGetIntegerv (GL_TEXTURE_BINDING_2D, &old);
+  glBindTexture (GL_TEXTURE_2D, tc->texture);
+  load_levels (tc, 1, tc->nlevels);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tc->min_filter);
+  glBindTexture (GL_TEXTURE_2D, old);
+}
+
+
+void
+texture_cache_load (texture_cache *tc, Bool mipmap_p)
+{
+  GLint texture = 0;
+
+  if (tc->hit_p)
+    {
+      load_levels (tc, 0, (mipmap_p ? tc->nlevels : 1));
+      return;
+    }
+
+  load_levels (tc, 0, 1);
+
+  if (mipmap_p)
+    {
+      /* Until the other levels are there, minify without them. */
+      glGetIntegerv (GL_TEXTURE_BINDING_2D, &texture);
+      tc->texture = texture;
+      glGetTexParameteriv (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                           &tc->min_filter);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                       (tc->min_filter == GL_NEAREST_MIPMAP_NEAREST ||
+                        tc->min_filter == GL_NEAREST_MIPMAP_LINEAR ||
+                        tc->min_filter == GL_NEAREST
+                        ? GL_NEAREST : GL_LINEAR));
+      tc->pending_p = True;
+    }
+  else
+    return;   /* Textures loaded without mipmaps are not cached. */
+
+# if HAVE_PTHREAD
+  if (threads_available (tc->dpy) >= 0 &&
+      io_thread_create (&tc->io, tc, texture_cache_thread, tc->dpy, 0))
+    {
+      tc->thread_p = True;
+      return;
+    }
+# endif /* HAVE_PTHREAD */
+
+  build_mipmaps (tc);
+  write_cache (tc);
+  load_rest (tc);
+}
+
+
+Bool
+texture_cache_done (texture_cache *tc)
+{
+  if (tc->thread_p)
+    {
+      if (!io_thread_is_done (&tc->io))
+        return False;
+      io_thread_finish (&tc->io);
+      tc->thread_p = False;
+    }
+  load_rest (tc);
+  return True;
+}
+
+
+void
+texture_cache_free (texture_cache *tc)
+{
+  if (!tc) return;
+  if (tc->thread_p)
+    {
+      /* Otherwise the thread frees it when it's done. */
+      if (io_thread_cancel (&tc->io))
+        destroy_cache (tc);
+    }
+  else
+    destroy_cache (tc);
+}
@@ -0,0 +1,78 @@
+/* texcache, Copyright (c) 2026 agent <agent@local>
+ * Caches procedurally-generated textures on disk.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+/* Some hacks compute their textures from scratch every time they start,
+   which, when the screen saver is cycling, is the same work over and over.
+   Instead, they can keep the result, and all of its mipmap levels, in
+   ~/.cache/xscreensaver/ (or ~/Library/Caches/ on MacOS):
+
+     texture_cache *tc = texture_cache_open (dpy, "myhack", "param 7",
+                                             256, 256, GL_RGBA);
+     GLubyte *data = texture_cache_buffer (tc);
+     if (data) generate_texture (data);       -- not in the cache
+
+     glBindTexture (GL_TEXTURE_2D, id);
+     glTexParameteri (...);
+     texture_cache_load (tc, True);
+
+   and then, once per frame, until it returns True:
+
+     if (tc && texture_cache_done (tc))
+       {
+         texture_cache_free (tc);
+         tc = 0;
+       }
+
+   If the texture was not in the cache, the mipmaps are built, and the
+   cache file written, on a worker thread.  Until they are ready, the
+   texture is drawn with a GL_LINEAR minification filter.
+ */
+
+typedef struct texture_cache texture_cache;
+
+/* The texture is width x height pixels of the given format (GL_RGBA,
+   GL_RGB, GL_LUMINANCE_ALPHA, GL_LUMINANCE or GL_ALPHA) in GL_UNSIGNED_BYTE,
+   with rows packed tightly.  "params" is whatever else the texture depends
+   on: textures are the same if the hack, params, size and format are.
+   Returns 0 if out of memory.
+ */
+extern texture_cache *texture_cache_open (Display *, const char *hack,
+                                          const char *params,
+                                          int width, int height,
+                                          GLenum format);
+
+/* If the texture was in the cache, returns 0.  Otherwise, returns the
+   buffer into which the caller must generate it, before the load.
+ */
+extern GLubyte *texture_cache_buffer (texture_cache *);
+
+/* Loads the texture into the texture currently bound to GL_TEXTURE_2D,
+   with or without mipmaps.  Set the texture's parameters first.  Without
+   mipmaps, a texture that was not in the cache is not added to it.
+ */
+extern void texture_cache_load (texture_cache *, Bool mipmap_p);
+
+/* Loads any mipmap levels that have become ready since the last call.
+   Returns True once there is nothing left to do.  The GL context of the
+   texture must be current.
+ */
+extern Bool texture_cache_done (texture_cache *);
+
+/* May be called at any time: the cache file is still written if it was
+   pending, but levels not yet loaded will not be.
+ */
+extern void texture_cache_free (texture_cache *);
+
+#endif /* __TEXTURE_CACHE_H__ */
@@ -39,17 +39,11 @@
 # include "jwzgles.h"
 #endif /* HAVE_JWZGLES */
 
-#ifdef HAVE_XSHM_EXTENSION
-# include "xshm.h"
-#endif /* HAVE_XSHM_EXTENSION */
-
 #include "xft.h"
 #include "resources.h"
 #include "texfont.h"
 #include "fps.h"	/* for current_device_rotation() */
 
-#undef HAVE_XSHM_EXTENSION  /* doesn't actually do any good here */
-
 
 /* These are in xlock-gl.c */
 extern void clear_gl_error (void);
@@ -58,169 +52,72 @@ extern void check_gl_error (const char *type);
 /* screenhack.h */
 extern char *progname;
 
-/* LRU cache of textures, to optimize the case where we're drawing the
-   same strings repeatedly.
+/* Each character is rendered once, into a cell of one big texture shared
+   by every string drawn in this font.  A string is then drawn as one quad
+   per character, with no X traffic unless it contains characters that
+   haven't been seen before.
  */
-typedef struct texfont_cache texfont_cache;
-struct texfont_cache {
-  char *string;
-  GLuint texid;
-  int width, height;
-  int width2, height2;
-  texfont_cache *next;
+typedef struct texfont_glyph texfont_glyph;
+struct texfont_glyph {
+  char utf8[8];			/* the character, null terminated */
+  int advance;			/* how far it moves the pen */
+  int lbearing, rbearing;	/* horizontal extent, relative to the pen */
+  int ascent, descent;		/* vertical extent, relative to the baseline */
+  int width, height;		/* size of its cell in the atlas, with padding */
+  int ax, ay;			/* top left of its cell in the atlas */
+  Bool rendered_p;		/* whether the cell holds it */
+  Bool pending_p;		/* whether the cell has been allocated for it */
+  texfont_glyph *next;		/* hash bucket */
 };
 
+#define GLYPH_HASH_SIZE	256
+#define GLYPH_PAD	2	/* blank pixels around each cell */
+#define ATLAS_MIN_SIZE	256
+#define ATLAS_MAX_SIZE	2048
+#define RENDER_MAX_WIDTH 2048	/* widest pixmap to render glyphs into */
+
 struct texture_font_data {
   Display *dpy;
   XftFont *xftfont;
-  int cache_size;
-  texfont_cache *cache;
-};
+  Visual *visual;
+  Colormap colormap;
+  int depth;
+  int tab_width;
 
+  texfont_glyph *glyphs[GLYPH_HASH_SIZE];
 
-#undef countof
-#define countof(x) (sizeof((x))/sizeof((*x)))
-
+  /* The atlas is filled in rows ("shelves") from the top down. */
+  GLuint texid;
+  int atlas_size, max_size;
+  int shelf_x, shelf_y, shelf_h;
+  Bool mipmap_p;
 
-/* return the next larger power of 2. */
-static int
-to_pow2 (int i)
-{
-  static const unsigned int pow2[] = { 
-    1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 
-    2048, 4096, 8192, 16384, 32768, 65536 };
-  int j;
-  for (j = 0; j < sizeof(pow2)/sizeof(*pow2); j++)
-    if (pow2[j] >= i) return pow2[j];
-  abort();  /* too big! */
-}
+  /* Glyphs that have been allocated cells, but not yet rendered. */
+  texfont_glyph **pending;
+  int npending, pending_size;
+};
 
 
-/* Given a Pixmap (of screen depth), converts it to an OpenGL luminance mipmap.
-   RGB are averaged to grayscale, and the resulting value is treated as alpha.
-   Pass in the size of the pixmap; the size of the texture is returned
-   (it may be larger, since GL like powers of 2.)
+#undef countof
+#define countof(x) (sizeof((x))/sizeof((*x)))
 
-   We use a screen-depth pixmap instead of a 1bpp bitmap so that if the fonts
-   were drawn with antialiasing, that is preserved.
+/* OpenGLES doesn't support GL_INTENSITY, so instead of using a
+   texture with 1 byte per pixel, the intensity value, we have
+   to use 2 bytes per pixel: solid white, and an alpha value.
  */
-static void
-bitmap_to_texture (Display *dpy, Pixmap p, Visual *visual, int depth,
-                   int *wP, int *hP)
-{
-  Bool mipmap_p = True;
-  int ow = *wP;
-  int oh = *hP;
-  int w2 = to_pow2 (ow);
-  int h2 = to_pow2 (oh);
-  int x, y, max, scale;
-  XImage *image = 0;
-  unsigned char *data = (unsigned char *) calloc (w2 * 2, (h2 + 1));
-  unsigned char *out = data;
-
-  /* If either dimension is larger than the supported size, reduce.
-     We still return the old size to keep the caller's math working,
-     but the texture itself will have fewer pixels in it.
-   */
-  glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max);
-  scale = 1;
-  while (w2 > max || h2 > max)
-    {
-      w2 /= 2;
-      h2 /= 2;
-      scale *= 2;
-    }
-
-  /* OpenGLES doesn't support GL_INTENSITY, so instead of using a
-     texture with 1 byte per pixel, the intensity value, we have
-     to use 2 bytes per pixel: solid white, and an alpha value.
-   */
-# ifdef HAVE_JWZGLES
-#  undef GL_INTENSITY
-# endif
-
-# ifdef GL_INTENSITY
-  GLuint iformat = GL_INTENSITY;
-  GLuint format  = GL_LUMINANCE;
-# else
-  GLuint iformat = GL_LUMINANCE_ALPHA;
-  GLuint format  = GL_LUMINANCE_ALPHA;
-# endif
-  GLuint type    = GL_UNSIGNED_BYTE;
-
-# ifdef HAVE_XSHM_EXTENSION
-  Bool use_shm = get_boolean_resource (dpy, "useSHM", "Boolean");
-  XShmSegmentInfo shm_info;
-# endif /* HAVE_XSHM_EXTENSION */
-
-# ifdef HAVE_XSHM_EXTENSION
-# error XX
-  if (use_shm)
-    {
-      image = create_xshm_image (dpy, visual, depth, ZPixmap, 0, &shm_info,
-                                 ow, oh);
-      if (image)
-        XShmGetImage (dpy, p, image, 0, 0, ~0L);
-      else
-        use_shm = False;
-    }
-# endif /* HAVE_XSHM_EXTENSION */
-
-  if (!image)
-    image = XGetImage (dpy, p, 0, 0, ow, oh, ~0L, ZPixmap);
-
-# ifdef HAVE_JWZGLES
-  /* This would work, but it's wasteful for no benefit. */
-  mipmap_p = False;
-# endif
-
-  for (y = 0; y < h2; y++)
-    for (x = 0; x < w2; x++) {
-      /* Might be better to average a scale x scale square of source pixels,
-         but at the resolutions we're dealing with, this is probably good
-         enough. */
-      int sx = x * scale;
-      int sy = y * scale;
-      unsigned long pixel = (sx >= ow || sy >= oh ? 0 :
-                             XGetPixel (image, sx, sy));
-      /* instead of averaging all three channels, let's just use red,
-         and assume it was already grayscale. */
-      unsigned long r = pixel & visual->red_mask;
-      /* This goofy trick is to make any of RGBA/ABGR/ARGB work. */
-      pixel = ((r >> 24) | (r >> 16) | (r >> 8) | r) & 0xFF;
-# ifndef GL_INTENSITY
-      *out++ = 0xFF;  /* 2 bytes per pixel (luminance, alpha) */
-# endif
-      *out++ = pixel;
-    }
-
-# ifdef HAVE_XSHM_EXTENSION
-  if (use_shm)
-    destroy_xshm_image (dpy, image, &shm_info);
-  else
-# endif /* HAVE_XSHM_EXTENSION */
-    XDestroyImage (image);
-
-  image = 0;
-
-  if (mipmap_p)
-    gluBuild2DMipmaps (GL_TEXTURE_2D, iformat, w2, h2, format, type, data);
-  else
-    glTexImage2D (GL_TEXTURE_2D, 0, iformat, w2, h2, 0, format, type, data);
-
-  {
-    char msg[100];
-    sprintf (msg, "texture font %s (%d x %d)",
-             mipmap_p ? "gluBuild2DMipmaps" : "glTexImage2D",
-             w2, h2);
-    check_gl_error (msg);
-  }
-
-  free (data);
+#ifdef HAVE_JWZGLES
+# undef GL_INTENSITY
+#endif
 
-  *wP = w2 * scale;
-  *hP = h2 * scale;
-}
+#ifdef GL_INTENSITY
+# define TEX_IFORMAT GL_INTENSITY
+# define TEX_FORMAT  GL_LUMINANCE
+# define TEX_BPP     1
+#else
+# define TEX_IFORMAT GL_LUMINANCE_ALPHA
+# define TEX_FORMAT  GL_LUMINANCE_ALPHA
+# define TEX_BPP     2
+#endif
 
 
 /* Loads the font named by the X resource "res" and returns
@@ -236,19 +133,12 @@ load_texture_font (Display *dpy, char *res)
   const char *def3 = "fixed";
   XftFont *f = 0;
   texture_font_data *data;
-  int cache_size = get_integer_resource (dpy, "texFontCacheSize", "Integer");
-
-  /* Hacks that draw a lot of different strings on the screen simultaneously,
-     like Star Wars, should set this to a larger value for performance. */
-  if (cache_size <= 0)
-    cache_size = 30;
+  XWindowAttributes xgwa;
 
   if (!res || !*res) abort();
 
-  if (!strcmp (res, "fpsFont")) {  /* Kludge. */
+  if (!strcmp (res, "fpsFont"))  /* Kludge. */
     def1 = "-*-courier-bold-r-normal-*-*-140-*-*-*-*-*-*";
-    cache_size = 0;  /* No need for a cache on FPS: already throttled. */
-  }
 
   if (!font) font = strdup(def1);
 
@@ -290,92 +180,157 @@ load_texture_font (Display *dpy, char *res)
   free (font);
   font = 0;
 
+  XGetWindowAttributes (dpy, RootWindow (dpy, screen), &xgwa);
+
   data = (texture_font_data *) calloc (1, sizeof(*data));
   data->dpy = dpy;
   data->xftfont = f;
-  data->cache_size = cache_size;
+  data->visual = xgwa.visual;
+  data->colormap = xgwa.colormap;
+  data->depth = xgwa.depth;
 
   return data;
 }
 
 
-/* Measure the string, or render it, depending on whether the XftDraw
-   is supplied.
+/* Returns the glyph for the character at the front of the string, and
+   its length in bytes.  The first time a character is seen, this measures
+   it, but doesn't render it.
  */
-static int
-iterate_texture_string (texture_font_data *data,
-                        const char *s, 
-                        XftDraw *xftdraw, XftColor *xftcolor,
-                        int x, int y,
-                        int *height_ret)
+static texfont_glyph *
+get_glyph (texture_font_data *data, const char *s, int *len_ret)
 {
-  int line_height = data->xftfont->ascent + data->xftfont->descent;
-  int left = x;
-  int max_x, ox, oy;
-  const char *os = s;
-  Bool sub_p = False, osub_p = False;
-  int cw = 0, tabs = 0;
+  unsigned int h = (unsigned char) *s;
+  texfont_glyph *g;
   XGlyphInfo extents;
+  int len = 1;
 
-  y += line_height;
-  max_x = x;
-  ox = x;
-  oy = y;
+  /* Include any UTF-8 continuation bytes. */
+  while (len < 4 && (((unsigned char) s[len]) & 0xC0) == 0x80)
+    {
+      h = h * 31 + (unsigned char) s[len];
+      len++;
+    }
+  *len_ret = len;
+  h %= GLYPH_HASH_SIZE;
+
+  for (g = data->glyphs[h]; g; g = g->next)
+    if (!strncmp (g->utf8, s, len) && !g->utf8[len])
+      return g;
+
+  g = (texfont_glyph *) calloc (1, sizeof(*g));
+  memcpy (g->utf8, s, len);
+  XftTextExtentsUtf8 (data->dpy, data->xftfont, (FcChar8 *) g->utf8, len,
+                      &extents);
+  g->advance  = extents.xOff;
+  g->lbearing = (extents.x > 0 ? -extents.x : 0);
+  g->rbearing = (extents.width - extents.x > extents.xOff
+                 ? extents.width - extents.x
+                 : extents.xOff);
+  g->ascent   = (extents.y > data->xftfont->ascent
+                 ? extents.y : data->xftfont->ascent);
+  g->descent  = (extents.height - extents.y > data->xftfont->descent
+                 ? extents.height - extents.y : data->xftfont->descent);
+
+  /* Keep rows 4-byte aligned for glTexSubImage2D. */
+  g->width  = (g->rbearing - g->lbearing + GLYPH_PAD*2 + 3) & ~3;
+  g->height = g->ascent + g->descent + GLYPH_PAD*2;
+
+  g->next = data->glyphs[h];
+  data->glyphs[h] = g;
+  return g;
+}
 
-  while (1)
+
+static int
+tab_width (texture_font_data *data)
+{
+  if (! data->tab_width)
     {
-      if (*s == 0 ||
-          *s == '\n' ||
-          *s == '\t' ||
-          (*s == '[' && isdigit(s[1])) ||
-          (*s == ']' && sub_p))
+      /* Measure "m" to determine tab width. */
+      int len;
+      int cw = get_glyph (data, "m", &len)->advance;
+      if (cw <= 0) cw = 1;
+      data->tab_width = cw * 7;
+    }
+  return data->tab_width;
+}
+
+
+/* Measures the string, or emits quads for it, depending on draw_p.
+   When drawing, the caller has done glBegin (GL_QUADS), and every glyph
+   in the string is in the atlas.
+ */
+static int
+layout_texture_string (texture_font_data *data, const char *s,
+                       Bool draw_p, int *height_ret)
+{
+  int line_height = data->xftfont->ascent + data->xftfont->descent;
+  int margin = line_height * 0.35;
+  int sub = line_height * 0.3;
+  int x = 0, y = line_height;
+  int max_x = 0;
+  Bool sub_p = False;
+  GLfloat scale = (draw_p ? 1.0 / data->atlas_size : 0);
+
+  while (*s)
+    {
+      texfont_glyph *g;
+      int len;
+
+      if (*s == '\n')
+        {
+          x = 0;
+          y += line_height;
+          sub_p = False;
+          s++;
+          continue;
+        }
+      else if (*s == '\t')
+        {
+          int tabs = tab_width (data);
+          x = ((x + tabs) / tabs) * tabs;
+          s++;
+          continue;
+        }
+      else if (*s == '[' && isdigit(s[1]))
+        {
+          sub_p = True;
+          s++;
+          continue;
+        }
+      else if (*s == ']' && sub_p)
+        {
+          sub_p = False;
+          s++;
+          continue;
+        }
+
+      g = get_glyph (data, s, &len);
+      s += len;
+
+      if (draw_p && g->rendered_p)
         {
-          if (s == os)
-            extents.xOff = 0;
-          else
-            XftTextExtentsUtf8 (data->dpy, data->xftfont,
-                                (FcChar8 *) os, (int) (s - os),
-                                &extents);
-          x += extents.xOff;
-          if (x > max_x)
-            max_x = x;
-
-          if (*s == '\n')
-            {
-              x = left;
-              y += line_height;
-              sub_p = False;
-            }
-          else if (*s == '\t')
-            {
-              if (! cw)
-                {
-                  /* Measure "m" to determine tab width. */
-                  XftTextExtentsUtf8 (data->dpy, data->xftfont,
-                                      (FcChar8 *) "m", 1, &extents);
-                  cw = extents.xOff;
-                  if (cw <= 0) cw = 1;
-                  tabs = cw * 7;
-                }
-              x = ((x + tabs) / tabs) * tabs;
-            }
-          else if (*s == '[' && isdigit(s[1]))
-            sub_p = True;
-          else if (*s == ']' && sub_p)
-            sub_p = False;
-
-          if (xftdraw && s != os)
-            XftDrawStringUtf8 (xftdraw, xftcolor, data->xftfont,
-                               ox, 
-                               oy + (int) (osub_p ? line_height * 0.3 : 0),
-                               (FcChar8 *) os, (int) (s - os));
-          if (!*s) break;
-          os = s+1;
-          ox = x;
-          oy = y;
-          osub_p = sub_p;
+          /* The first baseline is at `margin', and lines go down. */
+          GLfloat qx0 = x + g->lbearing - GLYPH_PAD;
+          GLfloat qy0 = (line_height + margin - y - (sub_p ? sub : 0) +
+                         g->ascent + GLYPH_PAD);
+          GLfloat qx1 = qx0 + g->width;
+          GLfloat qy1 = qy0 - g->height;
+          GLfloat tx0 = g->ax * scale;
+          GLfloat ty0 = g->ay * scale;
+          GLfloat tx1 = (g->ax + g->width)  * scale;
+          GLfloat ty1 = (g->ay + g->height) * scale;
+
+          glTexCoord2f (tx0, ty0); glVertex3f (qx0, qy0, 0);
+          glTexCoord2f (tx1, ty0); glVertex3f (qx1, qy0, 0);
+          glTexCoord2f (tx1, ty1); glVertex3f (qx1, qy1, 0);
+          glTexCoord2f (tx0, ty1); glVertex3f (qx0, qy1, 0);
         }
-      s++;
+
+      x += g->advance;
+      if (x > max_x)
+        max_x = x;
     }
 
   if (height_ret)
@@ -389,257 +344,325 @@ iterate_texture_string (texture_font_data *data,
 int
 texture_string_width (texture_font_data *data, const char *s, int *height_ret)
 {
-  return iterate_texture_string (data, s, 0, 0, 0, 0, height_ret);
+  return layout_texture_string (data, s, False, height_ret);
 }
 
 
-static struct texfont_cache *
-get_cache (texture_font_data *data, const char *string)
+/* Creates the atlas texture, or replaces it with an empty one of the
+   given size.  Every glyph will need to be rendered again.
+ */
+static void
+reset_atlas (texture_font_data *data, int size)
 {
-  int count = 0;
-  texfont_cache *prev = 0, *prev2 = 0, *curr = 0, *next = 0;
-
-  if (data->cache)
-    for (prev2 = 0, prev = 0, curr = data->cache, next = curr->next;
-         curr;
-         prev2 = prev, prev = curr, curr = next,
-           next = (curr ? curr->next : 0), count++)
-      {
-        if (!strcmp (string, curr->string))
-          {
-            if (prev)
-              prev->next = next;       /* Unlink from list */
-            if (curr != data->cache)
-              {
-                curr->next = data->cache;  /* Move to front */
-                data->cache = curr;
-              }
-            return curr;
-          }
-      }
+  unsigned char *blank;
+  int i;
 
-  /* Made it to the end of the list without a hit.
-     If the cache is full, empty out the last one on the list,
-     and move it to the front.  Keep the texid.
-   */
-  if (count > data->cache_size)
+  for (i = 0; i < GLYPH_HASH_SIZE; i++)
+    {
+      texfont_glyph *g;
+      for (g = data->glyphs[i]; g; g = g->next)
+        g->rendered_p = g->pending_p = False;
+    }
+  data->npending = 0;
+  data->shelf_x = data->shelf_y = data->shelf_h = 0;
+
+  if (! data->texid)
     {
-      free (prev->string);
-      prev->string  = 0;
-      prev->width   = 0;
-      prev->height  = 0;
-      prev->width2  = 0;
-      prev->height2 = 0;
-      if (prev2)
-        prev2->next = 0;
-      if (prev != data->cache)
-        prev->next = data->cache;
-      data->cache = prev;
-      return prev;
+      GLint max = 0;
+      glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max);
+      data->max_size = (max > ATLAS_MAX_SIZE ? ATLAS_MAX_SIZE :
+                        max < ATLAS_MIN_SIZE ? ATLAS_MIN_SIZE : max);
+      glGenTextures (1, &data->texid);
     }
 
-  /* Not cached, and cache not full.  Add a new entry at the front,
-     and allocate a new texture for it.
+  data->atlas_size = size;
+  blank = (unsigned char *) calloc (size * TEX_BPP, size);
+  glBindTexture (GL_TEXTURE_2D, data->texid);
+  clear_gl_error ();
+
+  /* Texture-rendering parameters to make font pixmaps tolerable to look at.
+     These belong to the texture, so they only need to be set once.
    */
-  curr = (struct texfont_cache *) calloc (1, sizeof(*prev));
-  glGenTextures (1, &curr->texid);
-  curr->string = 0;
-  curr->next = data->cache;
-  data->cache = curr;
+  data->mipmap_p = False;
+# if defined(GL_GENERATE_MIPMAP) && !defined(HAVE_JWZGLES)
+  /* Rebuild the mipmaps whenever a glyph is added to the atlas. */
+  glTexParameteri (GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+  data->mipmap_p = (glGetError() == GL_NO_ERROR);
+# endif
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                   (data->mipmap_p ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
 
-  return curr;
+  /* LOD bias is part of OpenGL 1.4.
+     GL_EXT_texture_lod_bias has been present since the original iPhone.
+   */
+# if !defined(GL_TEXTURE_LOD_BIAS) && defined(GL_TEXTURE_LOD_BIAS_EXT)
+#   define GL_TEXTURE_LOD_BIAS GL_TEXTURE_LOD_BIAS_EXT
+# endif
+# ifdef GL_TEXTURE_LOD_BIAS
+  glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, 0.25);
+# endif
+  clear_gl_error();  /* invalid enum on iPad 3 */
+
+  glTexImage2D (GL_TEXTURE_2D, 0, TEX_IFORMAT, size, size, 0,
+                TEX_FORMAT, GL_UNSIGNED_BYTE, blank);
+  free (blank);
+
+  {
+    char msg[100];
+    sprintf (msg, "texture font atlas (%d x %d)", size, size);
+    check_gl_error (msg);
+  }
 }
 
 
-/* Draws the string in the scene at the origin.
-   Newlines and tab stops are honored.
-   Any numbers inside [] will be rendered as a subscript.
-   Assumes the font has been loaded as with load_texture_font().
+/* Allocates a cell in the atlas for the glyph.  Returns False if full.
  */
-void
-print_texture_string (texture_font_data *data, const char *string)
+static Bool
+place_glyph (texture_font_data *data, texfont_glyph *g)
 {
-  int line_height = data->xftfont->ascent + data->xftfont->descent;
-  int margin = line_height * 0.35;
-  int width, height;
-  int width2, height2;
-  XWindowAttributes xgwa;
-  Pixmap p = 0;
-  texfont_cache *cache;
-
-  if (!*string) return;
+  if (data->shelf_x + g->width > data->atlas_size)
+    {
+      data->shelf_x = 0;
+      data->shelf_y += data->shelf_h;
+      data->shelf_h = 0;
+    }
+  if (g->width > data->atlas_size ||
+      data->shelf_y + g->height > data->atlas_size)
+    return False;
+
+  g->ax = data->shelf_x;
+  g->ay = data->shelf_y;
+  data->shelf_x += g->width;
+  if (g->height > data->shelf_h)
+    data->shelf_h = g->height;
+  g->pending_p = True;
+
+  if (data->npending >= data->pending_size)
+    {
+      data->pending_size = (data->pending_size ? data->pending_size * 2 : 64);
+      data->pending = (texfont_glyph **)
+        realloc (data->pending, data->pending_size * sizeof(*data->pending));
+      if (!data->pending) abort();
+    }
+  data->pending[data->npending++] = g;
+  return True;
+}
 
-  cache = get_cache (data, string);
 
-  /* Measure the string and make a pixmap that will fit it,
-     unless it's cached.
-   */
-  if (cache->string)
+/* Draws some glyphs side by side into one pixmap, reads it back, and
+   copies each into its cell in the atlas.  The atlas is bound.
+ */
+static void
+render_glyphs (texture_font_data *data, texfont_glyph **glyphs, int n)
+{
+  Display *dpy = data->dpy;
+  int w = 0, h = 0, x, i;
+  Pixmap p;
+  XGCValues gcv;
+  GC gc;
+  XRenderColor rcolor;
+  XftColor xftcolor;
+  XftDraw *xftdraw;
+  XImage *image;
+  unsigned char *buf;
+
+  for (i = 0; i < n; i++)
     {
-      width   = data->cache->width;
-      height  = data->cache->height;
+      w += glyphs[i]->width;
+      if (glyphs[i]->height > h)
+        h = glyphs[i]->height;
     }
-  else
+  if (w <= 0 || h <= 0) return;
+
+  p = XCreatePixmap (dpy, RootWindow (dpy, DefaultScreen (dpy)),
+                     w, h, data->depth);
+  gcv.foreground = BlackPixel (dpy, DefaultScreen (dpy));
+  gc = XCreateGC (dpy, p, GCForeground, &gcv);
+  XFillRectangle (dpy, p, gc, 0, 0, w, h);
+  XFreeGC (dpy, gc);
+
+  rcolor.red = rcolor.green = rcolor.blue = rcolor.alpha = 0xFFFF;
+  XftColorAllocValue (dpy, data->visual, data->colormap, &rcolor, &xftcolor);
+  xftdraw = XftDrawCreate (dpy, p, data->visual, data->colormap);
+  for (i = 0, x = 0; i < n; x += glyphs[i]->width, i++)
+    XftDrawStringUtf8 (xftdraw, &xftcolor, data->xftfont,
+                       x + GLYPH_PAD - glyphs[i]->lbearing,
+                       GLYPH_PAD + glyphs[i]->ascent,
+                       (FcChar8 *) glyphs[i]->utf8,
+                       strlen (glyphs[i]->utf8));
+  XftDrawDestroy (xftdraw);
+  XftColorFree (dpy, data->visual, data->colormap, &xftcolor);
+
+  image = XGetImage (dpy, p, 0, 0, w, h, ~0L, ZPixmap);
+  XFreePixmap (dpy, p);
+  if (!image) return;
+
+  buf = (unsigned char *) malloc (w * h * TEX_BPP);
+  for (i = 0, x = 0; i < n; x += glyphs[i]->width, i++)
     {
-      Window window = RootWindow (data->dpy, 0);
-      XGCValues gcv;
-      GC gc;
-
-      XGetWindowAttributes (data->dpy, window, &xgwa);
-      width = iterate_texture_string (data, string, 0, 0, 0, 0, &height);
-      p = XCreatePixmap (data->dpy, window, 
-                         width  + margin*2,
-                         height + margin*2,
-                         xgwa.depth);
-      gcv.foreground = BlackPixelOfScreen (xgwa.screen);
-      gc = XCreateGC (data->dpy, p, GCForeground, &gcv);
-      XFillRectangle (data->dpy, p, gc, 0, 0, 
-                      width  + margin*2,
-                      height + margin*2);
-      XFreeGC (data->dpy, gc);
+      texfont_glyph *g = glyphs[i];
+      unsigned char *out = buf;
+      int gx, gy;
+      for (gy = 0; gy < g->height; gy++)
+        for (gx = 0; gx < g->width; gx++)
+          {
+            unsigned long pixel = XGetPixel (image, x + gx, gy);
+            /* instead of averaging all three channels, let's just use red,
+               and assume it was already grayscale. */
+            unsigned long r = pixel & data->visual->red_mask;
+            /* This goofy trick is to make any of RGBA/ABGR/ARGB work. */
+            pixel = ((r >> 24) | (r >> 16) | (r >> 8) | r) & 0xFF;
+# if TEX_BPP == 2
+            *out++ = 0xFF;  /* 2 bytes per pixel (luminance, alpha) */
+# endif
+            *out++ = pixel;
+          }
+      glTexSubImage2D (GL_TEXTURE_2D, 0, g->ax, g->ay, g->width, g->height,
+                       TEX_FORMAT, GL_UNSIGNED_BYTE, buf);
+      g->rendered_p = True;
+      g->pending_p = False;
     }
 
-  /* Draw the string into the pixmap, unless it's cached.
-   */
-  if (!cache->string)
+  free (buf);
+  XDestroyImage (image);
+  check_gl_error ("texture font glyphs");
+}
+
+
+/* Makes sure every character in the string is in the atlas, rendering
+   any new ones all at once.  The atlas is bound.
+ */
+static void
+load_glyphs (texture_font_data *data, const char *string)
+{
+  Bool flushed_p = False;
+  const char *s;
+  int i, start, w;
+
+  if (! data->texid)
+    reset_atlas (data, ATLAS_MIN_SIZE);
+
+ AGAIN:
+  for (s = string; *s; )
     {
-      XRenderColor rcolor;
-      XftColor xftcolor;
-      XftDraw *xftdraw;
-      rcolor.red = rcolor.green = rcolor.blue = rcolor.alpha = 0xFFFF;
-      XftColorAllocValue (data->dpy, xgwa.visual, xgwa.colormap,
-                          &rcolor, &xftcolor);
-      xftdraw = XftDrawCreate (data->dpy, p, xgwa.visual, xgwa.colormap);
-      iterate_texture_string (data, string, xftdraw, &xftcolor,
-                              margin, 0, 0);
-      XftDrawDestroy (xftdraw);
-      XftColorFree (data->dpy, xgwa.visual, xgwa.colormap, &xftcolor);
+      int len;
+      texfont_glyph *g;
+      if (*s == '\n' || *s == '\t')
+        {
+          s++;
+          continue;
+        }
+      g = get_glyph (data, s, &len);
+      s += len;
+      if (g->rendered_p || g->pending_p || place_glyph (data, g))
+        continue;
+
+      /* The atlas is full.  Make it bigger if we can, or else start it
+         over with just the characters in this string; then try again.
+       */
+      if (data->atlas_size < data->max_size)
+        {
+          reset_atlas (data, data->atlas_size * 2);
+          goto AGAIN;
+        }
+      else if (!flushed_p)
+        {
+          flushed_p = True;
+          reset_atlas (data, data->atlas_size);
+          goto AGAIN;
+        }
+      /* Otherwise, this character just won't be drawn. */
     }
 
-  {
-    GLint old_texture;
-    int ofront, oblend;
-    Bool alpha_p, blend_p;
-    GLfloat omatrix[16];
-    GLfloat qx0, qy0, qx1, qy1;
-    GLfloat tx0, ty0, tx1, ty1;
-
-    /* Save the prevailing texture environment, and set up ours.
-     */
-    glGetIntegerv (GL_TEXTURE_BINDING_2D, &old_texture);
-    glGetIntegerv (GL_FRONT_FACE, &ofront);
-    glGetIntegerv (GL_BLEND_DST, &oblend);
-    glGetFloatv (GL_TEXTURE_MATRIX, omatrix);
-    blend_p = glIsEnabled (GL_BLEND);
-    alpha_p = glIsEnabled (GL_ALPHA_TEST);
-
-    clear_gl_error ();
+  /* Render them in batches, so that the pixmap isn't too wide. */
+  for (i = start = w = 0; i < data->npending; i++)
+    {
+      w += data->pending[i]->width;
+      if (w > RENDER_MAX_WIDTH && i > start)
+        {
+          render_glyphs (data, data->pending + start, i - start);
+          start = i;
+          w = data->pending[i]->width;
+        }
+    }
+  if (i > start)
+    render_glyphs (data, data->pending + start, i - start);
+  data->npending = 0;
+}
 
-    glPushMatrix();
 
-    glNormal3f (0, 0, 1);
-    glFrontFace (GL_CW);
+/* Draws the string in the scene at the origin.
+   Newlines and tab stops are honored.
+   Any numbers inside [] will be rendered as a subscript.
+   Assumes the font has been loaded as with load_texture_font().
+ */
+void
+print_texture_string (texture_font_data *data, const char *string)
+{
+# ifdef HAVE_JWZGLES
+  GLint old_texture;
+  int ofront, oblend;
+  Bool alpha_p, blend_p, tex_p;
+# endif
 
-    glMatrixMode (GL_TEXTURE);
-    glLoadIdentity ();
-    glMatrixMode (GL_MODELVIEW);
+  if (!*string) return;
 
-    glBindTexture (GL_TEXTURE_2D, cache->texid);
-    check_gl_error ("texture font binding");
+  /* Save the prevailing texture environment, and set up ours.
+     glPushAttrib doesn't need a round trip, but GLES doesn't have it.
+   */
+# ifdef HAVE_JWZGLES
+  glGetIntegerv (GL_TEXTURE_BINDING_2D, &old_texture);
+  glGetIntegerv (GL_FRONT_FACE, &ofront);
+  glGetIntegerv (GL_BLEND_DST, &oblend);
+  blend_p = glIsEnabled (GL_BLEND);
+  alpha_p = glIsEnabled (GL_ALPHA_TEST);
+  tex_p   = glIsEnabled (GL_TEXTURE_2D);
+# else
+  glPushAttrib (GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_POLYGON_BIT |
+                GL_TEXTURE_BIT);
+# endif
 
-    glEnable(GL_TEXTURE_2D);
+  if (data->texid)
+    glBindTexture (GL_TEXTURE_2D, data->texid);
+  load_glyphs (data, string);
 
-    /* Copy the bits from the Pixmap into a texture, unless it's cached.
-     */
-    if (cache->string)
-      {
-        width2  = data->cache->width2;
-        height2 = data->cache->height2;
-        if (p) abort();
-      }
-    else
-      {
-        width2  = width  + margin*2;
-        height2 = height + margin*2;
-        bitmap_to_texture (data->dpy, p, xgwa.visual, xgwa.depth,
-                           &width2, &height2);
-        XFreePixmap (data->dpy, p);
-      }
+  glNormal3f (0, 0, 1);
+  glFrontFace (GL_CW);
 
+  glMatrixMode (GL_TEXTURE);
+  glPushMatrix ();
+  glLoadIdentity ();
+  glMatrixMode (GL_MODELVIEW);
 
-    /* Texture-rendering parameters to make font pixmaps tolerable to look at.
-     */
+  glEnable (GL_TEXTURE_2D);
 
-    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                     GL_LINEAR_MIPMAP_LINEAR);
+  /* Don't write the transparent parts of the quad into the depth buffer. */
+  glAlphaFunc (GL_GREATER, 0.01);
+  glEnable (GL_ALPHA_TEST);
+  glEnable (GL_BLEND);
+  glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    /* LOD bias is part of OpenGL 1.4.
-       GL_EXT_texture_lod_bias has been present since the original iPhone.
-     */
-# if !defined(GL_TEXTURE_LOD_BIAS) && defined(GL_TEXTURE_LOD_BIAS_EXT)
-#   define GL_TEXTURE_LOD_BIAS GL_TEXTURE_LOD_BIAS_EXT
-# endif
-# ifdef GL_TEXTURE_LOD_BIAS
-    glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, 0.25);
-# endif
-    clear_gl_error();  /* invalid enum on iPad 3 */
-
-    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    /* Don't write the transparent parts of the quad into the depth buffer. */
-    glAlphaFunc (GL_GREATER, 0.01);
-    glEnable (GL_ALPHA_TEST);
-    glEnable (GL_BLEND);
-    glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    /* Draw a quad with that texture on it, possibly using a cached texture.
-     */
-    qx0 = -margin;
-    qy0 = line_height + margin;
-    qx1 = width + margin;
-    qy1 = line_height - height - margin;
-
-    tx0 = 0;
-    ty0 = 0;
-    tx1 = (width  + margin*2) / (GLfloat) width2;
-    ty1 = (height + margin*2) / (GLfloat) height2;
-
-    glBegin (GL_QUADS);
-    glTexCoord2f (tx0, ty0); glVertex3f (qx0, qy0, 0);
-    glTexCoord2f (tx1, ty0); glVertex3f (qx1, qy0, 0);
-    glTexCoord2f (tx1, ty1); glVertex3f (qx1, qy1, 0);
-    glTexCoord2f (tx0, ty1); glVertex3f (qx0, qy1, 0);
-    glEnd();
+  glBegin (GL_QUADS);
+  layout_texture_string (data, string, True, 0);
+  glEnd();
 
-    glPopMatrix();
+  /* Reset to the caller's texture environment.
+   */
+  glMatrixMode (GL_TEXTURE);
+  glPopMatrix ();
+  glMatrixMode (GL_MODELVIEW);
 
-    /* Reset to the caller's texture environment.
-     */
-    glBindTexture (GL_TEXTURE_2D, old_texture);
-    glFrontFace (ofront);
-    if (!alpha_p) glDisable (GL_ALPHA_TEST);
-    if (!blend_p) glDisable (GL_BLEND);
-    glBlendFunc (GL_SRC_ALPHA, oblend);
-  
-    glMatrixMode (GL_TEXTURE);
-    glMultMatrixf (omatrix);
-    glMatrixMode (GL_MODELVIEW);
-
-    check_gl_error ("texture font print");
-
-    /* Store this string into the cache, unless that's where it came from.
-     */
-    if (!cache->string)
-      {
-        cache->string  = strdup (string);
-        cache->width   = width;
-        cache->height  = height;
-        cache->width2  = width2;
-        cache->height2 = height2;
-      }
-  }
+# ifdef HAVE_JWZGLES
+  glBindTexture (GL_TEXTURE_2D, old_texture);
+  glFrontFace (ofront);
+  if (!alpha_p) glDisable (GL_ALPHA_TEST);
+  if (!blend_p) glDisable (GL_BLEND);
+  if (!tex_p)   glDisable (GL_TEXTURE_2D);
+  glBlendFunc (GL_SRC_ALPHA, oblend);
+# else
+  glPopAttrib ();
+# endif
 }
 
 
@@ -821,13 +844,18 @@ print_texture_label (Display *dpy,
 void
 free_texture_font (texture_font_data *data)
 {
-  while (data->cache)
-    {
-      texfont_cache *next = data->cache->next;
-      glDeleteTextures (1, &data->cache->texid);
-      free (data->cache);
-      data->cache = next;
-    }
+  int i;
+  for (i = 0; i < GLYPH_HASH_SIZE; i++)
+    while (data->glyphs[i])
+      {
+        texfont_glyph *next = data->glyphs[i]->next;
+        free (data->glyphs[i]);
+        data->glyphs[i] = next;
+      }
+  if (data->texid)
+    glDeleteTextures (1, &data->texid);
+  if (data->pending)
+    free (data->pending);
   if (data->xftfont)
     XftFontClose (data->dpy, data->xftfont);
   free (data);
@@ -1229,7 +1229,6 @@ draw_tunnel (ModeInfo *mi)
   glPopMatrix ();
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   check_gl_error("drawing done, calling swap buffers");
   glXSwapBuffers(dpy, window);
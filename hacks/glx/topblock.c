@@ -487,7 +487,6 @@ draw_topBlock (ModeInfo *mi)
   	glPopMatrix();	/* restore state */
   } 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
 	if (tb->highest>(5*maxFalling)) { drawCarpet=False; }
   glXSwapBuffers(dpy, window);
@@ -32,11 +32,44 @@
 #include "tube.h"
 
 typedef struct { GLfloat x, y, z; } XYZ;
+typedef struct { XYZ p; XYZ n; GLfloat s, t; } tube_vertex;
 
+/* The unit tube and cone only depend on their parameters, and hacks like
+   pipes and molecule draw hundreds of them a frame, so each combination
+   is built once into a vertex array that is kept for the life of the
+   process.  A mesh is drawn as up to three runs of that array: the side
+   walls and the two end caps.
+ */
+typedef struct tube_mesh tube_mesh;
+struct tube_mesh {
+  int cone_p, faces, smooth, caps_p, wire_p;
+  int nparts;
+  struct { GLenum mode; int first, count; } parts[3];
+  int polys;
+  tube_vertex *array;
+  tube_mesh *next;
+};
 
-static int
-unit_tube (int faces, int smooth, int caps_p, int wire_p)
+static tube_mesh *tube_meshes = 0;
+
+
+static void
+add_part (tube_mesh *m, GLenum mode, int first, int end)
+{
+  if (m->nparts >= 3) abort();
+  m->parts[m->nparts].mode  = mode;
+  m->parts[m->nparts].first = first;
+  m->parts[m->nparts].count = end - first;
+  m->nparts++;
+}
+
+
+static void
+make_unit_tube (tube_mesh *m)
 {
+  int faces = m->faces;
+  int smooth = m->smooth;
+  int wire_p = m->wire_p;
   int i;
   int polys = 0;
   GLfloat step = M_PI * 2 / faces;
@@ -45,10 +78,10 @@ unit_tube (int faces, int smooth, int caps_p, int wire_p)
   GLfloat x, y, x0=0, y0=0;
   int z = 0;
 
-  int arraysize, out;
-  struct { XYZ p; XYZ n; GLfloat s, t; } *array;
+  int arraysize, out, first;
+  tube_vertex *array;
 
-  arraysize = (faces+1) * 6;
+  arraysize = (faces+1) * 6 + 2 * (faces+4);
   array = (void *) calloc (arraysize, sizeof(*array));
   if (! array) abort();
   out = 0;
@@ -130,26 +163,17 @@ unit_tube (int faces, int smooth, int caps_p, int wire_p)
       if (out >= arraysize) abort();
     }
 
-  glEnableClientState (GL_VERTEX_ARRAY);
-  glEnableClientState (GL_NORMAL_ARRAY);
-  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
-
-  glVertexPointer   (3, GL_FLOAT, sizeof(*array), &array[0].p);
-  glNormalPointer   (   GL_FLOAT, sizeof(*array), &array[0].n);
-  glTexCoordPointer (2, GL_FLOAT, sizeof(*array), &array[0].s);
-
-  glFrontFace(GL_CCW);
-  glDrawArrays ((wire_p ? GL_LINES :
-                 (smooth ? GL_TRIANGLE_STRIP : GL_TRIANGLES)),
-                0, out);
+  add_part (m, (wire_p ? GL_LINES :
+                (smooth ? GL_TRIANGLE_STRIP : GL_TRIANGLES)),
+            0, out);
 
 
   /* End caps
    */
-  if (caps_p)
+  if (m->caps_p)
     for (z = 0; z <= 1; z++)
       {
-        out = 0;
+        first = out;
         if (! wire_p)
           {
             array[out].p.x = 0;
@@ -169,7 +193,7 @@ unit_tube (int faces, int smooth, int caps_p, int wire_p)
             GLfloat x = cos (th);
             GLfloat y = sin (th);
 
-            array[out] = array[0];  /* same normal and texture */
+            array[out] = array[first];  /* same normal and texture */
             array[out].p.x = x;
             array[out].p.y = z;
             array[out].p.z = y;
@@ -181,23 +205,20 @@ unit_tube (int faces, int smooth, int caps_p, int wire_p)
             if (out >= arraysize) abort();
           }
 
-        glVertexPointer   (3, GL_FLOAT, sizeof(*array), &array[0].p);
-        glNormalPointer   (   GL_FLOAT, sizeof(*array), &array[0].n);
-        glTexCoordPointer (2, GL_FLOAT, sizeof(*array), &array[0].s);
-
-        glFrontFace(GL_CCW);
-        glDrawArrays ((wire_p ? GL_LINE_LOOP : GL_TRIANGLE_FAN), 0, out);
+        add_part (m, (wire_p ? GL_LINE_LOOP : GL_TRIANGLE_FAN), first, out);
       }
 
-  free(array);
-
-  return polys;
+  m->array = array;
+  m->polys = polys;
 }
 
 
-static int
-unit_cone (int faces, int smooth, int cap_p, int wire_p)
+static void
+make_unit_cone (tube_mesh *m)
 {
+  int faces = m->faces;
+  int smooth = m->smooth;
+  int wire_p = m->wire_p;
   int i;
   int polys = 0;
   GLfloat step = M_PI * 2 / faces;
@@ -205,10 +226,10 @@ unit_cone (int faces, int smooth, int cap_p, int wire_p)
   GLfloat th;
   GLfloat x, y, x0, y0;
 
-  int arraysize, out;
-  struct { XYZ p; XYZ n; GLfloat s, t; } *array;
+  int arraysize, out, first;
+  tube_vertex *array;
 
-  arraysize = (faces+1) * 3;
+  arraysize = (faces+1) * 3 + (faces+2);
   array = (void *) calloc (arraysize, sizeof(*array));
   if (! array) abort();
   out = 0;
@@ -274,23 +295,14 @@ unit_cone (int faces, int smooth, int cap_p, int wire_p)
       polys++;
     }
 
-  glEnableClientState (GL_VERTEX_ARRAY);
-  glEnableClientState (GL_NORMAL_ARRAY);
-  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
-
-  glVertexPointer   (3, GL_FLOAT, sizeof(*array), &array[0].p);
-  glNormalPointer   (   GL_FLOAT, sizeof(*array), &array[0].n);
-  glTexCoordPointer (2, GL_FLOAT, sizeof(*array), &array[0].s);
-
-  glFrontFace(GL_CCW);
-  glDrawArrays ((wire_p ? GL_LINES : GL_TRIANGLES), 0, out);
+  add_part (m, (wire_p ? GL_LINES : GL_TRIANGLES), 0, out);
 
 
   /* End cap
    */
-  if (cap_p)
+  if (m->caps_p)
     {
-      out = 0;
+      first = out;
 
       if (! wire_p)
         {
@@ -309,7 +321,7 @@ unit_cone (int faces, int smooth, int cap_p, int wire_p)
           GLfloat x = cos (th);
           GLfloat y = sin (th);
 
-          array[out] = array[0];  /* same normal and texture */
+          array[out] = array[first];  /* same normal and texture */
           array[out].p.x = x;
           array[out].p.y = 0;
           array[out].p.z = y;
@@ -319,29 +331,76 @@ unit_cone (int faces, int smooth, int cap_p, int wire_p)
           if (out >= arraysize) abort();
         }
 
-      glVertexPointer   (3, GL_FLOAT, sizeof(*array), &array[0].p);
-      glNormalPointer   (   GL_FLOAT, sizeof(*array), &array[0].n);
-      glTexCoordPointer (2, GL_FLOAT, sizeof(*array), &array[0].s);
-
-      glFrontFace(GL_CCW);
-      glDrawArrays ((wire_p ? GL_LINE_LOOP : GL_TRIANGLE_FAN), 0, out);
+      add_part (m, (wire_p ? GL_LINE_LOOP : GL_TRIANGLE_FAN), first, out);
     }
 
-  free (array);
+  m->array = array;
+  m->polys = polys;
+}
+
 
-  return polys;
+static tube_mesh *
+find_tube_mesh (int faces, int smooth, int caps_p, int wire_p, int cone_p)
+{
+  tube_mesh *m;
+  for (m = tube_meshes; m; m = m->next)
+    if (m->faces == faces && m->smooth == smooth && m->caps_p == caps_p &&
+        m->wire_p == wire_p && m->cone_p == cone_p)
+      return m;
+
+  m = (tube_mesh *) calloc (1, sizeof(*m));
+  if (! m) abort();
+  m->faces  = faces;
+  m->smooth = smooth;
+  m->caps_p = caps_p;
+  m->wire_p = wire_p;
+  m->cone_p = cone_p;
+
+  if (cone_p)
+    make_unit_cone (m);
+  else
+    make_unit_tube (m);
+
+  m->next = tube_meshes;
+  tube_meshes = m;
+  return m;
+}
+
+
+static void
+tube_mesh_arrays (tube_mesh *m)
+{
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glEnableClientState (GL_NORMAL_ARRAY);
+  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+  glVertexPointer   (3, GL_FLOAT, sizeof(*m->array), &m->array[0].p);
+  glNormalPointer   (   GL_FLOAT, sizeof(*m->array), &m->array[0].n);
+  glTexCoordPointer (2, GL_FLOAT, sizeof(*m->array), &m->array[0].s);
+
+  glFrontFace(GL_CCW);
 }
 
 
 static int
-tube_1 (GLfloat x1, GLfloat y1, GLfloat z1,
-        GLfloat x2, GLfloat y2, GLfloat z2,
-        GLfloat diameter, GLfloat cap_size,
-        int faces, int smooth, int caps_p, int wire_p,
-        int cone_p)
+draw_tube_mesh (tube_mesh *m)
+{
+  int i;
+  for (i = 0; i < m->nparts; i++)
+    glDrawArrays (m->parts[i].mode, m->parts[i].first, m->parts[i].count);
+  return m->polys;
+}
+
+
+/* Sets up the modelview matrix to map the unit tube onto the line
+   between the two points.  Returns 0 if they are the same point.
+ */
+static int
+tube_transform (GLfloat x1, GLfloat y1, GLfloat z1,
+                GLfloat x2, GLfloat y2, GLfloat z2,
+                GLfloat diameter, GLfloat cap_size)
 {
   GLfloat length, X, Y, Z;
-  int polys = 0;
 
   if (diameter <= 0) abort();
 
@@ -354,8 +413,6 @@ tube_1 (GLfloat x1, GLfloat y1, GLfloat z1,
 
   length = sqrt (X*X + Y*Y + Z*Z);
 
-  glPushMatrix();
-
   glTranslatef(x1, y1, z1);
   glRotatef (-atan2 (X, Y)               * (180 / M_PI), 0, 0, 1);
   glRotatef ( atan2 (Z, sqrt(X*X + Y*Y)) * (180 / M_PI), 1, 0, 0);
@@ -369,11 +426,26 @@ tube_1 (GLfloat x1, GLfloat y1, GLfloat z1,
       glScalef (1, 1+c+c, 1);
     }
 
-  if (cone_p)
-    polys = unit_cone (faces, smooth, caps_p, wire_p);
-  else
-    polys = unit_tube (faces, smooth, caps_p, wire_p);
+  return 1;
+}
+
+
+static int
+tube_1 (GLfloat x1, GLfloat y1, GLfloat z1,
+        GLfloat x2, GLfloat y2, GLfloat z2,
+        GLfloat diameter, GLfloat cap_size,
+        int faces, int smooth, int caps_p, int wire_p,
+        int cone_p)
+{
+  tube_mesh *m = find_tube_mesh (faces, smooth, caps_p, wire_p, cone_p);
+  int polys = 0;
 
+  glPushMatrix();
+  if (tube_transform (x1, y1, z1, x2, y2, z2, diameter, cap_size))
+    {
+      tube_mesh_arrays (m);
+      polys = draw_tube_mesh (m);
+    }
   glPopMatrix();
   return polys;
 }
@@ -496,7 +496,6 @@ draw_voronoi (ModeInfo *mi)
   state_change (mi);
 
   if (mi->fps_p) do_fps (mi);
-  glFinish();
 
   glXSwapBuffers(dpy, window);
 }
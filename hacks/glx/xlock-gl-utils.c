@@ -18,6 +18,8 @@
 #include "xlockmoreI.h"
 #include "texfont.h"
 
+#include <sys/time.h>
+
 #ifndef isupper
 # define isupper(c)  ((c) >= 'A' && (c) <= 'Z')
 #endif
@@ -32,6 +34,51 @@
 static XErrorHandler orig_ehandler = 0;
 static Bool got_error = 0;
 
+/* With -render-scale (or $XSCREENSAVER_RENDER_SCALE, which the driver
+   sets from its renderScale preference) below 1, the hack is told that
+   its window is that much smaller than it really is, so it sets its
+   viewport to, and draws in, the lower left corner of the back buffer.
+   Just before the buffers are swapped, xlockmore_gl_swap_buffers()
+   stretches that corner over the whole window with glCopyPixels, and
+   xlockmore_gl_scale_event() shrinks the pointer positions to match.
+ */
+static Window scaled_window = 0;
+static GLfloat render_scale = 1;
+static int full_width, full_height, scaled_width, scaled_height;
+
+/* Hacks used to call glFinish() before every glXSwapBuffers(), so that
+   the CPU would not get ahead of the GPU.  But that stalls the pipeline
+   every frame: the CPU sits idle while the GPU draws, and the GPU sits
+   idle while the CPU computes the next frame.  Instead, with GL_ARB_sync,
+   xlockmore_gl_swap_buffers() leaves a fence behind each swap, and waits
+   for the previous frame's fence before the next one.  So the hack works
+   on frame N+1 while the GPU draws frame N, but never gets further ahead
+   than that.  The time spent waiting is shown in the FPS display.
+ */
+#if defined(GL_SYNC_GPU_COMMANDS_COMPLETE) && defined(GLX_ARB_get_proc_address)
+# define USE_GL_FENCES
+#endif
+
+typedef struct gl_present_state gl_present_state;
+struct gl_present_state {
+  Window window;
+  Bool double_buffered_p;
+  double wait;			/* seconds waited for the GPU, since asked */
+# ifdef USE_GL_FENCES
+  GLsync fence;			/* the previous frame's */
+# endif
+  gl_present_state *next;
+};
+
+static gl_present_state *present_states = 0;
+
+#ifdef USE_GL_FENCES
+static PFNGLFENCESYNCPROC      fence_sync_fn = 0;
+static PFNGLCLIENTWAITSYNCPROC client_wait_sync_fn = 0;
+static PFNGLDELETESYNCPROC     delete_sync_fn = 0;
+#endif
+
+
 static int
 BadValue_ehandler (Display *dpy, XErrorEvent *error)
 {
@@ -45,6 +92,130 @@ BadValue_ehandler (Display *dpy, XErrorEvent *error)
 }
 
 
+/* Whether the space-separated list of extension names contains this one.
+ */
+static Bool
+has_extension_p (const char *list, const char *name)
+{
+  int L = strlen (name);
+  const char *s = list;
+  while (s && (s = strstr (s, name)))
+    {
+      if ((s == list || s[-1] == ' ') && (s[L] == 0 || s[L] == ' '))
+        return True;
+      s += L;
+    }
+  return False;
+}
+
+
+static double
+double_time (void)
+{
+  struct timeval now;
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  struct timezone tzp;
+  gettimeofday(&now, &tzp);
+# else
+  gettimeofday(&now);
+# endif
+
+  return (now.tv_sec + ((double) now.tv_usec * 0.000001));
+}
+
+
+static gl_present_state *
+find_present_state (Window window)
+{
+  gl_present_state *p;
+  for (p = present_states; p; p = p->next)
+    if (p->window == window)
+      return p;
+  return 0;
+}
+
+
+/* With -swap-interval N, swap at most once every N vertical retraces;
+   0 means don't wait for the retrace at all.  The default, -1, leaves it
+   up to the driver.
+ */
+static void
+set_swap_interval (Display *dpy, Window window, int screen, int interval)
+{
+# ifdef GLX_ARB_get_proc_address
+  typedef void (*ext_fn) (Display *, GLXDrawable, int);
+  typedef int (*mesa_sgi_fn) (unsigned int);
+  const char *exts = glXQueryExtensionsString (dpy, screen);
+  if (!exts) return;
+
+  if (has_extension_p (exts, "GLX_EXT_swap_control"))
+    {
+      ext_fn fn = (ext_fn) glXGetProcAddressARB ((const GLubyte *)
+                                                 "glXSwapIntervalEXT");
+      if (fn) fn (dpy, window, interval);
+    }
+  else if (has_extension_p (exts, "GLX_MESA_swap_control"))
+    {
+      mesa_sgi_fn fn = (mesa_sgi_fn)
+        glXGetProcAddressARB ((const GLubyte *) "glXSwapIntervalMESA");
+      if (fn) fn (interval);
+    }
+  else if (interval > 0 && has_extension_p (exts, "GLX_SGI_swap_control"))
+    {
+      /* SGI's can't turn off syncing to the retrace. */
+      mesa_sgi_fn fn = (mesa_sgi_fn)
+        glXGetProcAddressARB ((const GLubyte *) "glXSwapIntervalSGI");
+      if (fn) fn (interval);
+    }
+# endif /* GLX_ARB_get_proc_address */
+}
+
+
+/* Called by init_GL once the context is current.
+ */
+static void
+init_present (ModeInfo *mi)
+{
+  gl_present_state *p = find_present_state (mi->window);
+  GLboolean d = False;
+  int interval;
+
+  if (!p)
+    {
+      p = (gl_present_state *) calloc (1, sizeof(*p));
+      if (!p) return;
+      p->window = mi->window;
+      p->next = present_states;
+      present_states = p;
+    }
+
+  glGetBooleanv (GL_DOUBLEBUFFER, &d);
+  p->double_buffered_p = d;
+
+  interval = get_integer_resource (mi->dpy, "swapInterval", "SwapInterval");
+  if (interval >= 0)
+    set_swap_interval (mi->dpy, mi->window, screen_number (mi->xgwa.screen),
+                       interval);
+
+# ifdef USE_GL_FENCES
+  if (!fence_sync_fn)
+    {
+      const char *exts = (const char *) glGetString (GL_EXTENSIONS);
+      if (exts && has_extension_p (exts, "GL_ARB_sync"))
+        {
+          client_wait_sync_fn = (PFNGLCLIENTWAITSYNCPROC)
+            glXGetProcAddressARB ((const GLubyte *) "glClientWaitSync");
+          delete_sync_fn = (PFNGLDELETESYNCPROC)
+            glXGetProcAddressARB ((const GLubyte *) "glDeleteSync");
+          if (client_wait_sync_fn && delete_sync_fn)
+            fence_sync_fn = (PFNGLFENCESYNCPROC)
+              glXGetProcAddressARB ((const GLubyte *) "glFenceSync");
+        }
+    }
+# endif /* USE_GL_FENCES */
+}
+
+
 GLXContext *
 init_GL(ModeInfo * mi)
 {
@@ -121,6 +292,25 @@ init_GL(ModeInfo * mi)
   /* Sometimes glDrawBuffer() throws "invalid op". Dunno why. Ignore. */
   clear_gl_error ();
 
+  /* The picture is stretched in the back buffer, so only double-buffered
+     contexts can draw smaller than their window. */
+  {
+    GLboolean d = False;
+    double scale = get_float_resource (dpy, "renderScale", "RenderScale");
+    const char *s = getenv ("XSCREENSAVER_RENDER_SCALE");
+    if (scale <= 0 && s)
+      scale = atof (s);
+    glGetBooleanv (GL_DOUBLEBUFFER, &d);
+    if (d && scale > 0 && scale < 1)
+      {
+        render_scale = (scale < 0.1 ? 0.1 : scale);
+        scaled_window = window;
+        xlockmore_gl_scale_window (mi);
+      }
+  }
+
+  init_present (mi);
+
   /* Process the -background argument. */
   {
     char *s = get_string_resource(mi->dpy, "background", "Background");
@@ -146,6 +336,159 @@ init_GL(ModeInfo * mi)
 
 
 
+/* Called whenever mi->xgwa has been re-read from the window: shrinks
+   it to the size that the hack should draw at.
+ */
+void
+xlockmore_gl_scale_window (ModeInfo *mi)
+{
+  if (mi->window != scaled_window)
+    return;
+  full_width    = mi->xgwa.width;
+  full_height   = mi->xgwa.height;
+  scaled_width  = full_width  * render_scale + 0.5;
+  scaled_height = full_height * render_scale + 0.5;
+  if (scaled_width  < 1) scaled_width  = 1;
+  if (scaled_height < 1) scaled_height = 1;
+  mi->xgwa.width  = scaled_width;
+  mi->xgwa.height = scaled_height;
+}
+
+
+/* Called on each event before the hack sees it: the pointer is over the
+   stretched picture, so say where it is in the one that the hack drew,
+   for the trackball and anything else that goes by the mouse.
+ */
+void
+xlockmore_gl_scale_event (ModeInfo *mi, XEvent *event)
+{
+  double sx, sy;
+  if (mi->window != scaled_window ||
+      (scaled_width == full_width && scaled_height == full_height))
+    return;
+  sx = (double) scaled_width  / full_width;
+  sy = (double) scaled_height / full_height;
+  switch (event->xany.type)
+    {
+    case ButtonPress:
+    case ButtonRelease:
+      event->xbutton.x *= sx;
+      event->xbutton.y *= sy;
+      break;
+    case MotionNotify:
+      event->xmotion.x *= sx;
+      event->xmotion.y *= sy;
+      break;
+    case EnterNotify:
+    case LeaveNotify:
+      event->xcrossing.x *= sx;
+      event->xcrossing.y *= sy;
+      break;
+    case KeyPress:
+    case KeyRelease:
+      event->xkey.x *= sx;
+      event->xkey.y *= sy;
+      break;
+    default:
+      break;
+    }
+}
+
+
+/* Called instead of glXSwapBuffers (see xlockmoreI.h.)
+ */
+void
+xlockmore_gl_swap_buffers (Display *dpy, Window window)
+{
+  if (window == scaled_window &&
+      (scaled_width != full_width || scaled_height != full_height))
+    {
+      glPushAttrib (GL_ENABLE_BIT | GL_VIEWPORT_BIT | GL_PIXEL_MODE_BIT |
+                    GL_TRANSFORM_BIT | GL_CURRENT_BIT);
+
+      /* CopyPixels fragments get textured, fogged, blended, etc. */
+      glDisable (GL_TEXTURE_1D);
+      glDisable (GL_TEXTURE_2D);
+      glDisable (GL_LIGHTING);
+      glDisable (GL_FOG);
+      glDisable (GL_BLEND);
+      glDisable (GL_ALPHA_TEST);
+      glDisable (GL_DEPTH_TEST);
+      glDisable (GL_STENCIL_TEST);
+      glDisable (GL_SCISSOR_TEST);
+
+      glViewport (0, 0, full_width, full_height);
+      glMatrixMode (GL_PROJECTION);
+      glPushMatrix ();
+      glLoadIdentity ();
+      glOrtho (0, full_width, 0, full_height, -1, 1);
+      glMatrixMode (GL_MODELVIEW);
+      glPushMatrix ();
+      glLoadIdentity ();
+
+      /* The source and destination overlap, but CopyPixels behaves as
+         if the whole source were read before anything is written. */
+      glRasterPos2i (0, 0);
+      glPixelZoom ((GLfloat) full_width  / scaled_width,
+                   (GLfloat) full_height / scaled_height);
+      glReadBuffer (GL_BACK);
+      glCopyPixels (0, 0, scaled_width, scaled_height, GL_COLOR);
+
+      glPopMatrix ();
+      glMatrixMode (GL_PROJECTION);
+      glPopMatrix ();
+      glPopAttrib ();
+    }
+
+  {
+    gl_present_state *p = find_present_state (window);
+
+    if (p && !p->double_buffered_p)
+      glFlush ();	/* glXSwapBuffers does nothing, not even flush */
+
+# ifdef USE_GL_FENCES
+    /* Don't start drawing a third frame while the GPU is still working
+       on the one before this one. */
+    if (p && p->fence)
+      {
+        double start = double_time();
+        client_wait_sync_fn (p->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                             1000000000);	/* 1 second, in ns */
+        p->wait += double_time() - start;
+        delete_sync_fn (p->fence);
+        p->fence = 0;
+      }
+# endif /* USE_GL_FENCES */
+
+    (glXSwapBuffers) (dpy, window);
+
+# ifdef USE_GL_FENCES
+    if (p && fence_sync_fn)
+      p->fence = fence_sync_fn (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+# endif /* USE_GL_FENCES */
+  }
+}
+
+
+/* Returns how many seconds xlockmore_gl_swap_buffers() has spent waiting
+   for the GPU to catch up since the last call, or -1 if it doesn't wait.
+ */
+double
+xlockmore_gl_gpu_wait (Window window)
+{
+# ifdef USE_GL_FENCES
+  gl_present_state *p = find_present_state (window);
+  if (p && fence_sync_fn)
+    {
+      double wait = p->wait;
+      p->wait = 0;
+      return wait;
+    }
+# endif /* USE_GL_FENCES */
+  return -1;
+}
+
+
 /* clear away any lingering error codes */
 void
 clear_gl_error (void)
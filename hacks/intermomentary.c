@@ -33,6 +33,7 @@
 #include <math.h>
 #include "screenhack.h"
 #include "hsv.h"
+#include "drawbatch.h"
 
 /* this program goes faster if some functions are inline.  The following is
  * borrowed from ifs.c */
@@ -95,6 +96,7 @@ struct state {
 
   struct field *f;
   GC fgc, copygc;
+  draw_batch *batch;
   XWindowAttributes xgwa;
   int draw_delay;
 
@@ -229,9 +231,7 @@ draw_glowpoint(struct state *st, Drawable drawable,
             a = 0.8 - i * i * 0.1 - j * j * 0.1;
 
             c = trans_point(st, px+i, py+j, 255, a, f);
-            XSetForeground(st->dpy, fgc, get_pixel (st, c));
-            XDrawPoint(st->dpy, drawable, fgc, px + i, py + j);
-            XSetForeground(st->dpy, fgc, f->fgcolor);
+            draw_batch_point(st->batch, get_pixel (st, c), px + i, py + j);
         }
     }
 }
@@ -278,9 +278,7 @@ moverender_rider(struct state *st, Drawable drawable,
 
         trans_point(st, px, py, c, 0.5, f);
 
-        XSetForeground(st->dpy, fgc, get_pixel(st, c));
-        XDrawPoint(st->dpy, drawable, fgc, px, py);
-        XSetForeground(st->dpy, fgc, f->fgcolor);
+        draw_batch_point(st->batch, get_pixel (st, c), px, py);
     }
 }
 
@@ -324,14 +322,11 @@ render_disc(struct state *st, Drawable drawable, GC fgc, struct field *f, int dn
                 /* p3a and p3b might be identical, ignore this case for now */
                 /* XPutPixel(f->off_map, p3ax, p3ay, f->fgcolor); */
                 c = trans_point(st, p3ax, p3ay, 255, 0.75, f);
-                XSetForeground(st->dpy, fgc, get_pixel (st, c));
-                XDrawPoint(st->dpy, drawable, fgc, p3ax, p3ay);
+                draw_batch_point(st->batch, get_pixel (st, c), p3ax, p3ay);
 
                 /* XPutPixel(f->off_map, p3bx, p3by, f->fgcolor); */
                 c = trans_point(st, p3bx, p3by, 255, 0.75, f);
-                XSetForeground(st->dpy, fgc, get_pixel (st, c));
-                XDrawPoint(st->dpy, drawable, fgc, p3bx, p3by);
-                XSetForeground(st->dpy, fgc, f->fgcolor);
+                draw_batch_point(st->batch, get_pixel (st, c), p3bx, p3by);
             }
         }
 
@@ -455,6 +450,7 @@ intermomentary_init (Display *dpy, Window window)
     
     st->fgc = XCreateGC(dpy, window, GCForeground, &gcv);
     st->copygc = XCreateGC(dpy, window, GCForeground, &gcv);
+    st->batch = draw_batch_init(dpy, window, st->fgc);
 
     st->f->fgcolor = gcv.foreground;
     st->f->bgcolor = gcv.background;
@@ -503,12 +499,17 @@ intermomentary_draw (Display *dpy, Window window, void *closure)
     }
   }
 
+  draw_batch_set_drawable(st->batch, st->f->off_map);
   blank_img(dpy, st->f->off_map, st->xgwa, st->fgc, st->f);
   for (tempx = 0; tempx < st->f->num; tempx++) {
     move_disc(st->f, tempx);
     render_disc(st, st->f->off_map, st->fgc, st->f, tempx);
   }
 
+  /* All the glow points go out with one XDrawPoints per color. */
+  draw_batch_flush(st->batch);
+  XSetForeground(dpy, st->fgc, st->f->fgcolor);
+
 #if 0
   XSetFillStyle(dpy, st->copygc, FillTiled);
   XSetTile(dpy, st->copygc, st->f->off_map);
@@ -542,6 +543,7 @@ static void
 intermomentary_free (Display *dpy, Window window, void *closure)
 {
   struct state *st = (struct state *) closure;
+  draw_batch_free (st->batch);
   free (st);
 }
 
@@ -146,6 +146,8 @@ static XrmOptionDescRec default_options [] = {
   { "-noinstall",".installColormap",	XrmoptionNoArg, "False" },
   { "-visual",	".visualID",		XrmoptionSepArg, 0 },
   { "-window-id", ".windowID",		XrmoptionSepArg, 0 },
+  { "-render-scale", ".renderScale",	XrmoptionSepArg, 0 },
+  { "-swap-interval", ".swapInterval",	XrmoptionSepArg, 0 },
   { "-fps",	".doFPS",		XrmoptionNoArg, "True" },
   { "-no-fps",  ".doFPS",		XrmoptionNoArg, "False" },
 
@@ -169,6 +171,8 @@ static char *default_defaults[] = {
   "*multiSample:	false",
   "*visualID:		default",
   "*windowID:		",
+  "*renderScale:	0",
+  "*swapInterval:	-1",
   "*desktopGrabber:	xscreensaver-getimage %s",
   0
 };
@@ -524,6 +528,67 @@ usleep_and_process_events (Display *dpy,
 }
 
 
+/* When we are running under xscreensaver, tell the driver every few
+   seconds how many frames per second we are managing, by setting a
+   property on our window.  Along with our CPU time, that is how the
+   driver tells whether this hack is too heavy for this machine.
+ */
+#define FRAME_REPORT_SECS 5
+
+static void
+report_frame_rate (Display *dpy, Window window)
+{
+  static int state = 0;		/* 1 if reporting, -1 if not, 0 if unknown */
+  static Atom XA_FPS;
+  static int frames;
+  static struct timeval start;
+  struct timeval now;
+  double secs;
+
+  if (state < 0) return;
+
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  {
+    struct timezone tzp;
+    gettimeofday (&now, &tzp);
+  }
+# else
+  gettimeofday (&now);
+# endif
+
+  if (state == 0)
+    {
+      const char *s = getenv ("XSCREENSAVER_WINDOW");
+      unsigned long id = 0;
+      char c;
+      if (s && *s &&
+          (1 == sscanf (s, " 0x%lx %c", &id, &c) ||
+           1 == sscanf (s, " %lu %c",   &id, &c)) &&
+          id == window)
+        {
+          state = 1;
+          XA_FPS = XInternAtom (dpy, "_XSCREENSAVER_FPS", False);
+          start = now;
+        }
+      else
+        state = -1;
+      return;
+    }
+
+  frames++;
+  secs = ((now.tv_sec - start.tv_sec) +
+          (now.tv_usec - start.tv_usec) / 1000000.0);
+  if (secs >= FRAME_REPORT_SECS)
+    {
+      long fps100 = (long) (frames * 100 / secs);
+      XChangeProperty (dpy, window, XA_FPS, XA_CARDINAL, 32,
+                       PropModeReplace, (unsigned char *) &fps100, 1);
+      frames = 0;
+      start = now;
+    }
+}
+
+
 static void
 screenhack_do_fps (Display *dpy, Window w, fps_state *fpst, void *closure)
 {
@@ -580,6 +645,7 @@ run_screenhack_table (Display *dpy,
 #ifdef DEBUG_PAIR
       if (fpst2) fps_cb (dpy, window, fpst2, closure);
 #endif
+      report_frame_rate (dpy, window);
 
       if (! usleep_and_process_events (dpy, ft,
                                        window, fpst, closure, delay
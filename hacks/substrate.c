@@ -32,6 +32,10 @@
 #include <math.h>
 #include "screenhack.h"
 
+#ifdef HAVE_XSHM_EXTENSION
+# include "xshm.h"
+#endif /* HAVE_XSHM_EXTENSION */
+
 /* this program goes faster if some functions are inline.  The following is
  * borrowed from ifs.c */
 #if !defined( __GNUC__ ) && !defined(__cplusplus) && !defined(c_plusplus)
@@ -41,6 +45,10 @@
 
 #define STEP 0.42
 
+/* The offscreen image is sent to the window in squares of this size, once
+   per frame, and only the squares that were drawn on. */
+#define DAMAGE_TILE 16
+
 /* Raw colormap extracted from pollockEFF.gif */
 static const char *rgb_colormap[] = {
     "#201F21", "#262C2E", "#352626", "#372B27",
@@ -84,7 +92,7 @@ typedef struct {
 
     int curved;
 
-    unsigned long sandcolor;
+    unsigned int sandcolor;
     float sandp, sandg;
 
     float degrees_drawn;
@@ -109,15 +117,38 @@ struct field {
     crack *cracks; /* grid of cracks */
     int *cgrid; /* grid of actual crack placement */
 
-    /* Raw map of pixels we need to keep for alpha blending */
-    unsigned long int *off_img;
-   
-    /* color parms */
+    /* Raw map of pixels we need to keep for alpha blending, as 0xRRGGBB */
+    unsigned int *off_img;
+
+    /* What off_img is copied into to be sent to the server.  When the
+       visual is 8-8-8 TrueColor at 32 bits per pixel, off_img points
+       straight at its data and there is nothing to copy. */
+    XImage *image;
+    Bool image_is_off_img;
+#ifdef HAVE_XSHM_EXTENSION
+    Bool shm_p;
+    XShmSegmentInfo shm_info;
+#endif /* HAVE_XSHM_EXTENSION */
+
+    /* One flag per DAMAGE_TILE square of off_img that needs sending */
+    unsigned char *damage;
+    int damage_w, damage_h;
+
+    /* 16.16 fixed point opacity of each grain of sand */
+    unsigned int *grain_alpha;
+
+    /* color parms, all as 0xRRGGBB */
     int numcolors;
-    unsigned long *parsedcolors;
-    unsigned long fgcolor;
-    unsigned long bgcolor;
+    unsigned int *parsedcolors;
+    unsigned long *parsedpixels;
+    unsigned int fgcolor;
+    unsigned int bgcolor;
+    unsigned long fgpixel, bgpixel;
+
+    Visual *visual;
     int visdepth;
+    Bool truecolor_p;
+    unsigned int rpos, rsiz, gpos, gsiz, bpos, bsiz;
 
     unsigned int cycles;
 
@@ -161,14 +192,28 @@ static struct field
     f->cracks = NULL;
     f->cgrid = NULL;
     f->off_img = NULL;
+    f->image = NULL;
+    f->image_is_off_img = False;
+#ifdef HAVE_XSHM_EXTENSION
+    f->shm_p = False;
+#endif /* HAVE_XSHM_EXTENSION */
+    f->damage = NULL;
+    f->damage_w = 0;
+    f->damage_h = 0;
+    f->grain_alpha = NULL;
     f->numcolors = 0;
     f->parsedcolors = NULL;
+    f->parsedpixels = NULL;
     f->cycles = 0;
     f->wireframe = 0;
     f->seamless = 0;
     f->fgcolor = 0;
     f->bgcolor = 0;
+    f->fgpixel = 0;
+    f->bgpixel = 0;
+    f->visual = NULL;
     f->visdepth = 0;
+    f->truecolor_p = False;
     f->grains = 0;
     f->circle_percent = 0;
     return f;
@@ -282,104 +327,37 @@ static inline void make_crack(struct field *f)
     }
 }
 
-static inline void point2rgb(int depth, unsigned long c, int *r, int *g, int *b) 
-{
-    switch(depth) {
-        case 32:
-        case 24:
-#ifdef HAVE_COCOA
-            /* This program idiotically does not go through a color map, so
-               we have to hardcode in knowledge of how jwxyz.a packs pixels!
-               Fix it to go through st->colors[st->ncolors] instead!
-             */
-            *r = (c & 0x00ff0000) >> 16; 
-            *g = (c & 0x0000ffff) >>  8;
-            *b = (c & 0x000000ff); 
-#else
-            *g = (c & 0xff00) >> 8; 
-            *r = (c & 0xff0000) >> 16; 
-            *b = c & 0xff; 
-#endif
-            break;
-        case 16:
-            *g = ((c >> 5) & 0x3f) << 2;
-            *r = ((c >> 11) & 0x1f) << 3; 
-            *b = (c & 0x1f) << 3; 
-            break;
-        case 15:
-            *g = ((c >> 5) & 0x1f) << 3;
-            *r = ((c >> 10) & 0x1f) << 3;
-            *b = (c & 0x1f) << 3;
-            break;
-    }
-}
-
-static inline unsigned long rgb2point(int depth, int r, int g, int b) 
-{
-    unsigned long ret = 0;
+#define mark_damage(f, x, y) \
+    ((f)->damage[((y) / DAMAGE_TILE) * (f)->damage_w + (x) / DAMAGE_TILE] = 1)
 
-    switch(depth) {
-        case 32:
-        case 24:
-#ifdef HAVE_COCOA
-            /* This program idiotically does not go through a color map, so
-               we have to hardcode in knowledge of how jwxyz.a packs pixels!
-               Fix it to go through st->colors[st->ncolors] instead!
-             */
-            ret = 0xFF000000 | (r << 16) | (g << 8) | b;
-#else
-            ret |= (r << 16) | (g << 8) | b;
-#endif
-            break;
-        case 16:
-            ret = ((r>>3) << 11) | ((g>>2)<<5) | (b>>3);
-            break;
-        case 15:
-            ret = ((r>>3) << 10) | ((g>>3)<<5) | (b>>3);
-            break;
-    }
-
-    return ret;
-}
-
-/* alpha blended point drawing -- this is Not Right and will likely fail on 
- * non-intel platforms as it is now, needs fixing */
-static inline unsigned long
-trans_point(struct state *st,
-            int x1, int y1, unsigned long myc, float a, 
+/* alpha blended point drawing.  'a' is the opacity in 16.16 fixed point;
+ * this is floor(old + (new - old) * a) per channel, the same thing the
+ * floating point version computed. */
+static inline void
+trans_point(int x1, int y1, unsigned int myc, unsigned int a,
             struct field *f) 
 {
     if ((x1 >= 0) && (x1 < f->width) && (y1 >= 0) && (y1 < f->height)) {
-        if (a >= 1.0) {
-            ref_pixel(f, x1, y1) = myc;
+        unsigned int *p = &ref_pixel(f, x1, y1);
+        if (a >= 0x10000) {
+            *p = myc;
         } else {
-            int or = 0, og = 0, ob = 0;
-            int r = 0, g = 0, b = 0;
-            int nr, ng, nb;
-            unsigned long c;
-
-            c = ref_pixel(f, x1, y1);
-
-            point2rgb(f->visdepth, c, &or, &og, &ob);
-            point2rgb(f->visdepth, myc, &r, &g, &b);
-
-            nr = or + (r - or) * a;
-            ng = og + (g - og) * a;
-            nb = ob + (b - ob) * a;
-
-            c = rgb2point(f->visdepth, nr, ng, nb);
-
-            ref_pixel(f, x1, y1) = c;
-
-            return c;
+            unsigned int c = *p;
+            unsigned int na = 0x10000 - a;
+            unsigned int nr = (((c >> 16) & 0xff) * na +
+                               ((myc >> 16) & 0xff) * a) >> 16;
+            unsigned int ng = (((c >> 8) & 0xff) * na +
+                               ((myc >> 8) & 0xff) * a) >> 16;
+            unsigned int nb = ((c & 0xff) * na + (myc & 0xff) * a) >> 16;
+
+            *p = (nr << 16) | (ng << 8) | nb;
         }
+        mark_damage(f, x1, y1);
     }
-
-    return f->bgcolor;
 }
 
 static inline void 
-region_color(struct state *st, GC fgc, struct field *f, crack *cr) 
+region_color(struct field *f, crack *cr) 
 {
     /* synthesis of Crack::regionColor() and SandPainter::render() */
 
@@ -391,7 +369,6 @@ region_color(struct state *st, GC fgc, struct field *f, crack *cr)
     int grains, i;
     float w;
     float drawx, drawy;
-    unsigned long c;
 
     while (openspace) {
         /* move perpendicular to crack */
@@ -443,11 +420,7 @@ region_color(struct state *st, GC fgc, struct field *f, crack *cr)
         }
 
         /* Draw sand bit */
-        c = trans_point(st, drawx, drawy, cr->sandcolor, (0.1 - i / (grains * 10.0)), f);
-
-        XSetForeground(st->dpy, fgc, c);
-        XDrawPoint(st->dpy, st->window, fgc, (int) drawx, (int) drawy);
-        XSetForeground(st->dpy, fgc, f->fgcolor);
+        trans_point(drawx, drawy, cr->sandcolor, f->grain_alpha[i], f);
     }
 }
 
@@ -490,7 +463,7 @@ static void build_substrate(struct field *f)
 
 
 static inline void
-movedrawcrack(struct state *st, GC fgc, struct field *f, int cracknum) 
+movedrawcrack(struct field *f, int cracknum) 
 {
     /* Basically Crack::move() */
 
@@ -529,11 +502,11 @@ movedrawcrack(struct state *st, GC fgc, struct field *f, int cracknum)
     if ((cx >= 0) && (cx < f->width) && (cy >= 0) && (cy < f->height)) {
         /* draw sand painter if we're not wireframe */
         if (!f->wireframe)
-            region_color(st, fgc, f, cr);
+            region_color(f, cr);
 
         /* draw fgcolor crack */
         ref_pixel(f, cx, cy) = f->fgcolor;
-        XDrawPoint(st->dpy, st->window, fgc, cx, cy);
+        mark_damage(f, cx, cy);
 
         if ( cr->curved && (cr->degrees_drawn > 360) ) {
             /* completed the circle, stop cracking */
@@ -565,18 +538,199 @@ movedrawcrack(struct state *st, GC fgc, struct field *f, int cracknum)
 }
 
 
+/* Given a bitmask, returns the position and width of the field.
+ */
+static void
+decode_mask (unsigned int mask, unsigned int *pos_ret, unsigned int *size_ret)
+{
+  int i;
+  for (i = 0; i < 32; i++)
+    if (mask & (1L << i))
+      {
+        int j = 0;
+        *pos_ret = i;
+        for (; i < 32; i++, j++)
+          if (! (mask & (1L << i)))
+            break;
+        *size_ret = j;
+        return;
+      }
+}
+
+static unsigned long
+rgb_to_pixel(struct field *f, unsigned int rgb)
+{
+    unsigned int r = (rgb >> 16) & 0xff;
+    unsigned int g = (rgb >> 8) & 0xff;
+    unsigned int b = rgb & 0xff;
+
+    if (f->truecolor_p) {
+#ifdef HAVE_COCOA
+        /* jwxyz packs pixels as ARGB. */
+        return 0xFF000000 | rgb;
+#else
+        return (((r >> (8 - f->rsiz)) << f->rpos) |
+                ((g >> (8 - f->gsiz)) << f->gpos) |
+                ((b >> (8 - f->bsiz)) << f->bpos));
+#endif
+    } else {
+        /* No blending on a colormapped visual: use the nearest of the
+           colors we allocated. */
+        unsigned long best = f->bgpixel;
+        long best_d = -1;
+        int i;
+        for (i = -2; i < f->numcolors; i++) {
+            unsigned int c = (i == -2 ? f->bgcolor :
+                              i == -1 ? f->fgcolor : f->parsedcolors[i]);
+            int dr = (int) ((c >> 16) & 0xff) - (int) r;
+            int dg = (int) ((c >> 8) & 0xff) - (int) g;
+            int db = (int) (c & 0xff) - (int) b;
+            long d = dr * dr + dg * dg + db * db;
+            if (best_d < 0 || d < best_d) {
+                best_d = d;
+                best = (i == -2 ? f->bgpixel :
+                        i == -1 ? f->fgpixel : f->parsedpixels[i]);
+            }
+        }
+        return best;
+    }
+}
+
+static void free_img(Display *dpy, struct field *f)
+{
+    if (f->image) {
+#ifdef HAVE_XSHM_EXTENSION
+        if (f->shm_p)
+            destroy_xshm_image(dpy, f->image, &f->shm_info);
+        else
+#endif /* HAVE_XSHM_EXTENSION */
+            XDestroyImage(f->image);
+        f->image = NULL;
+    }
+
+    if (f->off_img && !f->image_is_off_img)
+        free(f->off_img);
+    f->off_img = NULL;
+    f->image_is_off_img = False;
+
+    if (f->damage) {
+        free(f->damage);
+        f->damage = NULL;
+    }
+}
+
 static void build_img(Display *dpy, Window window, XWindowAttributes xgwa, GC fgc, 
                struct field *f) 
 {
-    if (f->off_img) {
-        free(f->off_img);
-        f->off_img = NULL;
+    unsigned int i, n;
+
+    free_img(dpy, f);
+
+    f->visual = xgwa.visual;
+    f->visdepth = xgwa.depth;
+    f->truecolor_p = (visual_class(xgwa.screen, xgwa.visual) == TrueColor);
+    if (f->truecolor_p) {
+        decode_mask(xgwa.visual->red_mask,   &f->rpos, &f->rsiz);
+        decode_mask(xgwa.visual->green_mask, &f->gpos, &f->gsiz);
+        decode_mask(xgwa.visual->blue_mask,  &f->bpos, &f->bsiz);
+        if (f->rsiz > 8 || f->gsiz > 8 || f->bsiz > 8)
+            f->truecolor_p = False;
+    }
+
+#ifdef HAVE_XSHM_EXTENSION
+    f->shm_p = get_boolean_resource(dpy, "useSHM", "Boolean");
+    if (f->shm_p) {
+        f->image = create_xshm_image(dpy, f->visual, f->visdepth, ZPixmap, 0,
+                                     &f->shm_info, f->width, f->height);
+        if (!f->image)
+            f->shm_p = False;
     }
+#endif /* HAVE_XSHM_EXTENSION */
 
-    f->off_img = (unsigned long *) xrealloc(f->off_img, sizeof(unsigned long) * 
-                                            f->width * f->height);
+    if (!f->image) {
+        f->image = XCreateImage(dpy, f->visual, f->visdepth, ZPixmap, 0, 0,
+                                f->width, f->height, 32, 0);
+        if (!f->image) {
+            fprintf(stderr, "%s: out of memory\n", progname);
+            exit(1);
+        }
+        f->image->data = xrealloc(NULL, f->image->bytes_per_line *
+                                  f->image->height);
+    }
 
-    memset(f->off_img, f->bgcolor, sizeof(unsigned long) * f->width * f->height);
+#ifndef HAVE_COCOA
+    {
+        union { unsigned int i; char c[4]; } order;
+        order.i = 1;
+        f->image_is_off_img =
+            (f->truecolor_p &&
+             f->image->bits_per_pixel == 32 &&
+             f->image->bytes_per_line == f->width * 4 &&
+             f->image->byte_order == (order.c[0] ? LSBFirst : MSBFirst) &&
+             f->rpos == 16 && f->gpos == 8 && f->bpos == 0 &&
+             f->rsiz == 8 && f->gsiz == 8 && f->bsiz == 8);
+    }
+#endif /* !HAVE_COCOA */
+
+    if (f->image_is_off_img)
+        f->off_img = (unsigned int *) f->image->data;
+    else
+        f->off_img = (unsigned int *) xrealloc(NULL, sizeof(unsigned int) *
+                                               f->width * f->height);
+
+    n = f->width * f->height;
+    for (i = 0; i < n; i++)
+        f->off_img[i] = f->bgcolor;
+
+    f->damage_w = (f->width + DAMAGE_TILE - 1) / DAMAGE_TILE;
+    f->damage_h = (f->height + DAMAGE_TILE - 1) / DAMAGE_TILE;
+    f->damage = (unsigned char *) xrealloc(NULL, f->damage_w * f->damage_h);
+    memset(f->damage, 0, f->damage_w * f->damage_h);
+}
+
+static void put_img(Display *dpy, Window window, GC gc, struct field *f,
+                    int x, int y, int w, int h)
+{
+    if (!f->image_is_off_img) {
+        int xx, yy;
+        for (yy = y; yy < y + h; yy++)
+            for (xx = x; xx < x + w; xx++)
+                XPutPixel(f->image, xx, yy,
+                          rgb_to_pixel(f, ref_pixel(f, xx, yy)));
+    }
+
+#ifdef HAVE_XSHM_EXTENSION
+    if (f->shm_p)
+        XShmPutImage(dpy, window, gc, f->image, x, y, x, y, w, h, False);
+    else
+#endif /* HAVE_XSHM_EXTENSION */
+        XPutImage(dpy, window, gc, f->image, x, y, x, y, w, h);
+}
+
+/* Send every damaged tile of the offscreen image to the window, merging
+   runs of adjacent tiles in a row into one request. */
+static void flush_img(Display *dpy, Window window, GC gc, struct field *f)
+{
+    int tx, ty;
+
+    for (ty = 0; ty < f->damage_h; ty++) {
+        unsigned char *row = f->damage + ty * f->damage_w;
+        for (tx = 0; tx < f->damage_w; tx++) {
+            int tx2, x, y, w, h;
+            if (!row[tx]) continue;
+            for (tx2 = tx; tx2 < f->damage_w && row[tx2]; tx2++)
+                row[tx2] = 0;
+
+            x = tx * DAMAGE_TILE;
+            y = ty * DAMAGE_TILE;
+            w = tx2 * DAMAGE_TILE - x;
+            h = DAMAGE_TILE;
+            if (x + w > f->width)  w = f->width - x;
+            if (y + h > f->height) h = f->height - y;
+            put_img(dpy, window, gc, f, x, y, w, h);
+            tx = tx2;
+        }
+    }
 }
 
 
@@ -585,6 +739,7 @@ substrate_init (Display *dpy, Window window)
 {
     struct state *st = (struct state *) calloc (1, sizeof(*st));
     XColor tmpcolor;
+    int i;
 
     st->dpy = dpy;
     st->window = window;
@@ -624,12 +779,14 @@ substrate_init (Display *dpy, Window window)
 
     st->f->height = st->xgwa.height;
     st->f->width = st->xgwa.width;
-    st->f->visdepth = st->xgwa.depth;
  
     /* Count the colors in our map and assign them in a horrifically inefficient 
      * manner but it only happens once */
     while (rgb_colormap[st->f->numcolors] != NULL) {
-        st->f->parsedcolors = (unsigned long *) xrealloc(st->f->parsedcolors, 
+        st->f->parsedcolors = (unsigned int *) xrealloc(st->f->parsedcolors, 
+                                                     sizeof(unsigned int) * 
+                                                     (st->f->numcolors + 1));
+        st->f->parsedpixels = (unsigned long *) xrealloc(st->f->parsedpixels, 
                                                      sizeof(unsigned long) * 
                                                      (st->f->numcolors + 1));
         if (!XParseColor(st->dpy, st->xgwa.colormap, rgb_colormap[st->f->numcolors], &tmpcolor)) {
@@ -644,7 +801,10 @@ substrate_init (Display *dpy, Window window)
             exit(1);
         }
 
-        st->f->parsedcolors[st->f->numcolors] = tmpcolor.pixel;
+        st->f->parsedpixels[st->f->numcolors] = tmpcolor.pixel;
+        st->f->parsedcolors[st->f->numcolors] = (((tmpcolor.red >> 8) << 16) |
+                                                 ((tmpcolor.green >> 8) << 8) |
+                                                 (tmpcolor.blue >> 8));
 
         st->f->numcolors++;
     }
@@ -655,8 +815,28 @@ substrate_init (Display *dpy, Window window)
                                         "background", "Background");
     st->fgc = XCreateGC(st->dpy, st->window, GCForeground, &st->gcv);
 
-    st->f->fgcolor = st->gcv.foreground;
-    st->f->bgcolor = st->gcv.background;
+    st->f->fgpixel = st->gcv.foreground;
+    st->f->bgpixel = st->gcv.background;
+
+    tmpcolor.pixel = st->gcv.foreground;
+    XQueryColor(st->dpy, st->xgwa.colormap, &tmpcolor);
+    st->f->fgcolor = (((tmpcolor.red >> 8) << 16) |
+                      ((tmpcolor.green >> 8) << 8) |
+                      (tmpcolor.blue >> 8));
+
+    tmpcolor.pixel = st->gcv.background;
+    XQueryColor(st->dpy, st->xgwa.colormap, &tmpcolor);
+    st->f->bgcolor = (((tmpcolor.red >> 8) << 16) |
+                      ((tmpcolor.green >> 8) << 8) |
+                      (tmpcolor.blue >> 8));
+
+    /* Opacity of each grain, highest nearest the crack */
+    st->f->grain_alpha = (unsigned int *)
+      xrealloc(NULL, sizeof(unsigned int) * (st->f->grains > 0 ? st->f->grains : 1));
+    for (i = 0; i < st->f->grains; i++) {
+        double a = 0.1 - i / (st->f->grains * 10.0);
+        st->f->grain_alpha[i] = (a <= 0 ? 0 : (unsigned int) (a * 0x10000 + 0.5));
+    }
 
     /* Initialize stuff */
     build_img(st->dpy, st->window, st->xgwa, st->fgc, st->f);
@@ -679,7 +859,6 @@ substrate_draw (Display *dpy, Window window, void *closure)
     if (st->f->height != st->xgwa.height || st->f->width != st->xgwa.width) {
       st->f->height = st->xgwa.height;
       st->f->width = st->xgwa.width;
-      st->f->visdepth = st->xgwa.depth;
 
       build_substrate(st->f);
       build_img(st->dpy, st->window, st->xgwa, st->fgc, st->f);
@@ -690,9 +869,11 @@ substrate_draw (Display *dpy, Window window, void *closure)
   }
 
   for (tempx = 0; tempx < st->f->num; tempx++) {
-    movedrawcrack(st, st->fgc, st->f, tempx);
+    movedrawcrack(st->f, tempx);
   }
 
+  flush_img(st->dpy, st->window, st->fgc, st->f);
+
   st->f->cycles++;
 
   if (st->f->cycles >= st->max_cycles && st->max_cycles != 0) {
@@ -730,6 +911,13 @@ static void
 substrate_free (Display *dpy, Window window, void *closure)
 {
   struct state *st = (struct state *) closure;
+  free_img (dpy, st->f);
+  free (st->f->grain_alpha);
+  free (st->f->parsedcolors);
+  free (st->f->parsedpixels);
+  free (st->f->cgrid);
+  free (st->f->cracks);
+  free (st->f);
   free (st);
 }
 
@@ -745,6 +933,9 @@ static const char *substrate_defaults[] = {
     "*maxCracks: 100",
     "*sandGrains: 64",
     "*circlePercent: 33",
+#ifdef HAVE_XSHM_EXTENSION
+    "*useSHM: True",
+#endif /* HAVE_XSHM_EXTENSION */
 #ifdef USE_IPHONE
   "*ignoreRotation: True",
 #endif
@@ -762,6 +953,10 @@ static XrmOptionDescRec substrate_options[] = {
     {"-max-cracks", ".maxCracks", XrmoptionSepArg, 0},
     {"-sand-grains", ".sandGrains", XrmoptionSepArg, 0},
     {"-circle-percent", ".circlePercent", XrmoptionSepArg, 0},
+#ifdef HAVE_XSHM_EXTENSION
+    {"-shm", ".useSHM", XrmoptionNoArg, "True"},
+    {"-no-shm", ".useSHM", XrmoptionNoArg, "False"},
+#endif /* HAVE_XSHM_EXTENSION */
     {0, 0, 0, 0}
 };
 
@@ -43,6 +43,7 @@ static const char sccsid[] = "@(#)swirl.c	4.00 97/01/01 xlockmore";
 # ifdef HAVE_XSHM_EXTENSION
 #  include "xshm.h"
 # endif /* HAVE_XSHM_EXTENSION */
+# include "palette.h"
 #else  /* !STANDALONE */
 # include "xlock.h"					/* from the xlockmore distribution */
 # undef HAVE_XSHM_EXTENSION
@@ -124,6 +125,9 @@ typedef struct swirl_data {
 	/* image stuff */
 	unsigned char *image;	/* image data */
 	XImage     *ximage;
+#ifdef STANDALONE
+	palette_image *pal;	/* colour indexes, when cells aren't writable */
+#endif /* STANDALONE */
 
 	/* colours stuff */
 	int         colours;	/* how many colours possible */
@@ -250,6 +254,21 @@ initialise_image(ModeInfo * mi, SWIRL_P swirl)
 	XDestroyImage(swirl->ximage);
 
   swirl->ximage = 0;
+
+#ifdef STANDALONE
+  if (swirl->pal)
+	palette_image_free(swirl->pal);
+  swirl->pal = 0;
+
+  /* Without writable colour cells, draw colour indexes instead, and
+	 cycle them through a palette on the client side. */
+  if (!mi->writable_p)
+	swirl->pal = palette_image_create(dpy, swirl->visual, swirl->rdepth,
+									  swirl->width, swirl->height,
+									  mi->use_shm);
+  if (swirl->pal)
+	return;
+#endif /* STANDALONE */
 #ifdef HAVE_XSHM_EXTENSION
   if (mi->use_shm)
 	{
@@ -1052,9 +1071,13 @@ do_point(SWIRL_P swirl, int i, int j)
 	value = value % swirl->colours;
 
 	/* lookup the pixel value if necessary */
-#ifndef STANDALONE
+#ifdef STANDALONE
+	if (swirl->pal)
+		value++;	/* palette index; 0 is the background */
+	else
+#else  /* !STANDALONE */
 	if (swirl->fixed_colourmap && swirl->dcolours > 2)
-#endif
+#endif /* !STANDALONE */
 		value = swirl->rgb_values[value].pixel;
 
 	/* return it */
@@ -1068,16 +1091,29 @@ do_point(SWIRL_P swirl, int i, int j)
  *
  * Draw a square block of points with the same value.
  *
- * -      ximage is the XImage to draw on.
+ * -      swirl is the swirl, holding the image to draw on.
  * -      x, y is the top left corner
  * -      s is the length of each side
  * -      v is the value
  */
 static void
-draw_block(XImage * ximage, int x, int y, int s, unsigned long v)
+draw_block(SWIRL_P swirl, int x, int y, int s, unsigned long v)
 {
+	XImage     *ximage = swirl->ximage;
 	int         a, b;
 
+#ifdef STANDALONE
+	if (swirl->pal) {
+		int         w;
+		unsigned char *data = palette_image_data(swirl->pal, &w, 0);
+
+		for (a = 0; a < s; a++)
+			memset(data + (y + a) * w + x, (int) v, s);
+		palette_image_changed(swirl->pal, x, y, s, s);
+		return;
+	}
+#endif /* STANDALONE */
+
 	for (a = 0; a < s; a++)
 		for (b = 0; b < s; b++) {
 			XPutPixel(ximage, x + b, y + a, v);
@@ -1115,16 +1151,21 @@ draw_point(ModeInfo * mi, SWIRL_P swirl)
 		r2 = r / 2;
 
 		/* interleave blocks at half r */
-		draw_block(swirl->ximage, x, y, r2, do_point(swirl, x, y));
-		draw_block(swirl->ximage, x + r2, y, r2, do_point(swirl, x + r2, y));
-		draw_block(swirl->ximage, x + r2, y + r2, r2, do_point(swirl,
+		draw_block(swirl, x, y, r2, do_point(swirl, x, y));
+		draw_block(swirl, x + r2, y, r2, do_point(swirl, x + r2, y));
+		draw_block(swirl, x + r2, y + r2, r2, do_point(swirl,
 			x + r2, y + r2));
-		draw_block(swirl->ximage, x, y + r2, r2, do_point(swirl, x, y + r2));
+		draw_block(swirl, x, y + r2, r2, do_point(swirl, x, y + r2));
 	} else
-		draw_block(swirl->ximage, x, y, r, do_point(swirl, x, y));
+		draw_block(swirl, x, y, r, do_point(swirl, x, y));
 
 	/* update the screen */
 
+#ifdef STANDALONE
+	if (swirl->pal)
+		return;		/* sent once per frame, by draw_swirl */
+#endif /* STANDALONE */
+
 #ifdef HAVE_XSHM_EXTENSION
 	if (mi->use_shm)
 	  XShmPutImage(MI_DISPLAY(mi), MI_WINDOW(mi), MI_GC(mi), swirl->ximage,
@@ -1281,6 +1322,16 @@ init_swirl(ModeInfo * mi)
 
 	swirl->rgb_values = mi->colors;
 	swirl->colours = mi->npixels;
+	if (swirl->pal) {
+		XColor      c[256];
+
+		/* index 0 is the background, and colour N is index N+1 */
+		if (swirl->colours > 255)
+			swirl->colours = 255;
+		c[0].pixel = MI_BLACK_PIXEL(mi);
+		memcpy(c + 1, mi->colors, swirl->colours * sizeof(*c));
+		palette_image_set_colors(swirl->pal, c, swirl->colours + 1);
+	}
 	swirl->dcolours = swirl->colours;
 /*	swirl->fixed_colourmap = !mi->writable_p;*/
 
@@ -1354,6 +1405,8 @@ draw_swirl(ModeInfo * mi)
 		  if (mi->writable_p)
 			rotate_colors(mi->xgwa.screen, MI_COLORMAP(mi),
 						  swirl->rgb_values, swirl->colours, 1);
+		  else if (swirl->pal)
+			palette_image_rotate(swirl->pal, 1, 1);
 #else  /* !STANDALONE */
 			/* rotate the colours */
 			install_map(MI_DISPLAY(mi), swirl, swirl->dshift);
@@ -1376,6 +1429,8 @@ draw_swirl(ModeInfo * mi)
 		  if (mi->writable_p)
 			rotate_colors(mi->xgwa.screen, MI_COLORMAP(mi),
 						  swirl->rgb_values, swirl->colours, 1);
+		  else if (swirl->pal)
+			palette_image_rotate(swirl->pal, 1, 1);
 #else  /* !STANDALONE */
 			/* rotate the colours */
 			install_map(MI_DISPLAY(mi), swirl, swirl->shift);
@@ -1428,6 +1483,11 @@ draw_swirl(ModeInfo * mi)
 					swirl->start_again--;
 			}
 		}
+
+#ifdef STANDALONE
+		if (swirl->pal)
+			palette_image_put(swirl->pal, MI_WINDOW(mi), MI_GC(mi));
+#endif /* STANDALONE */
 	}
 }
 
@@ -1461,6 +1521,10 @@ release_swirl (ModeInfo * mi)
 #endif /* !STANDALONE */
 			if (swirl->ximage != NULL)
 				XDestroyImage(swirl->ximage);
+#ifdef STANDALONE
+			if (swirl->pal)
+				palette_image_free(swirl->pal);
+#endif /* STANDALONE */
 			if (swirl->knots)
 				(void) free((void *) swirl->knots);
 		}
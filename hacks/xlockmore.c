@@ -515,6 +515,9 @@ xlockmore_reshape (Display *dpy, Window window, void *closure,
   if (mi && mi->xlmft->hack_reshape)
     {
       XGetWindowAttributes (dpy, window, &mi->xgwa);
+# if defined(USE_GL) && !defined(HAVE_COCOA) && !defined(HAVE_ANDROID)
+      xlockmore_gl_scale_window (mi);
+# endif
       mi->xlmft->hack_reshape (mi, mi->xgwa.width, mi->xgwa.height);
     }
 }
@@ -524,7 +527,15 @@ xlockmore_event (Display *dpy, Window window, void *closure, XEvent *event)
 {
   ModeInfo *mi = (ModeInfo *) closure;
   if (mi && mi->xlmft->hack_handle_events)
-    return mi->xlmft->hack_handle_events (mi, event);
+    {
+# if defined(USE_GL) && !defined(HAVE_COCOA) && !defined(HAVE_ANDROID)
+      XEvent scaled = *event;
+      xlockmore_gl_scale_event (mi, &scaled);
+      return mi->xlmft->hack_handle_events (mi, &scaled);
+# else
+      return mi->xlmft->hack_handle_events (mi, event);
+# endif
+    }
   else
     return False;
 }
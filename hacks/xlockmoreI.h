@@ -51,6 +51,10 @@ typedef struct ModeInfo ModeInfo;
 #  include <GL/gl.h>
 #  include <GL/glu.h>
 #  include <GL/glx.h>
+
+   /* So that the picture can be stretched first, with -render-scale. */
+   extern void xlockmore_gl_swap_buffers (Display *, Window);
+#  define glXSwapBuffers(dpy,window) xlockmore_gl_swap_buffers((dpy),(window))
 # endif
 
 # ifdef HAVE_JWZGLES
@@ -59,6 +63,9 @@ typedef struct ModeInfo ModeInfo;
 
 
   extern GLXContext *init_GL (ModeInfo *);
+  extern void xlockmore_gl_scale_window (ModeInfo *);
+  extern void xlockmore_gl_scale_event (ModeInfo *, XEvent *);
+  extern double xlockmore_gl_gpu_wait (Window);
   extern void xlockmore_reset_gl_state(void);
   extern void clear_gl_error (void);
   extern void check_gl_error (const char *type);
@@ -21,6 +21,78 @@
 
 extern char *progname;
 
+
+/* On a TrueColor visual, the pixel for a color is just its RGB bits
+   packed according to the visual's masks, and XAllocColor can't fail.
+   So we can compute it ourselves instead of making a server round-trip
+   for every color in a ramp.
+ */
+static Bool
+truecolor_visual_p (Screen *screen, Visual *visual)
+{
+# ifdef HAVE_COCOA
+  return False;
+# else
+  return (screen && visual && visual_class (screen, visual) == TrueColor);
+# endif
+}
+
+#ifndef HAVE_COCOA
+static unsigned short
+truecolor_channel (unsigned short value, unsigned long mask,
+                   unsigned long *pixel)
+{
+  int shift = 0, bits = 0;
+  unsigned long v;
+  if (!mask) return 0;
+  while (!(mask & 1)) { mask >>= 1; shift++; }
+  while (mask & 1)    { mask >>= 1; bits++;  }
+  if (bits > 16) bits = 16;
+  v = value >> (16 - bits);
+  *pixel |= v << shift;
+  return (unsigned short) ((v * 0xFFFF) / ((1L << bits) - 1));
+}
+
+static void
+truecolor_pixel (Visual *visual, XColor *color)
+{
+  unsigned long pixel = 0;
+  color->red   = truecolor_channel (color->red,   visual->red_mask,   &pixel);
+  color->green = truecolor_channel (color->green, visual->green_mask, &pixel);
+  color->blue  = truecolor_channel (color->blue,  visual->blue_mask,  &pixel);
+  color->pixel = pixel;
+}
+#endif /* !HAVE_COCOA */
+
+
+/* Allocates read-only cells for each of the colors, filling in their
+   pixel fields.  Stops at the first failure, and returns how many were
+   allocated.
+ */
+static int
+alloc_colors (Screen *screen, Visual *visual, Colormap cmap,
+              XColor *colors, int ncolors)
+{
+  Display *dpy = screen ? DisplayOfScreen (screen) : 0;
+  Bool truecolor_p = truecolor_visual_p (screen, visual);
+  int i;
+  for (i = 0; i < ncolors; i++)
+    {
+      XColor color;
+      color = colors[i];
+# ifndef HAVE_COCOA
+      if (truecolor_p)
+        truecolor_pixel (visual, &color);
+      else
+# endif
+      if (!XAllocColor (dpy, cmap, &color))
+        break;
+      colors[i].pixel = color.pixel;
+    }
+  return i;
+}
+
+
 void
 free_colors (Screen *screen, Colormap cmap, XColor *colors, int ncolors)
 {
@@ -173,19 +245,11 @@ make_color_ramp (Screen *screen, Visual *visual, Colormap cmap,
     }
   else
     {
-      for (i = 0; i < *ncolorsP; i++)
+      i = alloc_colors (screen, visual, cmap, colors, *ncolorsP);
+      if (i < *ncolorsP)
 	{
-	  XColor color;
-	  color = colors[i];
-	  if (XAllocColor (dpy, cmap, &color))
-	    {
-	      colors[i].pixel = color.pixel;
-	    }
-	  else
-	    {
-	      free_colors (screen, cmap, colors, i);
-	      goto FAIL;
-	    }
+	  free_colors (screen, cmap, colors, i);
+	  goto FAIL;
 	}
     }
 
@@ -412,19 +476,11 @@ make_color_path (Screen *screen, Visual *visual, Colormap cmap,
     }
   else
     {
-      for (i = 0; i < *ncolorsP; i++)
+      i = alloc_colors (screen, visual, cmap, colors, *ncolorsP);
+      if (i < *ncolorsP)
 	{
-	  XColor color;
-	  color = colors[i];
-	  if (XAllocColor (dpy, cmap, &color))
-	    {
-	      colors[i].pixel = color.pixel;
-	    }
-	  else
-	    {
-	      free_colors (screen, cmap, colors, i);
-	      goto FAIL;
-	    }
+	  free_colors (screen, cmap, colors, i);
+	  goto FAIL;
 	}
     }
 
@@ -679,17 +735,7 @@ make_random_colormap (Screen *screen, Visual *visual, Colormap cmap,
 	XStoreColors (dpy, cmap, colors, ncolors);
     }
   else
-    {
-      for (i = 0; i < ncolors; i++)
-	{
-	  XColor color;
-	  color = colors[i];
-	  if (!XAllocColor (dpy, cmap, &color))
-	    break;
-	  colors[i].pixel = color.pixel;
-	}
-      ncolors = i;
-    }
+    ncolors = alloc_colors (screen, visual, cmap, colors, ncolors);
 
   /* If we tried for writable cells and got none, try for non-writable. */
   if (allocate_p && ncolors == 0 && writable_pP && *writable_pP)
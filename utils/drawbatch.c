@@ -0,0 +1,256 @@
+/* xscreensaver, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+/* Per-color batching of points, segments and rectangles.  See drawbatch.h.
+ */
+
+#include "utils.h"
+#include "drawbatch.h"
+
+struct draw_list {
+  unsigned long pixel;
+  int npoints, points_size;
+  XPoint *points;
+  int nsegs, segs_size;
+  XSegment *segs;
+  int nrects, rects_size;
+  XRectangle *rects;
+};
+
+struct draw_batch {
+  Display *dpy;
+  Drawable d;
+  GC gc;
+
+  /* Lists in order of first use.  Lists past `nused' are left over from
+     earlier flushes; they keep their arrays for reuse.
+   */
+  int nlists, nused;
+  struct draw_list *lists;
+
+  /* Open-addressed table from pixel value to 1 + index into `lists'.
+     Zero means empty.  Cleared on every flush.
+   */
+  int hash_size;
+  int *hash;
+};
+
+
+draw_batch *
+draw_batch_init (Display *dpy, Drawable d, GC gc)
+{
+  draw_batch *b = (draw_batch *) calloc (1, sizeof(*b));
+  if (!b) return 0;
+  b->dpy = dpy;
+  b->d = d;
+  b->gc = gc;
+  b->hash_size = 64;
+  b->hash = (int *) calloc (b->hash_size, sizeof(*b->hash));
+  if (!b->hash)
+    {
+      free (b);
+      return 0;
+    }
+  return b;
+}
+
+
+void
+draw_batch_free (draw_batch *b)
+{
+  int i;
+  if (!b) return;
+  for (i = 0; i < b->nlists; i++)
+    {
+      struct draw_list *l = &b->lists[i];
+      if (l->points) free (l->points);
+      if (l->segs)   free (l->segs);
+      if (l->rects)  free (l->rects);
+    }
+  if (b->lists) free (b->lists);
+  free (b->hash);
+  free (b);
+}
+
+
+void
+draw_batch_set_drawable (draw_batch *b, Drawable d)
+{
+  if (b->d != d)
+    draw_batch_flush (b);
+  b->d = d;
+}
+
+
+static unsigned int
+hash_pixel (unsigned long pixel, int size)
+{
+  unsigned long h = pixel * 2654435761UL;
+  return (unsigned int) ((h ^ (h >> 16)) & (size - 1));
+}
+
+
+static void
+rehash (draw_batch *b, int size)
+{
+  int *hash = (int *) calloc (size, sizeof(*hash));
+  int i;
+  if (!hash) return;		/* keep probing the full-ish old table */
+  for (i = 0; i < b->nused; i++)
+    {
+      unsigned int h = hash_pixel (b->lists[i].pixel, size);
+      while (hash[h])
+        h = (h + 1) & (size - 1);
+      hash[h] = i + 1;
+    }
+  free (b->hash);
+  b->hash = hash;
+  b->hash_size = size;
+}
+
+
+/* Returns the list for this color, starting a new one if needed.
+ */
+static struct draw_list *
+find_list (draw_batch *b, unsigned long pixel)
+{
+  unsigned int h = hash_pixel (pixel, b->hash_size);
+  struct draw_list *l;
+
+  while (b->hash[h])
+    {
+      l = &b->lists[b->hash[h] - 1];
+      if (l->pixel == pixel)
+        return l;
+      h = (h + 1) & (b->hash_size - 1);
+    }
+
+  /* If rehash() ran out of memory, the table may be nearly full: it must
+     keep one empty slot, or the loop above would never end. */
+  if (b->nused >= b->hash_size - 1)
+    return 0;
+
+  if (b->nused >= b->nlists)
+    {
+      int n = (b->nlists ? b->nlists * 2 : 16);
+      struct draw_list *lists = (struct draw_list *)
+        realloc (b->lists, n * sizeof(*lists));
+      if (!lists) return 0;
+      memset (lists + b->nlists, 0, (n - b->nlists) * sizeof(*lists));
+      b->lists = lists;
+      b->nlists = n;
+    }
+
+  l = &b->lists[b->nused++];
+  l->pixel = pixel;
+  l->npoints = l->nsegs = l->nrects = 0;
+  b->hash[h] = b->nused;
+
+  /* Keep the table under half full. */
+  if (b->nused * 2 > b->hash_size)
+    rehash (b, b->hash_size * 2);
+
+  return l;
+}
+
+
+/* Grows an array to hold at least one more element.
+ */
+static Bool
+grow (void **array, int *size, int count, size_t elt)
+{
+  void *a;
+  int n;
+  if (count < *size) return True;
+  n = (*size ? *size * 2 : 64);
+  a = realloc (*array, n * elt);
+  if (!a) return False;
+  *array = a;
+  *size = n;
+  return True;
+}
+
+
+void
+draw_batch_point (draw_batch *b, unsigned long pixel, int x, int y)
+{
+  struct draw_list *l = find_list (b, pixel);
+  XPoint *p;
+  if (!l || !grow ((void **) &l->points, &l->points_size, l->npoints,
+                   sizeof(*l->points)))
+    return;
+  p = &l->points[l->npoints++];
+  p->x = x;
+  p->y = y;
+}
+
+
+void
+draw_batch_segment (draw_batch *b, unsigned long pixel,
+                    int x1, int y1, int x2, int y2)
+{
+  struct draw_list *l = find_list (b, pixel);
+  XSegment *s;
+  if (!l || !grow ((void **) &l->segs, &l->segs_size, l->nsegs,
+                   sizeof(*l->segs)))
+    return;
+  s = &l->segs[l->nsegs++];
+  s->x1 = x1;
+  s->y1 = y1;
+  s->x2 = x2;
+  s->y2 = y2;
+}
+
+
+void
+draw_batch_rectangle (draw_batch *b, unsigned long pixel,
+                      int x, int y, unsigned int w, unsigned int h)
+{
+  struct draw_list *l = find_list (b, pixel);
+  XRectangle *r;
+  if (!l || !grow ((void **) &l->rects, &l->rects_size, l->nrects,
+                   sizeof(*l->rects)))
+    return;
+  r = &l->rects[l->nrects++];
+  r->x = x;
+  r->y = y;
+  r->width = w;
+  r->height = h;
+}
+
+
+/* Xlib splits long XDrawPoints, XDrawSegments and XFillRectangles calls
+   into as many protocol requests as the server's maximum request size
+   needs, so each list can be sent in one call.
+ */
+void
+draw_batch_flush (draw_batch *b)
+{
+  int i;
+  if (!b->nused) return;
+
+  for (i = 0; i < b->nused; i++)
+    {
+      struct draw_list *l = &b->lists[i];
+      XSetForeground (b->dpy, b->gc, l->pixel);
+      if (l->nrects)
+        XFillRectangles (b->dpy, b->d, b->gc, l->rects, l->nrects);
+      if (l->nsegs)
+        XDrawSegments (b->dpy, b->d, b->gc, l->segs, l->nsegs);
+      if (l->npoints)
+        XDrawPoints (b->dpy, b->d, b->gc, l->points, l->npoints,
+                     CoordModeOrigin);
+      l->npoints = l->nsegs = l->nrects = 0;
+    }
+
+  b->nused = 0;
+  memset (b->hash, 0, b->hash_size * sizeof(*b->hash));
+}
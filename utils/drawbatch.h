@@ -0,0 +1,48 @@
+/* xscreensaver, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+/* Many hacks draw thousands of single points a frame, changing the
+   foreground color between most of them, which costs two X requests per
+   pixel.  This collects points, line segments and filled rectangles into
+   one list per color, and sends each list with a single XDrawPoints,
+   XDrawSegments or XFillRectangles when flushed.
+
+   Drawing order is kept within each color.  Between colors it is not:
+   the lists are sent in the order in which each color was first used
+   since the last flush, so if a hack relies on one color overwriting
+   another within a frame, it should flush in between.
+
+   The GC's foreground is left set to whatever color was sent last.
+ */
+
+#ifndef __XSCREENSAVER_DRAWBATCH_H__
+#define __XSCREENSAVER_DRAWBATCH_H__
+
+typedef struct draw_batch draw_batch;
+
+extern draw_batch *draw_batch_init (Display *, Drawable, GC);
+extern void draw_batch_free (draw_batch *);
+
+/* Changes the drawable that the next flush goes to. */
+extern void draw_batch_set_drawable (draw_batch *, Drawable);
+
+extern void draw_batch_point (draw_batch *, unsigned long pixel,
+                              int x, int y);
+extern void draw_batch_segment (draw_batch *, unsigned long pixel,
+                                int x1, int y1, int x2, int y2);
+extern void draw_batch_rectangle (draw_batch *, unsigned long pixel,
+                                  int x, int y,
+                                  unsigned int w, unsigned int h);
+
+/* Sends everything queued so far, and empties the queues. */
+extern void draw_batch_flush (draw_batch *);
+
+#endif /* __XSCREENSAVER_DRAWBATCH_H__ */
@@ -27,6 +27,18 @@ extern char *progname;
 #undef countof
 #define countof(x) (sizeof(x)/sizeof(*(x)))
 
+/* Hacks call erase_window() as often as they like, sometimes with no
+   delay at all.  Each call that draws costs a round trip, so steps are
+   drawn no more often than this; the calls in between do nothing.  Each
+   step sends its lines, rectangles or points in one request (or as few
+   as Xlib needs to split them into), not one request apiece.
+ */
+#define FRAME_TIME (1.0 / 30)
+
+/* Fizzle is drawn through a stipple of this many pixels square, whose
+   bits are set in a random order as the erase proceeds. */
+#define FIZZLE_SIZE 128
+
 typedef void (*Eraser) (eraser_state *);
 
 struct eraser_state {
@@ -36,13 +48,15 @@ struct eraser_state {
   int width, height;
   Eraser fn;
 
-  double start_time, stop_time;
+  double start_time, stop_time, draw_time;
   double ratio, prev_ratio;
 
   /* data for random_lines, venetian, random_squares */
   Bool horiz_p;
   Bool flip_p;
   int nlines, *lines;
+  XSegment *segs;		/* one step's lines, drawn together */
+  XRectangle *rects;		/* one step's squares */
 
   /* data for triple_wipe, quad_wipe */
   Bool flip_x, flip_y;
@@ -53,6 +67,11 @@ struct eraser_state {
   /* data for random_squares */
   int cols;
 
+  /* data for fizzle */
+  unsigned short *fizzle_order;
+  char *fizzle_bits;
+  GC fizzle_gc;
+
 };
 
 
@@ -71,6 +90,83 @@ double_time (void)
 }
 
 
+/* Allocates the per-step arrays for the line and square erasers. */
+static void
+alloc_lines (eraser_state *st)
+{
+  st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+  st->segs  = (XSegment *) calloc (st->nlines, sizeof(*st->segs));
+}
+
+
+static void
+free_lines (eraser_state *st)
+{
+  if (st->lines) free (st->lines);
+  if (st->segs)  free (st->segs);
+  if (st->rects) free (st->rects);
+  st->lines = 0;
+  st->segs = 0;
+  st->rects = 0;
+}
+
+
+/* Draws the lines lines[from] to lines[to-1], which are all horizontal
+   or all vertical, in one request.
+ */
+static void
+draw_straight_lines (eraser_state *st, int from, int to)
+{
+  int i, n = 0;
+  for (i = from; i < to; i++, n++)
+    {
+      XSegment *seg = &st->segs[n];
+      if (st->horiz_p)
+        {
+          seg->x1 = 0;         seg->y1 = st->lines[i];
+          seg->x2 = st->width; seg->y2 = st->lines[i];
+        }
+      else
+        {
+          seg->x1 = st->lines[i]; seg->y1 = 0;
+          seg->x2 = st->lines[i]; seg->y2 = st->height;
+        }
+    }
+  if (n > 0)
+    XDrawSegments (st->dpy, st->window, st->bg_gc, st->segs, n);
+}
+
+
+/* Like draw_straight_lines, for triple_wipe and quad_wipe, where the
+   lines below `height' are horizontal and the rest vertical.
+ */
+static void
+draw_wipe_lines (eraser_state *st, int from, int to)
+{
+  int i, n = 0;
+  for (i = from; i < to; i++, n++)
+    {
+      XSegment *seg = &st->segs[n];
+      int x, y, x2, y2;
+
+      if (st->lines[i] < st->height)
+        x = 0, y = st->lines[i], x2 = st->width, y2 = y;
+      else
+        x = st->lines[i] - st->height, y = 0, x2 = x, y2 = st->height;
+
+      if (st->flip_x)
+        x = st->width - x, x2 = st->width - x2;
+      if (st->flip_y)
+        y = st->height - y, y2 = st->height - y2;
+
+      seg->x1 = x;  seg->y1 = y;
+      seg->x2 = x2; seg->y2 = y2;
+    }
+  if (n > 0)
+    XDrawSegments (st->dpy, st->window, st->bg_gc, st->segs, n);
+}
+
+
 static void
 random_lines (eraser_state *st)
 {
@@ -80,7 +176,8 @@ random_lines (eraser_state *st)
     {
       st->horiz_p = (random() & 1);
       st->nlines = (st->horiz_p ? st->height : st->width);
-      st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+      alloc_lines (st);
+      if (! st->segs) return;
 
       for (i = 0; i < st->nlines; i++)  /* every line */
         st->lines[i] = i;
@@ -95,23 +192,12 @@ random_lines (eraser_state *st)
         }
     }
 
-  for (i = st->nlines * st->prev_ratio;
-       i < st->nlines * st->ratio;
-       i++)
-    {
-      if (st->horiz_p)
-        XDrawLine (st->dpy, st->window, st->bg_gc, 
-                   0, st->lines[i], st->width, st->lines[i]);
-      else
-        XDrawLine (st->dpy, st->window, st->bg_gc, 
-                   st->lines[i], 0, st->lines[i], st->height);
-    }
+  if (! st->segs) return;
+  draw_straight_lines (st, st->nlines * st->prev_ratio,
+                       ceil (st->nlines * st->ratio));
 
   if (st->ratio >= 1.0)
-    {
-      free (st->lines);
-      st->lines = 0;
-    }
+    free_lines (st);
 }
 
 
@@ -125,7 +211,8 @@ venetian (eraser_state *st)
       st->horiz_p = (random() & 1);
       st->flip_p = (random() & 1);
       st->nlines = (st->horiz_p ? st->height : st->width);
-      st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+      alloc_lines (st);
+      if (! st->segs) return;
 
       for (i = 0; i < st->nlines * 2; i++)
         {
@@ -136,23 +223,12 @@ venetian (eraser_state *st)
     }
 
   
-  for (i = st->nlines * st->prev_ratio;
-       i < st->nlines * st->ratio;
-       i++)
-    {
-      if (st->horiz_p)
-        XDrawLine (st->dpy, st->window, st->bg_gc, 
-                   0, st->lines[i], st->width, st->lines[i]);
-      else
-        XDrawLine (st->dpy, st->window, st->bg_gc, 
-                   st->lines[i], 0, st->lines[i], st->height);
-    }
+  if (! st->segs) return;
+  draw_straight_lines (st, st->nlines * st->prev_ratio,
+                       ceil (st->nlines * st->ratio));
 
   if (st->ratio >= 1.0)
-    {
-      free (st->lines);
-      st->lines = 0;
-    }
+    free_lines (st);
 }
 
 
@@ -165,7 +241,8 @@ triple_wipe (eraser_state *st)
       st->flip_x = random() & 1;
       st->flip_y = random() & 1;
       st->nlines = st->width + (st->height / 2);
-      st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+      alloc_lines (st);
+      if (! st->segs) return;
 
       for (i = 0; i < st->width / 2; i++)
         st->lines[i] = i * 2 + st->height;
@@ -176,30 +253,12 @@ triple_wipe (eraser_state *st)
           st->width - i * 2 - (st->width % 2 ? 0 : 1) + st->height;
     }
 
-  for (i = st->nlines * st->prev_ratio;
-       i < st->nlines * st->ratio;
-       i++)
-    {
-      int x, y, x2, y2;
-
-      if (st->lines[i] < st->height)
-        x = 0, y = st->lines[i], x2 = st->width, y2 = y;
-      else
-        x = st->lines[i]-st->height, y = 0, x2 = x, y2 = st->height;
-
-      if (st->flip_x)
-        x = st->width - x, x2 = st->width - x2;
-      if (st->flip_y)
-        y = st->height - y, y2 = st->height - y2;
-
-      XDrawLine (st->dpy, st->window, st->bg_gc, x, y, x2, y2);
-    }
+  if (! st->segs) return;
+  draw_wipe_lines (st, st->nlines * st->prev_ratio,
+                   ceil (st->nlines * st->ratio));
 
   if (st->ratio >= 1.0)
-    {
-      free (st->lines);
-      st->lines = 0;
-    }
+    free_lines (st);
 }
 
 
@@ -212,7 +271,8 @@ quad_wipe (eraser_state *st)
       st->flip_x = random() & 1;
       st->flip_y = random() & 1;
       st->nlines = st->width + st->height;
-      st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+      alloc_lines (st);
+      if (! st->segs) return;
 
       for (i = 0; i < st->nlines/4; i++)
         {
@@ -224,29 +284,12 @@ quad_wipe (eraser_state *st)
         }
     }
 
-  for (i = st->nlines * st->prev_ratio;
-       i < st->nlines * st->ratio;
-       i++)
-    {
-      int x, y, x2, y2;
-      if (st->lines[i] < st->height)
-        x = 0, y = st->lines[i], x2 = st->width, y2 = y;
-      else
-        x = st->lines[i] - st->height, y = 0, x2 = x, y2 = st->height;
-
-      if (st->flip_x)
-        x = st->width-x, x2 = st->width-x2;
-      if (st->flip_y)
-        y = st->height-y, y2 = st->height-y2;
-
-      XDrawLine (st->dpy, st->window, st->bg_gc, x, y, x2, y2);
-    }
+  if (! st->segs) return;
+  draw_wipe_lines (st, st->nlines * st->prev_ratio,
+                   ceil (st->nlines * st->ratio));
 
   if (st->ratio >= 1.0)
-    {
-      free (st->lines);
-      st->lines = 0;
-    }
+    free_lines (st);
 }
 
 
@@ -285,6 +328,7 @@ three_circle_wipe (eraser_state *st)
   int rad = (st->width > st->height ? st->width : st->height);
   int max = 360 * 64;
   int th, oth;
+  XArc arcs[6];
   int i;
 
   if (st->ratio == 0.0)
@@ -293,22 +337,25 @@ three_circle_wipe (eraser_state *st)
   th  = max/6 * st->ratio;
   oth = max/6 * st->prev_ratio;
 
-  for (i = 0; i < 3; i++)
+  for (i = 0; i < countof(arcs); i++)
     {
-      int off = i * max / 3;
-      XFillArc (st->dpy, st->window, st->bg_gc,
-                (st->width  / 2) - rad,
-                (st->height / 2) - rad, 
-                rad*2, rad*2,
-                (st->start + off + oth) % max,
-                th-oth);
-      XFillArc (st->dpy, st->window, st->bg_gc,
-                (st->width  / 2) - rad,
-                (st->height / 2) - rad, 
-                rad*2, rad*2,
-                (st->start + off - oth) % max,
-                oth-th);
+      int off = (i / 2) * max / 3;
+      arcs[i].x = (st->width  / 2) - rad;
+      arcs[i].y = (st->height / 2) - rad;
+      arcs[i].width  = rad*2;
+      arcs[i].height = rad*2;
+      if (i & 1)
+        {
+          arcs[i].angle1 = (st->start + off - oth) % max;
+          arcs[i].angle2 = oth-th;
+        }
+      else
+        {
+          arcs[i].angle1 = (st->start + off + oth) % max;
+          arcs[i].angle2 = th-oth;
+        }
     }
+  XFillArcs (st->dpy, st->window, st->bg_gc, arcs, countof(arcs));
 }
 
 
@@ -366,6 +413,73 @@ squaretate (eraser_state *st)
 }
 
 
+#if !defined(HAVE_COCOA) && !defined(HAVE_ANDROID)
+
+/* Erases the window through a stipple, with more of its bits set at
+   each step: one small bitmap and one rectangle per step, instead of
+   millions of random points.
+ */
+static void
+fizzle (eraser_state *st)
+{
+  int n = FIZZLE_SIZE * FIZZLE_SIZE;
+  int i, from, to;
+  Pixmap stipple;
+
+  if (! st->fizzle_order)	/* first time */
+    {
+      XGCValues gcv;
+      st->fizzle_order = (unsigned short *)
+        malloc (n * sizeof(*st->fizzle_order));
+      st->fizzle_bits = (char *) calloc (1, n / 8);
+      if (! st->fizzle_order || ! st->fizzle_bits) return;
+
+      for (i = 0; i < n; i++)  /* every pixel */
+        st->fizzle_order[i] = i;
+
+      for (i = 0; i < n; i++)  /* shuffle */
+        {
+          int t, r;
+          t = st->fizzle_order[i];
+          r = random() % n;
+          st->fizzle_order[i] = st->fizzle_order[r];
+          st->fizzle_order[r] = t;
+        }
+
+      XGetGCValues (st->dpy, st->bg_gc, GCForeground, &gcv);
+      gcv.fill_style = FillStippled;
+      gcv.ts_x_origin = random() % FIZZLE_SIZE;
+      gcv.ts_y_origin = random() % FIZZLE_SIZE;
+      st->fizzle_gc = XCreateGC (st->dpy, st->window,
+                                 (GCForeground | GCFillStyle |
+                                  GCTileStipXOrigin | GCTileStipYOrigin),
+                                 &gcv);
+    }
+
+  if (! st->fizzle_bits) return;
+
+  from = n * st->prev_ratio;
+  to   = ceil (n * st->ratio);
+  if (to <= from) return;
+
+  for (i = from; i < to; i++)
+    {
+      int p = st->fizzle_order[i];
+      st->fizzle_bits[p / 8] |= 1 << (p % 8);   /* XBM: LSB is leftmost */
+    }
+
+  stipple = XCreateBitmapFromData (st->dpy, st->window, st->fizzle_bits,
+                                   FIZZLE_SIZE, FIZZLE_SIZE);
+  XSetStipple (st->dpy, st->fizzle_gc, stipple);
+  XFillRectangle (st->dpy, st->window, st->fizzle_gc,
+                  0, 0, st->width, st->height);
+  XFreePixmap (st->dpy, stipple);
+}
+
+#else /* HAVE_COCOA || HAVE_ANDROID */
+
+/* jwxyz doesn't do stipples, so fall back to random points: as many as
+   there are pixels, four times over, for the whole erase. */
 static void
 fizzle (eraser_state *st)
 {
@@ -394,6 +508,10 @@ fizzle (eraser_state *st)
   free (points);
 }
 
+#endif /* HAVE_COCOA || HAVE_ANDROID */
+
+
+#define FAN_STEPS 40	/* a step is 4 degrees */
 
 static void
 spiral (eraser_state *st)
@@ -401,7 +519,7 @@ spiral (eraser_state *st)
   int max_radius = (st->width > st->height ? st->width : st->height) * 0.7;
   int loops = 10;
   float max_th = M_PI * 2 * loops;
-  int i;
+  int i, end;
   int steps = 360 * loops / 4;
   float off;
 
@@ -413,31 +531,33 @@ spiral (eraser_state *st)
 
   off = st->start * M_PI / 180;
 
-  for (i = steps * st->prev_ratio;
-       i < steps * st->ratio;
-       i++)
+  /* Consecutive triangles all share the center point, so a run of them
+     is one fan-shaped polygon.  Less than half a turn of the spiral at
+     a time, so that the polygon doesn't overlap itself. */
+  i = steps * st->prev_ratio;
+  end = ceil (steps * st->ratio);
+  while (i < end)
     {
-      float th1 = i     * max_th / steps;
-      float th2 = (i+1) * max_th / steps;
-      int   r1  = i     * max_radius / steps;
-      int   r2  = (i+1) * max_radius / steps;
-      XPoint points[3];
+      XPoint points[2 + FAN_STEPS];
+      int n = 0, j;
 
-      if (st->flip_p)
+      points[n].x = st->width  / 2;
+      points[n].y = st->height / 2;
+      n++;
+
+      for (j = i; j <= end && n < countof(points); j++, n++)
         {
-          th1 = max_th - th1;
-          th2 = max_th - th2;
+          float th = j * max_th / steps;
+          int   r  = j * max_radius / steps;
+          if (st->flip_p)
+            th = max_th - th;
+          points[n].x = points[0].x + r * cos (off + th);
+          points[n].y = points[0].y + r * sin (off + th);
         }
+      i = j - 1;
 
-      points[0].x = st->width  / 2;
-      points[0].y = st->height / 2;
-      points[1].x = points[0].x + r1 * cos (off + th1);
-      points[1].y = points[0].y + r1 * sin (off + th1);
-      points[2].x = points[0].x + r2 * cos (off + th2);
-      points[2].y = points[0].y + r2 * sin (off + th2);
-/*  XFillRectangle(st->dpy, st->window, st->fg_gc,0,0,st->width, st->height);*/
       XFillPolygon (st->dpy, st->window, st->bg_gc,
-                    points, 3, Convex, CoordModeOrigin);
+                    points, n, Nonconvex, CoordModeOrigin);
     }
 }
 
@@ -445,7 +565,7 @@ spiral (eraser_state *st)
 static void
 random_squares (eraser_state *st)
 {
-  int i, size, rows;
+  int i, n, size, rows;
 
   if (st->ratio == 0.0)
     {
@@ -454,6 +574,8 @@ random_squares (eraser_state *st)
       rows = (size ? (st->height / size) : 0) + 1;
       st->nlines = st->cols * rows;
       st->lines = (int *) calloc (st->nlines, sizeof(*st->lines));
+      st->rects = (XRectangle *) calloc (st->nlines, sizeof(*st->rects));
+      if (! st->rects) return;
 
       for (i = 0; i < st->nlines; i++)  /* every square */
         st->lines[i] = i;
@@ -468,26 +590,27 @@ random_squares (eraser_state *st)
         }
     }
 
+  if (! st->rects) return;
+
   size = st->width / st->cols;
   rows = (size ? (st->height / size) : 0) + 1;
 
-  for (i = st->nlines * st->prev_ratio;
+  for (i = st->nlines * st->prev_ratio, n = 0;
        i < st->nlines * st->ratio;
-       i++)
+       i++, n++)
     {
       int x = st->lines[i] % st->cols;
       int y = st->lines[i] / st->cols;
-      XFillRectangle (st->dpy, st->window, st->bg_gc,
-                      st->width  * x / st->cols,
-                      st->height * y / rows,
-                      size+1, size+1);
+      st->rects[n].x = st->width  * x / st->cols;
+      st->rects[n].y = st->height * y / rows;
+      st->rects[n].width  = size+1;
+      st->rects[n].height = size+1;
     }
+  if (n > 0)
+    XFillRectangles (st->dpy, st->window, st->bg_gc, st->rects, n);
 
   if (st->ratio >= 1.0)
-    {
-      free (st->lines);
-      st->lines = 0;
-    }
+    free_lines (st);
 }
 
 
@@ -706,6 +829,7 @@ eraser_init (Display *dpy, Window window)
 
   st->start_time = double_time();
   st->stop_time = st->start_time + duration;
+  st->draw_time = st->start_time;
 
   XSync (st->dpy, False);
 
@@ -719,6 +843,11 @@ eraser_draw (eraser_state *st, Bool first_p)
   double now = (first_p ? st->start_time : double_time());
   double duration = st->stop_time - st->start_time;
 
+  /* Too soon since the last step: do nothing this time. */
+  if (!first_p && now < st->draw_time + FRAME_TIME && now < st->stop_time)
+    return True;
+  st->draw_time = now;
+
   st->prev_ratio = st->ratio;
   st->ratio = (now - st->start_time) / duration;
 
@@ -737,6 +866,10 @@ eraser_free (eraser_state *st)
   XClearWindow (st->dpy, st->window);
   XFreeGC (st->dpy, st->fg_gc);
   XFreeGC (st->dpy, st->bg_gc);
+  if (st->fizzle_gc) XFreeGC (st->dpy, st->fizzle_gc);
+  if (st->fizzle_order) free (st->fizzle_order);
+  if (st->fizzle_bits) free (st->fizzle_bits);
+  free_lines (st);
   free (st);
 }
 
@@ -84,12 +84,10 @@ static int sgi_gamma_fade (Display *dpy,
 			   Bool out_p, Bool clear_windows);
 #endif /* HAVE_SGI_VC_EXTENSION */
 
-#ifdef HAVE_XF86VMODE_GAMMA
-static int xf86_gamma_fade (Display *dpy,
-                            Window *black_windows, int nwindows,
-                            int seconds, int ticks,
-                            Bool out_p, Bool clear_windows);
-#endif /* HAVE_XF86VMODE_GAMMA */
+static int gamma_fade (Display *dpy,
+                       Window *black_windows, int nwindows,
+                       int seconds, int ticks,
+                       Bool out_p, Bool clear_windows);
 
 
 void
@@ -127,14 +125,13 @@ fade_screens (Display *dpy, Colormap *cmaps,
   else
 #endif /* HAVE_SGI_VC_EXTENSION */
 
-#ifdef HAVE_XF86VMODE_GAMMA
-  /* Then try to do it by fading the gamma in an XFree86-specific way... */
-  if (0 == xf86_gamma_fade(dpy, black_windows, nwindows,
-                           seconds, ticks, out_p,
-                           clear_windows))
+  /* Then try to do it by fading the gamma of each monitor with RANDR,
+     or of each screen with XFree86-VidModeExtension... */
+  if (0 == gamma_fade (dpy, black_windows, nwindows,
+                       seconds, ticks, out_p,
+                       clear_windows))
     ;
   else
-#endif /* HAVE_XF86VMODE_GAMMA */
 
     /* Else, do it the old-fashioned way, which (somewhat) loses if
        there are TrueColor windows visible. */
@@ -618,6 +615,19 @@ sgi_whack_gamma(Display *dpy, int screen, struct screen_sgi_gamma_info *info,
 
 
 
+#if defined(HAVE_XF86VMODE_GAMMA) || defined(HAVE_RANDR_12)
+static Bool error_handler_hit_p = False;
+
+static int
+ignore_all_errors_ehandler (Display *dpy, XErrorEvent *error)
+{
+  error_handler_hit_p = True;
+  return 0;
+}
+#endif /* HAVE_XF86VMODE_GAMMA || HAVE_RANDR_12 */
+
+
+
 /* XFree86 4.x+ Gamma fading */
 
 #ifdef HAVE_XF86VMODE_GAMMA
@@ -628,189 +638,13 @@ typedef struct {
   XF86VidModeGamma vmg;
   int size;
   unsigned short *r, *g, *b;
+  unsigned short *sr, *sg, *sb;		/* the scaled ramps, while fading */
 } xf86_gamma_info;
 
 static int xf86_check_gamma_extension (Display *dpy);
 static Bool xf86_whack_gamma (Display *dpy, int screen,
                               xf86_gamma_info *ginfo, float ratio);
 
-static int
-xf86_gamma_fade (Display *dpy,
-                 Window *black_windows, int nwindows,
-                 int seconds, int ticks,
-                 Bool out_p, Bool clear_windows)
-{
-  int steps = seconds * ticks;
-  long usecs_per_step = (long)(seconds * 1000000) / (long)steps;
-  XEvent dummy_event;
-  int nscreens = ScreenCount(dpy);
-  struct timeval then, now;
-#ifdef GETTIMEOFDAY_TWO_ARGS
-  struct timezone tzp;
-#endif
-  int i, screen;
-  int status = -1;
-  xf86_gamma_info *info = 0;
-
-  static int ext_ok = -1;
-
-  /* Only probe the extension once: the answer isn't going to change. */
-  if (ext_ok == -1)
-    ext_ok = xf86_check_gamma_extension (dpy);
-
-  /* If this server doesn't have the gamma extension, bug out. */
-  if (ext_ok == 0)
-    goto FAIL;
-
-# ifndef HAVE_XF86VMODE_GAMMA_RAMP
-  if (ext_ok == 2) ext_ok = 1;  /* server is newer than client! */
-# endif
-
-  info = (xf86_gamma_info *) calloc(nscreens, sizeof(*info));
-
-  /* Get the current gamma maps for all screens.
-     Bug out and return -1 if we can't get them for some screen.
-   */
-  for (screen = 0; screen < nscreens; screen++)
-    {
-      if (ext_ok == 1)  /* only have gamma parameter, not ramps. */
-        {
-          if (!XF86VidModeGetGamma(dpy, screen, &info[screen].vmg))
-            goto FAIL;
-        }
-# ifdef HAVE_XF86VMODE_GAMMA_RAMP
-      else if (ext_ok == 2)  /* have ramps */
-        {
-          if (!XF86VidModeGetGammaRampSize(dpy, screen, &info[screen].size))
-            goto FAIL;
-          if (info[screen].size <= 0)
-            goto FAIL;
-
-          info[screen].r = (unsigned short *)
-            calloc(info[screen].size, sizeof(unsigned short));
-          info[screen].g = (unsigned short *)
-            calloc(info[screen].size, sizeof(unsigned short));
-          info[screen].b = (unsigned short *)
-            calloc(info[screen].size, sizeof(unsigned short));
-
-          if (!(info[screen].r && info[screen].g && info[screen].b))
-            goto FAIL;
-
-          if (!XF86VidModeGetGammaRamp(dpy, screen, info[screen].size,
-                                       info[screen].r,
-                                       info[screen].g,
-                                       info[screen].b))
-            goto FAIL;
-        }
-# endif /* HAVE_XF86VMODE_GAMMA_RAMP */
-      else
-        abort();
-    }
-
-#ifdef GETTIMEOFDAY_TWO_ARGS
-  gettimeofday(&then, &tzp);
-#else
-  gettimeofday(&then);
-#endif
-
-  /* If we're fading in (from black), then first crank the gamma all the
-     way down to 0, then take the windows off the screen.
-   */
-  if (!out_p)
-    {
-      for (screen = 0; screen < nscreens; screen++)
-	xf86_whack_gamma(dpy, screen, &info[screen], 0.0);
-      for (screen = 0; screen < nwindows; screen++)
-	if (black_windows && black_windows[screen])
-	  {
-	    XUnmapWindow (dpy, black_windows[screen]);
-	    XClearWindow (dpy, black_windows[screen]);
-	    XSync(dpy, False);
-	  }
-    }
-
-  /* Iterate by steps of the animation... */
-  for (i = (out_p ? steps : 0);
-       (out_p ? i > 0 : i < steps);
-       (out_p ? i-- : i++))
-    {
-      for (screen = 0; screen < nscreens; screen++)
-	{
-	  xf86_whack_gamma(dpy, screen, &info[screen],
-                           (((float)i) / ((float)steps)));
-
-	  /* If there is user activity, bug out.  (Bug out on keypresses or
-	     mouse presses, but not motion, and not release events.  Bugging
-	     out on motion made the unfade hack be totally useless, I think.)
-
-	     We put the event back so that the calling code can notice it too.
-	     It would be better to not remove it at all, but that's harder
-	     because Xlib has such a non-design for this kind of crap, and
-	     in this application it doesn't matter if the events end up out
-	     of order, so in the grand unix tradition we say "fuck it" and
-	     do something that mostly works for the time being.
-	   */
-	  if (XCheckMaskEvent (dpy, (KeyPressMask|ButtonPressMask),
-			       &dummy_event))
-	    {
-	      XPutBackEvent (dpy, &dummy_event);
-	      goto DONE;
-	    }
-
-#ifdef GETTIMEOFDAY_TWO_ARGS
-	  gettimeofday(&now, &tzp);
-#else
-	  gettimeofday(&now);
-#endif
-
-	  /* If we haven't already used up our alotted time, sleep to avoid
-	     changing the colormap too fast. */
-          sleep_from (&now, &then, usecs_per_step);
-	}
-    }
-  
-
- DONE:
-
-  if (out_p && black_windows)
-    {
-      for (screen = 0; screen < nwindows; screen++)
-	{
-	  if (clear_windows)
-	    XClearWindow (dpy, black_windows[screen]);
-	  XMapRaised (dpy, black_windows[screen]);
-	}
-      XSync(dpy, False);
-    }
-
-  /* I can't explain this; without this delay, we get a flicker.
-     I suppose there's some lossage with stale bits being in the
-     hardware frame buffer or something, and this delay gives it
-     time to flush out.  This sucks! */
-  usleep(100000);  /* 1/10th second */
-
-  for (screen = 0; screen < nscreens; screen++)
-    xf86_whack_gamma(dpy, screen, &info[screen], 1.0);
-  XSync(dpy, False);
-
-  status = 0;
-
- FAIL:
-  if (info)
-    {
-      for (screen = 0; screen < nscreens; screen++)
-        {
-          if (info[screen].r) free(info[screen].r);
-          if (info[screen].g) free(info[screen].g);
-          if (info[screen].b) free(info[screen].b);
-        }
-      free(info);
-    }
-
-  return status;
-}
-
-
 /* This bullshit is needed because the VidMode extension doesn't work
    on remote displays -- but if the remote display has the extension
    at all, XF86VidModeQueryExtension returns true, and then
@@ -818,15 +652,6 @@ xf86_gamma_fade (Display *dpy,
    may I have another.
  */
 
-static Bool error_handler_hit_p = False;
-
-static int
-ignore_all_errors_ehandler (Display *dpy, XErrorEvent *error)
-{
-  error_handler_hit_p = True;
-  return 0;
-}
-
 static Bool
 safe_XF86VidModeQueryVersion (Display *dpy, int *majP, int *minP)
 {
@@ -894,17 +719,15 @@ xf86_check_gamma_extension (Display *dpy)
 #define XF86_MIN_GAMMA  0.1
 
 
+/* The caller handles errors and syncs, so that a fade step is one round
+   trip for all of the screens.
+ */
 static Bool
 xf86_whack_gamma(Display *dpy, int screen, xf86_gamma_info *info,
                  float ratio)
 {
   Bool status;
 
-  XErrorHandler old_handler;
-  XSync (dpy, False);
-  error_handler_hit_p = False;
-  old_handler = XSetErrorHandler (ignore_all_errors_ehandler);
-
   if (ratio < 0) ratio = 0;
   if (ratio > 1) ratio = 1;
 
@@ -928,11 +751,8 @@ xf86_whack_gamma(Display *dpy, int screen, xf86_gamma_info *info,
     {
 # ifdef HAVE_XF86VMODE_GAMMA_RAMP
 
-      unsigned short *r, *g, *b;
+      unsigned short *r = info->sr, *g = info->sg, *b = info->sb;
       int i;
-      r = (unsigned short *) malloc(info->size * sizeof(unsigned short));
-      g = (unsigned short *) malloc(info->size * sizeof(unsigned short));
-      b = (unsigned short *) malloc(info->size * sizeof(unsigned short));
 
       for (i = 0; i < info->size; i++)
         {
@@ -943,20 +763,512 @@ xf86_whack_gamma(Display *dpy, int screen, xf86_gamma_info *info,
 
       status = XF86VidModeSetGammaRamp(dpy, screen, info->size, r, g, b);
 
-      free (r);
-      free (g);
-      free (b);
-
 # else  /* !HAVE_XF86VMODE_GAMMA_RAMP */
       abort();
 # endif /* !HAVE_XF86VMODE_GAMMA_RAMP */
     }
 
+  return status;
+}
+
+#endif /* HAVE_XF86VMODE_GAMMA */
+
+
+
+/* RANDR 1.2+ per-CRTC gamma fading.
+
+   This is the best way: each monitor has its own gamma ramp, and the
+   server loads it into the hardware during vertical blank.
+ */
+
+#ifdef HAVE_RANDR_12
+
+# include <X11/extensions/Xrandr.h>
+
+static Bool
+randr_check_gamma_extension (Display *dpy)
+{
+  int event, error, major, minor;
+  if (!XRRQueryExtension (dpy, &event, &error))
+    return False;
+  if (!XRRQueryVersion (dpy, &major, &minor))
+    return False;
+  return (major > 1 || (major == 1 && minor >= 2));
+}
+
+
+static XRRScreenResources *
+randr_resources (Display *dpy, Window root)
+{
+  /* The non-"Current" version makes the server re-probe the outputs,
+     which can take a while. */
+# if RANDR_MAJOR > 1 || (RANDR_MAJOR == 1 && RANDR_MINOR >= 3)
+  return XRRGetScreenResourcesCurrent (dpy, root);
+# else
+  return XRRGetScreenResources (dpy, root);
+# endif
+}
+
+#endif /* HAVE_RANDR_12 */
+
+
+
+/* Gamma fading as a series of steps.
+
+   fade_start() saves the current gamma of every monitor (or, failing
+   RANDR, every screen); fade_step() sets them according to how much of
+   the fade's time has passed; and fade_finish() puts them back.  The
+   caller can go about its business between steps.
+ */
+
+#if defined(HAVE_XF86VMODE_GAMMA) || defined(HAVE_RANDR_12)
+
+typedef struct {
+  int screen;
+# ifdef HAVE_RANDR_12
+  RRCrtc crtc;
+  XRRCrtcGamma *saved, *scratch;
+# endif
+# ifdef HAVE_XF86VMODE_GAMMA
+  xf86_gamma_info xf86;
+# endif
+} gamma_ramp;
+
+enum { GAMMA_RANDR, GAMMA_XF86 };
+
+struct fade_state {
+  Display *dpy;
+  Window *black_windows;
+  int nwindows;
+  Bool out_p, clear_windows;
+  int seconds, ticks;
+  struct timeval start;
+  int kind;
+  int nramps;
+  gamma_ramp *ramps;
+};
+
+
+static gamma_ramp *
+add_ramp (fade_state *fs)
+{
+  gamma_ramp *r = (gamma_ramp *)
+    realloc (fs->ramps, (fs->nramps + 1) * sizeof(*r));
+  if (!r) return 0;
+  fs->ramps = r;
+  r = &fs->ramps[fs->nramps++];
+  memset (r, 0, sizeof(*r));
+  return r;
+}
+
+
+static void
+free_ramps (fade_state *fs)
+{
+  int i;
+  for (i = 0; i < fs->nramps; i++)
+    {
+      gamma_ramp *r = &fs->ramps[i];
+# ifdef HAVE_RANDR_12
+      if (r->saved)   XRRFreeGamma (r->saved);
+      if (r->scratch) XRRFreeGamma (r->scratch);
+# endif
+# ifdef HAVE_XF86VMODE_GAMMA
+      if (r->xf86.r) free (r->xf86.r);
+      if (r->xf86.g) free (r->xf86.g);
+      if (r->xf86.b) free (r->xf86.b);
+      if (r->xf86.sr) free (r->xf86.sr);
+      if (r->xf86.sg) free (r->xf86.sg);
+      if (r->xf86.sb) free (r->xf86.sb);
+# endif
+    }
+  if (fs->ramps) free (fs->ramps);
+  fs->ramps = 0;
+  fs->nramps = 0;
+}
+
+
+#ifdef HAVE_RANDR_12
+/* Saves the gamma of every CRTC that is showing something.
+   Returns 0 on success.
+ */
+static int
+randr_save_gamma (fade_state *fs)
+{
+  Display *dpy = fs->dpy;
+  int nscreens = ScreenCount (dpy);
+  int screen, i;
+  XErrorHandler old_handler;
+
+  static int ext_ok = -1;
+
+  /* Only probe the extension once: the answer isn't going to change. */
+  if (ext_ok == -1)
+    ext_ok = randr_check_gamma_extension (dpy);
+  if (!ext_ok)
+    return -1;
+
+  XSync (dpy, False);
+  error_handler_hit_p = False;
+  old_handler = XSetErrorHandler (ignore_all_errors_ehandler);
+
+  for (screen = 0; screen < nscreens; screen++)
+    {
+      XRRScreenResources *res = randr_resources (dpy, RootWindow (dpy,
+                                                                  screen));
+      if (!res) continue;
+      for (i = 0; i < res->ncrtc; i++)
+        {
+          XRRCrtcInfo *ci = XRRGetCrtcInfo (dpy, res, res->crtcs[i]);
+          Bool on_p = (ci && ci->mode != None);
+          gamma_ramp *r;
+          int size;
+
+          if (ci) XRRFreeCrtcInfo (ci);
+          if (!on_p) continue;
+          size = XRRGetCrtcGammaSize (dpy, res->crtcs[i]);
+          if (size <= 0) continue;
+
+          r = add_ramp (fs);
+          if (!r) break;
+          r->screen = screen;
+          r->crtc = res->crtcs[i];
+          r->saved = XRRGetCrtcGamma (dpy, r->crtc);
+          r->scratch = XRRAllocGamma (size);
+          if (!r->saved || !r->scratch || r->saved->size != size)
+            error_handler_hit_p = True;
+        }
+      XRRFreeScreenResources (res);
+    }
+
   XSync (dpy, False);
   XSetErrorHandler (old_handler);
   XSync (dpy, False);
 
-  return status;
+  if (error_handler_hit_p || fs->nramps == 0)
+    {
+      free_ramps (fs);
+      return -1;
+    }
+  fs->kind = GAMMA_RANDR;
+  return 0;
 }
+#endif /* HAVE_RANDR_12 */
+
+
+#ifdef HAVE_XF86VMODE_GAMMA
+/* Saves the gamma of every screen.  Returns 0 on success.
+ */
+static int
+xf86_save_gamma (fade_state *fs)
+{
+  Display *dpy = fs->dpy;
+  int nscreens = ScreenCount (dpy);
+  int screen;
+
+  static int ext_ok = -1;
+
+  /* Only probe the extension once: the answer isn't going to change. */
+  if (ext_ok == -1)
+    ext_ok = xf86_check_gamma_extension (dpy);
+
+  /* If this server doesn't have the gamma extension, bug out. */
+  if (ext_ok == 0)
+    return -1;
+
+# ifndef HAVE_XF86VMODE_GAMMA_RAMP
+  if (ext_ok == 2) ext_ok = 1;  /* server is newer than client! */
+# endif
+
+  /* Get the current gamma maps for all screens.
+     Bug out and return -1 if we can't get them for some screen.
+   */
+  for (screen = 0; screen < nscreens; screen++)
+    {
+      gamma_ramp *r = add_ramp (fs);
+      xf86_gamma_info *info;
+      if (!r) goto FAIL;
+      r->screen = screen;
+      info = &r->xf86;
+
+      if (ext_ok == 1)  /* only have gamma parameter, not ramps. */
+        {
+          if (!XF86VidModeGetGamma(dpy, screen, &info->vmg))
+            goto FAIL;
+        }
+# ifdef HAVE_XF86VMODE_GAMMA_RAMP
+      else if (ext_ok == 2)  /* have ramps */
+        {
+          if (!XF86VidModeGetGammaRampSize(dpy, screen, &info->size))
+            goto FAIL;
+          if (info->size <= 0)
+            goto FAIL;
 
+          info->r = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+          info->g = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+          info->b = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+          info->sr = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+          info->sg = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+          info->sb = (unsigned short *)
+            calloc(info->size, sizeof(unsigned short));
+
+          if (!(info->r && info->g && info->b &&
+                info->sr && info->sg && info->sb))
+            goto FAIL;
+
+          if (!XF86VidModeGetGammaRamp(dpy, screen, info->size,
+                                       info->r, info->g, info->b))
+            goto FAIL;
+        }
+# endif /* HAVE_XF86VMODE_GAMMA_RAMP */
+      else
+        abort();
+    }
+
+  fs->kind = GAMMA_XF86;
+  return 0;
+
+ FAIL:
+  free_ramps (fs);
+  return -1;
+}
 #endif /* HAVE_XF86VMODE_GAMMA */
+
+
+/* Scales every saved gamma ramp by `ratio', 0.0 - 1.0.
+ */
+static void
+set_gamma (fade_state *fs, double ratio)
+{
+  int i;
+  if (ratio < 0) ratio = 0;
+  if (ratio > 1) ratio = 1;
+
+# ifdef HAVE_RANDR_12
+  if (fs->kind == GAMMA_RANDR)
+    {
+      XErrorHandler old_handler;
+      error_handler_hit_p = False;
+      old_handler = XSetErrorHandler (ignore_all_errors_ehandler);
+
+      for (i = 0; i < fs->nramps; i++)
+        {
+          gamma_ramp *r = &fs->ramps[i];
+          XRRCrtcGamma *from = r->saved, *to = r->scratch;
+          int j;
+          if (ratio >= 1)
+            to = from;
+          else
+            for (j = 0; j < from->size; j++)
+              {
+                to->red[j]   = from->red[j]   * ratio;
+                to->green[j] = from->green[j] * ratio;
+                to->blue[j]  = from->blue[j]  * ratio;
+              }
+          XRRSetCrtcGamma (fs->dpy, r->crtc, to);
+        }
+
+      /* One round trip per step, not per monitor: a monitor that went
+         away mid-fade is not a reason to die. */
+      XSync (fs->dpy, False);
+      XSetErrorHandler (old_handler);
+      return;
+    }
+# endif /* HAVE_RANDR_12 */
+
+# ifdef HAVE_XF86VMODE_GAMMA
+  if (fs->kind == GAMMA_XF86)
+    {
+      XErrorHandler old_handler;
+      error_handler_hit_p = False;
+      old_handler = XSetErrorHandler (ignore_all_errors_ehandler);
+      for (i = 0; i < fs->nramps; i++)
+        xf86_whack_gamma (fs->dpy, fs->ramps[i].screen, &fs->ramps[i].xf86,
+                          ratio);
+      XSync (fs->dpy, False);
+      XSetErrorHandler (old_handler);
+    }
+# endif /* HAVE_XF86VMODE_GAMMA */
+}
+
+
+fade_state *
+fade_start (Display *dpy, Window *black_windows, int nwindows,
+            int seconds, int ticks, Bool out_p, Bool clear_windows)
+{
+  fade_state *fs = (fade_state *) calloc (1, sizeof(*fs));
+  int i;
+
+  if (!fs) return 0;
+  fs->dpy = dpy;
+  fs->out_p = out_p;
+  fs->clear_windows = clear_windows;
+  fs->seconds = (seconds > 0 ? seconds : 1);
+  fs->ticks = (ticks > 0 ? ticks : 1);
+
+  if (
+# ifdef HAVE_RANDR_12
+      randr_save_gamma (fs) &&
+# endif
+# ifdef HAVE_XF86VMODE_GAMMA
+      xf86_save_gamma (fs) &&
+# endif
+      True)   /* neither worked */
+    {
+      free (fs);
+      return 0;
+    }
+
+  if (black_windows && nwindows > 0)
+    {
+      fs->black_windows = (Window *) calloc (nwindows, sizeof(Window));
+      if (fs->black_windows)
+        {
+          memcpy (fs->black_windows, black_windows,
+                  nwindows * sizeof(Window));
+          fs->nwindows = nwindows;
+        }
+    }
+
+  /* If we're fading in (from black), then first crank the gamma all the
+     way down to 0, then take the windows off the screen.
+   */
+  if (!out_p)
+    {
+      set_gamma (fs, 0.0);
+      for (i = 0; i < fs->nwindows; i++)
+        if (fs->black_windows[i])
+          {
+            XUnmapWindow (dpy, fs->black_windows[i]);
+            XClearWindow (dpy, fs->black_windows[i]);
+          }
+      XSync (dpy, False);
+    }
+
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  {
+    struct timezone tzp;
+    gettimeofday (&fs->start, &tzp);
+  }
+# else
+  gettimeofday (&fs->start);
+# endif
+
+  return fs;
+}
+
+
+unsigned long
+fade_step (fade_state *fs)
+{
+  struct timeval now;
+  double elapsed, ratio;
+
+# ifdef GETTIMEOFDAY_TWO_ARGS
+  struct timezone tzp;
+  gettimeofday (&now, &tzp);
+# else
+  gettimeofday (&now);
+# endif
+
+  elapsed = ((now.tv_sec - fs->start.tv_sec) +
+             (now.tv_usec - fs->start.tv_usec) / 1000000.0);
+
+  /* If the clock went backward, or several seconds passed because the
+     machine was asleep or thrashing, just be done. */
+  if (elapsed < 0 || elapsed >= fs->seconds)
+    return 0;
+
+  ratio = elapsed / fs->seconds;
+  set_gamma (fs, (fs->out_p ? 1 - ratio : ratio));
+  return (1000 / fs->ticks) + 1;
+}
+
+
+void
+fade_finish (fade_state *fs)
+{
+  Display *dpy = fs->dpy;
+  int i;
+
+  if (fs->out_p)
+    {
+      for (i = 0; i < fs->nwindows; i++)
+	{
+	  if (fs->clear_windows)
+	    XClearWindow (dpy, fs->black_windows[i]);
+	  XMapRaised (dpy, fs->black_windows[i]);
+	}
+      XSync (dpy, False);
+
+      /* I can't explain this; without this delay, we get a flicker.
+         I suppose there's some lossage with stale bits being in the
+         hardware frame buffer or something, and this delay gives it
+         time to flush out.  This sucks! */
+      usleep (100000);  /* 1/10th second */
+    }
+
+  set_gamma (fs, 1.0);
+  XSync (dpy, False);
+
+  free_ramps (fs);
+  if (fs->black_windows) free (fs->black_windows);
+  free (fs);
+}
+
+#else  /* !HAVE_XF86VMODE_GAMMA && !HAVE_RANDR_12 */
+
+fade_state *
+fade_start (Display *dpy, Window *black_windows, int nwindows,
+            int seconds, int ticks, Bool out_p, Bool clear_windows)
+{
+  return 0;
+}
+
+unsigned long fade_step (fade_state *fs) { return 0; }
+void fade_finish (fade_state *fs) { }
+
+#endif /* !HAVE_XF86VMODE_GAMMA && !HAVE_RANDR_12 */
+
+
+/* Runs a whole fade, sleeping between steps.  Returns -1 if gamma
+   fading isn't possible.
+ */
+static int
+gamma_fade (Display *dpy,
+            Window *black_windows, int nwindows,
+            int seconds, int ticks,
+            Bool out_p, Bool clear_windows)
+{
+  fade_state *fs = fade_start (dpy, black_windows, nwindows,
+                               seconds, ticks, out_p, clear_windows);
+  XEvent dummy_event;
+  unsigned long msecs;
+
+  if (!fs) return -1;
+
+  while ((msecs = fade_step (fs)) > 0)
+    {
+      /* If there is user activity, bug out.  (Bug out on keypresses or
+         mouse presses, but not motion, and not release events.  Bugging
+         out on motion made the unfade hack be totally useless, I think.)
+
+         We put the event back so that the calling code can notice it too.
+       */
+      if (XCheckMaskEvent (dpy, (KeyPressMask|ButtonPressMask),
+                           &dummy_event))
+        {
+          XPutBackEvent (dpy, &dummy_event);
+          break;
+        }
+      usleep (msecs * 1000);
+    }
+
+  fade_finish (fs);
+  return 0;
+}
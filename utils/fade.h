@@ -18,4 +18,19 @@ extern void fade_screens (Display *dpy,
 			  Colormap *cmaps, Window *black_windows, int nwindows,
 			  int seconds, int ticks,
 			  Bool out_p, Bool clear_windows);
+
+/* The same thing, for callers with an event loop to get back to, but only
+   if it can be done by fading the monitors' gamma.  fade_start() returns
+   0 if it can't.  Otherwise, call fade_step() again as many milliseconds
+   later as it says, until it returns 0; then call fade_finish().  That
+   can also be called early, to skip to the end.
+ */
+typedef struct fade_state fade_state;
+extern fade_state *fade_start (Display *dpy,
+                               Window *black_windows, int nwindows,
+                               int seconds, int ticks,
+                               Bool out_p, Bool clear_windows);
+extern unsigned long fade_step (fade_state *);
+extern void fade_finish (fade_state *);
+
 #endif /* __FADE_H__ */
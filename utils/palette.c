@@ -0,0 +1,379 @@
+/* xscreensaver, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+/* Palette-indexed images, for color cycling on TrueColor.  See palette.h.
+ */
+
+#include "utils.h"
+#include "palette.h"
+#include "thread_util.h"
+
+#ifdef HAVE_XSHM_EXTENSION
+# include "xshm.h"
+#endif
+
+#ifndef HAVE_COCOA
+# include <X11/Xutil.h>		/* for XDestroyImage() */
+#endif
+
+/* Below this many pixels, starting up the worker threads costs more
+   than it saves. */
+#define THREAD_MIN_PIXELS (256 * 256)
+
+struct palette_thread {
+  unsigned id;
+  palette_image *p;
+};
+
+struct palette_image {
+  Display *dpy;
+  int width, height;
+  unsigned char *data;
+  XImage *image;
+# ifdef HAVE_XSHM_EXTENSION
+  Bool shm_p;
+  XShmSegmentInfo shm_info;
+# endif
+
+  int ncolors;
+  unsigned long colors[256];
+  int first, rotation;		/* colors [first, ncolors) are rotated */
+
+  /* Pixel for each index, with the rotation applied.  The sized ones are
+     in the byte order of the image, and only the one that matches its
+     bits_per_pixel is used. */
+  Bool lut_dirty_p;
+  unsigned long lut[256];
+  unsigned int lut32[256];
+  unsigned short lut16[256];
+  unsigned char lut8[256];
+
+  /* The rectangle that has changed since the last put, [x0,x1) x [y0,y1),
+     and the rows the threads are to translate. */
+  int x0, y0, x1, y1;
+  int row0, row1;
+
+  struct threadpool pool;	/* count is 0 if not threaded */
+};
+
+
+static int
+palette_thread_create (void *self_raw, struct threadpool *pool, unsigned id)
+{
+  struct palette_thread *self = (struct palette_thread *) self_raw;
+  self->p = GET_PARENT_OBJ (palette_image, pool, pool);
+  self->id = id;
+  return 0;
+}
+
+static void
+palette_thread_destroy (void *self_raw)
+{
+}
+
+
+palette_image *
+palette_image_create (Display *dpy, Visual *visual, unsigned int depth,
+                      int width, int height, Bool use_shm)
+{
+  palette_image *p = (palette_image *) calloc (1, sizeof(*p));
+  if (!p) return 0;
+  if (width < 1)  width = 1;
+  if (height < 1) height = 1;
+  p->dpy = dpy;
+  p->width = width;
+  p->height = height;
+  p->data = (unsigned char *) calloc (width, height);
+  if (!p->data) goto FAIL;
+
+# ifdef HAVE_XSHM_EXTENSION
+  if (use_shm)
+    {
+      p->image = create_xshm_image (dpy, visual, depth, ZPixmap, 0,
+                                    &p->shm_info, width, height);
+      p->shm_p = !!p->image;
+    }
+# endif
+
+  if (!p->image)
+    {
+      p->image = XCreateImage (dpy, visual, depth, ZPixmap, 0, 0,
+                               width, height, 8, 0);
+      if (!p->image) goto FAIL;
+      p->image->data = (char *) calloc (height, p->image->bytes_per_line);
+      if (!p->image->data) goto FAIL;
+    }
+
+  if (width * height >= THREAD_MIN_PIXELS)
+    {
+      static const struct threadpool_class cls = {
+        sizeof(struct palette_thread),
+        palette_thread_create,
+        palette_thread_destroy
+      };
+      if (threadpool_create (&p->pool, &cls, dpy, hardware_concurrency (dpy)))
+        p->pool.count = 0;	/* See the note in thread_util.h. */
+    }
+
+  p->lut_dirty_p = True;
+  p->x1 = width;
+  p->y1 = height;
+  return p;
+
+ FAIL:
+  palette_image_free (p);
+  return 0;
+}
+
+
+void
+palette_image_free (palette_image *p)
+{
+  if (!p) return;
+  if (p->pool.count)
+    threadpool_destroy (&p->pool);
+  if (p->image)
+    {
+# ifdef HAVE_XSHM_EXTENSION
+      if (p->shm_p)
+        destroy_xshm_image (p->dpy, p->image, &p->shm_info);
+      else
+# endif
+        XDestroyImage (p->image);
+    }
+  if (p->data) free (p->data);
+  free (p);
+}
+
+
+unsigned char *
+palette_image_data (palette_image *p, int *width, int *height)
+{
+  if (width)  *width  = p->width;
+  if (height) *height = p->height;
+  return p->data;
+}
+
+
+void
+palette_image_changed (palette_image *p, int x, int y, int w, int h)
+{
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > p->width)  x1 = p->width;
+  if (y1 > p->height) y1 = p->height;
+  if (x >= x1 || y >= y1) return;
+
+  if (p->x0 >= p->x1)		/* nothing pending */
+    {
+      p->x0 = x;  p->y0 = y;
+      p->x1 = x1; p->y1 = y1;
+    }
+  else
+    {
+      if (x  < p->x0) p->x0 = x;
+      if (y  < p->y0) p->y0 = y;
+      if (x1 > p->x1) p->x1 = x1;
+      if (y1 > p->y1) p->y1 = y1;
+    }
+}
+
+
+void
+palette_image_set_colors (palette_image *p, const XColor *colors, int ncolors)
+{
+  int i;
+  if (ncolors > 256) ncolors = 256;
+  if (ncolors < 0)   ncolors = 0;
+  for (i = 0; i < ncolors; i++)
+    p->colors[i] = colors[i].pixel;
+  p->ncolors = ncolors;
+  p->first = 0;
+  p->rotation = 0;
+  p->lut_dirty_p = True;
+}
+
+
+void
+palette_image_rotate (palette_image *p, int first, int distance)
+{
+  int n;
+  if (first < 0) first = 0;
+  if (first != p->first)
+    p->rotation = 0;
+  p->first = first;
+  n = p->ncolors - first;
+  if (n < 2) return;
+  p->rotation = (p->rotation + distance) % n;
+  if (p->rotation < 0) p->rotation += n;
+  p->lut_dirty_p = True;
+}
+
+
+static void
+make_luts (palette_image *p)
+{
+  XImage *image = p->image;
+  union { int i; char c; } u;
+  Bool swap_p;
+  int i;
+
+  u.i = 1;
+  swap_p = (image->byte_order != (u.c ? LSBFirst : MSBFirst));
+
+  for (i = 0; i < 256; i++)
+    {
+      unsigned long pixel;
+      if (i >= p->ncolors)
+        pixel = (p->ncolors ? p->colors[0] : 0);
+      else if (i < p->first)
+        pixel = p->colors[i];
+      else
+        {
+          int n = p->ncolors - p->first;
+          int j = (i - p->first - p->rotation) % n;
+          if (j < 0) j += n;
+          pixel = p->colors[p->first + j];
+        }
+
+      p->lut[i] = pixel;
+      if (swap_p)
+        {
+          p->lut32[i] = (((pixel & 0x000000FFL) << 24) |
+                         ((pixel & 0x0000FF00L) <<  8) |
+                         ((pixel & 0x00FF0000L) >>  8) |
+                         ((pixel & 0xFF000000L) >> 24));
+          p->lut16[i] = (((pixel & 0x00FF) << 8) |
+                         ((pixel & 0xFF00) >> 8));
+        }
+      else
+        {
+          p->lut32[i] = (unsigned int) pixel;
+          p->lut16[i] = (unsigned short) pixel;
+        }
+      p->lut8[i] = (unsigned char) pixel;
+    }
+
+  p->lut_dirty_p = False;
+}
+
+
+/* Translates the changed columns of rows [row0, row1) into the XImage.
+ */
+static void
+expand_rows (palette_image *p, int row0, int row1)
+{
+  XImage *image = p->image;
+  int x0 = p->x0;
+  int w = p->x1 - p->x0;
+  int x, y;
+
+  for (y = row0; y < row1; y++)
+    {
+      const unsigned char *s = p->data + y * p->width + x0;
+      char *row = image->data + y * image->bytes_per_line;
+
+      switch (image->bits_per_pixel) {
+      case 32:
+        {
+          const unsigned int *lut = p->lut32;
+          unsigned int *d = (unsigned int *) row + x0;
+          for (x = 0; x + 4 <= w; x += 4, s += 4, d += 4)
+            {
+              d[0] = lut[s[0]];
+              d[1] = lut[s[1]];
+              d[2] = lut[s[2]];
+              d[3] = lut[s[3]];
+            }
+          for (; x < w; x++)
+            *d++ = lut[*s++];
+        }
+        break;
+      case 16:
+        {
+          const unsigned short *lut = p->lut16;
+          unsigned short *d = (unsigned short *) row + x0;
+          for (x = 0; x < w; x++)
+            *d++ = lut[*s++];
+        }
+        break;
+      case 8:
+        {
+          const unsigned char *lut = p->lut8;
+          unsigned char *d = (unsigned char *) row + x0;
+          for (x = 0; x < w; x++)
+            *d++ = lut[*s++];
+        }
+        break;
+      default:
+        /* 24 bit, or something stranger. */
+        for (x = 0; x < w; x++)
+          XPutPixel (image, x0 + x, y, p->lut[*s++]);
+        break;
+      }
+    }
+}
+
+
+static void
+palette_thread_run (void *self_raw)
+{
+  struct palette_thread *self = (struct palette_thread *) self_raw;
+  palette_image *p = self->p;
+  int n = p->pool.count;
+  int h = p->row1 - p->row0;
+  expand_rows (p,
+               p->row0 + (h * (int) self->id) / n,
+               p->row0 + (h * ((int) self->id + 1)) / n);
+}
+
+
+void
+palette_image_put (palette_image *p, Drawable d, GC gc)
+{
+  int w, h;
+
+  if (p->lut_dirty_p)
+    {
+      make_luts (p);
+      p->x0 = p->y0 = 0;
+      p->x1 = p->width;
+      p->y1 = p->height;
+    }
+
+  if (p->x0 >= p->x1 || p->y0 >= p->y1)
+    return;
+
+  w = p->x1 - p->x0;
+  h = p->y1 - p->y0;
+
+  p->row0 = p->y0;
+  p->row1 = p->y1;
+  if (p->pool.count > 1 && w * h >= THREAD_MIN_PIXELS)
+    {
+      threadpool_run (&p->pool, palette_thread_run);
+      threadpool_wait (&p->pool);
+    }
+  else
+    expand_rows (p, p->row0, p->row1);
+
+# ifdef HAVE_XSHM_EXTENSION
+  if (p->shm_p)
+    XShmPutImage (p->dpy, d, gc, p->image,
+                  p->x0, p->y0, p->x0, p->y0, w, h, False);
+  else
+# endif
+    XPutImage (p->dpy, d, gc, p->image,
+               p->x0, p->y0, p->x0, p->y0, w, h);
+
+  p->x0 = p->y0 = p->x1 = p->y1 = 0;
+}
@@ -0,0 +1,59 @@
+/* xscreensaver, Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+/* Color cycling without writable color cells.
+
+   Hacks that animate by rotating a colormap (rotate_colors) only work on
+   PseudoColor visuals; on TrueColor there are no cells to store into.
+   Instead, a hack can draw palette indexes into a palette_image, one byte
+   per pixel.  Changing or rotating the palette then costs one pass over
+   the image, translating each index to its pixel value through a lookup
+   table, and one XPutImage: no redrawing.
+
+   The translation is split across threads for large images.
+ */
+
+#ifndef __XSCREENSAVER_PALETTE_H__
+#define __XSCREENSAVER_PALETTE_H__
+
+typedef struct palette_image palette_image;
+
+/* Creates an image to be drawn on windows of the given visual and depth.
+   Uses a shared memory XImage if use_shm is true and that works.
+ */
+extern palette_image *palette_image_create (Display *, Visual *,
+                                            unsigned int depth,
+                                            int width, int height,
+                                            Bool use_shm);
+extern void palette_image_free (palette_image *);
+
+/* The index of pixel (x,y) is data[y * width + x].  After changing any,
+   call palette_image_changed() on the rectangle that contains them.
+ */
+extern unsigned char *palette_image_data (palette_image *,
+                                          int *width, int *height);
+extern void palette_image_changed (palette_image *,
+                                   int x, int y, int w, int h);
+
+/* Index N is drawn with colors[N].pixel.  At most 256 colors are used. */
+extern void palette_image_set_colors (palette_image *,
+                                      const XColor *, int ncolors);
+
+/* Like rotate_colors(), on the colors from index `first' up: index N is
+   then drawn with the color that index (N - distance) had before.  The
+   colors below `first' stay where they are, e.g. for a background at 0.
+ */
+extern void palette_image_rotate (palette_image *, int first, int distance);
+
+/* Sends whatever has changed since the last call to the drawable. */
+extern void palette_image_put (palette_image *, Drawable, GC);
+
+#endif /* __XSCREENSAVER_PALETTE_H__ */
@@ -33,6 +33,7 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 
 #include <signal.h>
 #include <sys/wait.h>
@@ -56,6 +57,8 @@
 
 extern const char *progname;
 
+#define RING_SIZE 16384
+
 struct text_data {
   Display *dpy;
   char *program;
@@ -67,8 +70,15 @@ struct text_data {
   FILE *pipe;
   pid_t pid;
   XtInputId pipe_id;
-  Bool input_available_p;
+  Bool eof_p;			/* the pipe is done, once `ring' is empty */
   Time subproc_relaunch_delay;
+
+  /* What has been read from the pipe but not yet returned.  We read as
+     much as is available whenever the pipe is readable, instead of one
+     byte per call to textclient_getc().
+   */
+  unsigned char ring[RING_SIZE];
+  int ring_start, ring_count;
   XComposeStatus compose;
 
   Bool meta_sends_esc_p;
@@ -81,15 +91,53 @@ struct text_data {
 };
 
 
+static void subproc_cb (XtPointer closure, int *source, XtInputId *id);
+
+/* Listen to the pipe only while there is room to read into. */
+static void
+watch_pipe (text_data *d, Bool on_p)
+{
+  if (on_p && !d->pipe_id && d->pipe && !d->eof_p)
+    d->pipe_id =
+      XtAppAddInput (XtDisplayToApplicationContext (d->dpy),
+                     fileno (d->pipe),
+                     (XtPointer) (XtInputReadMask | XtInputExceptMask),
+                     subproc_cb, (XtPointer) d);
+  else if (!on_p && d->pipe_id)
+    {
+      XtRemoveInput (d->pipe_id);
+      d->pipe_id = 0;
+    }
+}
+
+
+/* The pipe is readable: read as much as fits in the ring up to where it
+   wraps.  Only the first read after select() is sure not to block, so
+   it's one read per call; if there is more, Xt calls us again.
+ */
 static void
 subproc_cb (XtPointer closure, int *source, XtInputId *id)
 {
   text_data *d = (text_data *) closure;
+
+  if (d->ring_count < RING_SIZE)
+    {
+      int end = (d->ring_start + d->ring_count) % RING_SIZE;
+      int span = (end >= d->ring_start
+                  ? RING_SIZE - end
+                  : d->ring_start - end);
+      int n = read (*source, (void *) (d->ring + end), span);
 # ifdef DEBUG
-  if (! d->input_available_p)
-    fprintf (stderr, "%s: textclient: input available\n", progname);
+      fprintf (stderr, "%s: textclient: read %d of %d\n", progname, n, span);
 # endif
-  d->input_available_p = True;
+      if (n > 0)
+        d->ring_count += n;
+      else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+        d->eof_p = True;	/* EOF, or EIO from a pty */
+    }
+
+  if (d->eof_p || d->ring_count >= RING_SIZE)
+    watch_pipe (d, False);
 }
 
 
@@ -102,7 +150,6 @@ subproc_cb (XtPointer closure, int *source, XtInputId *id)
 static void
 launch_text_generator (text_data *d)
 {
-  XtAppContext app = XtDisplayToApplicationContext (d->dpy);
   char buf[255];
   const char *oprogram = d->program;
   char *s;
@@ -190,10 +237,7 @@ launch_text_generator (text_data *d)
           if (d->pipe) abort();
 	  d->pipe = fdopen (fd, "r+");
           if (d->pipe_id) abort();
-	  d->pipe_id =
-	    XtAppAddInput (app, fileno (d->pipe),
-			   (XtPointer) (XtInputReadMask | XtInputExceptMask),
-			   subproc_cb, (XtPointer) d);
+          watch_pipe (d, True);
 # ifdef DEBUG
           fprintf (stderr, "%s: textclient: pid = %d\n", progname, d->pid);
 # endif
@@ -214,10 +258,7 @@ launch_text_generator (text_data *d)
       if ((d->pipe = popen (cmd, "r")))
 	{
           if (d->pipe_id) abort();
-	  d->pipe_id =
-	    XtAppAddInput (app, fileno (d->pipe),
-			   (XtPointer) (XtInputReadMask | XtInputExceptMask),
-			   subproc_cb, (XtPointer) d);
+          watch_pipe (d, True);
 # ifdef DEBUG
           fprintf (stderr, "%s: textclient: popen\n", progname);
 # endif
@@ -276,9 +317,7 @@ close_pipe (text_data *d)
     }
   d->pid = 0;
 
-  if (d->pipe_id)
-    XtRemoveInput (d->pipe_id);
-  d->pipe_id = 0;
+  watch_pipe (d, False);
 
   if (d->pipe)
     {
@@ -288,8 +327,8 @@ close_pipe (text_data *d)
       pclose (d->pipe);
     }
   d->pipe = 0;
-
-
+  d->eof_p = False;
+  d->ring_start = d->ring_count = 0;
 }
 
 
@@ -333,7 +372,6 @@ textclient_reshape (text_data *d,
   if (!strcmp (d->program, "xscreensaver-text"))
     {
       close_pipe (d);
-      d->input_available_p = False;
       start_timer (d);
     }
 }
@@ -409,58 +447,86 @@ textclient_close (text_data *d)
   free (d);
 }
 
+/* Copies up to `n' bytes of the program's output into `buf', and
+   returns how many.  Never blocks: returns 0 if there's nothing to read
+   right now.
+ */
 int
-textclient_getc (text_data *d)
+textclient_read (text_data *d, char *buf, int n)
 {
-  XtAppContext app = XtDisplayToApplicationContext (d->dpy);
-  int ret = -1;
+  int got = 0;
 
-  if (XtAppPending (app) & (XtIMTimer|XtIMAlternateInput))
-    XtAppProcessEvent (app, XtIMTimer|XtIMAlternateInput);
+  /* Only go looking for more if we've run out. */
+  if (d->ring_count == 0 && !(d->out_buffer && *d->out_buffer))
+    {
+      XtAppContext app = XtDisplayToApplicationContext (d->dpy);
+      if (XtAppPending (app) & (XtIMTimer|XtIMAlternateInput))
+        XtAppProcessEvent (app, XtIMTimer|XtIMAlternateInput);
+    }
+
+  while (got < n && d->out_buffer && *d->out_buffer)
+    buf[got++] = *d->out_buffer++;
 
-  if (d->out_buffer && *d->out_buffer)
+  while (got < n && d->ring_count > 0)
     {
-      ret = *d->out_buffer;
-      d->out_buffer++;
+      int span = RING_SIZE - d->ring_start;
+      if (span > d->ring_count) span = d->ring_count;
+      if (span > n - got) span = n - got;
+      memcpy (buf + got, d->ring + d->ring_start, span);
+      got += span;
+      d->ring_start = (d->ring_start + span) % RING_SIZE;
+      d->ring_count -= span;
     }
-  else if (d->input_available_p && d->pipe)
+
+  if (got > 0)
     {
-      unsigned char s[2];
-      int n = read (fileno (d->pipe), (void *) s, 1);
-      if (n > 0)
-        ret = s[0];
-      else		/* EOF */
+      int i;
+      for (i = got - 1; i >= 0; i--)
+        if (buf[i] == '\r' || buf[i] == '\n')
+          break;
+      d->out_column = (i < 0 ? d->out_column + got : got - 1 - i);
+    }
+
+  if (d->ring_count == 0)
+    d->ring_start = 0;
+
+  if (d->ring_count < RING_SIZE / 2)
+    watch_pipe (d, True);
+
+  if (d->eof_p && d->ring_count == 0)
+    {
+      if (d->pid)
         {
-	  if (d->pid)
-	    {
 # ifdef DEBUG
-              fprintf (stderr, "%s: textclient: waitpid %d\n",
-                       progname, d->pid);
+          fprintf (stderr, "%s: textclient: waitpid %d\n", progname, d->pid);
 # endif
-	      waitpid (d->pid, NULL, 0);
-              d->pid = 0;
-	    }
+          waitpid (d->pid, NULL, 0);
+          d->pid = 0;
+        }
 
-          close_pipe (d);
+      close_pipe (d);
 
-          if (d->out_column > 0)
-            {
+      if (d->out_column > 0)
+        {
 # ifdef DEBUG
-              fprintf (stderr, "%s: textclient: adding blank line at EOF\n",
-                       progname);
+          fprintf (stderr, "%s: textclient: adding blank line at EOF\n",
+                   progname);
 # endif
-              d->out_buffer = "\r\n\r\n";
-            }
-
-          start_timer (d);
+          d->out_buffer = "\r\n\r\n";
         }
-      d->input_available_p = False;
+
+      start_timer (d);
     }
 
-  if (ret == '\r' || ret == '\n')
-    d->out_column = 0;
-  else if (ret > 0)
-    d->out_column++;
+  return got;
+}
+
+
+int
+textclient_getc (text_data *d)
+{
+  char c;
+  int ret = (textclient_read (d, &c, 1) == 1 ? (unsigned char) c : -1);
 
 # ifdef DEBUG
   if (ret <= 0)
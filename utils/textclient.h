@@ -27,6 +27,10 @@ extern void textclient_reshape (text_data *,
                                 int char_w, int char_h,
                                 int max_lines);
 extern int textclient_getc (text_data *);
+
+/* Reads up to N bytes of the program's output into BUF, and returns how
+   many.  Returns 0 if nothing is available yet; never blocks. */
+extern int textclient_read (text_data *, char *buf, int n);
 extern Bool textclient_putc (text_data *, XKeyEvent *);
 
 #endif /* __TEXTCLIENT_H__ */